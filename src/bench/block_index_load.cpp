@@ -0,0 +1,69 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <poc/poc.h>
+#include <txdb.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <assert.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+static const int BLOCK_INDEX_COUNT = 100 * 1000;
+
+//! Write a chain of burst block indexes, the generators of the blocks cannot be derived from a public key
+static void FillBlockTree(CBlockTreeDB& db, const Consensus::Params& params)
+{
+    std::vector<CBlockIndex> vIndexes(BLOCK_INDEX_COUNT);
+    std::vector<uint256> vHashes(BLOCK_INDEX_COUNT);
+    std::vector<const CBlockIndex*> vBlockInfo;
+    for (int i = 0; i < BLOCK_INDEX_COUNT; ++i) {
+        CBlockIndex& index = vIndexes[i];
+        index.pprev = i > 0 ? &vIndexes[i - 1] : nullptr;
+        index.nHeight = i + 1;
+        index.nStatus = BLOCK_VALID_SCRIPTS | BLOCK_HAVE_DATA;
+        index.nDataPos = i + 1;
+        index.nTx = 1;
+        index.nTime = 1531292789 + i * 300;
+        index.nBaseTarget = poc::GetBaseTarget(index.nHeight, params);
+        index.nNonce = i;
+        index.nPlotterId = 1234567890 + i % 1000;
+        *reinterpret_cast<int*>(index.hashMerkleRoot.begin()) = i + 1;
+        *reinterpret_cast<int*>(index.generatorAccountID.begin()) = i % 1000 + 1;
+        vHashes[i] = index.GetBlockHeader().GetHash();
+        index.phashBlock = &vHashes[i];
+        vBlockInfo.push_back(&index);
+    }
+    bool fWritten = db.WriteBatchSync({}, 0, vBlockInfo, params);
+    assert(fWritten);
+}
+
+// Block index of 100k burst blocks loaded from the block tree db, the generators are stored with the records.
+static void LoadBlockIndexRecords(benchmark::State& state)
+{
+    const std::unique_ptr<const CChainParams> chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    CBlockTreeDB db(64 << 20, true, true);
+    FillBlockTree(db, params);
+
+    while (state.KeepRunning()) {
+        std::unordered_map<uint256, std::unique_ptr<CBlockIndex>, BlockHasher> mapIndexes;
+        bool fLoaded = db.LoadBlockIndexGuts(params, [&mapIndexes](const uint256& hash) -> CBlockIndex* {
+            if (hash.IsNull())
+                return nullptr;
+            std::unique_ptr<CBlockIndex>& pindex = mapIndexes[hash];
+            if (!pindex)
+                pindex.reset(new CBlockIndex());
+            return pindex.get();
+        });
+        assert(fLoaded && mapIndexes.size() == BLOCK_INDEX_COUNT);
+    }
+}
+
+BENCHMARK(LoadBlockIndexRecords, 1);
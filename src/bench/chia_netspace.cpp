@@ -0,0 +1,106 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <chiapos/post.h>
+#include <poc/poc.h>
+
+#include <vector>
+
+static const int CHAIN_HEIGHT = 10000;
+
+//! Main consensus with chiapos activated at a low height
+static Consensus::Params GetBenchConsensus()
+{
+    Consensus::Params params = CreateChainParams(CBaseChainParams::MAIN)->GetConsensus();
+    params.BHDIP009Height = 100;
+    return params;
+}
+
+static void BuildChiaChain(std::vector<CBlockIndex>& blocks, const Consensus::Params& params)
+{
+    blocks.resize(CHAIN_HEIGHT + 1);
+    for (int nHeight = 0; nHeight <= CHAIN_HEIGHT; ++nHeight) {
+        CBlockIndex& block = blocks[nHeight];
+        block.nHeight = nHeight;
+        block.pprev = nHeight > 0 ? &blocks[nHeight - 1] : nullptr;
+        block.BuildSkip();
+        if (nHeight >= params.BHDIP009Height) {
+            block.chiaposFields.nDifficulty = params.BHDIP009StartDifficulty + nHeight % 7 * 1000;
+            block.chiaposFields.nVdfIters = 1000000 + nHeight % 11 * 10000;
+        }
+        block.Update(params);
+    }
+}
+
+//! The evaluation before the window sums were stored on the block index
+static uint64_t GetDifficultyForNextIterationsByWalk(CBlockIndex const* pindex, Consensus::Params const& params)
+{
+    if (pindex->nHeight + 1 == params.BHDIP009Height) {
+        return params.BHDIP009StartDifficulty;
+    }
+    arith_uint256 totalDifficulty{0};
+    int nCount = params.BHDIP009DifficultyEvalWindow;
+    while (nCount > 0 && pindex != nullptr && pindex->nHeight >= params.BHDIP009Height) {
+        totalDifficulty += chiapos::GetChiaBlockDifficulty(pindex, params);
+        --nCount;
+        pindex = pindex->pprev;
+    }
+    int nBlocksCalc = params.BHDIP009DifficultyEvalWindow - nCount;
+    if (nBlocksCalc == 0) {
+        return params.BHDIP009StartDifficulty;
+    }
+    return (totalDifficulty / nBlocksCalc).GetLow64();
+}
+
+static arith_uint256 CalculateAverageNetworkSpaceByWalk(CBlockIndex const* pindex, Consensus::Params const& params)
+{
+    int nCount = params.BHDIP009DifficultyEvalWindow;
+    int nActual{0};
+    arith_uint256 result;
+    while (nCount > 0 && pindex->nHeight >= params.BHDIP009Height) {
+        result += chiapos::CalculateNetworkSpace(GetDifficultyForNextIterationsByWalk(pindex->pprev, params),
+                pindex->chiaposFields.GetTotalIters(), params.BHDIP009DifficultyConstantFactorBits);
+        ++nActual;
+        pindex = pindex->pprev;
+        --nCount;
+    }
+    if (nActual == 0) {
+        return 0;
+    }
+    return result / nActual;
+}
+
+// Average network space at tip, walking the evaluation window for every block of the window.
+static void ChiaNetspaceWalk(benchmark::State& state)
+{
+    Consensus::Params params = GetBenchConsensus();
+    std::vector<CBlockIndex> blocks;
+    BuildChiaChain(blocks, params);
+    const CBlockIndex* pindexTip = &blocks.back();
+
+    while (state.KeepRunning()) {
+        arith_uint256 netspace = CalculateAverageNetworkSpaceByWalk(pindexTip, params);
+        assert(netspace > 0);
+    }
+}
+
+// Same as above, read from the window sums of the block index. The results are compared in poc_tests.
+static void ChiaNetspaceWindowSum(benchmark::State& state)
+{
+    Consensus::Params params = GetBenchConsensus();
+    std::vector<CBlockIndex> blocks;
+    BuildChiaChain(blocks, params);
+    const CBlockIndex* pindexTip = &blocks.back();
+
+    while (state.KeepRunning()) {
+        arith_uint256 netspace = poc::CalculateAverageNetworkSpace(pindexTip, params);
+        assert(netspace > 0);
+    }
+}
+
+BENCHMARK(ChiaNetspaceWalk, 100);
+BENCHMARK(ChiaNetspaceWindowSum, 100 * 1000);
@@ -0,0 +1,83 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <checkqueue.h>
+#include <poc/poc.h>
+#include <uint256.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+
+static const int MIN_CORES = 2;
+static const int HEADER_COUNT = 64;
+
+static std::vector<poc::PlotterNonce> GetBenchHeaderNonces(const Consensus::Params& params)
+{
+    std::vector<poc::PlotterNonce> nonces;
+    for (int i = 0; i < HEADER_COUNT; ++i) {
+        poc::PlotterNonce nonce;
+        nonce.nPlotterId = 1234567890 + i % 3;
+        nonce.nNonce = i;
+        nonce.nHeight = params.BHDIP006Height + 1 + i;
+        nonce.generationSignature = ArithToUint256(arith_uint256(i + 1));
+        nonce.nBaseTarget = poc::GetBaseTarget(nonce.nHeight, params);
+        nonces.push_back(nonce);
+    }
+    return nonces;
+}
+
+// Deadlines of a run of 64 burst headers, calculated one by one like the header acceptance does without the queue.
+static void HeaderProofCheckSerial(benchmark::State& state)
+{
+    const std::unique_ptr<const CChainParams> chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    const std::vector<poc::PlotterNonce> nonces = GetBenchHeaderNonces(params);
+
+    while (state.KeepRunning()) {
+        for (const poc::PlotterNonce& nonce : nonces) {
+            poc::CalculateDeadlines(Span<const poc::PlotterNonce>(&nonce, 1), params);
+        }
+    }
+}
+
+// Same as above, checked in batches of SIMD lanes on the header proof check queue.
+static void HeaderProofCheckQueue(benchmark::State& state)
+{
+    const std::unique_ptr<const CChainParams> chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    const std::vector<poc::PlotterNonce> nonces = GetBenchHeaderNonces(params);
+
+    CCheckQueue<CHeaderProofCheck> queue{16};
+    boost::thread_group tg;
+    for (auto x = 0; x < std::max(MIN_CORES, GetNumCores()); ++x) {
+        tg.create_thread([&]{queue.Thread();});
+    }
+    while (state.KeepRunning()) {
+        std::vector<CHeaderProofCheck> vChecks;
+        for (std::size_t n = 0; n < nonces.size(); n += poc::MAX_BATCH_NONCES) {
+            const std::size_t nEnd = std::min(nonces.size(), n + poc::MAX_BATCH_NONCES);
+            std::vector<uint256> vHashes;
+            for (std::size_t i = n; i < nEnd; ++i) {
+                vHashes.push_back(ArithToUint256(arith_uint256(i)));
+            }
+            vChecks.emplace_back(std::move(vHashes), std::vector<poc::PlotterNonce>(nonces.begin() + n, nonces.begin() + nEnd), params);
+        }
+        CCheckQueueControl<CHeaderProofCheck> control(&queue);
+        control.Add(vChecks);
+        control.Wait();
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+BENCHMARK(HeaderProofCheckSerial, 1);
+BENCHMARK(HeaderProofCheckQueue, 1);
@@ -0,0 +1,89 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <omnicore/log.h>
+#include <omnicore/omnicore.h>
+#include <omnicore/sto.h>
+#include <omnicore/tally.h>
+#include <sync.h>
+
+#include <assert.h>
+#include <string>
+#include <unordered_map>
+
+using namespace mastercore;
+
+static const int ADDRESS_COUNT = 1000 * 1000;
+static const uint32_t PROPERTY_COUNT = 10 * 1000;
+static const uint32_t BENCH_PROPERTY = PROPERTY_COUNT / 2;
+
+//! Fill the tallies with 1M addresses, every address holds one of 10k properties
+static void FillTallies()
+{
+    bool fDebugTally = msc_debug_tally;
+    msc_debug_tally = false;
+    for (int i = 0; i < ADDRESS_COUNT; ++i) {
+        update_tally_map("address" + std::to_string(i), 1 + i % PROPERTY_COUNT, 100 + i, BALANCE);
+    }
+    msc_debug_tally = fDebugTally;
+}
+
+static void ClearTallies()
+{
+    LOCK(cs_tally);
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+}
+
+// Total tokens and owners of one property, scanned from the tallies of all addresses.
+static void OmniTotalTokensScan(benchmark::State& state)
+{
+    FillTallies();
+    while (state.KeepRunning()) {
+        LOCK(cs_tally);
+        int64_t totalTokens = 0;
+        int64_t owners = 0;
+        for (std::unordered_map<std::string, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+            int64_t tokens = it->second.getMoneyHeld(BENCH_PROPERTY);
+            if (tokens != 0) {
+                totalTokens += tokens;
+                owners++;
+            }
+        }
+        assert(owners == ADDRESS_COUNT / PROPERTY_COUNT && totalTokens > 0);
+    }
+    ClearTallies();
+}
+
+// Same as above, read from the holders of the property.
+static void OmniTotalTokensHolders(benchmark::State& state)
+{
+    FillTallies();
+    while (state.KeepRunning()) {
+        LOCK(cs_tally);
+        const CMPPropertyHolders& property = mp_property_holders.at(BENCH_PROPERTY);
+        assert(property.holders.size() == ADDRESS_COUNT / PROPERTY_COUNT && property.totalTokens > 0);
+    }
+    ClearTallies();
+}
+
+// Receivers of a send to owners of one property, the sender is one of the 100 holders.
+static void OmniSTOReceivers(benchmark::State& state)
+{
+    FillTallies();
+    bool fDebugSto = msc_debug_sto;
+    msc_debug_sto = false;
+    std::string sender = "address" + std::to_string(BENCH_PROPERTY - 1);
+    while (state.KeepRunning()) {
+        OwnerAddrType receivers = STO_GetReceivers(sender, BENCH_PROPERTY, 1000 * 1000);
+        assert(receivers.size() == ADDRESS_COUNT / PROPERTY_COUNT - 1);
+    }
+    msc_debug_sto = fDebugSto;
+    ClearTallies();
+}
+
+BENCHMARK(OmniTotalTokensScan, 5);
+BENCHMARK(OmniTotalTokensHolders, 1000 * 1000);
+BENCHMARK(OmniSTOReceivers, 10 * 1000);
@@ -0,0 +1,121 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <consensus/pledge_term.h>
+#include <script/standard.h>
+#include <txdb.h>
+
+static const int RETARGET_COUNT = 100 * 1000;
+static const int ACCOUNT_COUNT = 1000;
+static const int RETARGET_HEIGHT = 200000;
+static const int ACCOUNT_COIN_COUNT = 200 * 1000;
+
+static CScript GetAccountScript(int n)
+{
+    uint160 hash;
+    *reinterpret_cast<int*>(hash.begin()) = n + 1;
+    return GetScriptForDestination(ScriptHash(hash));
+}
+
+static PledgeTerms GetBenchPledgeTerms()
+{
+    PledgeTerms terms;
+    terms[0] = {3360 * 5, 8};
+    terms[1] = {3360 * 365, 20};
+    terms[2] = {3360 * 365 * 2, 50};
+    terms[3] = {3360 * 365 * 3, 100};
+    return terms;
+}
+
+//! Fill the coin database with retarget coins, every account receives and revokes the same count of them
+static void FillRetargetCoins(CCoinsViewDB& db)
+{
+    CCoinsMap coins;
+    CAccountTotalsMap totals;
+    for (int i = 0; i < RETARGET_COUNT; ++i) {
+        uint256 txid;
+        *reinterpret_cast<int*>(txid.begin()) = i + 1;
+        Coin coin(CTxOut(COIN, GetAccountScript(i % ACCOUNT_COUNT)), RETARGET_HEIGHT, false);
+        coin.Refresh();
+        auto payload = std::make_shared<PointRetargetPayload>();
+        payload->receiverID = ExtractAccountID(GetAccountScript((i + 1) % ACCOUNT_COUNT));
+        payload->pointType = DATACARRIER_TYPE_CHIA_POINT_TERM_1;
+        payload->nPointHeight = RETARGET_HEIGHT - 1;
+        coin.extraData = payload;
+        ApplyCoinToAccountTotals(totals, COutPoint(txid, 0), coin, 1);
+        CCoinsCacheEntry& entry = coins[COutPoint(txid, 0)];
+        entry.coin = std::move(coin);
+        entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+    }
+    uint256 hashBlock;
+    *reinterpret_cast<int*>(hashBlock.begin()) = 1;
+    db.BatchWrite(coins, totals, hashBlock);
+}
+
+// Pledge balance of one account scanned from the coin database, which holds 100k retarget coins.
+static void PledgeBalanceRetarget(benchmark::State& state)
+{
+    CCoinsViewDB db("coinsbench", 16 << 20, true, true);
+    FillRetargetCoins(db);
+    PledgeTerms terms = GetBenchPledgeTerms();
+    CAccountID accountID = ExtractAccountID(GetAccountScript(ACCOUNT_COUNT / 2));
+
+    while (state.KeepRunning()) {
+        CAmount balancePointSend{0}, balancePointReceive{0};
+        db.GetBalance(accountID, CCoinsMap(), nullptr, &balancePointSend, &balancePointReceive, &terms, RETARGET_HEIGHT + 1, false);
+        assert(balancePointSend == balancePointReceive);
+        assert(balancePointSend > 0);
+    }
+}
+
+// Same as above, read from the account totals.
+static void PledgeBalanceTotals(benchmark::State& state)
+{
+    CCoinsViewDB db("coinsbench", 16 << 20, true, true);
+    FillRetargetCoins(db);
+    CCoinsViewCache cache(&db);
+    PledgeTerms terms = GetBenchPledgeTerms();
+    CAccountID accountID = ExtractAccountID(GetAccountScript(ACCOUNT_COUNT / 2));
+
+    while (state.KeepRunning()) {
+        CAmount balancePointSend{0}, balancePointReceive{0};
+        cache.GetAccountBalance(false, accountID, nullptr, &balancePointSend, &balancePointReceive, &terms, RETARGET_HEIGHT + 1);
+        assert(balancePointSend == balancePointReceive);
+        assert(balancePointSend > 0);
+    }
+}
+
+// Height filtered coin balance of one account which holds 200k coins.
+static void CoinBalanceAtHeight(benchmark::State& state)
+{
+    CCoinsViewDB db("coinsbench", 64 << 20, true, true);
+    CScript scriptPubKey = GetAccountScript(0);
+    CCoinsMap coins;
+    CAccountTotalsMap totals;
+    for (int i = 0; i < ACCOUNT_COIN_COUNT; ++i) {
+        uint256 txid;
+        *reinterpret_cast<int*>(txid.begin()) = i + 1;
+        Coin coin(CTxOut(COIN, scriptPubKey), i / 10 + 1, false);
+        coin.Refresh();
+        ApplyCoinToAccountTotals(totals, COutPoint(txid, 0), coin, 1);
+        CCoinsCacheEntry& entry = coins[COutPoint(txid, 0)];
+        entry.coin = std::move(coin);
+        entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+    }
+    uint256 hashBlock;
+    *reinterpret_cast<int*>(hashBlock.begin()) = 1;
+    db.BatchWrite(coins, totals, hashBlock);
+    CAccountID accountID = ExtractAccountID(scriptPubKey);
+
+    while (state.KeepRunning()) {
+        CAmount balance = db.GetBalance(accountID, CCoinsMap(), nullptr, nullptr, nullptr, nullptr, ACCOUNT_COIN_COUNT / 20, false);
+        assert(balance == COIN * ACCOUNT_COIN_COUNT / 2);
+    }
+}
+
+BENCHMARK(PledgeBalanceRetarget, 100);
+BENCHMARK(PledgeBalanceTotals, 100 * 1000);
+BENCHMARK(CoinBalanceAtHeight, 10);
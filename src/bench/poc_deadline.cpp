@@ -0,0 +1,72 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <poc/poc.h>
+#include <primitives/block.h>
+
+#include <memory>
+#include <vector>
+
+static const int NONCE_COUNT = 16;
+
+static void BuildPrevBlockIndex(CBlockIndex& prevBlockIndex, const Consensus::Params& params)
+{
+    prevBlockIndex.nHeight = params.BHDIP006Height;
+    prevBlockIndex.nBaseTarget = poc::GetBaseTarget(prevBlockIndex.nHeight, params);
+}
+
+static std::vector<poc::PlotterNonce> GetBenchNonces(const CBlockIndex& prevBlockIndex)
+{
+    std::vector<poc::PlotterNonce> nonces;
+    CBlockHeader block;
+    block.nPlotterId = 1234567890;
+    for (int i = 0; i < NONCE_COUNT; ++i) {
+        block.nNonce = i;
+        nonces.push_back(poc::MakePlotterNonce(prevBlockIndex, block));
+    }
+    return nonces;
+}
+
+// Deadlines of 16 nonces, calculated one after another.
+static void PocDeadlineSingle(benchmark::State& state)
+{
+    const std::unique_ptr<const CChainParams> chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    CBlockIndex prevBlockIndex;
+    BuildPrevBlockIndex(prevBlockIndex, params);
+    CBlockHeader block;
+    block.nPlotterId = 1234567890;
+
+    while (state.KeepRunning()) {
+        for (int i = 0; i < NONCE_COUNT; ++i) {
+            block.nNonce = i;
+            poc::CalculateDeadline(prevBlockIndex, block, params);
+        }
+    }
+}
+
+// Same as above, calculated as one batch.
+static void PocDeadlineBatch(benchmark::State& state)
+{
+    const std::unique_ptr<const CChainParams> chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    CBlockIndex prevBlockIndex;
+    BuildPrevBlockIndex(prevBlockIndex, params);
+    const std::vector<poc::PlotterNonce> nonces = GetBenchNonces(prevBlockIndex);
+    CBlockHeader block;
+    block.nPlotterId = nonces.back().nPlotterId;
+    block.nNonce = nonces.back().nNonce;
+    assert(poc::CalculateDeadlines(MakeSpan(nonces), params).back() == poc::CalculateDeadline(prevBlockIndex, block, params));
+
+    while (state.KeepRunning()) {
+        std::vector<uint64_t> deadlines = poc::CalculateDeadlines(MakeSpan(nonces), params);
+        assert(deadlines.size() == NONCE_COUNT);
+    }
+}
+
+BENCHMARK(PocDeadlineSingle, 1);
+BENCHMARK(PocDeadlineBatch, 1);
@@ -155,35 +155,64 @@ CBlockIndex* CBlockIndex::GetAncestor(int height)
     return const_cast<CBlockIndex*>(static_cast<const CBlockIndex*>(this)->GetAncestor(height));
 }
 
+std::shared_ptr<const chiapos::CBlockFields> CBlockIndex::GetChiaposFields() const
+{
+    static const std::shared_ptr<const chiapos::CBlockFields> pnullFields = std::make_shared<const chiapos::CBlockFields>();
+    if (!IsChiaBlock())
+        return pnullFields;
+    // Released by the flush of the block index without cs_main held by the readers
+    std::shared_ptr<const chiapos::CBlockFields> pfields = std::atomic_load(&pchiaposFields);
+    if (pfields)
+        return pfields;
+    pfields = ReadBlockChiaposFields(GetBlockHash());
+    if (!pfields)
+        throw std::runtime_error(strprintf("%s: cannot read the chiapos fields of block %s", __func__, GetBlockHash().ToString()));
+    return pfields;
+}
+
+CBlockHeader CBlockIndex::GetBlockHeader() const
+{
+    CBlockHeader block;
+    block.nVersion       = nVersion;
+    if (pprev)
+        block.hashPrevBlock = pprev->GetBlockHash();
+    block.hashMerkleRoot = hashMerkleRoot;
+    block.nTime          = nTime;
+    block.nBaseTarget    = nBaseTarget;
+    block.nNonce         = nNonce;
+    block.nPlotterId     = nPlotterId;
+    block.vchPubKey      = vchPubKey;
+    block.vchSignature   = vchSignature;
+    block.chiaposFields  = *GetChiaposFields();
+    return block;
+}
+
 void CBlockIndex::Update(const Consensus::Params& params)
 {
     // Genearation signature
     static uint256 dummyGenerationSignature;
     generationSignature = pprev ? &pprev->nextGenerationSignature : &dummyGenerationSignature;
-    if (nHeight + 1 <= params.BHDIP001PreMiningEndHeight) {
-        //! Pre-Mining not exist generation signature
-        nextGenerationSignature.SetNull();
-    } else if (nHeight + 1 <= params.BHDIP007Height) {
-        //! hashMerkleRoot + nPlotterId. Unsafe
-        // Legacy consensus use little endian
-        uint64_t plotterId = htole64(nPlotterId);
-        CShabal256()
-            .Write(hashMerkleRoot.begin(), hashMerkleRoot.size())
-            .Write((const unsigned char*)&plotterId, 8)
-            .Finalize(nextGenerationSignature.begin());
-    } else if (nHeight + 1 < params.BHDIP009Height) {
-        //! generationSignature + nPlotterId
-        assert(generationSignature != nullptr && !generationSignature->IsNull());
-        uint64_t plotterId = htobe64(nPlotterId);
-        CShabal256()
-            .Write(generationSignature->begin(), generationSignature->size())
-            .Write((const unsigned char*)&plotterId, 8)
-            .Finalize(nextGenerationSignature.begin());
-    }
+    nextGenerationSignature = poc::CalculateNextGenerationSignature(nHeight, *generationSignature, hashMerkleRoot, nPlotterId, params);
 
     // Generator
     if (!vchPubKey.empty())
         generatorAccountID = ExtractAccountID(CPubKey(vchPubKey));
+
+    // Sums of the difficulty evaluation window, the block leaving the window is subtracted
+    if (pprev != nullptr && nHeight >= params.BHDIP009Height) {
+        bool fPrevInWindow = pprev->nHeight >= params.BHDIP009Height;
+        nChiaDifficultySum = (fPrevInWindow ? pprev->nChiaDifficultySum : 0) + chiapos::GetChiaBlockDifficulty(this, params);
+        nChiaNetspaceSum = (fPrevInWindow ? pprev->nChiaNetspaceSum : 0) + chiapos::GetChiaBlockNetworkSpace(this, params);
+        int nLeavingHeight = nHeight - params.BHDIP009DifficultyEvalWindow;
+        if (nLeavingHeight >= params.BHDIP009Height) {
+            const CBlockIndex* pindexLeaving = GetAncestor(nLeavingHeight);
+            nChiaDifficultySum -= chiapos::GetChiaBlockDifficulty(pindexLeaving, params);
+            nChiaNetspaceSum -= chiapos::GetChiaBlockNetworkSpace(pindexLeaving, params);
+        }
+    } else {
+        nChiaDifficultySum = 0;
+        nChiaNetspaceSum = 0;
+    }
 }
 
 void CBlockIndex::BuildSkip()
@@ -15,6 +15,7 @@
 
 #include <chiapos/block_fields.h>
 
+#include <memory>
 #include <vector>
 
 /**
@@ -209,7 +210,27 @@ public:
     //! Generate next block required this value.
     uint256 nextGenerationSignature;
 
-    chiapos::CBlockFields chiaposFields;
+    //! (memory only) Accumulated subsidy up to and including this block, -1 until calculated.
+    //! See GetBlockAccumulateSubsidy()
+    mutable CAmount nAccumulateSubsidy;
+
+    //! (memory only) Sum of chia difficulties of the blocks in the difficulty evaluation window ending with this block
+    arith_uint256 nChiaDifficultySum;
+
+    //! (memory only) Sum of network spaces of the blocks in the difficulty evaluation window ending with this block
+    arith_uint256 nChiaNetspaceSum;
+
+    //! The chia fields read by the consensus, the others are returned by GetChiaposFields()
+    chiapos::CBlockIndexFields chiaposFields;
+
+    //! (memory only) The challenge of the next block, made from the hash and the vdf proof of this chia block
+    uint256 hashNextChallenge;
+
+    //! (memory only) All the chia fields of the header, kept in memory until the block index is flushed
+    std::shared_ptr<const chiapos::CBlockFields> pchiaposFields;
+
+    //! Metrics of a connected chia block, kept in memory until the block index is flushed
+    std::shared_ptr<const chiapos::CBlockMetrics> pchiaMetrics;
 
     void SetNull()
     {
@@ -229,6 +250,10 @@ public:
         nTimeMax = 0;
         generationSignature = nullptr;
         nextGenerationSignature.SetNull();
+        nAccumulateSubsidy = -1;
+        nChiaDifficultySum = 0;
+        nChiaNetspaceSum = 0;
+        hashNextChallenge.SetNull();
 
         nVersion       = 0;
         hashMerkleRoot = uint256();
@@ -240,6 +265,8 @@ public:
         vchSignature.clear();
 
         chiaposFields.SetNull();
+        pchiaposFields.reset();
+        pchiaMetrics.reset();
     }
 
     CBlockIndex()
@@ -264,7 +291,9 @@ public:
         nPlotterId     = block.nPlotterId;
         vchPubKey      = block.vchPubKey;
         vchSignature   = block.vchSignature;
-        chiaposFields  = block.chiaposFields;
+        chiaposFields  = chiapos::CBlockIndexFields(block.chiaposFields);
+        if (!block.chiaposFields.IsNull())
+            pchiaposFields = std::make_shared<const chiapos::CBlockFields>(block.chiaposFields);
     }
 
     FlatFilePos GetBlockPos() const {
@@ -285,22 +314,13 @@ public:
         return ret;
     }
 
-    CBlockHeader GetBlockHeader() const
-    {
-        CBlockHeader block;
-        block.nVersion       = nVersion;
-        if (pprev)
-            block.hashPrevBlock = pprev->GetBlockHash();
-        block.hashMerkleRoot = hashMerkleRoot;
-        block.nTime          = nTime;
-        block.nBaseTarget    = nBaseTarget;
-        block.nNonce         = nNonce;
-        block.nPlotterId     = nPlotterId;
-        block.vchPubKey      = vchPubKey;
-        block.vchSignature   = vchSignature;
-        block.chiaposFields  = chiaposFields;
-        return block;
-    }
+    /**
+     * All the chia fields of the block, null fields for the blocks before chiapos. They are read from the
+     * block tree db once the block index is flushed, throws std::runtime_error when they cannot be read.
+     */
+    std::shared_ptr<const chiapos::CBlockFields> GetChiaposFields() const;
+
+    CBlockHeader GetBlockHeader() const;
 
     uint256 GetBlockHash() const
     {
@@ -403,32 +423,86 @@ int64_t GetBlockProofEquivalentTime(const CBlockIndex& to, const CBlockIndex& fr
 const CBlockIndex* LastCommonAncestor(const CBlockIndex* pa, const CBlockIndex* pb);
 
 
+/**
+ * Flag of the version written with a block index record, the full generator account is appended to the record.
+ * The former versions read the flag as a part of the version and skip the appended field, the records they write
+ * again have neither of them.
+ */
+static const int SERIALIZE_BLOCK_INDEX_GENERATOR = 0x20000000;
+
+/** The serialized chia fields at the end of a block index record, they are copied without being decoded */
+class CChiaposFieldsRecord
+{
+    std::vector<unsigned char>& vch;
+    //! Size of the fields appended after the chia fields
+    size_t nTrailingSize;
+
+public:
+    CChiaposFieldsRecord(std::vector<unsigned char>& vchIn, size_t nTrailingSizeIn) : vch(vchIn), nTrailingSize(nTrailingSizeIn) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        s.write((const char*)vch.data(), vch.size());
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        // The fields are followed by the appended fields only
+        if (s.size() < nTrailingSize)
+            throw std::ios_base::failure("CChiaposFieldsRecord: record too short");
+        vch.resize(s.size() - nTrailingSize);
+        s.read((char*)vch.data(), vch.size());
+    }
+};
+
 /** Used to marshal pointers into hashes for db storage. */
 class CDiskBlockIndex : public CBlockIndex
 {
 public:
     uint256 hashPrev;
     bool fChiapos;
+    //! The chia fields stored with the index, CBlockIndex keeps a part of them in memory
+    chiapos::CBlockFields fullChiaposFields;
+    //! The chia fields are read and written as the bytes of vchChiaposFieldsRecord rather than fullChiaposFields
+    bool fChiaposFieldsRecord;
+    std::vector<unsigned char> vchChiaposFieldsRecord;
+    //! The full generator account was read from the record, the former versions only store its low 64 bits
+    bool fHaveGenerator;
 
     CDiskBlockIndex() {
         hashPrev = uint256();
         fChiapos = false;
+        fChiaposFieldsRecord = false;
+        fHaveGenerator = false;
     }
 
-    explicit CDiskBlockIndex(const CBlockIndex* pindex, bool fInChiapos) : CBlockIndex(*pindex), fChiapos(fInChiapos) {
+    explicit CDiskBlockIndex(const CBlockIndex* pindex, bool fInChiapos) : CBlockIndex(*pindex), fChiapos(fInChiapos), fChiaposFieldsRecord(false), fHaveGenerator(false) {
         hashPrev = (pprev ? pprev->GetBlockHash() : uint256());
         if (fChiapos) {
             nStatus |= BLOCK_CHIAPOS;
         }
+        if (pindex->IsChiaBlock()) {
+            // The fields released by the flush of the block index are copied from the record on disk by the writer
+            if (pchiaposFields) {
+                fullChiaposFields = *pchiaposFields;
+            } else {
+                fChiaposFieldsRecord = true;
+            }
+        }
     }
 
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
-        int _nVersion = s.GetVersion();
-        if (!(s.GetType() & SER_GETHASH))
+        int _nVersion = s.GetVersion() & ~SERIALIZE_BLOCK_INDEX_GENERATOR;
+        if (!(s.GetType() & SER_GETHASH)) {
+            // The generator which cannot be derived from the public key
+            if (!ser_action.ForRead() && vchPubKey.empty() && !generatorAccountID.IsNull())
+                _nVersion |= SERIALIZE_BLOCK_INDEX_GENERATOR;
             READWRITE(VARINT(_nVersion, VarIntMode::NONNEGATIVE_SIGNED));
+        }
+        const bool fAppendGenerator = _nVersion & SERIALIZE_BLOCK_INDEX_GENERATOR;
 
         READWRITE(VARINT(nHeight, VarIntMode::NONNEGATIVE_SIGNED));
         READWRITE(VARINT(nStatus));
@@ -451,7 +525,11 @@ public:
         READWRITE(nTime);
 
         if (fChiapos) {
-            READWRITE(chiaposFields);
+            if (fChiaposFieldsRecord) {
+                READWRITE(CChiaposFieldsRecord(vchChiaposFieldsRecord, fAppendGenerator ? sizeof(CAccountID) : 0));
+            } else {
+                READWRITE(fullChiaposFields);
+            }
         } else {
             READWRITE(nBaseTarget);
             READWRITE(nNonce);
@@ -461,6 +539,12 @@ public:
                 READWRITE(LIMITED_VECTOR(vchSignature, CPubKey::SIGNATURE_SIZE));
             }
         }
+
+        if (fAppendGenerator) {
+            READWRITE(generatorAccountID);
+            if (ser_action.ForRead())
+                fHaveGenerator = true;
+        }
     }
 
     uint256 GetBlockHash() const
@@ -475,7 +559,7 @@ public:
         block.nPlotterId      = nPlotterId;
         block.vchPubKey       = vchPubKey;
         block.vchSignature    = vchSignature;
-        block.chiaposFields   = chiaposFields;
+        block.chiaposFields   = fullChiaposFields;
         return block.GetHash();
     }
 
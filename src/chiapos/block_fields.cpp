@@ -44,4 +44,25 @@ bool CBlockFields::IsNull() const {
     return nDifficulty == 0 && posProof.IsNull() && vdfProof.IsNull() && vchFarmerSignature.empty();
 }
 
+CBlockIndexFields::CBlockIndexFields(CBlockFields const& fields)
+    : nDifficulty(fields.nDifficulty),
+      challenge(fields.posProof.challenge),
+      nPlotK(fields.posProof.nPlotK),
+      nVdfIters(fields.vdfProof.nVdfIters),
+      nVdfDuration(fields.vdfProof.nVdfDuration),
+      vchFarmerPk(fields.posProof.vchFarmerPk) {}
+
+void CBlockIndexFields::SetNull() {
+    nDifficulty = 0;
+    challenge.SetNull();
+    nPlotK = 0;
+    nVdfIters = 0;
+    nVdfDuration = 0;
+    vchFarmerPk.clear();
+}
+
+bool CBlockIndexFields::IsNull() const {
+    return nDifficulty == 0 && challenge.IsNull() && nPlotK == 0 && nVdfIters == 0 && nVdfDuration == 0 && vchFarmerPk.empty();
+}
+
 }  // namespace chiapos
@@ -1,6 +1,7 @@
 #ifndef BTCHD_CHIAPOS_BLOCK_FIELDS_H
 #define BTCHD_CHIAPOS_BLOCK_FIELDS_H
 
+#include <amount.h>
 #include <chiapos/kernel/bls_key.h>
 #include <chiapos/kernel/chiapos_types.h>
 #include <serialize.h>
@@ -118,6 +119,61 @@ public:
     }
 };
 
+/**
+ * The fields of a chia block which are kept in the block index, they are what the consensus reads of every block.
+ * The proofs and the signature are read from the block tree db when they are needed, see CBlockIndex::GetChiaposFields()
+ */
+class CBlockIndexFields {
+public:
+    uint64_t nDifficulty;
+    uint256 challenge;  // The challenge for PoS
+    uint8_t nPlotK;     // The size of the plot
+    uint64_t nVdfIters;
+    uint64_t nVdfDuration;
+    Bytes vchFarmerPk;
+
+    CBlockIndexFields() { SetNull(); }
+
+    explicit CBlockIndexFields(CBlockFields const& fields);
+
+    void SetNull();
+
+    bool IsNull() const;
+
+    uint64_t GetTotalIters() const {
+        return nVdfIters;
+    }
+
+    uint64_t GetTotalDuration() const {
+        return nVdfDuration;
+    }
+};
+
+/** The metrics of a chia block, they are computed once when the block is connected */
+class CBlockMetrics {
+public:
+    uint64_t nRequiredIters{0};        // The vdf iterations required by the quality of the PoS
+    uint256 mixedQualityString;        // The quality of the PoS
+    uint256 challenge;                 // The challenge for the next block
+    uint64_t nChallengeDifficulty{0};  // The difficulty for the next block
+    uint64_t nNetspace{0};             // The network space estimated from the vdf iterations
+    int64_t nBlockDuration{0};         // The seconds since the previous block
+    CAmount nCoinbaseReward{0};        // The reward paid to the miner by the coinbase
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(VARINT(nRequiredIters));
+        READWRITE(mixedQualityString);
+        READWRITE(challenge);
+        READWRITE(VARINT(nChallengeDifficulty));
+        READWRITE(VARINT(nNetspace));
+        READWRITE(VARINT(nBlockDuration, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(nCoinbaseReward, VarIntMode::NONNEGATIVE_SIGNED));
+    }
+};
+
 }  // namespace chiapos
 
 #endif
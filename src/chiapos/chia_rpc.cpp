@@ -1,4 +1,5 @@
 #include <chainparams.h>
+#include <httpserver.h>
 #include <key_io.h>
 #include <miner.h>
 #include <net.h>
@@ -6,11 +7,17 @@
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <util/strencodings.h>
+#include <util/system.h>
+#include <util/validation.h>
 #include <validation.h>
+#include <validationinterface.h>
 #include <subsidy_utils.h>
 #include <core_io.h>
+#include <index/pledgeindex.h>
 
+#include <atomic>
 #include <cstdint>
+#include <limits>
 #include <stdexcept>
 
 #include "chiapos/kernel/bls_key.h"
@@ -30,6 +37,9 @@ extern std::unique_ptr<CConnman> g_connman;
 
 namespace chiapos {
 
+static int const DEFAULT_WAIT_CHALLENGE_TIMEOUT = 10;
+static int const MAX_WAIT_CHALLENGE_TIMEOUT = 30;
+
 namespace utils {
 
 std::shared_ptr<CBlock> CreateFakeBlock(CTxDestination const& dest) {
@@ -62,16 +72,16 @@ static UniValue checkChiapos(JSONRPCRequest const& request) {
     return IsTheChainReadyForChiapos(pindexPrev, params);
 }
 
-static UniValue queryChallenge(JSONRPCRequest const& request) {
-    RPCHelpMan("querychallenge", "Query next challenge for PoST", {},
-               RPCResult{"\"challenge\" (hex) the challenge in hex string"},
-               RPCExamples{HelpExampleCli("querychallenge", "")})
-            .Check(request);
-
-    LOCK(cs_main);
+static int ParseNonNegativeParam(UniValue const& param, char const* name) {
+    int nValue;
+    if (!ParseInt32(param.isNum() ? param.getValStr() : param.get_str(), &nValue) || nValue < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, tinyformat::format("invalid %s", name));
+    }
+    return nValue;
+}
 
-    CBlockIndex const* pindexPrev = ChainActive().Tip();
-    Consensus::Params const& params = Params().GetConsensus();
+static UniValue MakeChallengeObject(CBlockIndex const* pindexPrev, Consensus::Params const& params) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+    AssertLockHeld(cs_main);
 
     if (!IsTheChainReadyForChiapos(pindexPrev, params)) {
         throw std::runtime_error("chiapos is not ready");
@@ -89,10 +99,10 @@ static UniValue queryChallenge(JSONRPCRequest const& request) {
         res.pushKV("prev_vdf_duration", params.BHDIP008TargetSpacing);
     } else {
         // We need to read the challenge from last block
-        challenge = MakeChallenge(pindexPrev->GetBlockHash(), pindexPrev->chiaposFields.vdfProof.vchProof);
+        challenge = MakeChallenge(pindexPrev, params);
         res.pushKV("challenge", challenge.GetHex());
-        res.pushKV("prev_vdf_iters", pindexPrev->chiaposFields.vdfProof.nVdfIters);
-        res.pushKV("prev_vdf_duration", pindexPrev->chiaposFields.vdfProof.nVdfDuration);
+        res.pushKV("prev_vdf_iters", pindexPrev->chiaposFields.nVdfIters);
+        res.pushKV("prev_vdf_duration", pindexPrev->chiaposFields.nVdfDuration);
     }
     assert(!challenge.IsNull());
     res.pushKV("prev_block_hash", pindexPrev->GetBlockHash().GetHex());
@@ -133,6 +143,88 @@ static UniValue queryChallenge(JSONRPCRequest const& request) {
     return res;
 }
 
+static UniValue queryChallenge(JSONRPCRequest const& request) {
+    RPCHelpMan("querychallenge", "Query next challenge for PoST", {},
+               RPCResult{"\"challenge\" (hex) the challenge in hex string"},
+               RPCExamples{HelpExampleCli("querychallenge", "")})
+            .Check(request);
+
+    LOCK(cs_main);
+    return MakeChallengeObject(ChainActive().Tip(), Params().GetConsensus());
+}
+
+static std::atomic<int> g_nChallengeWaiters{0};
+
+/** A place of a waitchallenge call, at most half of the RPC workers wait for the challenge at once */
+class ChallengeWaiterSlot {
+public:
+    ChallengeWaiterSlot() {
+        int nMaxWaiters = std::max<int64_t>(gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1) / 2;
+        m_fAcquired = ++g_nChallengeWaiters <= nMaxWaiters;
+    }
+
+    ~ChallengeWaiterSlot() { --g_nChallengeWaiters; }
+
+    bool IsAcquired() const { return m_fAcquired; }
+
+private:
+    bool m_fAcquired;
+};
+
+static UniValue waitChallenge(JSONRPCRequest const& request) {
+    RPCHelpMan("waitchallenge", "Wait until the challenge is changed or new vdf proofs of the challenge arrive, the miners use it instead of polling querychallenge",
+               {
+                   {"challenge", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The challenge known by the miner"},
+                   {"vdf_proofs", RPCArg::Type::NUM, /* default */ "0", "The number of the vdf proofs of the challenge known by the miner"},
+                   {"timeout", RPCArg::Type::NUM, /* default */ strprintf("%d", DEFAULT_WAIT_CHALLENGE_TIMEOUT), strprintf("Seconds to wait, at most %d", MAX_WAIT_CHALLENGE_TIMEOUT)},
+               },
+               RPCResult{"\"{json}\" the current challenge as querychallenge returns, it is returned on timeout as well"},
+               RPCExamples{HelpExampleCli("waitchallenge", "xxxxxxxx 0 10")})
+            .Check(request);
+
+    // Each waiting call holds an RPC worker, the miners above the limit are told to query the challenge instead
+    ChallengeWaiterSlot slot;
+    if (!slot.IsAcquired()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "too many miners are waiting for the challenge, use querychallenge");
+    }
+
+    uint256 knownChallenge = ParseHashV(request.params[0], "challenge");
+    size_t nKnownVdfProofs{0};
+    if (request.params.size() > 1 && !request.params[1].isNull()) {
+        nKnownVdfProofs = ParseNonNegativeParam(request.params[1], "vdf_proofs");
+    }
+    int nTimeout = DEFAULT_WAIT_CHALLENGE_TIMEOUT;
+    if (request.params.size() > 2 && !request.params[2].isNull()) {
+        nTimeout = std::min(ParseNonNegativeParam(request.params[2], "timeout"), MAX_WAIT_CHALLENGE_TIMEOUT);
+    }
+    Consensus::Params const& params = Params().GetConsensus();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(nTimeout);
+    while (IsRPCRunning()) {
+        // Take the sequence before checking, an update in between wakes the wait immediately
+        uint64_t nSequence = GetChallengeUpdateSequence();
+        {
+            LOCK(cs_main);
+            CBlockIndex const* pindexPrev = ChainActive().Tip();
+            if (!IsTheChainReadyForChiapos(pindexPrev, params)) {
+                throw std::runtime_error("chiapos is not ready");
+            }
+            if (MakeChallenge(pindexPrev, params) != knownChallenge) {
+                break;
+            }
+        }
+        if (QueryLocalVdfProof(knownChallenge).size() > nKnownVdfProofs) {
+            break;
+        }
+        if (!WaitForChallengeUpdate(nSequence, deadline)) {
+            break;
+        }
+    }
+
+    LOCK(cs_main);
+    return MakeChallengeObject(ChainActive().Tip(), params);
+}
+
 static UniValue submitVdfRequest(JSONRPCRequest const& request) {
     RPCHelpMan("submitvdfrequest", "Submit vdf request to P2P network",
         {
@@ -149,7 +241,6 @@ static UniValue submitVdfRequest(JSONRPCRequest const& request) {
         throw std::runtime_error(tinyformat::format("%s: invalid iters=(%d)", __func__, nIters));
     }
 
-    LOCK(cs_main);
     AddLocalVdfRequest(challenge, nIters);
 
     // send the request to P2P network
@@ -195,11 +286,11 @@ static UniValue submitVdfProof(JSONRPCRequest const& request) {
         throw std::runtime_error(tinyformat::format("%s: the vdf proof (challenge=%s, proof=%s) is invalid", __func__, vdfProof.challenge.GetHex(), BytesToHex(vdfProof.vchProof)));
     }
 
-    LOCK(cs_main);
-
     // save the proof
     if (!AddLocalVdfProof(vdfProof)) {
         LogPrint(BCLog::POC, "%s: warning - proof (challenge=%s, iters=%ld) does exist in local\n", __func__, vdfProof.challenge.GetHex(), vdfProof.nVdfIters);
+    } else {
+        GetMainSignals().NewVdfProof(std::make_shared<const CVdfProof>(vdfProof));
     }
 
     // dispatch the message to P2P network
@@ -224,12 +315,36 @@ CVdfProof ParseVdfProof(UniValue const& val) {
     return proof;
 }
 
+/** Check if the released block is unknown or failed to connect, ProcessNewBlock doesn't tell the latter */
+static bool IsReleasedBlockRejected(uint256 const& hash) {
+    LOCK(cs_main);
+    CBlockIndex const* pindex = LookupBlockIndex(hash);
+    return pindex == nullptr || (pindex->nStatus & BLOCK_FAILED_MASK) != 0;
+}
+
 void GenerateChiaBlock(uint256 const& hashPrevBlock, int nHeightOfPrevBlock, CTxDestination const& rewardDest,
                        uint256 const& initialChallenge, chiapos::Bytes const& vchFarmerSk, CPosProof const& posProof,
                        CVdfProof const& vdfProof, uint64_t nDifficulty) {
+    int64_t nTimeStart = GetTimeMicros();
     CKey farmerSk(MakeArray<SK_LEN>(vchFarmerSk));
     auto params = Params();
+
+    // The proofs are verified once here, the validation of the released block finds them memoized by their hash
+    {
+        CBlockFields fields;
+        fields.posProof = posProof;
+        fields.vdfProof = vdfProof;
+        CValidationState state;
+        if (!VerifyLocalChiaProofs(fields, nHeightOfPrevBlock + 1, params.GetConsensus(), state)) {
+            throw std::runtime_error(strprintf("the proofs cannot be verified: %s", FormatStateMessage(state)));
+        }
+    }
+    int64_t nTimeVerified = GetTimeMicros();
+
     std::shared_ptr<CBlock> pblock;
+    bool fWarm{false};
+    CScript scriptPubKey = GetScriptForDestination(rewardDest);
+    int64_t nTime1;
     {
         LOCK(cs_main);
 
@@ -247,7 +362,8 @@ void GenerateChiaBlock(uint256 const& hashPrevBlock, int nHeightOfPrevBlock, CTx
         }
 
         CBlockIndex* pindexCurr = ::ChainActive().Tip();
-        if (pindexPrev->GetBlockHash() != pindexCurr->GetBlockHash()) {
+        bool fReorg = pindexPrev->GetBlockHash() != pindexCurr->GetBlockHash();
+        if (fReorg) {
             // The chain has changed during the proofs generation, we need to ensure:
             // 1. The new block is able to connect to the pevious block
             // 2. The difficulty of the new proofs should be larger than the last block's difficulty on the chain
@@ -301,18 +417,68 @@ void GenerateChiaBlock(uint256 const& hashPrevBlock, int nHeightOfPrevBlock, CTx
         // Trying to release a new block
         PubKeyOrHash poolPkOrHash =
                 MakePubKeyOrHash(static_cast<PlotPubKeyType>(posProof.nPlotType), posProof.vchPoolPkOrHash);
-        std::unique_ptr<CBlockTemplate> ptemplate = BlockAssembler(params).CreateNewChiaBlock(
-                pindexPrev, GetScriptForDestination(rewardDest), farmerSk, posProof, vdfProof);
+        std::unique_ptr<CBlockTemplate> ptemplate;
+        if (g_chia_template_cache) {
+            ptemplate = g_chia_template_cache->Take(pindexPrev, scriptPubKey, MakeBytes(farmerSk.GetPubKey()));
+        }
+        if (ptemplate && !fReorg) {
+            // The template is assembled in advance and the block is validated when it is processed
+            fWarm = true;
+            BlockAssembler::FillChiaBlock(ptemplate->block, pindexPrev, farmerSk, posProof, vdfProof, params.GetConsensus());
+        } else {
+            ptemplate = BlockAssembler(params).CreateNewChiaBlock(pindexPrev, scriptPubKey, farmerSk, posProof, vdfProof);
+        }
         if (ptemplate == nullptr) {
             throw std::runtime_error("cannot generate new block, the template object is null");
         }
         pblock.reset(new CBlock(ptemplate->block));
+        nTime1 = GetTimeMicros();
     }
 
     if (pblock == nullptr) {
         throw std::runtime_error("pblock is null, cannot release new block");
     }
     ReleaseBlock(pblock, params);
+    if (fWarm && IsReleasedBlockRejected(pblock->GetHash())) {
+        // The warm template skipped TestBlockValidity, assemble the block again the usual way
+        LogPrintf("%s: the block from the warm template is rejected, assemble a new one\n", __func__);
+        {
+            LOCK(cs_main);
+            CBlockIndex const* pindexPrev = ::ChainActive().Tip();
+            if (pindexPrev->GetBlockHash() != hashPrevBlock) {
+                throw std::runtime_error("the block is rejected and the chain has been changed");
+            }
+            std::unique_ptr<CBlockTemplate> ptemplate =
+                    BlockAssembler(params).CreateNewChiaBlock(pindexPrev, scriptPubKey, farmerSk, posProof, vdfProof);
+            if (ptemplate == nullptr) {
+                throw std::runtime_error("cannot generate new block, the template object is null");
+            }
+            pblock.reset(new CBlock(ptemplate->block));
+        }
+        ReleaseBlock(pblock, params);
+    }
+    int64_t nTime2 = GetTimeMicros();
+    LogPrint(BCLog::BENCH, "%s: %s template, verify proofs: %.2fms, assemble: %.2fms, release: %.2fms (total %.2fms)\n", __func__,
+             fWarm ? "warm" : "cold", 0.001 * (nTimeVerified - nTimeStart), 0.001 * (nTime1 - nTimeVerified),
+             0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
+}
+
+static UniValue queryVdfCacheInfo(JSONRPCRequest const& request) {
+    RPCHelpMan("queryvdfcacheinfo", "Query the statistics of the verified vdf proof cache", {},
+               RPCResult{"{\n"
+                         "  \"hits\": xxxxx,      (numeric) Count of the proofs found in the cache\n"
+                         "  \"misses\": xxxxx,    (numeric) Count of the proofs which are verified\n"
+                         "}\n"},
+               RPCExamples{HelpExampleCli("queryvdfcacheinfo", "")})
+            .Check(request);
+
+    uint64_t nHits, nMisses;
+    GetVdfProofCacheStats(nHits, nMisses);
+
+    UniValue res(UniValue::VOBJ);
+    res.pushKV("hits", nHits);
+    res.pushKV("misses", nMisses);
+    return res;
 }
 
 static UniValue submitProof(JSONRPCRequest const& request) {
@@ -474,14 +640,14 @@ static UniValue queryMiningRequirement(JSONRPCRequest const& request) {
     while (pcurrIndex && pcurrIndex->nHeight >= params.BHDIP009Height && count < params.nCapacityEvalWindow) {
         // check fpk from the block
         for (auto const& fpk : fpks) {
-            if (fpk.GetChiaFarmerPk().ToBytes() == pcurrIndex->chiaposFields.posProof.vchFarmerPk) {
+            if (fpk.GetChiaFarmerPk().ToBytes() == pcurrIndex->chiaposFields.vchFarmerPk) {
                 // Now we export the block to UniValue and push it to array
                 UniValue blkVal(UniValue::VOBJ);
                 auto dest = CTxDestination(static_cast<ScriptHash>(pcurrIndex->generatorAccountID));
                 std::string accountIDStr = EncodeDestination(dest);
                 blkVal.pushKV("height", pcurrIndex->nHeight);
                 blkVal.pushKV("hash", pcurrIndex->GetBlockHash().GetHex());
-                blkVal.pushKV("fpk", chiapos::BytesToHex(pcurrIndex->chiaposFields.posProof.vchFarmerPk));
+                blkVal.pushKV("fpk", chiapos::BytesToHex(pcurrIndex->chiaposFields.vchFarmerPk));
                 blkVal.pushKV("accountID", accountIDStr);
                 blks.push_back(blkVal);
                 break;
@@ -834,7 +1000,8 @@ static UniValue dumpPosProofs(JSONRPCRequest const& request) {
 
     UniValue res(UniValue::VARR);
     for (int i = 0; i < nNumBlocks; ++i) {
-        UniValue proofVal = dumpPosProof(pindex->chiaposFields.posProof, pindex->chiaposFields.vdfProof, pindex->nHeight);
+        auto pfields = pindex->GetChiaposFields();
+        UniValue proofVal = dumpPosProof(pfields->posProof, pfields->vdfProof, pindex->nHeight);
         res.push_back(std::move(proofVal));
         pindex = pindex->pprev;
         if (pindex == nullptr) {
@@ -844,22 +1011,6 @@ static UniValue dumpPosProofs(JSONRPCRequest const& request) {
     return res;
 }
 
-struct PledgeTx {
-    uint256 blockHash;
-    int nHeight;
-    uint256 txHash;
-    CAccountID sender;
-    CAccountID receiver;
-    CAmount nReceivedAmount;
-    CAmount nActualAmount;
-    DatacarrierType pledgeType;
-    DatacarrierType pointType;
-    int nPointHeight;
-    int nExpiresOnHeight;
-    bool fAvailable;
-    bool fInTerm;
-};
-
 using PledgeTxSet = std::map<uint256, PledgeTx>;
 
 std::string GetStrFromAccountID(CAccountID const& accountID) {
@@ -885,95 +1036,32 @@ UniValue ConvertPledgeTxToUniValue(PledgeTx const& pledgeTx) {
     return resVal;
 }
 
-bool IsPledgeTx(PledgeTxSet const& txs, uint256 const& txHash) {
-    return txs.find(txHash) != std::cend(txs);
-}
+/** The pledge txs stripped from the blocks of the active chain when the pledge index is disabled */
+class PledgeTxSetView : public PledgeTxView {
+public:
+    explicit PledgeTxSetView(PledgeTxSet& txs) : m_txs(txs) {}
 
-void MarkPledgeToUnavailable(PledgeTxSet& txs, uint256 const& txHashToMark, uint256 const& txHashCurr) {
-    auto it = txs.find(txHashToMark);
-    if (it == std::cend(txs)) {
-        // cannot find the prevous tx, throw error
-        throw std::runtime_error(tinyformat::format("previous tx(%s) cannot be found from retarget tx(%s)", txHashToMark.GetHex(), txHashCurr.GetHex()));
+    bool GetPledgeTx(uint256 const& txHash, PledgeTx& pledgeTx) override {
+        auto it = m_txs.find(txHash);
+        if (it == std::cend(m_txs)) {
+            return false;
+        }
+        pledgeTx = it->second;
+        return true;
     }
-    it->second.fAvailable = false;
-}
 
-bool GetPledgeTx(PledgeTxSet const& txs, uint256 const& txHash, PledgeTx& outPledgeTx) {
-    auto it = txs.find(txHash);
-    if (it == std::cend(txs)) {
-        return false;
+    void AddPledgeTx(PledgeTx pledgeTx) override {
+        uint256 txHash = pledgeTx.txHash;
+        m_txs[txHash] = std::move(pledgeTx);
     }
-    outPledgeTx = it->second;
-    return true;
-}
 
-static void StripPledgeTx(PledgeTxSet& pledgeTxs, CBlock const& block, int nHeight, Consensus::Params const& params) {
-    for (auto const& tx : block.vtx) {
-        if (tx->IsCoinBase() || !tx->IsUniform()) {
-            continue;
-        }
-        // TODO check if the type of the tx is a withdraw then mark it to unavailable
-        auto ppayload = ExtractTransactionDatacarrier(*tx, nHeight, {DATACARRIER_TYPE_BINDCHIAFARMER, DATACARRIER_TYPE_CHIA_POINT, DATACARRIER_TYPE_CHIA_POINT_TERM_1, DATACARRIER_TYPE_CHIA_POINT_TERM_2, DATACARRIER_TYPE_CHIA_POINT_TERM_3, DATACARRIER_TYPE_CHIA_POINT_RETARGET});
-        if (ppayload == nullptr) {
-            if (IsPledgeTx(pledgeTxs, tx->vin[0].prevout.hash)) {
-                MarkPledgeToUnavailable(pledgeTxs, tx->vin[0].prevout.hash, tx->GetHash());
-            }
-        } else {
-            assert(tx->vout.size() >= 2);
-            PledgeTx pledgeTx;
-            pledgeTx.blockHash = block.GetHash();
-            pledgeTx.nHeight = nHeight;
-            pledgeTx.txHash = tx->GetHash();
-            // account IDs
-            pledgeTx.sender = ExtractAccountID(tx->vout[0].scriptPubKey);
-            pledgeTx.pledgeType = ppayload->type;
-            pledgeTx.fAvailable = true;
-            if (ppayload->type == DATACARRIER_TYPE_BINDCHIAFARMER) {
-                pledgeTx.receiver = pledgeTx.sender;
-                pledgeTx.nReceivedAmount = tx->vout[0].nValue;
-                pledgeTx.nActualAmount = 0;
-                pledgeTx.pointType = DATACARRIER_TYPE_BINDCHIAFARMER;
-                pledgeTx.nPointHeight = 0;
-                pledgeTx.nExpiresOnHeight = 99999999;
-                pledgeTx.fInTerm = false;
-            } else {
-                if (ppayload->type == DATACARRIER_TYPE_CHIA_POINT_RETARGET) {
-                    // TODO find the previous tx and mark it to unavailable
-                    auto retargetPayload = PointRetargetPayload::As(ppayload);
-                    pledgeTx.pointType = retargetPayload->GetPointType();
-                    pledgeTx.nPointHeight = retargetPayload->nPointHeight;
-                    auto txHash = tx->vin[0].prevout.hash;
-                    PledgeTx originalPledgeTx;
-                    if (!GetPledgeTx(pledgeTxs, txHash, originalPledgeTx)) {
-                        throw std::runtime_error(tinyformat::format("cannot find original pledge-tx(%s)", txHash.GetHex()));
-                    }
-                    pledgeTx.nReceivedAmount = originalPledgeTx.nReceivedAmount;
-                    MarkPledgeToUnavailable(pledgeTxs, txHash, tx->GetHash());
-                } else {
-                    // point
-                    auto pointPayload = PointPayload::As(ppayload);
-                    pledgeTx.receiver = pointPayload->GetReceiverID();
-                    pledgeTx.nReceivedAmount = tx->vout[0].nValue;
-                    pledgeTx.pointType = pledgeTx.pledgeType;
-                    pledgeTx.nPointHeight = nHeight;
-                }
-                // check if it's state is in-term
-                int nTermIndex = pledgeTx.pointType - DATACARRIER_TYPE_CHIA_POINT;
-                auto const& term = params.BHDIP009PledgeTerms[nTermIndex];
-                int nExpiresOnHeight = pledgeTx.nPointHeight + term.nLockHeight;
-                pledgeTx.fInTerm = nHeight < nExpiresOnHeight;
-                if (pledgeTx.fInTerm) {
-                    pledgeTx.nActualAmount = term.nWeightPercent * pledgeTx.nReceivedAmount / 100;
-                } else {
-                    pledgeTx.nActualAmount = params.BHDIP009PledgeTerms[0].nWeightPercent * pledgeTx.nReceivedAmount / 100;
-                }
-                pledgeTx.nExpiresOnHeight = nExpiresOnHeight;
-            }
-            // save
-            pledgeTxs[pledgeTx.txHash] = std::move(pledgeTx);
-        }
+    void SpendPledgeTx(PledgeTx const& pledgeTx, uint256 const& spentByTxHash, int nSpentHeight) override {
+        m_txs[pledgeTx.txHash].fAvailable = false;
     }
-}
+
+private:
+    PledgeTxSet& m_txs;
+};
 
 struct Amounts {
     CAmount received;
@@ -981,17 +1069,64 @@ struct Amounts {
 };
 
 static UniValue queryChainPledgeInfo(JSONRPCRequest const& request) {
+    RPCHelpMan("querychainpledgeinfo", "Query the pledge txs of the chain, they are read from the pledge index when -pledgeindex is enabled and synced",
+               {
+                   {"start_height", RPCArg::Type::NUM, /* default */ "BHDIP009 height", "Only the pledge txs from the height"},
+                   {"end_height", RPCArg::Type::NUM, /* default */ "tip height", "Only the pledge txs to the height"},
+                   {"account", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Only the pledge txs sent or received by the address"},
+               },
+               RPCResult("\"{json}\" the summary, the amounts of the receivers and the pledge txs"),
+               RPCExamples(HelpExampleCli("querychainpledgeinfo", "") + HelpExampleCli("querychainpledgeinfo", "200000 210000 xxxxxx")))
+            .Check(request);
+
     auto params = ::Params().GetConsensus();
-    LOCK(cs_main);
+
+    int nStartHeight = params.BHDIP009Height;
+    int nEndHeight = std::numeric_limits<int>::max();
+    if (request.params.size() > 0 && !request.params[0].isNull()) {
+        nStartHeight = std::max(ParseNonNegativeParam(request.params[0], "start_height"), params.BHDIP009Height);
+    }
+    if (request.params.size() > 1 && !request.params[1].isNull()) {
+        nEndHeight = ParseNonNegativeParam(request.params[1], "end_height");
+    }
+    optional<CAccountID> accountID;
+    if (request.params.size() > 2 && !request.params[2].isNull()) {
+        CTxDestination dest = DecodeDestination(request.params[2].get_str());
+        if (!IsValidDestination(dest)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+        }
+        accountID = ExtractAccountID(dest);
+    }
 
     PledgeTxSet pledgeTxs;
-    for (int nHeight = params.BHDIP009Height; nHeight < ::ChainActive().Height(); ++nHeight) {
-        auto pindex = ::ChainActive()[nHeight];
-        CBlock block;
-        if (!ReadBlockFromDisk(block, pindex, params)) {
-            throw std::runtime_error(tinyformat::format("cannot read block(%s) from disk", pindex->GetBlockHash().GetHex()));
+    // The chain is scanned while the pledge index is still syncing, it only has a part of the pledge txs
+    if (g_pledgeindex && g_pledgeindex->BlockUntilSyncedToCurrentChain()) {
+        std::vector<PledgeTx> vPledgeTxs;
+        if (!g_pledgeindex->FindPledgeTxs(nStartHeight, nEndHeight, accountID ? &*accountID : nullptr, vPledgeTxs)) {
+            throw JSONRPCError(RPC_DATABASE_ERROR, "cannot read the pledge txs from the pledge index");
+        }
+        for (auto& pledgeTx : vPledgeTxs) {
+            uint256 txHash = pledgeTx.txHash;
+            pledgeTxs[txHash] = std::move(pledgeTx);
+        }
+    } else {
+        // The whole chain is stripped, the retargets and the withdraws refer to the earlier pledge txs
+        LOCK(cs_main);
+        PledgeTxSetView view(pledgeTxs);
+        for (int nHeight = params.BHDIP009Height; nHeight <= ::ChainActive().Height(); ++nHeight) {
+            auto pindex = ::ChainActive()[nHeight];
+            CBlock block;
+            if (!ReadBlockFromDisk(block, pindex, params)) {
+                throw std::runtime_error(tinyformat::format("cannot read block(%s) from disk", pindex->GetBlockHash().GetHex()));
+            }
+            StripPledgeTxs(view, block, nHeight, params);
+        }
+        for (auto it = pledgeTxs.begin(); it != pledgeTxs.end();) {
+            PledgeTx const& pledgeTx = it->second;
+            bool fMatch = pledgeTx.nHeight >= nStartHeight && pledgeTx.nHeight <= nEndHeight &&
+                          (!accountID || pledgeTx.sender == *accountID || pledgeTx.receiver == *accountID);
+            it = fMatch ? std::next(it) : pledgeTxs.erase(it);
         }
-        StripPledgeTx(pledgeTxs, block, nHeight, params);
     }
 
     std::map<CAccountID, Amounts> accountIDAmount;
@@ -1252,6 +1387,7 @@ UniValue burntxout(JSONRPCRequest const& request)
 static CRPCCommand const commands[] = {
         {"chia", "checkchiapos", &checkChiapos, {}},
         {"chia", "querychallenge", &queryChallenge, {}},
+        {"chia", "waitchallenge", &waitChallenge, {"challenge", "vdf_proofs", "timeout"}},
         {"chia", "querynetspace", &queryNetspace, {}},
         {"chia", "querychainvdfinfo", &queryChainVdfInfo, {"height"}},
         {"chia", "queryminingrequirement", &queryMiningRequirement, {"address", "farmer-pk"}},
@@ -1263,8 +1399,9 @@ static CRPCCommand const commands[] = {
         {"chia", "dumpburstcheckpoints", &dumpBurstCheckpoints, {}},
         {"chia", "submitvdfrequest", &submitVdfRequest, {"challenge", "iters"}},
         {"chia", "submitvdfproof", &submitVdfProof, {"challenge", "y", "proof", "witness_type", "iters", "duration"}},
+        {"chia", "queryvdfcacheinfo", &queryVdfCacheInfo, {}},
         {"chia", "dumpposproofs", &dumpPosProofs, {"count"}},
-        {"chia", "querychainpledgeinfo", &queryChainPledgeInfo, {}},
+        {"chia", "querychainpledgeinfo", &queryChainPledgeInfo, {"start_height", "end_height", "account"}},
         {"chia", "burntxout", &burntxout, {"txid","n"} },
 };
 
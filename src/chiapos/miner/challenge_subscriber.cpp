@@ -0,0 +1,104 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
+#include "challenge_subscriber.h"
+
+#include <plog/Log.h>
+#include <tinyformat.h>
+
+#include <cstring>
+#include <stdexcept>
+
+#if ENABLE_ZMQ
+#include <zmq.h>
+#endif
+
+namespace miner {
+
+/// The receiving thread checks the shutdown at this interval
+static int const RECEIVE_TIMEOUT_MS = 500;
+
+#if ENABLE_ZMQ
+
+ChallengeSubscriber::ChallengeSubscriber(std::string const& endpoint) {
+    m_context = zmq_ctx_new();
+    m_socket = zmq_socket(m_context, ZMQ_SUB);
+    int timeout_ms = RECEIVE_TIMEOUT_MS;
+    zmq_setsockopt(m_socket, ZMQ_RCVTIMEO, &timeout_ms, sizeof(timeout_ms));
+    for (char const* topic : {"hashchallenge", "rawvdfproof"}) {
+        zmq_setsockopt(m_socket, ZMQ_SUBSCRIBE, topic, strlen(topic));
+    }
+    if (zmq_connect(m_socket, endpoint.c_str()) != 0) {
+        std::string err = zmq_strerror(zmq_errno());
+        zmq_close(m_socket);
+        zmq_ctx_term(m_context);
+        throw std::runtime_error(tinyformat::format("cannot connect to zmq endpoint %s: %s", endpoint, err));
+    }
+    m_pthread.reset(new std::thread(&ChallengeSubscriber::SubscribeProc, this));
+    PLOG_INFO << "subscribed the challenges and the vdf proofs from " << endpoint;
+}
+
+ChallengeSubscriber::~ChallengeSubscriber() {
+    m_running = false;
+    m_pthread->join();
+    zmq_close(m_socket);
+    zmq_ctx_term(m_context);
+}
+
+void ChallengeSubscriber::SubscribeProc() {
+    while (m_running) {
+        zmq_msg_t msg;
+        zmq_msg_init(&msg);
+        int rc = zmq_msg_recv(&msg, m_socket, 0);
+        bool more = rc >= 0 && zmq_msg_more(&msg);
+        zmq_msg_close(&msg);
+        if (rc < 0) {
+            if (zmq_errno() != EAGAIN) {
+                PLOGE << "zmq: " << zmq_strerror(zmq_errno());
+                std::this_thread::sleep_for(std::chrono::milliseconds(RECEIVE_TIMEOUT_MS));
+            }
+            continue;
+        }
+        // The topic, the body and the sequence of a notification are the parts of one message
+        if (!more) {
+            Notify();
+        }
+    }
+}
+
+#else
+
+ChallengeSubscriber::ChallengeSubscriber(std::string const& endpoint) {
+    throw std::runtime_error(tinyformat::format("cannot subscribe %s, the miner is built without zmq", endpoint));
+}
+
+ChallengeSubscriber::~ChallengeSubscriber() {}
+
+void ChallengeSubscriber::SubscribeProc() {}
+
+#endif
+
+uint64_t ChallengeSubscriber::GetSequence() const {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_sequence;
+}
+
+bool ChallengeSubscriber::WaitForUpdate(uint64_t sequence, std::chrono::steady_clock::time_point deadline) const {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    return m_cv.wait_until(lock, deadline, [this, sequence]() { return m_sequence != sequence; });
+}
+
+void ChallengeSubscriber::Notify() {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        ++m_sequence;
+    }
+    m_cv.notify_all();
+}
+
+}  // namespace miner
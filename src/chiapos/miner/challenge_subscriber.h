@@ -0,0 +1,49 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BHD_MINER_CHALLENGE_SUBSCRIBER_H
+#define BHD_MINER_CHALLENGE_SUBSCRIBER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace miner {
+
+/// Subscribes the `hashchallenge` and `rawvdfproof` topics which are published by the node with `-zmqpubhashchallenge`
+/// and `-zmqpubrawvdfproof`, the miner waits for them instead of polling `querychallenge`
+class ChallengeSubscriber {
+public:
+    /// Throws std::runtime_error when the endpoint cannot be connected or the miner is built without zmq
+    explicit ChallengeSubscriber(std::string const& endpoint);
+
+    ~ChallengeSubscriber();
+
+    uint64_t GetSequence() const;
+
+    /// Wait for a notification after the sequence, returns false on timeout
+    bool WaitForUpdate(uint64_t sequence, std::chrono::steady_clock::time_point deadline) const;
+
+private:
+    void SubscribeProc();
+
+    void Notify();
+
+    void* m_context{nullptr};
+    void* m_socket{nullptr};
+    std::atomic_bool m_running{true};
+    std::unique_ptr<std::thread> m_pthread;
+    mutable std::mutex m_mtx;
+    mutable std::condition_variable m_cv;
+    uint64_t m_sequence{0};
+};
+
+}  // namespace miner
+
+#endif
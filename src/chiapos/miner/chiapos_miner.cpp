@@ -13,6 +13,7 @@
 #include <chiapos/kernel/utils.h>
 #include <chiapos/kernel/vdf.h>
 
+#include <chiapos/miner/challenge_subscriber.h>
 #include <chiapos/miner/rpc_client.h>
 
 #include <atomic>
@@ -94,20 +95,21 @@ chiapos::optional<RPCClient::PosProof> QueryBestPosProof(Prover& prover, uint256
     if (out_plot_path) {
         *out_plot_path = qs_pack.plot_path;
     }
-    chiapos::PlotMemo memo;
-    if (!Prover::ReadPlotMemo(qs_pack.plot_path, memo)) {
+    auto pinfo = prover.GetPlotInfo(qs_pack.plot_path);
+    if (!pinfo) {
         return {};
     }
+    chiapos::PlotMemo const& memo = pinfo->memo;
     RPCClient::PosProof proof;
     proof.mixed_quality_string = mixed_quality_string;
     proof.iters = chiapos::CalculateIterationsQuality(mixed_quality_string, difficulty, bits_filter,
                                                       difficulty_constant_factor_bits, qs_pack.k, base_iters);
     proof.challenge = challenge;
     proof.k = qs_pack.k;
-    proof.plot_id = chiapos::MakeUint256(memo.plot_id);
+    proof.plot_id = pinfo->plot_id;
     proof.pool_pk_or_hash = chiapos::MakePubKeyOrHash(memo.plot_id_type, memo.pool_pk_or_puzzle_hash);
-    proof.local_pk = chiapos::MakeArray<chiapos::PK_LEN>(Prover::CalculateLocalPkBytes(memo.local_master_sk));
-    if (!Prover::QueryFullProof(qs_pack.plot_path, challenge, qs_pack.index, proof.proof, out_farmer_pk)) {
+    proof.local_pk = pinfo->local_pk;
+    if (!prover.QueryFullProof(qs_pack.plot_path, challenge, qs_pack.index, proof.proof, out_farmer_pk)) {
         return {};
     }
     PLOGI << "iters=" << chiapos::FormatNumberStr(std::to_string(proof.iters)) << ", k=" << (int)proof.k
@@ -124,6 +126,15 @@ chiapos::optional<RPCClient::PosProof> QueryBestPosProof(Prover& prover, uint256
 
 static int const CHECKING_VDF_INTERVAL_SECS = 22;
 
+/// The longest time to wait in a long poll or for a notification of the node, the timelord is queried between the waits
+static int const WAIT_CHALLENGE_SECS = 10;
+static int const WAIT_CHALLENGE_WITH_TIMELORD_SECS = 1;
+
+/// The challenge is polled at the interval when the node doesn't wait for it
+static int const POLL_CHALLENGE_INTERVAL_MS = 200;
+
+static int const RPC_METHOD_NOT_FOUND = -32601;
+
 Miner::Miner(RPCClient& client, Prover& prover, std::map<chiapos::PubKey, chiapos::SecreKey> secre_keys,
              std::string reward_dest, int difficulty_constant_factor_bits)
         : m_client(client),
@@ -166,6 +177,14 @@ void Miner::StartTimelord(std::vector<std::string> const& endpoints, uint16_t de
     m_pthread_timelord.reset(new std::thread(std::bind(&Miner::TimelordProc, this)));
 }
 
+void Miner::StartSubscriber(std::string const& endpoint) {
+    try {
+        m_psubscriber.reset(new ChallengeSubscriber(endpoint));
+    } catch (std::exception const& e) {
+        PLOGE << e.what() << ", waiting for the challenge by `waitchallenge`";
+    }
+}
+
 int Miner::Run() {
     int const ERROR_RECOVER_WAIT_SECONDS = 3;
     RPCClient::Challenge queried_challenge;
@@ -180,7 +199,8 @@ int Miner::Run() {
             std::this_thread::yield();
             PLOG_INFO << "==== Status: " << ToString(m_state) << " ====";
             if (m_state == State::RequireChallenge) {
-                if (!m_client.CheckChiapos()) {
+                auto ch = m_client.QueryChallengeIfReady();
+                if (!ch.has_value()) {
                     PLOGE << "chiapos is not ready!";
                     std::this_thread::sleep_for(std::chrono::seconds(3));
                     continue;
@@ -191,8 +211,7 @@ int Miner::Run() {
                 vdf.reset();
                 m_current_challenge.SetNull();
                 m_current_iters = 0;
-                // Query challenge
-                queried_challenge = m_client.QueryChallenge();
+                queried_challenge = std::move(*ch);
                 if (m_submit_history.find(queried_challenge.challenge) != std::end(m_submit_history)) {
                     PLOG_INFO << "proof is already submitted, waiting for next challenge...";
                     std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -404,6 +423,7 @@ Miner::BreakReason Miner::CheckAndBreak(std::atomic_bool& running, int timeout_s
         });
     }
     auto start_time = std::chrono::system_clock::now();
+    int num_of_known_vdf_proofs{0};
     while (running) {
         auto curr_time = std::chrono::system_clock::now();
         auto curr_seconds = std::chrono::duration_cast<std::chrono::seconds>(curr_time - start_time).count();
@@ -411,8 +431,30 @@ Miner::BreakReason Miner::CheckAndBreak(std::atomic_bool& running, int timeout_s
             return BreakReason::Timeout;
         }
         try {
-            // Query current challenge, compare
-            RPCClient::Challenge ch = m_client.QueryChallenge();
+            int wait_seconds = std::min<int>(timeout_seconds - curr_seconds, m_pthread_timelord
+                                                                                 ? WAIT_CHALLENGE_WITH_TIMELORD_SECS
+                                                                                 : WAIT_CHALLENGE_SECS);
+            // Take the sequence before querying, a notification in between ends the wait below immediately
+            uint64_t sequence = m_psubscriber ? m_psubscriber->GetSequence() : 0;
+            // Wait for the node to change the challenge or to receive new vdf proofs, poll the older nodes
+            RPCClient::Challenge ch;
+            bool waited{false};
+            if (!m_psubscriber && m_long_poll) {
+                try {
+                    ch = m_client.WaitChallenge(initial_challenge, num_of_known_vdf_proofs, wait_seconds);
+                    waited = true;
+                } catch (RPCError const& e) {
+                    if (e.GetCode() == RPC_METHOD_NOT_FOUND) {
+                        PLOGW << "the node doesn't support `waitchallenge`, querying the challenge periodically";
+                        m_long_poll = false;
+                    }
+                    // Otherwise enough miners are waiting on the node already, query the challenge this time
+                    ch = m_client.QueryChallenge();
+                }
+            } else {
+                ch = m_client.QueryChallenge();
+            }
+            num_of_known_vdf_proofs = ch.vdf_proofs.size();
             if (ch.challenge != initial_challenge) {
                 // Challenge is changed
                 return BreakReason::ChallengeIsChanged;
@@ -441,7 +483,13 @@ Miner::BreakReason Miner::CheckAndBreak(std::atomic_bool& running, int timeout_s
                     return BreakReason::VDFIsAcquired;
                 }
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            if (m_psubscriber) {
+                // Wait for the node to publish a new challenge or a new vdf proof
+                m_psubscriber->WaitForUpdate(sequence,
+                                             std::chrono::steady_clock::now() + std::chrono::seconds(wait_seconds));
+            } else if (!waited) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(POLL_CHALLENGE_INTERVAL_MS));
+            }
         } catch (NetError const& e) {
             PLOGE << "NetError: " << e.what();
             return BreakReason::Error;
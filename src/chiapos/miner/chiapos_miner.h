@@ -12,6 +12,7 @@
 
 #include <tinyformat.h>
 
+#include "challenge_subscriber.h"
 #include "prover.h"
 #include "rpc_client.h"
 
@@ -47,6 +48,9 @@ public:
 
     void StartTimelord(std::vector<std::string> const& endpoints, uint16_t default_port);
 
+    /// Wait for the notifications of the node instead of the long poll of the challenge, see ChallengeSubscriber
+    void StartSubscriber(std::string const& endpoint);
+
     int Run();
 
 private:
@@ -86,6 +90,10 @@ private:
     std::map<uint256, std::vector<ProofDetail>> m_proofs;
     std::set<uint256> m_submit_history;
     std::atomic_bool m_shutting_down{false};
+    // false when the node doesn't support the long poll of the challenge
+    bool m_long_poll{true};
+    // null when the challenge is waited by the long poll or polled
+    std::unique_ptr<ChallengeSubscriber> m_psubscriber;
     // temporary save the current challenge/iters
     uint256 m_current_challenge;
     uint64_t m_current_iters;
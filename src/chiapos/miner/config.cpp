@@ -42,6 +42,7 @@ std::string Config::ToJsonString() const {
         timelord_endpoints.push_back(UniValue(endpoint));
     }
     root.pushKV("timelords", timelord_endpoints);
+    root.pushKV("zmq", m_zmq_endpoint);
 
     UniValue allowed_ks(UniValue::VARR);
     for (auto const& k : m_allowed_k_vec) {
@@ -49,6 +50,14 @@ std::string Config::ToJsonString() const {
     }
     root.pushKV("allowedPlotK", allowed_ks);
 
+    root.pushKV("harvesterTimeBudget", m_harvester_time_budget_ms);
+    UniValue latency_buckets(UniValue::VARR);
+    for (int bound : m_harvester_latency_buckets_ms) {
+        latency_buckets.push_back(bound);
+    }
+    root.pushKV("harvesterLatencyBuckets", latency_buckets);
+    root.pushKV("plotRescanInterval", m_plot_rescan_interval_secs);
+
     return root.write(4);
 }
 
@@ -107,6 +116,10 @@ void Config::ParseFromJsonString(std::string const& json_str) {
         }
     }
 
+    if (root.exists("zmq") && root["zmq"].isStr()) {
+        m_zmq_endpoint = root["zmq"].get_str();
+    }
+
     if (root.exists("seed")) {
         if (root["seed"].isStr()) {
             std::string seed = root["seed"].get_str();
@@ -137,6 +150,21 @@ void Config::ParseFromJsonString(std::string const& json_str) {
             m_allowed_k_vec.push_back(k_val.get_int());
         }
     }
+
+    if (root.exists("harvesterTimeBudget") && root["harvesterTimeBudget"].isNum()) {
+        m_harvester_time_budget_ms = root["harvesterTimeBudget"].get_int();
+    }
+
+    if (root.exists("harvesterLatencyBuckets") && root["harvesterLatencyBuckets"].isArray()) {
+        m_harvester_latency_buckets_ms.clear();
+        for (UniValue const& val : root["harvesterLatencyBuckets"].getValues()) {
+            m_harvester_latency_buckets_ms.push_back(val.get_int());
+        }
+    }
+
+    if (root.exists("plotRescanInterval") && root["plotRescanInterval"].isNum()) {
+        m_plot_rescan_interval_secs = root["plotRescanInterval"].get_int();
+    }
 }
 
 Config::RPC Config::GetRPC() const { return m_rpc; }
@@ -153,6 +181,14 @@ bool Config::NoProxy() const { return m_no_proxy; }
 
 std::vector<std::string> Config::GetTimelordEndpoints() const { return m_timelord_endpoints; }
 
+std::string Config::GetZmqEndpoint() const { return m_zmq_endpoint; }
+
 std::vector<uint8_t> Config::GetAllowedKs() const { return m_allowed_k_vec; }
 
+int Config::GetHarvesterTimeBudget() const { return m_harvester_time_budget_ms; }
+
+std::vector<int> Config::GetHarvesterLatencyBuckets() const { return m_harvester_latency_buckets_ms; }
+
+int Config::GetPlotRescanInterval() const { return m_plot_rescan_interval_secs; }
+
 }  // namespace miner
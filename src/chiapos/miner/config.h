@@ -7,6 +7,9 @@
 
 #include <univalue.h>
 
+#include "harvester.h"
+#include "prover.h"
+
 #include <string>
 
 namespace miner {
@@ -38,8 +41,16 @@ public:
 
     std::vector<std::string> GetTimelordEndpoints() const;
 
+    std::string GetZmqEndpoint() const;
+
     std::vector<uint8_t> GetAllowedKs() const;
 
+    int GetHarvesterTimeBudget() const;
+
+    std::vector<int> GetHarvesterLatencyBuckets() const;
+
+    int GetPlotRescanInterval() const;
+
 private:
     RPC m_rpc;
     std::string m_reward_dest;
@@ -48,7 +59,11 @@ private:
     bool m_testnet{true};
     bool m_no_proxy{true};
     std::vector<std::string> m_timelord_endpoints;
+    std::string m_zmq_endpoint;
     std::vector<uint8_t> m_allowed_k_vec;
+    int m_harvester_time_budget_ms{DEFAULT_HARVESTER_TIME_BUDGET_MS};
+    std::vector<int> m_harvester_latency_buckets_ms{DEFAULT_HARVESTER_LATENCY_BUCKETS_MS};
+    int m_plot_rescan_interval_secs{DEFAULT_PLOT_RESCAN_INTERVAL_SECS};
 };
 
 }  // namespace miner
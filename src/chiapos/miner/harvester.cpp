@@ -0,0 +1,268 @@
+#include "harvester.h"
+
+#include <chiapos/bhd_types.h>
+#include <chiapos/kernel/utils.h>
+
+#include <plog/Log.h>
+#include <tinyformat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <sstream>
+
+#ifndef _WIN32
+
+#include <sys/stat.h>
+
+#endif
+
+namespace miner {
+
+/// Write the histograms to the log after every number of lookups
+static uint64_t const HARVESTER_LOG_LATENCIES_INTERVAL = 20;
+
+LatencyHistogram::LatencyHistogram(std::vector<int> bounds_ms) : m_bounds_ms(std::move(bounds_ms)) {
+    std::sort(std::begin(m_bounds_ms), std::end(m_bounds_ms));
+    m_buckets.resize(m_bounds_ms.size() + 1, 0);
+}
+
+void LatencyHistogram::Add(int64_t latency_ms) {
+    auto it = std::upper_bound(std::begin(m_bounds_ms), std::end(m_bounds_ms), latency_ms);
+    ++m_buckets[std::distance(std::begin(m_bounds_ms), it)];
+    ++m_count;
+    m_total_ms += latency_ms;
+    m_max_ms = std::max(m_max_ms, latency_ms);
+}
+
+std::string LatencyHistogram::ToString() const {
+    std::stringstream ss;
+    for (size_t i = 0; i < m_bounds_ms.size(); ++i) {
+        ss << "<" << m_bounds_ms[i] << "ms: " << m_buckets[i] << ", ";
+    }
+    if (!m_bounds_ms.empty()) {
+        ss << ">=" << m_bounds_ms.back() << "ms: " << m_buckets.back() << ", ";
+    }
+    ss << "count: " << m_count << ", avg: " << (m_count > 0 ? m_total_ms / static_cast<int64_t>(m_count) : 0)
+       << "ms, max: " << m_max_ms << "ms";
+    return ss.str();
+}
+
+struct Harvester::Lookup {
+    uint256 challenge;
+    int bits_of_filter;
+    std::atomic_bool cancelled{false};
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<chiapos::QualityStringPack> results;
+    int num_of_running{0};
+};
+
+struct Harvester::Device {
+    Device(std::string name_in, std::vector<int> latency_buckets_ms)
+            : name(std::move(name_in)), histogram(std::move(latency_buckets_ms)) {}
+
+    std::string name;
+    std::thread worker;
+    // guards the members below
+    std::mutex mtx;
+    std::condition_variable cv;
+    // replaced as a whole when the plots change, a running lookup keeps the old one
+    std::shared_ptr<std::vector<chiapos::CPlotFile> const> plot_files{
+            std::make_shared<std::vector<chiapos::CPlotFile>>()};
+    std::shared_ptr<Lookup> pending;
+    bool stopping{false};
+    LatencyHistogram histogram;
+};
+
+#ifdef _WIN32
+
+static std::string GetDeviceKey(std::string const& plot_path) {
+    auto root_name = fs::path(plot_path).root_name().string();
+    std::transform(std::begin(root_name), std::end(root_name), std::begin(root_name), ::toupper);
+    return root_name;
+}
+
+#else
+
+static std::string GetDeviceKey(std::string const& plot_path) {
+    struct stat st;
+    if (stat(plot_path.c_str(), &st) != 0) {
+        // Unknown device, the plots of the same directory share a worker
+        return fs::path(plot_path).parent_path().string();
+    }
+    return std::to_string(st.st_dev);
+}
+
+#endif
+
+Harvester::Harvester(std::vector<chiapos::CPlotFile> const& plot_files, int time_budget_ms,
+                     std::vector<int> latency_buckets_ms)
+        : m_time_budget_ms(time_budget_ms), m_latency_buckets_ms(std::move(latency_buckets_ms)) {
+    AddPlots(plot_files);
+    PLOG_INFO << tinyformat::format("harvester: %d plot(s) on %d device(s), time budget %d ms", plot_files.size(),
+                                    GetNumOfDevices(), m_time_budget_ms);
+}
+
+Harvester::~Harvester() {
+    for (auto pdevice : GetDevices()) {
+        std::lock_guard<std::mutex> lock(pdevice->mtx);
+        pdevice->stopping = true;
+        pdevice->cv.notify_all();
+    }
+    for (auto pdevice : GetDevices()) {
+        pdevice->worker.join();
+    }
+}
+
+void Harvester::AddPlots(std::vector<chiapos::CPlotFile> const& plot_files) {
+    std::map<Device*, std::vector<chiapos::CPlotFile>> added;
+    std::lock_guard<std::mutex> lock_devices(m_mtx_devices);
+    for (auto const& plot_file : plot_files) {
+        std::string key = GetDeviceKey(plot_file.GetPath());
+        auto it = m_devices_by_key.find(key);
+        if (it == std::end(m_devices_by_key)) {
+            std::string name = fs::path(plot_file.GetPath()).parent_path().string();
+            m_devices.push_back(chiapos::MakeUnique<Device>(std::move(name), m_latency_buckets_ms));
+            Device& device = *m_devices.back();
+            device.worker = std::thread([this, &device]() { WorkerProc(device); });
+            it = m_devices_by_key.insert(std::make_pair(key, &device)).first;
+        }
+        added[it->second].push_back(plot_file);
+    }
+    for (auto& entry : added) {
+        Device& device = *entry.first;
+        std::lock_guard<std::mutex> lock(device.mtx);
+        auto plot_files_new = std::make_shared<std::vector<chiapos::CPlotFile>>(*device.plot_files);
+        std::copy(std::begin(entry.second), std::end(entry.second), std::back_inserter(*plot_files_new));
+        device.plot_files = std::move(plot_files_new);
+        PLOGD << tinyformat::format("harvester device: %s, %d plot(s)", device.name, device.plot_files->size());
+    }
+}
+
+void Harvester::RemovePlots(std::set<std::string> const& plot_paths) {
+    for (auto pdevice : GetDevices()) {
+        std::lock_guard<std::mutex> lock(pdevice->mtx);
+        auto plot_files_new = std::make_shared<std::vector<chiapos::CPlotFile>>();
+        for (auto const& plot_file : *pdevice->plot_files) {
+            if (plot_paths.find(plot_file.GetPath()) == std::end(plot_paths)) {
+                plot_files_new->push_back(plot_file);
+            }
+        }
+        if (plot_files_new->size() != pdevice->plot_files->size()) {
+            pdevice->plot_files = std::move(plot_files_new);
+            PLOGD << tinyformat::format("harvester device: %s, %d plot(s)", pdevice->name, pdevice->plot_files->size());
+        }
+    }
+}
+
+int Harvester::GetNumOfDevices() const {
+    std::lock_guard<std::mutex> lock(m_mtx_devices);
+    return m_devices.size();
+}
+
+std::vector<Harvester::Device*> Harvester::GetDevices() const {
+    std::lock_guard<std::mutex> lock(m_mtx_devices);
+    std::vector<Device*> devices;
+    for (auto const& pdevice : m_devices) {
+        devices.push_back(pdevice.get());
+    }
+    return devices;
+}
+
+std::vector<chiapos::QualityStringPack> Harvester::GetQualityStrings(uint256 const& challenge, int bits_of_filter) {
+    auto start = std::chrono::steady_clock::now();
+    auto devices = GetDevices();
+    auto lookup = std::make_shared<Lookup>();
+    lookup->challenge = challenge;
+    lookup->bits_of_filter = bits_of_filter;
+    lookup->num_of_running = devices.size();
+    for (auto pdevice : devices) {
+        // A lookup which is still pending belongs to a finished challenge, it is replaced
+        std::lock_guard<std::mutex> lock(pdevice->mtx);
+        pdevice->pending = lookup;
+        pdevice->cv.notify_all();
+    }
+    std::vector<chiapos::QualityStringPack> res;
+    int num_of_running;
+    {
+        std::unique_lock<std::mutex> lock(lookup->mtx);
+        auto finished = [&lookup]() { return lookup->num_of_running == 0; };
+        if (m_time_budget_ms > 0) {
+            lookup->cv.wait_until(lock, start + std::chrono::milliseconds(m_time_budget_ms), finished);
+        } else {
+            lookup->cv.wait(lock, finished);
+        }
+        lookup->cancelled = true;
+        res = lookup->results;
+        num_of_running = lookup->num_of_running;
+    }
+    auto duration_ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    PLOG_DEBUG << tinyformat::format("harvester lookup takes %d ms, %d answer(s)", duration_ms, res.size());
+    ++m_num_of_lookups;
+    if (num_of_running > 0) {
+        PLOGW << tinyformat::format(
+                "harvester time budget %d ms is exceeded, %d device(s) are still looking up, %d answer(s) are collected",
+                m_time_budget_ms, num_of_running, res.size());
+        LogLatencies();
+    } else if (m_num_of_lookups % HARVESTER_LOG_LATENCIES_INTERVAL == 0) {
+        LogLatencies();
+    }
+    return res;
+}
+
+void Harvester::LogLatencies() const {
+    for (auto pdevice : GetDevices()) {
+        std::lock_guard<std::mutex> lock(pdevice->mtx);
+        PLOG_INFO << tinyformat::format("disk latency %s: %s", pdevice->name, pdevice->histogram.ToString());
+    }
+}
+
+void Harvester::WorkerProc(Device& device) {
+    while (1) {
+        std::shared_ptr<Lookup> lookup;
+        std::shared_ptr<std::vector<chiapos::CPlotFile> const> plot_files;
+        {
+            std::unique_lock<std::mutex> lock(device.mtx);
+            device.cv.wait(lock, [&device]() { return device.stopping || device.pending != nullptr; });
+            if (device.stopping) {
+                return;
+            }
+            lookup = std::move(device.pending);
+            plot_files = device.plot_files;
+        }
+        for (auto const& plot_file : *plot_files) {
+            if (lookup->cancelled) {
+                break;
+            }
+            if (lookup->bits_of_filter > 0 &&
+                !chiapos::PassesFilter(plot_file.GetPlotId(), lookup->challenge, lookup->bits_of_filter)) {
+                continue;
+            }
+            PLOG_DEBUG << "passed for plot-id: " << plot_file.GetPlotId().GetHex()
+                       << ", challenge: " << lookup->challenge.GetHex();
+            auto start = std::chrono::steady_clock::now();
+            std::vector<chiapos::QualityStringPack> qstrs;
+            bool succ = plot_file.GetQualityString(lookup->challenge, qstrs);
+            auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                      std::chrono::steady_clock::now() - start)
+                                      .count();
+            {
+                std::lock_guard<std::mutex> lock(device.mtx);
+                device.histogram.Add(latency_ms);
+            }
+            if (succ && !qstrs.empty()) {
+                std::lock_guard<std::mutex> lock(lookup->mtx);
+                std::copy(std::begin(qstrs), std::end(qstrs), std::back_inserter(lookup->results));
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(lookup->mtx);
+            --lookup->num_of_running;
+        }
+        lookup->cv.notify_all();
+    }
+}
+
+}  // namespace miner
@@ -0,0 +1,88 @@
+#ifndef BHD_MINER_HARVESTER_H
+#define BHD_MINER_HARVESTER_H
+
+#include <chiapos/kernel/chiapos_types.h>
+#include <chiapos/kernel/pos.h>
+#include <uint256.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace miner {
+
+int const DEFAULT_HARVESTER_TIME_BUDGET_MS = 20000;
+
+std::vector<int> const DEFAULT_HARVESTER_LATENCY_BUCKETS_MS = {100, 500, 1000, 2000, 5000, 10000};
+
+/// The lookup latencies of a disk, the last bucket counts the lookups over the largest bound
+class LatencyHistogram {
+public:
+    explicit LatencyHistogram(std::vector<int> bounds_ms);
+
+    void Add(int64_t latency_ms);
+
+    uint64_t GetCount() const { return m_count; }
+
+    std::string ToString() const;
+
+private:
+    std::vector<int> m_bounds_ms;
+    std::vector<uint64_t> m_buckets;
+    uint64_t m_count{0};
+    int64_t m_total_ms{0};
+    int64_t m_max_ms{0};
+};
+
+/**
+ * Harvester looks up the quality strings of the plots, one worker thread for each physical device, so the slow disks
+ * don't block each other. The lookup of a challenge returns what has arrived when the time budget runs out.
+ * The plots can be added and removed while the workers are looking up, a lookup carries on with the plots it started
+ * with.
+ */
+class Harvester {
+public:
+    Harvester(std::vector<chiapos::CPlotFile> const& plot_files, int time_budget_ms, std::vector<int> latency_buckets_ms);
+
+    ~Harvester();
+
+    std::vector<chiapos::QualityStringPack> GetQualityStrings(uint256 const& challenge, int bits_of_filter);
+
+    void AddPlots(std::vector<chiapos::CPlotFile> const& plot_files);
+
+    void RemovePlots(std::set<std::string> const& plot_paths);
+
+    int GetNumOfDevices() const;
+
+    /// Write the latency histograms of the disks to the log
+    void LogLatencies() const;
+
+private:
+    struct Lookup;
+
+    struct Device;
+
+    void WorkerProc(Device& device);
+
+    std::vector<Device*> GetDevices() const;
+
+private:
+    int m_time_budget_ms;
+    std::vector<int> m_latency_buckets_ms;
+    uint64_t m_num_of_lookups{0};
+    // guards the devices, the devices are kept until the harvester is destroyed
+    mutable std::mutex m_mtx_devices;
+    std::vector<std::unique_ptr<Device>> m_devices;
+    std::map<std::string, Device*> m_devices_by_key;
+};
+
+}  // namespace miner
+
+#endif
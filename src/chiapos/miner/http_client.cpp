@@ -15,18 +15,21 @@ HTTPClient::HTTPClient(std::string url, std::string user, std::string passwd, bo
           m_no_proxy(no_proxy) {
     PLOG_DEBUG << "Contruct HTTPClient with url=`" << m_url << "`, user=`" << m_user << "`, passwd=`" << m_passwd
                << "`";
+    m_header_list = curl_slist_append(nullptr, "Content-Type: application/json-rpc");
+    m_header_list = curl_slist_append(m_header_list, "Accept: application/json");
+    m_header_list = curl_slist_append(m_header_list, "Connection: keep-alive");
+    curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, m_header_list);
+    curl_easy_setopt(m_curl, CURLOPT_TCP_KEEPALIVE, 1L);
 }
 
-HTTPClient::~HTTPClient() { curl_easy_cleanup(m_curl); }
+HTTPClient::~HTTPClient() {
+    curl_easy_cleanup(m_curl);
+    curl_slist_free_all(m_header_list);
+}
 
 std::tuple<bool, int, std::string> HTTPClient::Send(std::string const& buff) {
+    m_recv_data.clear();
     curl_easy_setopt(m_curl, CURLOPT_URL, m_url.c_str());
-
-    curl_slist* header_list;
-    header_list = curl_slist_append(nullptr, "Content-Type: application/json-rpc");
-    header_list = curl_slist_append(header_list, "Accept: application/json");
-    header_list = curl_slist_append(header_list, "Connection: close");
-    curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, header_list);
     curl_easy_setopt(m_curl, CURLOPT_POST, 1L);
     curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, buff.c_str());
     curl_easy_setopt(m_curl, CURLOPT_USERNAME, m_user.c_str());
@@ -46,8 +49,6 @@ std::tuple<bool, int, std::string> HTTPClient::Send(std::string const& buff) {
     CURLcode code = curl_easy_perform(m_curl);
     PLOG_DEBUG << "curl_easy_perform returns " << code << ": " << curl_easy_strerror(code);
 
-    curl_slist_free_all(header_list);
-
     if (code != CURLE_OK) {
         std::stringstream ss;
         ss << "curl returns error: code=" << code << ", " << curl_easy_strerror(code);
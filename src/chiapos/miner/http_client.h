@@ -15,6 +15,18 @@ public:
 
     ~HTTPClient();
 
+    HTTPClient(HTTPClient const&) = delete;
+
+    HTTPClient& operator=(HTTPClient const&) = delete;
+
+    void SetURL(std::string url) { m_url = std::move(url); }
+
+    void SetAuth(std::string user, std::string passwd) {
+        m_user = std::move(user);
+        m_passwd = std::move(passwd);
+    }
+
+    /// Send the buffer and receive the reply, the connection is kept alive and reused by the next call
     std::tuple<bool, int, std::string> Send(std::string const& buff);
 
     chiapos::Bytes GetReceivedData() const;
@@ -28,6 +40,7 @@ private:
 
 private:
     CURL* m_curl;
+    curl_slist* m_header_list;
     std::string m_url;
     std::string m_user;
     std::string m_passwd;
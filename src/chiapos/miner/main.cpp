@@ -198,7 +198,9 @@ int HandleCommand_GenConfig(std::string const& config_path) {
 }
 
 int HandleCommand_Mining() {
-    miner::Prover prover(miner::StrListToPathList(miner::g_config.GetPlotPath()), miner::g_config.GetAllowedKs());
+    miner::Prover prover(miner::StrListToPathList(miner::g_config.GetPlotPath()), miner::g_config.GetAllowedKs(),
+                         miner::g_config.GetHarvesterTimeBudget(), miner::g_config.GetHarvesterLatencyBuckets(),
+                         miner::g_config.GetPlotRescanInterval());
     std::unique_ptr<miner::RPCClient> pclient = tools::CreateRPCClient(miner::g_config, miner::g_args.cookie_path);
     // Start mining
     miner::Miner miner(*pclient, prover, miner::ConvertSecureKeys(miner::g_config.GetSeeds()),
@@ -206,6 +208,11 @@ int HandleCommand_Mining() {
     // do we have timelord service
     auto timelord_endpoints = miner::g_config.GetTimelordEndpoints();
     miner.StartTimelord(timelord_endpoints, 19191);
+    // the node publishes the challenges and the vdf proofs with -zmqpubhashchallenge and -zmqpubrawvdfproof
+    std::string zmq_endpoint = miner::g_config.GetZmqEndpoint();
+    if (!zmq_endpoint.empty()) {
+        miner.StartSubscriber(zmq_endpoint);
+    }
     return miner.Run();
 }
 
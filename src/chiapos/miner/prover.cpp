@@ -4,11 +4,13 @@
 #include <chiapos/kernel/pos.h>
 #include <chiapos/kernel/utils.h>
 #include <chiapos/kernel/bls_key.h>
+#include <crypto/sha256.h>
 
 #include <plog/Log.h>
 #include <tinyformat.h>
 
 #include <algorithm>
+#include <chrono>
 
 #ifdef _WIN32
 
@@ -16,6 +18,16 @@
 
 #endif
 
+#ifdef __linux__
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#endif
+
 namespace miner {
 
 using MatchFunc = std::function<bool(std::string const&)>;
@@ -106,37 +118,25 @@ std::vector<Path> StrListToPathList(std::vector<std::string> const& str_list) {
     return path_list;
 }
 
-Prover::Prover(std::vector<Path> const& path_list, std::vector<uint8_t> const& allowed_k_vec) {
-    CSHA256 generator;
+/// A directory is scanned when it has been quiet for the time after a change, a plot is often copied in pieces
+static auto const PLOT_DIR_SETTLE_TIME = std::chrono::seconds(2);
+
+static void XorPlotId(uint256& group_hash, chiapos::PlotId const& plot_id) {
+    uint256 hash;
+    CSHA256().Write(plot_id.begin(), plot_id.size()).Finalize(hash.begin());
+    for (unsigned int i = 0; i < hash.size(); ++i) {
+        *(group_hash.begin() + i) ^= *(hash.begin() + i);
+    }
+}
+
+Prover::Prover(std::vector<Path> const& path_list, std::vector<uint8_t> const& allowed_k_vec,
+               int harvester_time_budget_ms, std::vector<int> harvester_latency_buckets_ms, int rescan_interval_secs)
+        : m_allowed_k_vec(allowed_k_vec), m_rescan_interval_secs(rescan_interval_secs) {
     PLOGI << tinyformat::format("total %d paths found from config", path_list.size());
     for (auto const& path : path_list) {
-        std::vector<std::string> files;
-        uint64_t total_size;
-        std::tie(files, total_size) = EnumPlotsFromDir(path.string());
-        m_total_size += total_size;
-        for (auto const& file : files) {
-            chiapos::CPlotFile plotFile(file);
-            if (plotFile.IsReady()) {
-                bool allowed{true};
-                if (!allowed_k_vec.empty()) {
-                    auto it = std::find(std::begin(allowed_k_vec), std::end(allowed_k_vec), plotFile.GetK());
-                    allowed = it != std::end(allowed_k_vec);
-                }
-                if (allowed) {
-                    PLOGD << tinyformat::format("Add plot, k=%d, path=%s", (int)plotFile.GetK(), file);
-                    auto plot_id = plotFile.GetPlotId();
-                    generator.Write(plot_id.begin(), plot_id.size());
-                    m_plotter_files.push_back(std::move(plotFile));
-                }
-            } else {
-                m_total_size -= fs::file_size(file);
-                PLOG_ERROR << "bad plot: " << file;
-            }
-        }
+        m_dirs.push_back(path.string());
+        RescanDir(path.string());
     }
-    generator.Finalize(m_group_hash.begin());
-    PLOG_INFO << "found total " << m_plotter_files.size() << " plots, group hash: " << m_group_hash.GetHex()
-              << ", total size: " << chiapos::MakeNumberStr(m_total_size);
     if (!allowed_k_vec.empty()) {
         std::stringstream ss;
         for (auto k : allowed_k_vec) {
@@ -144,49 +144,250 @@ Prover::Prover(std::vector<Path> const& path_list, std::vector<uint8_t> const& a
         }
         PLOG_INFO << "PlotK allowed: " << ss.str();
     }
+    std::vector<chiapos::CPlotFile> plot_files;
+    for (auto const& entry : m_plot_infos) {
+        plot_files.push_back(entry.second.plot_file);
+    }
+    m_harvester.reset(new Harvester(plot_files, harvester_time_budget_ms, std::move(harvester_latency_buckets_ms)));
+    m_watcher = std::thread([this]() { WatcherProc(); });
+}
+
+Prover::~Prover() {
+    m_stopping = true;
+    m_watcher.join();
+}
+
+uint64_t Prover::GetTotalSize() const {
+    boost::shared_lock<boost::shared_mutex> lock(m_mtx_plots);
+    return m_total_size;
+}
+
+uint256 Prover::GetGroupHash() const {
+    boost::shared_lock<boost::shared_mutex> lock(m_mtx_plots);
+    return m_group_hash;
+}
+
+int Prover::GetNumOfPlots() const {
+    boost::shared_lock<boost::shared_mutex> lock(m_mtx_plots);
+    return m_plot_infos.size();
 }
 
 std::vector<chiapos::QualityStringPack> Prover::GetQualityStrings(uint256 const& challenge, int bits_of_filter) const {
-    std::vector<chiapos::QualityStringPack> res;
-    for (auto const& plotFile : m_plotter_files) {
-        if (bits_of_filter > 0 && !chiapos::PassesFilter(plotFile.GetPlotId(), challenge, bits_of_filter)) {
+    return m_harvester->GetQualityStrings(challenge, bits_of_filter);
+}
+
+void Prover::RevokeByFarmerPk(chiapos::PubKey const& farmer_pk) {
+    std::lock_guard<std::mutex> lock_update(m_mtx_update);
+    std::set<std::string> revoked_paths;
+    {
+        boost::unique_lock<boost::shared_mutex> lock(m_mtx_plots);
+        m_revoked_farmer_pks.insert(farmer_pk);
+        for (auto it = std::begin(m_plot_infos); it != std::end(m_plot_infos);) {
+            if (it->second.farmer_pk != farmer_pk) {
+                ++it;
+                continue;
+            }
+            m_total_size -= it->second.size;
+            XorPlotId(m_group_hash, it->second.plot_id);
+            m_skipped_plots[it->first] = it->second.dir;
+            revoked_paths.insert(it->first);
+            it = m_plot_infos.erase(it);
+        }
+    }
+    m_harvester->RemovePlots(revoked_paths);
+}
+
+void Prover::RescanDir(std::string const& dir) {
+    std::lock_guard<std::mutex> lock_update(m_mtx_update);
+    std::vector<std::string> files;
+    std::tie(files, std::ignore) = EnumPlotsFromDir(dir);
+    std::set<std::string> listed_files(std::begin(files), std::end(files));
+    // Find the changes, the plots are only read by the rescan so the lookups carry on meanwhile
+    std::vector<std::string> new_files;
+    std::set<std::string> removed_files;
+    std::set<chiapos::PubKey> revoked_farmer_pks;
+    {
+        boost::shared_lock<boost::shared_mutex> lock(m_mtx_plots);
+        for (auto const& file : files) {
+            if (m_plot_infos.find(file) == std::end(m_plot_infos) &&
+                m_skipped_plots.find(file) == std::end(m_skipped_plots)) {
+                new_files.push_back(file);
+            }
+        }
+        for (auto const& entry : m_plot_infos) {
+            if (entry.second.dir == dir && listed_files.find(entry.first) == std::end(listed_files)) {
+                removed_files.insert(entry.first);
+            }
+        }
+        for (auto const& entry : m_skipped_plots) {
+            if (entry.second == dir && listed_files.find(entry.first) == std::end(listed_files)) {
+                removed_files.insert(entry.first);
+            }
+        }
+        revoked_farmer_pks = m_revoked_farmer_pks;
+    }
+    if (new_files.empty() && removed_files.empty()) {
+        return;
+    }
+    // Open the new plots
+    std::vector<PlotInfo> added_infos;
+    std::vector<std::string> skipped_files;
+    for (auto const& file : new_files) {
+        chiapos::CPlotFile plotFile(file);
+        if (!plotFile.IsReady()) {
+            // It is opened again in the next scan
+            PLOG_ERROR << "bad plot: " << file;
+            continue;
+        }
+        if (!m_allowed_k_vec.empty() &&
+            std::find(std::begin(m_allowed_k_vec), std::end(m_allowed_k_vec), plotFile.GetK()) ==
+                    std::end(m_allowed_k_vec)) {
+            skipped_files.push_back(file);
+            continue;
+        }
+        chiapos::PlotMemo memo;
+        if (!plotFile.ReadMemo(memo) || memo.farmer_pk.size() != chiapos::PK_LEN ||
+            memo.local_master_sk.size() != chiapos::SK_LEN) {
+            PLOG_ERROR << "bad memo of plot: " << file;
             continue;
         }
-        PLOG_DEBUG << "passed for plot-id: " << plotFile.GetPlotId().GetHex() << ", challenge: " << challenge.GetHex();
-        std::vector<chiapos::QualityStringPack> qstrs;
-        if (plotFile.GetQualityString(challenge, qstrs)) {
-            std::copy(std::begin(qstrs), std::end(qstrs), std::back_inserter(res));
+        auto farmer_pk = chiapos::MakeArray<chiapos::PK_LEN>(memo.farmer_pk);
+        if (revoked_farmer_pks.find(farmer_pk) != std::end(revoked_farmer_pks)) {
+            skipped_files.push_back(file);
+            continue;
+        }
+        uint64_t size;
+        try {
+            size = fs::file_size(file);
+        } catch (std::exception const& e) {
+            PLOG_ERROR << tinyformat::format("cannot read the size of plot: %s, reason: %s", file, e.what());
+            continue;
         }
+        PLOGD << tinyformat::format("Add plot, k=%d, path=%s", (int)plotFile.GetK(), file);
+        auto plot_id = plotFile.GetPlotId();
+        auto local_pk = chiapos::MakeArray<chiapos::PK_LEN>(CalculateLocalPkBytes(memo.local_master_sk));
+        added_infos.push_back(PlotInfo{plotFile, std::move(memo), plot_id, farmer_pk, local_pk, dir, size});
+    }
+    std::vector<chiapos::CPlotFile> added_plot_files;
+    {
+        boost::unique_lock<boost::shared_mutex> lock(m_mtx_plots);
+        for (auto const& file : removed_files) {
+            auto it = m_plot_infos.find(file);
+            if (it != std::end(m_plot_infos)) {
+                PLOGD << tinyformat::format("Remove plot, path=%s", file);
+                m_total_size -= it->second.size;
+                XorPlotId(m_group_hash, it->second.plot_id);
+                m_plot_infos.erase(it);
+            }
+            m_skipped_plots.erase(file);
+        }
+        for (auto& info : added_infos) {
+            m_total_size += info.size;
+            XorPlotId(m_group_hash, info.plot_id);
+            added_plot_files.push_back(info.plot_file);
+            std::string path = info.plot_file.GetPath();
+            m_plot_infos.insert(std::make_pair(std::move(path), std::move(info)));
+        }
+        for (auto const& file : skipped_files) {
+            m_skipped_plots[file] = dir;
+        }
+        PLOG_INFO << "found total " << m_plot_infos.size() << " plots, group hash: " << m_group_hash.GetHex()
+                  << ", total size: " << chiapos::MakeNumberStr(m_total_size);
+    }
+    if (m_harvester) {
+        m_harvester->RemovePlots(removed_files);
+        m_harvester->AddPlots(added_plot_files);
     }
-    return res;
 }
 
-void Prover::RevokeByFarmerPk(chiapos::PubKey const& farmer_pk) {
-    auto it_rm = std::remove_if(std::begin(m_plotter_files), std::end(m_plotter_files),
-                                [&farmer_pk](chiapos::CPlotFile const& plot_file) -> bool {
-                                    chiapos::PlotMemo memo;
-                                    plot_file.ReadMemo(memo);
-                                    assert(memo.farmer_pk.size() == farmer_pk.size());
-                                    return (chiapos::MakeArray<chiapos::PK_LEN>(memo.farmer_pk) == farmer_pk);
-                                });
-    m_plotter_files.erase(it_rm, std::end(m_plotter_files));
-}
-
-bool Prover::QueryFullProof(Path const& plot_path, uint256 const& challenge, int index, chiapos::Bytes& out,
-                            chiapos::PubKey& out_farmer_pk) {
-    chiapos::CPlotFile plotFile(plot_path.string());
-    chiapos::PlotMemo memo;
-    if (!plotFile.ReadMemo(memo)) {
-        throw std::runtime_error(tinyformat::format("cannot read memo from plot file: %s", plot_path));
-    }
-    assert(memo.farmer_pk.size() == out_farmer_pk.size());
-    memcpy(out_farmer_pk.data(), memo.farmer_pk.data(), out_farmer_pk.size());
-    return plotFile.GetFullProof(challenge, index, out);
-}
-
-bool Prover::ReadPlotMemo(Path const& plot_file_path, chiapos::PlotMemo& out) {
-    chiapos::CPlotFile plotFile(plot_file_path.string());
-    return plotFile.ReadMemo(out);
+void Prover::WatcherProc() {
+    auto last_full_scan = std::chrono::steady_clock::now();
+    std::map<std::string, std::chrono::steady_clock::time_point> changed_dirs;
+#ifdef __linux__
+    std::map<int, std::string> watched_dirs;
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1) {
+        PLOGW << tinyformat::format("cannot watch the plot directories, errno: %d", errno);
+    } else {
+        for (auto const& dir : m_dirs) {
+            int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE);
+            if (wd == -1) {
+                PLOGW << tinyformat::format("cannot watch the plot directory: %s, errno: %d", dir, errno);
+                continue;
+            }
+            watched_dirs[wd] = dir;
+        }
+    }
+#endif
+    while (!m_stopping) {
+#ifdef __linux__
+        if (fd != -1) {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            if (poll(&pfd, 1, 1000) > 0) {
+                alignas(struct inotify_event) char buf[4096];
+                ssize_t len;
+                while ((len = read(fd, buf, sizeof(buf))) > 0) {
+                    for (char* ptr = buf; ptr < buf + len;) {
+                        auto const* event = reinterpret_cast<struct inotify_event const*>(ptr);
+                        auto it = watched_dirs.find(event->wd);
+                        if (it != std::end(watched_dirs)) {
+                            changed_dirs[it->second] = std::chrono::steady_clock::now();
+                        }
+                        ptr += sizeof(struct inotify_event) + event->len;
+                    }
+                }
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+#endif
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = std::begin(changed_dirs); it != std::end(changed_dirs);) {
+            if (now - it->second < PLOT_DIR_SETTLE_TIME) {
+                ++it;
+                continue;
+            }
+            PLOGD << tinyformat::format("plot directory is changed: %s", it->first);
+            RescanDir(it->first);
+            it = changed_dirs.erase(it);
+        }
+        if (m_rescan_interval_secs > 0 && now - last_full_scan >= std::chrono::seconds(m_rescan_interval_secs)) {
+            for (auto const& dir : m_dirs) {
+                if (m_stopping) {
+                    break;
+                }
+                RescanDir(dir);
+            }
+            last_full_scan = now;
+        }
+    }
+#ifdef __linux__
+    if (fd != -1) {
+        close(fd);
+    }
+#endif
+}
+
+chiapos::optional<PlotInfo> Prover::GetPlotInfo(std::string const& plot_path) const {
+    boost::shared_lock<boost::shared_mutex> lock(m_mtx_plots);
+    auto it = m_plot_infos.find(plot_path);
+    if (it == std::end(m_plot_infos)) {
+        return {};
+    }
+    return it->second;
+}
+
+bool Prover::QueryFullProof(std::string const& plot_path, uint256 const& challenge, int index, chiapos::Bytes& out,
+                            chiapos::PubKey& out_farmer_pk) const {
+    auto pinfo = GetPlotInfo(plot_path);
+    if (!pinfo) {
+        throw std::runtime_error(tinyformat::format("the plot isn't loaded: %s", plot_path));
+    }
+    out_farmer_pk = pinfo->farmer_pk;
+    // The plot is read out of the lock, a removed plot stays open until the copy is released
+    return pinfo->plot_file.GetFullProof(challenge, index, out);
 }
 
 chiapos::Bytes Prover::CalculateLocalPkBytes(chiapos::Bytes const& local_master_sk) {
@@ -5,35 +5,68 @@
 #include <chiapos/kernel/pos.h>
 #include <uint256.h>
 
+#include "harvester.h"
+
+#include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include <boost/thread/shared_mutex.hpp>
+
 #include <chiapos/bhd_types.h>
 
 namespace miner {
 
+/// The plot directories are scanned again after the number of seconds, 0 turns it off
+int const DEFAULT_PLOT_RESCAN_INTERVAL_SECS = 300;
+
 std::vector<Path> StrListToPathList(std::vector<std::string> const& str_list);
 
-class Prover {
-    std::vector<chiapos::CPlotFile> m_plotter_files;
+/// The metadata of a plot, it is read when the plot is loaded and the opened plot is kept for the full proofs
+struct PlotInfo {
+    chiapos::CPlotFile plot_file;
+    chiapos::PlotMemo memo;
+    chiapos::PlotId plot_id;
+    chiapos::PubKey farmer_pk;
+    chiapos::PubKey local_pk;
+    std::string dir;
+    uint64_t size;
+};
 
+/**
+ * Prover holds the plots of the plot directories. The directories are watched (inotify on linux) and scanned again
+ * periodically, the plots are added and removed while mining, the total size and the group hash follow them.
+ */
+class Prover {
 public:
-    Prover(std::vector<Path> const& path_list, std::vector<uint8_t> const& allowed_k_vec);
+    Prover(std::vector<Path> const& path_list, std::vector<uint8_t> const& allowed_k_vec,
+           int harvester_time_budget_ms = DEFAULT_HARVESTER_TIME_BUDGET_MS,
+           std::vector<int> harvester_latency_buckets_ms = DEFAULT_HARVESTER_LATENCY_BUCKETS_MS,
+           int rescan_interval_secs = DEFAULT_PLOT_RESCAN_INTERVAL_SECS);
+
+    ~Prover();
 
-    uint64_t GetTotalSize() const { return m_total_size; }
+    uint64_t GetTotalSize() const;
 
-    uint256 GetGroupHash() const { return m_group_hash; }
+    /// The xor of the hashes of the plot ids, so it can be updated when a plot is added or removed
+    uint256 GetGroupHash() const;
 
-    int GetNumOfPlots() const { return m_plotter_files.size(); }
+    int GetNumOfPlots() const;
 
     std::vector<chiapos::QualityStringPack> GetQualityStrings(uint256 const& challenge, int bits_of_filter) const;
 
     void RevokeByFarmerPk(chiapos::PubKey const& farmer_pk);
 
-    static bool QueryFullProof(Path const& plot_path, uint256 const& challenge, int index, chiapos::Bytes& out,
-                               chiapos::PubKey& out_farmer_pk);
+    /// Get the cached metadata of a plot, returns none when the plot isn't loaded
+    chiapos::optional<PlotInfo> GetPlotInfo(std::string const& plot_path) const;
 
-    static bool ReadPlotMemo(Path const& plot_file_path, chiapos::PlotMemo& out);
+    bool QueryFullProof(std::string const& plot_path, uint256 const& challenge, int index, chiapos::Bytes& out,
+                        chiapos::PubKey& out_farmer_pk) const;
 
     static chiapos::Bytes CalculateLocalPkBytes(chiapos::Bytes const& local_master_sk);
 
@@ -41,8 +74,28 @@ public:
                             chiapos::Bytes const& proof);
 
 private:
+    /// Scan the directory and apply the new and the removed plots
+    void RescanDir(std::string const& dir);
+
+    void WatcherProc();
+
+private:
+    std::vector<std::string> m_dirs;
+    std::vector<uint8_t> m_allowed_k_vec;
+    int m_rescan_interval_secs;
+    std::unique_ptr<Harvester> m_harvester;
+    // serializes the rescans and the revokes, the lookups don't wait for it
+    std::mutex m_mtx_update;
+    // guards the members below
+    mutable boost::shared_mutex m_mtx_plots;
+    std::map<std::string, PlotInfo> m_plot_infos;
+    // the plots of the disallowed k, or the revoked farmer, they aren't opened again, mapped to their directories
+    std::map<std::string, std::string> m_skipped_plots;
+    std::set<chiapos::PubKey> m_revoked_farmer_pks;
     uint64_t m_total_size{0};
     uint256 m_group_hash;
+    std::atomic_bool m_stopping{false};
+    std::thread m_watcher;
 };
 
 }  // namespace miner
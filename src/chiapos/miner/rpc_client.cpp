@@ -3,12 +3,18 @@
 #include <chiapos/kernel/bls_key.h>
 #include <chiapos/kernel/utils.h>
 
+#include <chrono>
 #include <fstream>
 
 #include <chiapos/bhd_types.h>
 
+#include <tinyformat.h>
+
 namespace miner {
 
+/// Write the round-trip times of the calls to the log after every number of calls
+static uint64_t const RPC_LOG_ROUND_TRIPS_INTERVAL = 100;
+
 std::string DepositTermToString(DepositTerm term) {
     switch (term) {
         case DepositTerm::NoTerm:
@@ -76,9 +82,8 @@ bool RPCClient::CheckChiapos() {
     return res.result.get_bool();
 }
 
-RPCClient::Challenge RPCClient::QueryChallenge() {
-    auto res = SendMethod(m_no_proxy, "querychallenge");
-    Challenge ch;
+static RPCClient::Challenge ParseChallenge(RPCClient::Result const& res) {
+    RPCClient::Challenge ch;
     ch.challenge = uint256S(res.result["challenge"].get_str());
     ch.difficulty = res.result["difficulty"].get_int64();
     ch.prev_block_hash = uint256S(res.result["prev_block_hash"].get_str());
@@ -93,7 +98,7 @@ RPCClient::Challenge RPCClient::QueryChallenge() {
         auto vdf_proofs = res.result["vdf_proofs"];
         if (vdf_proofs.isArray()) {
             for (auto const& vdf_proof : vdf_proofs.getValues()) {
-                VdfProof local_vdf_proof;
+                RPCClient::VdfProof local_vdf_proof;
                 local_vdf_proof.challenge = uint256S(vdf_proof["challenge"].get_str());
                 local_vdf_proof.y = chiapos::MakeVDFForm(chiapos::BytesFromHex(vdf_proof["y"].get_str()));
                 local_vdf_proof.proof = chiapos::BytesFromHex(vdf_proof["proof"].get_str());
@@ -107,6 +112,29 @@ RPCClient::Challenge RPCClient::QueryChallenge() {
     return ch;
 }
 
+RPCClient::Challenge RPCClient::QueryChallenge() { return ParseChallenge(SendMethod(m_no_proxy, "querychallenge")); }
+
+chiapos::optional<RPCClient::Challenge> RPCClient::QueryChallengeIfReady() {
+    std::vector<UniValue> requests;
+    requests.push_back(BuildRequest("checkchiapos"));
+    requests.push_back(BuildRequest("querychallenge"));
+    auto results = SendBatch(m_no_proxy, std::move(requests));
+    if (!results[0].error.empty()) {
+        throw RPCError(results[0].error_code, results[0].error);
+    }
+    if (!results[0].result.get_bool()) {
+        return {};
+    }
+    if (!results[1].error.empty()) {
+        throw RPCError(results[1].error_code, results[1].error);
+    }
+    return ParseChallenge(results[1]);
+}
+
+RPCClient::Challenge RPCClient::WaitChallenge(uint256 const& challenge, int known_vdf_proofs, int timeout_seconds) {
+    return ParseChallenge(SendMethod(m_no_proxy, "waitchallenge", challenge, known_vdf_proofs, timeout_seconds));
+}
+
 RPCClient::PledgeParams RPCClient::QueryNetspace() {
     auto res = SendMethod(m_no_proxy, "querynetspace");
     PledgeParams params;
@@ -263,4 +291,113 @@ void RPCClient::BuildRPCJson(UniValue& params, VdfProof const& proof) {
 
 void RPCClient::BuildRPCJsonWithParams(UniValue& out_params) {}
 
+std::vector<RPCClient::Result> RPCClient::SendBatch(bool no_proxy, std::vector<UniValue> requests) {
+    UniValue batch(UniValue::VARR);
+    std::string method_names;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        requests[i].pushKV("id", static_cast<int>(i));
+        if (!method_names.empty()) {
+            method_names += "+";
+        }
+        method_names += requests[i]["method"].get_str();
+        batch.push_back(requests[i]);
+    }
+    UniValue reply = Send(no_proxy, method_names, batch);
+    if (!reply.isArray() || reply.size() != requests.size()) {
+        throw NetError("invalid batch reply from RPC server");
+    }
+    std::vector<Result> results(requests.size());
+    for (auto const& entry : reply.getValues()) {
+        Result result = ParseResult(entry, false);
+        if (!entry.exists("id") || !entry["id"].isNum() || result.id < 0 ||
+            result.id >= static_cast<int>(results.size())) {
+            throw NetError("invalid id of the batch reply from RPC server");
+        }
+        results[result.id] = std::move(result);
+    }
+    return results;
+}
+
+UniValue RPCClient::Send(bool no_proxy, std::string const& method_name, UniValue const& request) {
+    std::string url_with_wallet;
+    if (m_wallet_name.empty()) {
+        url_with_wallet = m_url;
+    } else {
+        url_with_wallet = m_url + "/wallet/" + m_wallet_name;
+    }
+    if (m_http_client == nullptr) {
+        m_http_client = chiapos::MakeUnique<HTTPClient>(url_with_wallet, m_user, m_passwd, no_proxy);
+    } else {
+        // The cookie might be reloaded
+        m_http_client->SetURL(url_with_wallet);
+        m_http_client->SetAuth(m_user, m_passwd);
+    }
+    std::string send_str = request.write();
+    PLOG_DEBUG << "sending: `" << send_str << "`";
+    auto start = std::chrono::steady_clock::now();
+    bool succ;
+    int code;
+    std::string err_str;
+    std::tie(succ, code, err_str) = m_http_client->Send(send_str);
+    if (!succ) {
+        // Connect again on the next call
+        m_http_client.reset();
+        std::stringstream ss;
+        ss << "RPC command error `" << method_name << "`: " << err_str;
+        throw NetError(ss.str().c_str());
+    }
+    AddRoundTrip(method_name,
+                 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+    // Analyze the result
+    chiapos::Bytes received_data = m_http_client->GetReceivedData();
+    if (received_data.empty()) {
+        throw NetError("empty result from RPC server");
+    }
+    char const* psz = reinterpret_cast<char const*>(received_data.data());
+    UniValue res;
+    res.read(psz, received_data.size());
+    PLOG_DEBUG << "received: `" << res.write() << "`";
+    return res;
+}
+
+RPCClient::Result RPCClient::ParseResult(UniValue const& reply, bool throw_on_error) {
+    Result result;
+    if (reply.exists("result")) {
+        result.result = reply["result"];
+    }
+    if (reply.exists("error") && !reply["error"].isNull()) {
+        UniValue errorJson = reply["error"];
+        int code = errorJson["code"].get_int();
+        std::string msg = errorJson["message"].get_str();
+        if (throw_on_error) {
+            throw RPCError(code, msg);
+        }
+        result.error_code = code;
+        result.error = msg;
+    }
+    if (reply.exists("id") && reply["id"].isNum()) {
+        result.id = reply["id"].get_int();
+    }
+    return result;
+}
+
+void RPCClient::AddRoundTrip(std::string const& method_name, int64_t duration_ms) {
+    PLOG_DEBUG << "rpc `" << method_name << "` round-trip: " << duration_ms << "ms";
+    RoundTripStats& stats = m_round_trips[method_name];
+    ++stats.count;
+    stats.total_ms += duration_ms;
+    stats.max_ms = std::max(stats.max_ms, duration_ms);
+    if (++m_num_of_calls % RPC_LOG_ROUND_TRIPS_INTERVAL == 0) {
+        LogRoundTrips();
+    }
+}
+
+void RPCClient::LogRoundTrips() const {
+    for (auto const& entry : m_round_trips) {
+        RoundTripStats const& stats = entry.second;
+        PLOG_INFO << tinyformat::format("rpc round-trip `%s`: count %d, avg %dms, max %dms", entry.first, stats.count,
+                                        stats.total_ms / static_cast<int64_t>(stats.count), stats.max_ms);
+    }
+}
+
 }  // namespace miner
@@ -13,7 +13,10 @@
 #include <vdf_computer.h>
 
 #include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "http_client.h"
 #include "uint256.h"
@@ -52,6 +55,7 @@ public:
     struct Result {
         UniValue result;
         std::string error;
+        int error_code{0};
         int id;
     };
 
@@ -153,6 +157,12 @@ public:
 
     Challenge QueryChallenge();
 
+    /// Check chiapos and query the challenge in one batch, returns nothing when chiapos isn't ready
+    chiapos::optional<Challenge> QueryChallengeIfReady();
+
+    /// Long poll, returns when the challenge is changed, more vdf proofs than the known ones arrive or on timeout
+    Challenge WaitChallenge(uint256 const& challenge, int known_vdf_proofs, int timeout_seconds);
+
     PledgeParams QueryNetspace();
 
     void SubmitProof(ProofPack const& proof_pack);
@@ -218,66 +228,51 @@ private:
     }
 
     template <typename... T>
-    Result SendMethod(bool no_proxy, std::string const& method_name, T&&... vals) {
+    UniValue BuildRequest(std::string const& method_name, T&&... vals) {
         UniValue root(UniValue::VOBJ);
         root.pushKV("jsonrpc", "2.0");
         root.pushKV("method", method_name);
         UniValue params(UniValue::VARR);
         BuildRPCJsonWithParams(params, std::forward<T>(vals)...);
         root.pushKV("params", params);
-        // Invoke curl
-        std::string url_with_wallet;
-        if (m_wallet_name.empty()) {
-            url_with_wallet = m_url;
-        } else {
-            url_with_wallet = m_url + "/wallet/" + m_wallet_name;
-        }
-        HTTPClient client(url_with_wallet, m_user, m_passwd, no_proxy);
-        std::string send_str = root.write();
-        PLOG_DEBUG << "sending: `" << send_str << "`";
-        bool succ;
-        int code;
-        std::string err_str;
-        std::tie(succ, code, err_str) = client.Send(send_str);
-        if (!succ) {
-            std::stringstream ss;
-            ss << "RPC command error `" << method_name << "`: " << err_str;
-            throw NetError(ss.str().c_str());
-        }
-        // Analyze the result
-        chiapos::Bytes received_data = client.GetReceivedData();
-        if (received_data.empty()) {
-            throw NetError("empty result from RPC server");
-        }
-        char const* psz = reinterpret_cast<char const*>(received_data.data());
-        UniValue res;
-        res.read(psz, received_data.size());
-
-        // Build result and return
-        PLOG_DEBUG << "received: `" << res.write() << "`";
-        Result result;
-        if (res.exists("result")) {
-            result.result = res["result"];
-        }
-        if (res.exists("error") && !res["error"].isNull()) {
-            UniValue errorJson = res["error"];
-            int code = errorJson["code"].get_int();
-            std::string msg = errorJson["message"].get_str();
-            throw RPCError(code, msg);
-        }
-        if (res.exists("id") && res["id"].isNum()) {
-            result.id = res["id"].get_int();
-        }
-        return result;
+        return root;
+    }
+
+    template <typename... T>
+    Result SendMethod(bool no_proxy, std::string const& method_name, T&&... vals) {
+        return ParseResult(Send(no_proxy, method_name, BuildRequest(method_name, std::forward<T>(vals)...)), true);
     }
 
+    /// Send the requests in one JSON-RPC batch, the results are in the order of the requests and the errors of the
+    /// calls are returned in the results
+    std::vector<Result> SendBatch(bool no_proxy, std::vector<UniValue> requests);
+
+    /// Post the request through the kept-alive connection and record the round-trip time
+    UniValue Send(bool no_proxy, std::string const& method_name, UniValue const& request);
+
+    static Result ParseResult(UniValue const& reply, bool throw_on_error);
+
+    void AddRoundTrip(std::string const& method_name, int64_t duration_ms);
+
+    void LogRoundTrips() const;
+
 private:
+    struct RoundTripStats {
+        uint64_t count{0};
+        int64_t total_ms{0};
+        int64_t max_ms{0};
+    };
+
     bool m_no_proxy;
     std::string m_wallet_name;
     std::string m_cookie_path_str;
     std::string m_url;
     std::string m_user;
     std::string m_passwd;
+    // the connection is reused by all calls, the client isn't thread-safe
+    std::unique_ptr<HTTPClient> m_http_client;
+    std::map<std::string, RoundTripStats> m_round_trips;
+    uint64_t m_num_of_calls{0};
 };
 
 }  // namespace miner
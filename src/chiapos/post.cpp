@@ -5,11 +5,17 @@
 #include <chiapos/kernel/bls_key.h>
 
 #include <consensus/validation.h>
+#include <crypto/sha256.h>
+#include <cuckoocache.h>
 #include <logging.h>
+#include <memusage.h>
 #include <net.h>
 #include <net_processing.h>
 #include <netmessagemaker.h>
+#include <random.h>
 #include <rpc/util.h>
+#include <script/sigcache.h>
+#include <sync.h>
 #include <uint256.h>
 #include <univalue.h>
 #include <util/system.h>
@@ -17,14 +23,278 @@
 #include <vdf_computer.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <memory>
 
+#include <boost/thread.hpp>
+
 namespace chiapos {
 
-std::map<uint256, std::set<uint64_t>> g_vdf_requests;
+CVdfProofCache::CVdfProofCache()
+{
+    GetRandBytes(nonce.begin(), 32);
+}
+
+void CVdfProofCache::ComputeEntry(uint256& entry, CVdfProof const& proof) const
+{
+    unsigned char buf[9];
+    WriteLE64(buf, proof.nVdfIters);
+    buf[8] = proof.nWitnessType;
+    CSHA256().Write(nonce.begin(), 32).Write(proof.challenge.begin(), 32).Write(buf, sizeof(buf))
+            .Write(proof.vchY.data(), proof.vchY.size()).Write(proof.vchProof.data(), proof.vchProof.size())
+            .Finalize(entry.begin());
+}
+
+bool CVdfProofCache::Get(uint256 const& entry)
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_vdfcache);
+    bool fFound = setValid.contains(entry, false);
+    ++(fFound ? nHits : nMisses);
+    return fFound;
+}
+
+void CVdfProofCache::Set(uint256& entry)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_vdfcache);
+    setValid.insert(entry);
+}
+
+namespace {
+
+CVdfProofCache vdfProofCache;
+
+} // namespace
+
+CVdfProofCache& GetVdfProofCache() {
+    return vdfProofCache;
+}
+
+void InitVdfProofCache() {
+    size_t nElems = vdfProofCache.setup_bytes(VDF_PROOF_CACHE_BYTES);
+    LogPrintf("Using %zu KiB for vdf proof cache, able to store %zu elements\n",
+            (nElems * sizeof(uint256)) >> 10, nElems);
+}
+
+void GetVdfProofCacheStats(uint64_t& nHits, uint64_t& nMisses) {
+    nHits = vdfProofCache.GetHits();
+    nMisses = vdfProofCache.GetMisses();
+}
+
+namespace {
+
+/**
+ * The vdf requests and proofs received from the network and the local timelord, by challenge.
+ * The challenges are stamped with the tip height when they are seen first, the challenges too
+ * far behind the tip are evicted when blocks connect, the oldest ones when the memory is over the limit.
+ * The challenge of the tip is never evicted for the memory, the entries which do not fit are refused.
+ */
+class CVdfStore
+{
+private:
+    struct ChallengeEntry {
+        int nHeight;
+        std::set<uint64_t> setRequestIters;
+        std::multimap<uint64_t, CVdfProof> mapProofs; //! By iters
+    };
+
+    mutable Mutex cs_store;
+    std::map<uint256, ChallengeEntry> mapChallenges GUARDED_BY(cs_store);
+    std::set<std::pair<int, uint256>> setChallengesByHeight GUARDED_BY(cs_store);
+    size_t nUsage GUARDED_BY(cs_store){0};
+    size_t nMaxUsage GUARDED_BY(cs_store){DEFAULT_MAX_VDF_STORE_SIZE * 1000000};
+    int nTipHeight GUARDED_BY(cs_store){0};
+    uint256 tipChallenge GUARDED_BY(cs_store);
+
+    static size_t ChallengeUsage()
+    {
+        return memusage::MallocUsage(sizeof(memusage::stl_tree_node<std::pair<const uint256, ChallengeEntry>>)) +
+               memusage::MallocUsage(sizeof(memusage::stl_tree_node<std::pair<int, uint256>>));
+    }
+
+    static size_t RequestUsage()
+    {
+        return memusage::MallocUsage(sizeof(memusage::stl_tree_node<uint64_t>));
+    }
+
+    static size_t ProofUsage(CVdfProof const& proof)
+    {
+        return memusage::MallocUsage(sizeof(memusage::stl_tree_node<std::pair<const uint64_t, CVdfProof>>)) +
+               memusage::DynamicUsage(proof.vchY) + memusage::DynamicUsage(proof.vchProof);
+    }
+
+    ChallengeEntry& GetOrCreateEntry(uint256 const& challenge) EXCLUSIVE_LOCKS_REQUIRED(cs_store)
+    {
+        auto it = mapChallenges.find(challenge);
+        if (it == mapChallenges.end()) {
+            it = mapChallenges.emplace(challenge, ChallengeEntry{nTipHeight, {}, {}}).first;
+            setChallengesByHeight.emplace(nTipHeight, challenge);
+            nUsage += ChallengeUsage();
+        }
+        return it->second;
+    }
+
+    void EraseChallenge(std::map<uint256, ChallengeEntry>::iterator it) EXCLUSIVE_LOCKS_REQUIRED(cs_store)
+    {
+        nUsage -= ChallengeUsage() + RequestUsage() * it->second.setRequestIters.size();
+        for (auto const& proof : it->second.mapProofs) {
+            nUsage -= ProofUsage(proof.second);
+        }
+        setChallengesByHeight.erase(std::make_pair(it->second.nHeight, it->first));
+        mapChallenges.erase(it);
+    }
+
+    //! Evict the oldest challenges until the memory is under the limit, the challenge in use and the tip challenge are kept
+    bool TrimToSize(uint256 const& challengeInUse) EXCLUSIVE_LOCKS_REQUIRED(cs_store)
+    {
+        auto itByHeight = setChallengesByHeight.begin();
+        while (nUsage > nMaxUsage && itByHeight != setChallengesByHeight.end()) {
+            uint256 challenge = (itByHeight++)->second;
+            if (challenge != challengeInUse && challenge != tipChallenge) {
+                EraseChallenge(mapChallenges.find(challenge));
+            }
+        }
+        return nUsage <= nMaxUsage;
+    }
+
+    //! Erase the challenge left without requests and proofs by a refused entry
+    void EraseIfEmpty(uint256 const& challenge) EXCLUSIVE_LOCKS_REQUIRED(cs_store)
+    {
+        auto it = mapChallenges.find(challenge);
+        if (it != mapChallenges.end() && it->second.setRequestIters.empty() && it->second.mapProofs.empty()) {
+            EraseChallenge(it);
+        }
+    }
+
+public:
+    void SetMaxUsage(size_t nMaxUsageIn)
+    {
+        LOCK(cs_store);
+        nMaxUsage = nMaxUsageIn;
+        TrimToSize(uint256());
+    }
+
+    bool AddRequest(uint256 const& challenge, uint64_t nIters)
+    {
+        LOCK(cs_store);
+        ChallengeEntry& entry = GetOrCreateEntry(challenge);
+        if (!entry.setRequestIters.insert(nIters).second) {
+            return false;
+        }
+        nUsage += RequestUsage();
+        if (!TrimToSize(challenge)) {
+            entry.setRequestIters.erase(nIters);
+            nUsage -= RequestUsage();
+            EraseIfEmpty(challenge);
+            return false;
+        }
+        return true;
+    }
+
+    std::set<uint64_t> QueryRequests(uint256 const& challenge) const
+    {
+        LOCK(cs_store);
+        auto it = mapChallenges.find(challenge);
+        if (it == mapChallenges.end()) {
+            return {};
+        }
+        return it->second.setRequestIters;
+    }
+
+    bool AddProof(CVdfProof vdfProof)
+    {
+        LOCK(cs_store);
+        ChallengeEntry& entry = GetOrCreateEntry(vdfProof.challenge);
+        auto range = entry.mapProofs.equal_range(vdfProof.nVdfIters);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (vdfProof.Equals(it->second)) {
+                return false;
+            }
+        }
+        nUsage += ProofUsage(vdfProof);
+        uint256 challenge = vdfProof.challenge;
+        auto itProof = entry.mapProofs.emplace_hint(range.second, vdfProof.nVdfIters, std::move(vdfProof));
+        if (!TrimToSize(challenge)) {
+            nUsage -= ProofUsage(itProof->second);
+            entry.mapProofs.erase(itProof);
+            EraseIfEmpty(challenge);
+            return false;
+        }
+        return true;
+    }
+
+    bool FindProof(uint256 const& challenge, uint64_t nIters, CVdfProof* pvdfProof) const
+    {
+        LOCK(cs_store);
+        auto it = mapChallenges.find(challenge);
+        if (it == mapChallenges.end()) {
+            return false;
+        }
+        auto itProof = it->second.mapProofs.lower_bound(nIters);
+        if (itProof == it->second.mapProofs.end()) {
+            return false;
+        }
+        if (pvdfProof) {
+            *pvdfProof = itProof->second;
+        }
+        return true;
+    }
+
+    std::vector<CVdfProof> QueryProofs(uint256 const& challenge) const
+    {
+        LOCK(cs_store);
+        auto it = mapChallenges.find(challenge);
+        if (it == mapChallenges.end()) {
+            return {};
+        }
+        std::vector<CVdfProof> vProofs;
+        vProofs.reserve(it->second.mapProofs.size());
+        for (auto const& proof : it->second.mapProofs) {
+            vProofs.push_back(proof.second);
+        }
+        return vProofs;
+    }
+
+    void Prune(int nTipHeightIn, uint256 const& tipChallengeIn)
+    {
+        LOCK(cs_store);
+        nTipHeight = nTipHeightIn;
+        tipChallenge = tipChallengeIn;
+        while (!setChallengesByHeight.empty() && setChallengesByHeight.begin()->first < nTipHeight - VDF_STORE_EXPIRY_DEPTH) {
+            EraseChallenge(mapChallenges.find(setChallengesByHeight.begin()->second));
+        }
+    }
+
+    VdfStoreStats GetStats() const
+    {
+        LOCK(cs_store);
+        VdfStoreStats stats;
+        stats.nChallenges = mapChallenges.size();
+        stats.nUsage = nUsage;
+        stats.nMaxUsage = nMaxUsage;
+        return stats;
+    }
+};
+
+CVdfStore vdfStore;
 
-std::map<uint256, std::vector<CVdfProof>> g_vdf_proofs;
+Mutex cs_challengeUpdate;
+std::condition_variable cvChallengeUpdate;
+uint64_t nChallengeUpdateSequence GUARDED_BY(cs_challengeUpdate){0};
+
+} // namespace
+
+void InitLocalVdfStore() {
+    vdfStore.SetMaxUsage(std::max<int64_t>(0, gArgs.GetArg("-maxvdfstore", DEFAULT_MAX_VDF_STORE_SIZE)) * 1000000);
+}
+
+void PruneLocalVdfStore(int nTipHeight, uint256 const& tipChallenge) {
+    vdfStore.Prune(nTipHeight, tipChallenge);
+}
+
+VdfStoreStats GetLocalVdfStoreStats() {
+    return vdfStore.GetStats();
+}
 
 uint256 MakeChallenge(CBlockIndex const* pindex, Consensus::Params const& params) {
     assert(pindex);
@@ -33,8 +303,8 @@ uint256 MakeChallenge(CBlockIndex const* pindex, Consensus::Params const& params
         Bytes initialVdfProof(100, 0);
         return MakeChallenge(pindex->GetBlockHash(), initialVdfProof);
     } else {
-        // We need to read the challenge from last block
-        return MakeChallenge(pindex->GetBlockHash(), pindex->chiaposFields.vdfProof.vchProof);
+        // The challenge is made from the vdf proof of the last block when it is added to the block index
+        return pindex->hashNextChallenge;
     }
 }
 
@@ -131,12 +401,57 @@ bool CheckVdfProof(CVdfProof const& proof, CValidationState& state) {
                              "zero duration");
     }
 
-    return VerifyVdf(proof.challenge, MakeZeroForm(), proof.nVdfIters, MakeVDFForm(proof.vchY), proof.vchProof,
-                     proof.nWitnessType);
+    uint256 entry;
+    vdfProofCache.ComputeEntry(entry, proof);
+    if (vdfProofCache.Get(entry)) {
+        return true;
+    }
+    if (!VerifyVdf(proof.challenge, MakeZeroForm(), proof.nVdfIters, MakeVDFForm(proof.vchY), proof.vchProof,
+                   proof.nWitnessType)) {
+        return false;
+    }
+    vdfProofCache.Set(entry);
+    return true;
+}
+
+static bool CheckFieldsPosProof(CBlockFields const& fields, int nTargetHeight, CValidationState& state,
+                                Consensus::Params const& params, uint256& mixedQualityString) {
+    if (!CheckPosProof(fields.posProof, state, params, nTargetHeight)) {
+        return false;
+    }
+    PubKeyOrHash poolPkOrHash = chiapos::MakePubKeyOrHash(static_cast<PlotPubKeyType>(fields.posProof.nPlotType),
+                                                          fields.posProof.vchPoolPkOrHash);
+    mixedQualityString = MakeMixedQualityString(
+            MakeArray<PK_LEN>(fields.posProof.vchLocalPk), MakeArray<PK_LEN>(fields.posProof.vchFarmerPk), poolPkOrHash,
+            fields.posProof.nPlotK, fields.posProof.challenge, fields.posProof.vchProof);
+    if (mixedQualityString.IsNull()) {
+        return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, "bad-chia-fields",
+                             "mixed quality-string is null(wrong PoS)\n");
+    }
+    return true;
+}
+
+static bool CheckFieldsVdfProof(CBlockFields const& fields, CValidationState& state) {
+    try {
+        if (!CheckVdfProof(fields.vdfProof, state)) {
+            return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, "bad-chia-fields",
+                    "vdf proof cannot be verified");
+        }
+    } catch (std::exception const& e) {
+        return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, "bad-chia-fields", e.what());
+    }
+    return true;
+}
+
+bool CheckBlockFieldsProofs(CBlockFields const& fields, int nTargetHeight, CValidationState& state,
+                            Consensus::Params const& params, uint256& mixedQualityString) {
+    return CheckFieldsPosProof(fields, nTargetHeight, state, params, mixedQualityString) &&
+           CheckFieldsVdfProof(fields, state);
 }
 
 bool CheckBlockFields(CBlockFields const& fields, uint64_t nTimeOfTheBlock, CBlockIndex const* pindexPrev,
-                      CValidationState& state, Consensus::Params const& params) {
+                      CValidationState& state, Consensus::Params const& params,
+                      uint256 const* pverifiedMixedQualityString) {
     static char const* SZ_BAD_WHAT = "bad-chia-fields";
     // Initial challenge should be calculated from previous block
     int nTargetHeight = pindexPrev->nHeight + 1;
@@ -155,15 +470,16 @@ bool CheckBlockFields(CBlockFields const& fields, uint64_t nTimeOfTheBlock, CBlo
         initialChallenge = MakeChallenge(pindexPrev->GetBlockHash(), emptyProof);
     } else {
         // Check duration
-        if (pindexPrev->chiaposFields.vdfProof.nVdfDuration == 0) {
+        if (pindexPrev->chiaposFields.nVdfDuration == 0) {
             return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, SZ_BAD_WHAT,
                                  "zero vdf-duration");
         }
-        if (pindexPrev->chiaposFields.vdfProof.vchProof.empty()) {
+        // Null when the vdf proof of the previous block is empty
+        if (pindexPrev->hashNextChallenge.IsNull()) {
             return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, SZ_BAD_WHAT,
                                  "length of vdfProof is zero");
         }
-        initialChallenge = MakeChallenge(pindexPrev->GetBlockHash(), pindexPrev->chiaposFields.vdfProof.vchProof);
+        initialChallenge = pindexPrev->hashNextChallenge;
     }
 
     if (fields.vdfProof.nVdfDuration == 0) {
@@ -187,13 +503,7 @@ bool CheckBlockFields(CBlockFields const& fields, uint64_t nTimeOfTheBlock, CBlo
         return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, SZ_BAD_WHAT,
                              "the value of previous difficulty is zero");
     }
-    double targetMulFactor = 1.0;
-    if (nTargetHeight >= params.BHDIP010TargetSpacingMulFactorEnableAtHeight) {
-        targetMulFactor = params.BHDIP010TargetSpacingMulFactor;
-    }
-    uint64_t nDifficulty = AdjustDifficulty(nDifficultyPrev, fields.GetTotalDuration(), params.BHDIP008TargetSpacing,
-                                            QueryDurationFix(nTargetHeight, params.BHDIP009TargetDurationFixes),
-                                            GetDifficultyChangeMaxFactor(nTargetHeight, params), params.BHDIP009StartDifficulty, targetMulFactor);
+    uint64_t nDifficulty = AdjustBlockDifficulty(nDifficultyPrev, fields.GetTotalDuration(), nTargetHeight, params);
     if (nDifficulty == 0) {
         return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, SZ_BAD_WHAT,
                              "the value of current difficulty is zero");
@@ -217,22 +527,17 @@ bool CheckBlockFields(CBlockFields const& fields, uint64_t nTimeOfTheBlock, CBlo
         return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, SZ_BAD_WHAT,
                              "invalid pos challenge");
     }
-    if (!CheckPosProof(fields.posProof, state, params, nTargetHeight)) {
+    uint256 mixed_quality_string;
+    if (pverifiedMixedQualityString != nullptr) {
+        // The proofs are verified ahead
+        mixed_quality_string = *pverifiedMixedQualityString;
+    } else if (!CheckFieldsPosProof(fields, nTargetHeight, state, params, mixed_quality_string)) {
         return false;
     }
 
     // Check vdf-iters
     LogPrint(BCLog::POC, "%s: checking iters related with quality, plot-type: %d, plot-k: %d\n", __func__,
              fields.posProof.nPlotType, fields.posProof.nPlotK);
-    PubKeyOrHash poolPkOrHash = chiapos::MakePubKeyOrHash(static_cast<PlotPubKeyType>(fields.posProof.nPlotType),
-                                                          fields.posProof.vchPoolPkOrHash);
-    uint256 mixed_quality_string = MakeMixedQualityString(
-            MakeArray<PK_LEN>(fields.posProof.vchLocalPk), MakeArray<PK_LEN>(fields.posProof.vchFarmerPk), poolPkOrHash,
-            fields.posProof.nPlotK, fields.posProof.challenge, fields.posProof.vchProof);
-    if (mixed_quality_string.IsNull()) {
-        return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, SZ_BAD_WHAT,
-                             "mixed quality-string is null(wrong PoS)\n");
-    }
     uint64_t nBaseIters = GetBaseIters(nTargetHeight, params);
     int nBitsFilter =
             nTargetHeight < params.BHDIP009PlotIdBitsOfFilterEnableOnHeight ? 0 : params.BHDIP009PlotIdBitsOfFilter;
@@ -247,16 +552,7 @@ bool CheckBlockFields(CBlockFields const& fields, uint64_t nTimeOfTheBlock, CBlo
 
     // Check vdf-proof
     LogPrint(BCLog::POC, "%s: checking VDF proof\n", __func__);
-    try {
-        if (!CheckVdfProof(fields.vdfProof, state)) {
-            return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, SZ_BAD_WHAT,
-                    "vdf proof cannot be verified");
-        }
-    } catch (std::exception const& e) {
-        return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, SZ_BAD_WHAT, e.what());
-    }
-
-    return true;
+    return pverifiedMixedQualityString != nullptr || CheckFieldsVdfProof(fields, state);
 }
 
 bool ReleaseBlock(std::shared_ptr<CBlock> pblock, CChainParams const& params) {
@@ -298,24 +594,51 @@ uint64_t GetChiaBlockDifficulty(CBlockIndex const* pindex, Consensus::Params con
     }
 }
 
+arith_uint256 GetChiaBlockNetworkSpace(CBlockIndex const* pindex, Consensus::Params const& params) {
+    assert(pindex != nullptr && pindex->pprev != nullptr);
+    return CalculateNetworkSpace(GetDifficultyForNextIterations(pindex->pprev, params), pindex->chiaposFields.GetTotalIters(),
+                                 params.BHDIP009DifficultyConstantFactorBits);
+}
+
+CBlockMetrics MakeBlockMetrics(CBlockIndex const* pindex, CBlock const& block, Consensus::Params const& params) {
+    assert(pindex != nullptr && pindex->pprev != nullptr && pindex->nHeight >= params.BHDIP009Height);
+    CPosProof const& posProof = block.chiaposFields.posProof;
+    CBlockMetrics metrics;
+    PubKeyOrHash poolPkOrHash = MakePubKeyOrHash(static_cast<PlotPubKeyType>(posProof.nPlotType), posProof.vchPoolPkOrHash);
+    metrics.mixedQualityString = MakeMixedQualityString(MakeArray<PK_LEN>(posProof.vchLocalPk), MakeArray<PK_LEN>(posProof.vchFarmerPk),
+                                                        poolPkOrHash, posProof.nPlotK, posProof.challenge, posProof.vchProof);
+    int nBitsFilter = pindex->nHeight < params.BHDIP009PlotIdBitsOfFilterEnableOnHeight ? 0 : params.BHDIP009PlotIdBitsOfFilter;
+    metrics.nRequiredIters = CalculateIterationsQuality(metrics.mixedQualityString, GetDifficultyForNextIterations(pindex->pprev, params),
+                                                        nBitsFilter, params.BHDIP009DifficultyConstantFactorBits, posProof.nPlotK,
+                                                        GetBaseIters(pindex->nHeight, params));
+    metrics.challenge = MakeChallenge(pindex, params);
+    metrics.nChallengeDifficulty = GetDifficultyForNextIterations(pindex, params);
+    metrics.nNetspace = GetChiaBlockNetworkSpace(pindex, params).GetLow64();
+    metrics.nBlockDuration = pindex->GetBlockTime() - pindex->pprev->GetBlockTime();
+    metrics.nCoinbaseReward = block.vtx[0]->vout[0].nValue;
+    return metrics;
+}
+
 uint64_t GetDifficultyForNextIterations(CBlockIndex const* pindex, Consensus::Params const& params) {
     int nTargetHeight = pindex->nHeight + 1;
     if (nTargetHeight == params.BHDIP009Height) {
         return params.BHDIP009StartDifficulty;
     }
-    arith_uint256 totalDifficulty{0};
-    int nCount = params.BHDIP009DifficultyEvalWindow;
-    while (nCount > 0 && pindex != nullptr && pindex->nHeight >= params.BHDIP009Height) {
-        totalDifficulty += GetChiaBlockDifficulty(pindex, params);
-        // next
-        --nCount;
-        pindex = pindex->pprev;
-    }
-    int nBlocksCalc = params.BHDIP009DifficultyEvalWindow - nCount;
-    if (nBlocksCalc == 0) {
+    int nBlocksCalc = std::min(pindex->nHeight - params.BHDIP009Height + 1, params.BHDIP009DifficultyEvalWindow);
+    if (nBlocksCalc <= 0) {
         return params.BHDIP009StartDifficulty;
     }
-    return (totalDifficulty / nBlocksCalc).GetLow64();
+    return (pindex->nChiaDifficultySum / nBlocksCalc).GetLow64();
+}
+
+uint64_t AdjustBlockDifficulty(uint64_t nDifficultyPrev, uint64_t nTotalDuration, int nTargetHeight, Consensus::Params const& params) {
+    double targetMulFactor = 1.0;
+    if (nTargetHeight >= params.BHDIP010TargetSpacingMulFactorEnableAtHeight) {
+        targetMulFactor = params.BHDIP010TargetSpacingMulFactor;
+    }
+    return AdjustDifficulty(nDifficultyPrev, nTotalDuration, params.BHDIP008TargetSpacing,
+                            QueryDurationFix(nTargetHeight, params.BHDIP009TargetDurationFixes),
+                            GetDifficultyChangeMaxFactor(nTargetHeight, params), params.BHDIP009StartDifficulty, targetMulFactor);
 }
 
 int GetBaseIters(int nTargetHeight, Consensus::Params const& params) {
@@ -337,70 +660,47 @@ double GetDifficultyChangeMaxFactor(int nTargetHeight, Consensus::Params const&
 }
 
 bool AddLocalVdfRequest(uint256 const& challenge, uint64_t nIters) {
-    AssertLockHeld(cs_main);
-    auto it = g_vdf_requests.find(challenge);
-    if (it == std::cend(g_vdf_requests)) {
-        g_vdf_requests.insert(std::make_pair(challenge, std::set<uint64_t>{nIters}));
-        return true;
-    }
-    if (it->second.find(nIters) == std::cend(it->second)) {
-        it->second.insert(nIters);
-        return true;
-    }
-    return false;
+    return vdfStore.AddRequest(challenge, nIters);
 }
 
 std::set<uint64_t> QueryLocalVdfRequests(uint256 const& challenge) {
-    AssertLockHeld(cs_main);
-    auto it = g_vdf_requests.find(challenge);
-    if (it == std::cend(g_vdf_requests)) {
-        return {};
-    }
-    return it->second;
+    return vdfStore.QueryRequests(challenge);
 }
 
 bool AddLocalVdfProof(CVdfProof vdfProof) {
-    AssertLockHeld(cs_main);
-    auto it = g_vdf_proofs.find(vdfProof.challenge);
-    if (it == std::cend(g_vdf_proofs)) {
-        g_vdf_proofs.insert(std::make_pair(vdfProof.challenge, std::vector<CVdfProof>{std::move(vdfProof)}));
-        return true;
-    }
-    auto it_vdfProof = std::find_if(std::cbegin(it->second), std::cend(it->second), [&vdfProof](CVdfProof const& vdfProofItem) {
-        return vdfProof.Equals(vdfProofItem);
-    });
-    if (it_vdfProof == std::cend(it->second)) {
-        it->second.push_back(std::move(vdfProof));
-        return true;
+    if (!vdfStore.AddProof(std::move(vdfProof))) {
+        return false;
     }
-    return false;
+    NotifyChallengeUpdate();
+    return true;
 }
 
 bool FindLocalVdfProof(uint256 const& challenge, uint64_t nIters, CVdfProof* pvdfProof) {
-    AssertLockHeld(cs_main);
-    auto it = g_vdf_proofs.find(challenge);
-    if (it == std::cend(g_vdf_proofs)) {
-        return false;
-    }
-    auto it_vdfProof = std::find_if(std::cbegin(it->second), std::cend(it->second), [nIters](CVdfProof const& vdfProof) {
-        return vdfProof.nVdfIters >= nIters;
-    });
-    if (it_vdfProof == std::cend(it->second)) {
-        return false;
-    }
-    if (pvdfProof) {
-        *pvdfProof = *it_vdfProof;
-    }
-    return true;
+    return vdfStore.FindProof(challenge, nIters, pvdfProof);
 }
 
 std::vector<CVdfProof> QueryLocalVdfProof(uint256 const& challenge) {
-    AssertLockHeld(cs_main);
-    auto it = g_vdf_proofs.find(challenge);
-    if (it == std::cend(g_vdf_proofs)) {
-        return {};
+    return vdfStore.QueryProofs(challenge);
+}
+
+void NotifyChallengeUpdate() {
+    {
+        LOCK(cs_challengeUpdate);
+        ++nChallengeUpdateSequence;
     }
-    return it->second;
+    cvChallengeUpdate.notify_all();
+}
+
+uint64_t GetChallengeUpdateSequence() {
+    LOCK(cs_challengeUpdate);
+    return nChallengeUpdateSequence;
+}
+
+bool WaitForChallengeUpdate(uint64_t nSequence, std::chrono::steady_clock::time_point deadline) {
+    WAIT_LOCK(cs_challengeUpdate, lock);
+    return cvChallengeUpdate.wait_until(lock, deadline, [nSequence]() EXCLUSIVE_LOCKS_REQUIRED(cs_challengeUpdate) {
+        return nChallengeUpdateSequence != nSequence;
+    });
 }
 
 }  // namespace chiapos
@@ -8,14 +8,20 @@
 #include <chiapos/kernel/utils.h>
 #include <chiapos/kernel/vdf.h>
 #include <consensus/validation.h>
+#include <cuckoocache.h>
+#include <script/sigcache.h>
 #include <serialize.h>
 #include <uint256.h>
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <string>
 #include <tuple>
 #include <vector>
 
+#include <boost/thread/shared_mutex.hpp>
+
 class CChainParams;
 class CConnman;
 class CNode;
@@ -29,10 +35,63 @@ uint256 MakeChallenge(CBlockIndex const* pindex, Consensus::Params const& params
 
 bool CheckPosProof(CPosProof const& proof, CValidationState& state, Consensus::Params const& params, int nTargetHeight);
 
+/** Memory of the verified vdf proof cache */
+static const size_t VDF_PROOF_CACHE_BYTES = 1 << 20;
+
+/**
+ * Verified vdf proof cache, to avoid doing the expensive class-group verification twice for every proof
+ * (once when the proof is relayed, and again when the block which uses the proof is accepted)
+ */
+class CVdfProofCache
+{
+private:
+    //! Entries are SHA256(nonce || challenge || iters || witness type || y || proof)
+    uint256 nonce;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_vdfcache;
+    std::atomic<uint64_t> nHits{0};
+    std::atomic<uint64_t> nMisses{0};
+
+public:
+    //! The entries are salted with a random nonce
+    CVdfProofCache();
+
+    explicit CVdfProofCache(uint256 const& nonceIn) : nonce(nonceIn) {}
+
+    void ComputeEntry(uint256& entry, CVdfProof const& proof) const;
+
+    bool Get(uint256 const& entry);
+
+    void Set(uint256& entry);
+
+    uint32_t setup_bytes(size_t n) { return setValid.setup_bytes(n); }
+
+    uint64_t GetHits() const { return nHits; }
+
+    uint64_t GetMisses() const { return nMisses; }
+};
+
+/** The verified vdf proof cache of CheckVdfProof */
+CVdfProofCache& GetVdfProofCache();
+
+/** Initialize the verified vdf proof cache */
+void InitVdfProofCache();
+
+/** Hits and misses of the verified vdf proof cache */
+void GetVdfProofCacheStats(uint64_t& nHits, uint64_t& nMisses);
+
+/** Check the vdf proof, the verified proofs are cached and not verified again */
 bool CheckVdfProof(CVdfProof const& proof, CValidationState& state);
 
+/** Verify the PoS and VDF proofs of the fields, which do not depend on the previous block */
+bool CheckBlockFieldsProofs(CBlockFields const& fields, int nTargetHeight, CValidationState& state,
+                            Consensus::Params const& params, uint256& mixedQualityString);
+
+/** Check the fields against the previous block, the proofs are not verified again when the mixed quality string of verified proofs is given */
 bool CheckBlockFields(CBlockFields const& fields, uint64_t nTimeOfTheBlock, CBlockIndex const* pindexPrev,
-                      CValidationState& state, Consensus::Params const& params);
+                      CValidationState& state, Consensus::Params const& params,
+                      uint256 const* pverifiedMixedQualityString = nullptr);
 
 bool ReleaseBlock(std::shared_ptr<CBlock> pblock, CChainParams const& params);
 
@@ -40,12 +99,42 @@ bool IsTheChainReadyForChiapos(CBlockIndex const* pindex, Consensus::Params cons
 
 uint64_t GetChiaBlockDifficulty(CBlockIndex const* pindex, Consensus::Params const& params);
 
+/** The network space estimated from the iterations of a chia block */
+arith_uint256 GetChiaBlockNetworkSpace(CBlockIndex const* pindex, Consensus::Params const& params);
+
+/** Compute the metrics of a chia block from its full data, the PoS of the block is not verified again */
+CBlockMetrics MakeBlockMetrics(CBlockIndex const* pindex, CBlock const& block, Consensus::Params const& params);
+
+/** The average difficulty of the evaluation window ending with pindex, read from the sums on the block index */
 uint64_t GetDifficultyForNextIterations(CBlockIndex const* pindex, Consensus::Params const& params);
 
+/** The difficulty of the chia block at the target height, adjusted from the average difficulty of the window before it by the vdf duration of the block */
+uint64_t AdjustBlockDifficulty(uint64_t nDifficultyPrev, uint64_t nTotalDuration, int nTargetHeight, Consensus::Params const& params);
+
 int GetBaseIters(int nTargetHeight, Consensus::Params const& params);
 
 double GetDifficultyChangeMaxFactor(int nTargetHeight, Consensus::Params const& params);
 
+/** Default for -maxvdfstore, the memory limit of the local vdf requests and proofs in megabytes */
+static const int64_t DEFAULT_MAX_VDF_STORE_SIZE = 16;
+
+/** The challenges seen more than this count of blocks behind the tip are evicted from the local vdf store */
+static const int VDF_STORE_EXPIRY_DEPTH = 24;
+
+struct VdfStoreStats {
+    size_t nChallenges;
+    size_t nUsage;
+    size_t nMaxUsage;
+};
+
+/** Apply -maxvdfstore to the local vdf store */
+void InitLocalVdfStore();
+
+/** Set the tip height which new challenges are stamped with and evict the challenges too far behind it, called whenever the tip changes, the tip challenge is kept over the memory limit */
+void PruneLocalVdfStore(int nTipHeight, uint256 const& tipChallenge);
+
+VdfStoreStats GetLocalVdfStoreStats();
+
 bool AddLocalVdfRequest(uint256 const& challenge, uint64_t nIters);
 
 std::set<uint64_t> QueryLocalVdfRequests(uint256 const& challenge);
@@ -56,6 +145,14 @@ bool FindLocalVdfProof(uint256 const& challenge, uint64_t nIters, CVdfProof* pvd
 
 std::vector<CVdfProof> QueryLocalVdfProof(uint256 const& challenge);
 
+/** Wake the miners waiting for the challenge, called on a new tip and on a new local vdf proof */
+void NotifyChallengeUpdate();
+
+uint64_t GetChallengeUpdateSequence();
+
+/** Wait for an update after the sequence, returns false on timeout */
+bool WaitForChallengeUpdate(uint64_t nSequence, std::chrono::steady_clock::time_point deadline);
+
 }  // namespace chiapos
 
 #endif
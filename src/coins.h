@@ -18,7 +18,9 @@
 #include <assert.h>
 #include <stdint.h>
 
+#include <array>
 #include <functional>
+#include <map>
 #include <memory>
 #include <set>
 #include <unordered_map>
@@ -224,6 +226,145 @@ struct CCoinsCacheEntry
 
 typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
 
+/**
+ * Sum of pledge amounts. The term weighted sum is calculated exactly as summing `nWeightPercent * amount / 100`
+ * coin by coin, which is `nWeightPercent * (amount / 100) + nWeightPercent * (amount % 100) / 100`, so the
+ * count of coins for each remainder of amount is kept.
+ *
+ * Serialized format:
+ * - VARINT(nTotal)
+ * - the count of remainders followed by each VARINT(remainder) and VARINT(count)
+ */
+struct CPledgeAmountSum
+{
+    CAmount nTotal{0};
+    std::map<uint8_t, int64_t> mapRemainderCount;
+
+    void Add(CAmount nAmount, int nSign) {
+        nTotal += nSign * nAmount;
+        int64_t& nCount = mapRemainderCount[static_cast<uint8_t>(nAmount % 100)];
+        nCount += nSign;
+        if (nCount == 0)
+            mapRemainderCount.erase(static_cast<uint8_t>(nAmount % 100));
+    }
+
+    void Merge(const CPledgeAmountSum& other) {
+        nTotal += other.nTotal;
+        for (const auto& pair : other.mapRemainderCount) {
+            int64_t& nCount = mapRemainderCount[pair.first];
+            nCount += pair.second;
+            if (nCount == 0)
+                mapRemainderCount.erase(pair.first);
+        }
+    }
+
+    bool IsNull() const { return nTotal == 0 && mapRemainderCount.empty(); }
+
+    CAmount GetWeighted(int nWeightPercent) const {
+        CAmount nRemainders = 0, nWeightedRemainders = 0;
+        for (const auto& pair : mapRemainderCount) {
+            nRemainders += pair.first * pair.second;
+            nWeightedRemainders += nWeightPercent * pair.first / 100 * pair.second;
+        }
+        assert((nTotal - nRemainders) % 100 == 0);
+        return nWeightPercent * ((nTotal - nRemainders) / 100) + nWeightedRemainders;
+    }
+
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        assert(nTotal >= 0);
+        ::Serialize(s, VARINT(nTotal, VarIntMode::NONNEGATIVE_SIGNED));
+        WriteCompactSize(s, mapRemainderCount.size());
+        for (const auto& pair : mapRemainderCount) {
+            assert(pair.second > 0);
+            ::Serialize(s, pair.first);
+            ::Serialize(s, VARINT(pair.second, VarIntMode::NONNEGATIVE_SIGNED));
+        }
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream &s) {
+        ::Unserialize(s, VARINT(nTotal, VarIntMode::NONNEGATIVE_SIGNED));
+        mapRemainderCount.clear();
+        uint64_t nSize = ReadCompactSize(s);
+        for (uint64_t i = 0; i < nSize; ++i) {
+            uint8_t nRemainder;
+            int64_t nCount;
+            ::Unserialize(s, nRemainder);
+            ::Unserialize(s, VARINT(nCount, VarIntMode::NONNEGATIVE_SIGNED));
+            mapRemainderCount[nRemainder] = nCount;
+        }
+    }
+};
+
+/**
+ * Running totals of the unspent coins related to an account. In a cache view they are kept as the delta
+ * against the base view.
+ */
+struct CAccountTotals
+{
+    //! The index of point types, see GetPointTypeIndex()
+    static const int POINT_TYPE_COUNT = 5;
+    //! The chia point types with terms, DATACARRIER_TYPE_CHIA_POINT to DATACARRIER_TYPE_CHIA_POINT_TERM_3
+    static const int TERM_COUNT = 4;
+
+    //! Amount of unspent coins
+    CAmount nCoinAmount{0};
+    //! The highest height of coins that have been added, it is never decreased when the coin is spent
+    uint32_t nCoinMaxHeight{0};
+    //! Count of unspent bind coins
+    int64_t nBindBurstCount{0};
+    int64_t nBindChiaCount{0};
+    //! Point coins by point type
+    std::array<CPledgeAmountSum, POINT_TYPE_COUNT> pointSend;
+    std::array<CPledgeAmountSum, POINT_TYPE_COUNT> pointReceive;
+    //! Retarget coins by the term of the retargeted point
+    std::array<CPledgeAmountSum, TERM_COUNT> retargetSend;
+    std::array<CPledgeAmountSum, TERM_COUNT> retargetReceive;
+    //! (memory only) Count of the retarget coins sent by the account which were spent or added again in a cache over
+    //! an entry which may be in the base view. The database scan keeps counting those coins until they are flushed,
+    //! the totals don't, so the balances of the account are scanned until then.
+    uint32_t nRetargetSendRewrites{0};
+
+    static int GetPointTypeIndex(DatacarrierType type) {
+        assert(type == DATACARRIER_TYPE_POINT || DatacarrierTypeIsChiaPoint(type));
+        return type == DATACARRIER_TYPE_POINT ? 0 : 1 + (type - DATACARRIER_TYPE_CHIA_POINT);
+    }
+
+    static int GetTermIndex(DatacarrierType type) {
+        assert(DatacarrierTypeIsChiaPoint(type));
+        return type - DATACARRIER_TYPE_CHIA_POINT;
+    }
+
+    void Merge(const CAccountTotals& other);
+    bool IsNull() const;
+
+    /** Same as CCoinsView::GetBalance() but calculated from the totals */
+    CAmount GetBalance(CAmount *balanceBindPlotter, CAmount *balancePointSend, CAmount *balancePointReceive, PledgeTerms const* terms, bool includeBurst) const;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(VARINT(nCoinAmount, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(nCoinMaxHeight));
+        READWRITE(VARINT(nBindBurstCount, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(nBindChiaCount, VarIntMode::NONNEGATIVE_SIGNED));
+        for (auto& sum : pointSend) READWRITE(sum);
+        for (auto& sum : pointReceive) READWRITE(sum);
+        for (auto& sum : retargetSend) READWRITE(sum);
+        for (auto& sum : retargetReceive) READWRITE(sum);
+    }
+};
+
+typedef std::map<CAccountID, CAccountTotals> CAccountTotalsMap;
+
+/**
+ * Apply a coin to the totals of the accounts it relates to. nSign is 1 when the coin is added and -1 when
+ * it is spent. Only coins with an owner account are applied, the same as the account indexes of CCoinsViewDB.
+ */
+void ApplyCoinToAccountTotals(CAccountTotalsMap& mapTotals, const COutPoint& outpoint, const Coin& coin, int nSign);
+
 /** Bind plotter coin information */
 struct CBindPlotterCoinInfo
 {
@@ -309,7 +450,8 @@ public:
 
     //! Do a bulk modification (multiple Coin changes + BestBlock change).
     //! The passed mapCoins can be modified.
-    virtual bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock);
+    //! The passed mapTotals is the delta of account totals caused by the changes of mapCoins.
+    virtual bool BatchWrite(CCoinsMap &mapCoins, CAccountTotalsMap &mapTotals, const uint256 &hashBlock);
 
     //! Get a cursor to iterate over the whole spendable state
     virtual CCoinsViewCursorRef Cursor() const;
@@ -333,6 +475,9 @@ public:
 
     //! Get plotter bind all coin entries.
     virtual CBindPlotterCoinsMap GetBindPlotterEntries(const CPlotterBindData &bindData) const;
+
+    //! Retrieve the running totals of an account. Returns false when the view doesn't maintain them.
+    virtual bool GetAccountTotals(const CAccountID &accountID, CAccountTotals &totals) const;
 };
 
 
@@ -349,7 +494,7 @@ public:
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
     void SetBackend(CCoinsView &viewIn);
-    bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
+    bool BatchWrite(CCoinsMap &mapCoins, CAccountTotalsMap &mapTotals, const uint256 &hashBlock) override;
     CCoinsViewCursorRef Cursor() const override;
     CCoinsViewCursorRef Cursor(const CAccountID &accountID) const override;
     CCoinsViewCursorRef PointSendCursor(const CAccountID &accountID, PointType pt) const override;
@@ -358,6 +503,7 @@ public:
     CAmount GetBalance(const CAccountID &accountID, const CCoinsMap &mapChildCoins, CAmount *balanceBindPlotter, CAmount *balancePointSend, CAmount *balancePointReceive, PledgeTerms const* terms, int nHeight, bool includeBurst) const override;
     CBindPlotterCoinsMap GetAccountBindPlotterEntries(const CAccountID &accountID, const CPlotterBindData &bindData = {}) const override;
     CBindPlotterCoinsMap GetBindPlotterEntries(const CPlotterBindData &bindData) const override;
+    bool GetAccountTotals(const CAccountID &accountID, CAccountTotals &totals) const override;
 };
 
 
@@ -372,6 +518,9 @@ protected:
     mutable uint256 hashBlock;
     mutable CCoinsMap cacheCoins;
 
+    /* Delta of account totals against the base view, updated as coins are added and spent. */
+    CAccountTotalsMap cacheTotals;
+
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage;
 
@@ -388,7 +537,7 @@ public:
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
     void SetBestBlock(const uint256 &hashBlock);
-    bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
+    bool BatchWrite(CCoinsMap &mapCoins, CAccountTotalsMap &mapTotals, const uint256 &hashBlock) override;
     CCoinsViewCursorRef Cursor() const override {
         throw std::logic_error("CCoinsViewCache cursor iteration not supported.");
     }
@@ -405,6 +554,7 @@ public:
 
     CBindPlotterCoinsMap GetAccountBindPlotterEntries(const CAccountID &accountID, const CPlotterBindData &bindData = {}) const override;
     CBindPlotterCoinsMap GetBindPlotterEntries(const CPlotterBindData &bindData) const override;
+    bool GetAccountTotals(const CAccountID &accountID, CAccountTotals &totals) const override;
 
     /**
      * Check if we have the given utxo already loaded in this cache.
@@ -470,7 +620,12 @@ public:
     //! Check whether all prevouts of the transaction are present in the UTXO set represented by this view
     bool HaveInputs(const CTransaction& tx) const;
 
-    /** Scan UTXO for the account. Return total balance. */
+    /**
+     * Get balances of the account, from the running totals when they are maintained or else by scanning UTXO. Return total balance.
+     * The scan keeps counting the retarget coins of the database which are spent or added again in a cache until the cache is
+     * flushed, the totals drop them at once. The balances are scanned while the account has such coins, see
+     * CAccountTotals::nRetargetSendRewrites, so they are always the same as the scan.
+     */
     CAmount GetAccountBalance(bool includeBurst, const CAccountID &accountID, CAmount *balanceBindPlotter = nullptr, CAmount *balancePointSend = nullptr, CAmount *balancePointReceive = nullptr, PledgeTerms const* terms = nullptr, int nHeight = 0) const;
 
     /** Return a reference to lastest bind plotter information, or a pruned one if not found. */
@@ -345,7 +345,7 @@ int Consensus::GetBindPlotterLimitHeight(int nBindHeight, CBindPlotterInfo const
             if (::ChainActive()[nHeight]->nPlotterId == lastBindInfo.bindData.GetBurstPlotterId())
                 return std::max(nHeight, lastBindInfo.nHeight) + 1;
         } else if (lastBindInfo.bindData.GetType() == CPlotterBindData::Type::CHIA) {
-            if (::ChainActive()[nHeight]->chiaposFields.posProof.vchFarmerPk == lastBindInfo.bindData.GetChiaFarmerPk().ToBytes())
+            if (::ChainActive()[nHeight]->chiaposFields.vchFarmerPk == lastBindInfo.bindData.GetChiaFarmerPk().ToBytes())
                 return std::max(nHeight, lastBindInfo.nHeight) + 1;
         }
     }
@@ -382,7 +382,7 @@ int Consensus::GetUnbindPlotterLimitHeight(CBindPlotterInfo const& bindInfo, CCo
         if (pindex->nHeight < params.BHDIP009Height) {
             bindData = pindex->nPlotterId;
         } else {
-            bindData = CChiaFarmerPk(pindex->chiaposFields.posProof.vchFarmerPk);
+            bindData = CChiaFarmerPk(pindex->chiaposFields.vchFarmerPk);
         }
         if (bindData == bindInfo.bindData) {
             if (++nMinedBlockCount > params.nCapacityEvalWindow / 40)
@@ -63,6 +63,17 @@ static inline size_t RecursiveDynamicUsage(const CBlockLocator& locator) {
     return memusage::DynamicUsage(locator.vHave);
 }
 
+static inline size_t RecursiveDynamicUsage(const chiapos::CBlockFields& fields) {
+    return memusage::DynamicUsage(fields.posProof.vchPoolPkOrHash) + memusage::DynamicUsage(fields.posProof.vchLocalPk) +
+           memusage::DynamicUsage(fields.posProof.vchFarmerPk) + memusage::DynamicUsage(fields.posProof.vchProof) +
+           memusage::DynamicUsage(fields.vdfProof.vchY) + memusage::DynamicUsage(fields.vdfProof.vchProof) +
+           memusage::DynamicUsage(fields.vchFarmerSignature);
+}
+
+static inline size_t RecursiveDynamicUsage(const chiapos::CBlockIndexFields& fields) {
+    return memusage::DynamicUsage(fields.vchFarmerPk);
+}
+
 template<typename X>
 static inline size_t RecursiveDynamicUsage(const std::shared_ptr<X>& p) {
     return p ? memusage::DynamicUsage(p) + RecursiveDynamicUsage(*p) : 0;
@@ -4,8 +4,27 @@
 
 #include <crypto/shabal256.h>
 
+#include <crypto/common.h>
 #include <crypto/shabal/sph_shabal.h>
 
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+#if defined(USE_ASM)
+#include <cpuid.h>
+#endif
+#endif
+
+namespace shabal256_sse41
+{
+void Hash_4way(unsigned char* const out[4], const unsigned char* const in[4], size_t len);
+}
+
+namespace shabal256_avx2
+{
+void Hash_8way(unsigned char* const out[8], const unsigned char* const in[8], size_t len);
+}
+
 CShabal256::CShabal256()
 {
     cc = new sph_shabal256_context;
@@ -33,3 +52,99 @@ CShabal256& CShabal256::Reset()
     ::sph_shabal256_init(cc);
     return *this;
 }
+
+namespace {
+
+const size_t OUTPUT_LANES_MAX = 8;
+
+typedef void (*HashNwayType)(unsigned char* const out[], const unsigned char* const in[], size_t len);
+
+struct HashNway {
+    HashNwayType hash{nullptr};
+    size_t lanes{1};
+};
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+
+HashNway DetectHashNway()
+{
+    HashNway ret;
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+    uint32_t eax, ebx, ecx, edx;
+    __cpuid_count(1, 0, eax, ebx, ecx, edx);
+    bool have_sse4 = (ecx >> 19) & 1;
+    bool have_xsave = (ecx >> 27) & 1;
+    bool have_avx = (ecx >> 28) & 1;
+    bool have_avx2 = false;
+    if (have_sse4) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+    (void)have_avx2;
+    (void)have_xsave;
+    (void)have_avx;
+
+#if defined(ENABLE_SSE41) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_sse4) {
+        ret.hash = shabal256_sse41::Hash_4way;
+        ret.lanes = 4;
+    }
+#endif
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_avx2 && have_avx && have_xsave && AVXEnabled()) {
+        ret.hash = shabal256_avx2::Hash_8way;
+        ret.lanes = 8;
+    }
+#endif
+#endif
+    return ret;
+}
+
+const HashNway& GetHashNway()
+{
+    static const HashNway hashNway = DetectHashNway();
+    return hashNway;
+}
+
+} // namespace
+
+void Shabal256Batch(unsigned char* const out[], const unsigned char* const in[], size_t len, size_t count)
+{
+    const HashNway& hashNway = GetHashNway();
+    size_t i = 0;
+    if (hashNway.hash != nullptr) {
+        for (; i + hashNway.lanes <= count; i += hashNway.lanes) {
+            hashNway.hash(out + i, in + i, len);
+        }
+        if (count - i > 1) {
+            // Fill the unused lanes with the last message, it's still faster than hashing one by one
+            unsigned char dummy[OUTPUT_LANES_MAX][CShabal256::OUTPUT_SIZE];
+            unsigned char* laneOut[OUTPUT_LANES_MAX];
+            const unsigned char* laneIn[OUTPUT_LANES_MAX];
+            for (size_t lane = 0; lane < hashNway.lanes; ++lane) {
+                laneOut[lane] = i + lane < count ? out[i + lane] : dummy[lane];
+                laneIn[lane] = i + lane < count ? in[i + lane] : in[count - 1];
+            }
+            hashNway.hash(laneOut, laneIn, len);
+            i = count;
+        }
+    }
+    CShabal256 shabal256;
+    for (; i < count; ++i) {
+        shabal256.Write(in[i], len).Finalize(out[i]);
+    }
+}
+
+size_t Shabal256BatchLanes()
+{
+    return GetHashNway().lanes;
+}
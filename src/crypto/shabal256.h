@@ -23,4 +23,13 @@ public:
     CShabal256& Reset();
 };
 
+/**
+ * Compute the SHABAL-256 hashes of count messages of the same length.
+ * Several messages are hashed at once when the CPU supports SSE4.1 or AVX2.
+ */
+void Shabal256Batch(unsigned char* const out[], const unsigned char* const in[], size_t len, size_t count);
+
+/** Return the parallel lanes of Shabal256Batch on this CPU, 1 when messages are hashed one by one. */
+size_t Shabal256BatchLanes();
+
 #endif // BITCOIN_CRYPTO_SHABAL256_H
\ No newline at end of file
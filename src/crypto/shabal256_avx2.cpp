@@ -0,0 +1,154 @@
+// Copyright (c) 2017-2020 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// This is a translation to AVX2 of the SHABAL-256 in crypto/shabal/shabal.cpp, 8 messages are hashed at once.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include <crypto/common.h>
+
+namespace shabal256_avx2 {
+namespace {
+
+__m256i inline K(uint32_t x) { return _mm256_set1_epi32(x); }
+
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+__m256i inline Sub(__m256i x, __m256i y) { return _mm256_sub_epi32(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+__m256i inline Xor(__m256i x, __m256i y, __m256i z) { return Xor(Xor(x, y), z); }
+__m256i inline Or(__m256i x, __m256i y) { return _mm256_or_si256(x, y); }
+__m256i inline AndNot(__m256i x, __m256i y) { return _mm256_andnot_si256(x, y); }
+__m256i inline Not(__m256i x) { return Xor(x, K(0xFFFFFFFFul)); }
+__m256i inline ShR(__m256i x, int n) { return _mm256_srli_epi32(x, n); }
+__m256i inline ShL(__m256i x, int n) { return _mm256_slli_epi32(x, n); }
+__m256i inline RotL(__m256i x, int n) { return Or(ShL(x, n), ShR(x, 32 - n)); }
+__m256i inline Mul3(__m256i x) { return Add(ShL(x, 1), x); }
+__m256i inline Mul5(__m256i x) { return Add(ShL(x, 2), x); }
+
+const uint32_t A_INIT[12] = {
+    0x52F84552ul, 0xE54B7999ul, 0x2D8EE3ECul, 0xB9645191ul, 0xE0078B86ul, 0xBB7C44C9ul,
+    0xD2B5C1CAul, 0xB0D2EB8Cul, 0x14CE5A45ul, 0x22AF50DCul, 0xEFFDBC6Bul, 0xEB21B74Aul
+};
+const uint32_t B_INIT[16] = {
+    0xB555C6EEul, 0x3E710596ul, 0xA72A652Ful, 0x9301515Ful, 0xDA28C1FAul, 0x696FD868ul, 0x9CB6BF72ul, 0x0AFE4002ul,
+    0xA6E03615ul, 0x5138C1D4ul, 0xBE216306ul, 0xB38B8890ul, 0x3EA8B96Bul, 0x3299ACE4ul, 0x30924DD4ul, 0x55CB34A5ul
+};
+const uint32_t C_INIT[16] = {
+    0xB405F031ul, 0xC4233EBAul, 0xB3733979ul, 0xC0DD9D55ul, 0xC51C28AEul, 0xA327B8E1ul, 0x56C56167ul, 0xED614433ul,
+    0x88B59D60ul, 0x60E2CEBAul, 0x758B4B8Bul, 0x83E82A7Ful, 0xBC968828ul, 0xE6E00BF7ul, 0xBA839E55ul, 0x9B491C60ul
+};
+
+struct State {
+    __m256i A[12], B[16], C[16];
+    uint64_t W;
+};
+
+/** Read the little endian word i of the 64-byte block of every lane. */
+__m256i inline Read8(const unsigned char* const blocks[8], int i)
+{
+    return _mm256_set_epi32(ReadLE32(blocks[7] + 4 * i), ReadLE32(blocks[6] + 4 * i), ReadLE32(blocks[5] + 4 * i), ReadLE32(blocks[4] + 4 * i),
+                            ReadLE32(blocks[3] + 4 * i), ReadLE32(blocks[2] + 4 * i), ReadLE32(blocks[1] + 4 * i), ReadLE32(blocks[0] + 4 * i));
+}
+
+void inline Write8(unsigned char* const out[8], int offset, __m256i v)
+{
+    uint32_t words[8];
+    _mm256_storeu_si256((__m256i*)words, v);
+    for (int lane = 0; lane < 8; ++lane) {
+        WriteLE32(out[lane] + offset, words[lane]);
+    }
+}
+
+void inline XorW(State& s)
+{
+    s.A[0] = Xor(s.A[0], K((uint32_t)s.W));
+    s.A[1] = Xor(s.A[1], K((uint32_t)(s.W >> 32)));
+}
+
+void inline SwapBC(State& s)
+{
+    for (int i = 0; i < 16; ++i) {
+        __m256i tmp = s.B[i];
+        s.B[i] = s.C[i];
+        s.C[i] = tmp;
+    }
+}
+
+/** The keyed permutation P of SHABAL. */
+void inline Permute(State& s, const __m256i M[16])
+{
+    for (int i = 0; i < 16; ++i) {
+        s.B[i] = RotL(s.B[i], 17);
+    }
+    for (int j = 0; j < 48; ++j) {
+        int i = j % 16;
+        __m256i& a = s.A[j % 12];
+        a = Xor(Mul3(Xor(a, Mul5(RotL(s.A[(j + 11) % 12], 15)), s.C[(24 - i) % 16])),
+                Xor(s.B[(i + 13) % 16], AndNot(s.B[(i + 6) % 16], s.B[(i + 9) % 16]), M[i]));
+        s.B[i] = Not(Xor(RotL(s.B[i], 1), a));
+    }
+    for (int k = 0; k < 36; ++k) {
+        s.A[(47 - k) % 12] = Add(s.A[(47 - k) % 12], s.C[(54 - k) % 16]);
+    }
+}
+
+} // namespace
+
+void Hash_8way(unsigned char* const out[8], const unsigned char* const in[8], size_t len)
+{
+    State s;
+    for (int i = 0; i < 12; ++i) s.A[i] = K(A_INIT[i]);
+    for (int i = 0; i < 16; ++i) s.B[i] = K(B_INIT[i]);
+    for (int i = 0; i < 16; ++i) s.C[i] = K(C_INIT[i]);
+    s.W = 1;
+
+    // Full blocks
+    __m256i M[16];
+    const unsigned char* blocks[8];
+    size_t offset = 0;
+    for (; offset + 64 <= len; offset += 64) {
+        for (int lane = 0; lane < 8; ++lane) blocks[lane] = in[lane] + offset;
+        for (int i = 0; i < 16; ++i) {
+            M[i] = Read8(blocks, i);
+            s.B[i] = Add(s.B[i], M[i]);
+        }
+        XorW(s);
+        Permute(s, M);
+        for (int i = 0; i < 16; ++i) s.C[i] = Sub(s.C[i], M[i]);
+        SwapBC(s);
+        ++s.W;
+    }
+
+    // Padded final block and the three extra rounds
+    unsigned char tail[8][64];
+    for (int lane = 0; lane < 8; ++lane) {
+        memcpy(tail[lane], in[lane] + offset, len - offset);
+        tail[lane][len - offset] = 0x80;
+        memset(tail[lane] + len - offset + 1, 0, 64 - (len - offset + 1));
+        blocks[lane] = tail[lane];
+    }
+    for (int i = 0; i < 16; ++i) {
+        M[i] = Read8(blocks, i);
+        s.B[i] = Add(s.B[i], M[i]);
+    }
+    XorW(s);
+    Permute(s, M);
+    for (int round = 0; round < 3; ++round) {
+        SwapBC(s);
+        XorW(s);
+        Permute(s, M);
+    }
+
+    for (int i = 8; i < 16; ++i) {
+        Write8(out, (i - 8) * 4, s.B[i]);
+    }
+}
+
+} // namespace shabal256_avx2
+
+#endif
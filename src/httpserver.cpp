@@ -53,7 +53,12 @@ public:
     }
     void operator()() override
     {
-        func(req.get(), path);
+        try {
+            func(req.get(), path);
+        } catch (const std::exception& e) {
+            // The request is answered with an internal error when it is destroyed unhandled
+            LogPrintf("%s: %s\n", path, e.what());
+        }
     }
 
     std::unique_ptr<HTTPRequest> req;
@@ -0,0 +1,375 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/pledgeindex.h>
+
+#include <chainparams.h>
+#include <consensus/params.h>
+#include <dbwrapper.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <functional>
+#include <stdexcept>
+
+/* The index database stores the pledge txs by height and tx hash, with the height of each tx hash.
+ * The accounts of the sender and the receiver refer to their pledge txs, and the withdraws and the
+ * retargets refer to the pledge txs they spent, so the spent pledge txs become available again
+ * when the blocks are rewound.
+ *
+ * Keys for the pledge txs have the type [DB_PLEDGE_TX, uint32 (BE), uint256], the height is
+ * represented as big-endian so that sequential reads of the pledge txs by height are fast.
+ * Keys for the heights have the type [DB_PLEDGE_TX_HEIGHT, uint256].
+ * Keys for the accounts have the type [DB_PLEDGE_ACCOUNT, uint160, uint32 (BE), uint256].
+ * Keys for the spends have the type [DB_PLEDGE_SPENT, uint32 (BE), uint256], keyed by the spending tx.
+ */
+constexpr char DB_PLEDGE_TX = 'p';
+constexpr char DB_PLEDGE_TX_HEIGHT = 'h';
+constexpr char DB_PLEDGE_ACCOUNT = 'a';
+constexpr char DB_PLEDGE_SPENT = 's';
+
+std::unique_ptr<PledgeIndex> g_pledgeindex;
+
+namespace {
+
+struct DBHeightTxKey {
+    char prefix;
+    int height;
+    uint256 txid;
+
+    DBHeightTxKey() : prefix(0), height(0) {}
+    DBHeightTxKey(char prefix_in, int height_in, const uint256& txid_in) : prefix(prefix_in), height(height_in), txid(txid_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, prefix);
+        ser_writedata32be(s, height);
+        s << txid;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        prefix = ser_readdata8(s);
+        height = ser_readdata32be(s);
+        s >> txid;
+    }
+};
+
+struct DBAccountKey {
+    CAccountID accountID;
+    int height;
+    uint256 txid;
+
+    DBAccountKey() : height(0) {}
+    DBAccountKey(const CAccountID& accountID_in, int height_in, const uint256& txid_in) : accountID(accountID_in), height(height_in), txid(txid_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_PLEDGE_ACCOUNT);
+        s << accountID;
+        ser_writedata32be(s, height);
+        s << txid;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_PLEDGE_ACCOUNT) {
+            throw std::ios_base::failure("Invalid format for pledge index DB account key");
+        }
+        s >> accountID;
+        height = ser_readdata32be(s);
+        s >> txid;
+    }
+};
+
+} // namespace
+
+/**
+ * Access to the pledgeindex database (indexes/pledgeindex/)
+ */
+class PledgeIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the pledge tx with the given hash. Returns false if the tx hash is not indexed.
+    bool ReadPledgeTx(const uint256& txid, PledgeTx& pledgeTx) const;
+
+    /// Write a pledge tx, with its height and accounts.
+    void WritePledgeTx(CDBBatch& batch, const PledgeTx& pledgeTx);
+
+    /// Erase the pledge txs and the spends above the height, the spent pledge txs become available.
+    bool EraseAboveHeight(int nHeight);
+};
+
+PledgeIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "pledgeindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool PledgeIndex::DB::ReadPledgeTx(const uint256& txid, PledgeTx& pledgeTx) const
+{
+    int nHeight;
+    if (!Read(std::make_pair(DB_PLEDGE_TX_HEIGHT, txid), nHeight)) {
+        return false;
+    }
+    return Read(DBHeightTxKey(DB_PLEDGE_TX, nHeight, txid), pledgeTx);
+}
+
+void PledgeIndex::DB::WritePledgeTx(CDBBatch& batch, const PledgeTx& pledgeTx)
+{
+    batch.Write(DBHeightTxKey(DB_PLEDGE_TX, pledgeTx.nHeight, pledgeTx.txHash), pledgeTx);
+    batch.Write(std::make_pair(DB_PLEDGE_TX_HEIGHT, pledgeTx.txHash), pledgeTx.nHeight);
+    batch.Write(DBAccountKey(pledgeTx.sender, pledgeTx.nHeight, pledgeTx.txHash), '\0');
+    if (pledgeTx.receiver != pledgeTx.sender) {
+        batch.Write(DBAccountKey(pledgeTx.receiver, pledgeTx.nHeight, pledgeTx.txHash), '\0');
+    }
+}
+
+bool PledgeIndex::DB::EraseAboveHeight(int nHeight)
+{
+    CDBBatch batch(*this);
+    std::unique_ptr<CDBIterator> db_it(NewIterator());
+
+    // Make the spent pledge txs available again
+    std::map<uint256, PledgeTx> mapRestored;
+    db_it->Seek(DBHeightTxKey(DB_PLEDGE_SPENT, nHeight + 1, uint256()));
+    for (; db_it->Valid(); db_it->Next()) {
+        DBHeightTxKey key;
+        uint256 txidSpent;
+        if (!db_it->GetKey(key) || key.prefix != DB_PLEDGE_SPENT) break;
+        if (!db_it->GetValue(txidSpent)) {
+            return error("%s: cannot read the spend of tx %s", __func__, key.txid.ToString());
+        }
+        auto it = mapRestored.find(txidSpent);
+        if (it == mapRestored.end()) {
+            PledgeTx pledgeTx;
+            if (!ReadPledgeTx(txidSpent, pledgeTx)) {
+                return error("%s: cannot read the pledge tx %s", __func__, txidSpent.ToString());
+            }
+            it = mapRestored.emplace(txidSpent, std::move(pledgeTx)).first;
+        }
+        it->second.fAvailable = true;
+        batch.Erase(key);
+    }
+
+    // Erase the pledge txs
+    db_it->Seek(DBHeightTxKey(DB_PLEDGE_TX, nHeight + 1, uint256()));
+    for (; db_it->Valid(); db_it->Next()) {
+        DBHeightTxKey key;
+        PledgeTx pledgeTx;
+        if (!db_it->GetKey(key) || key.prefix != DB_PLEDGE_TX) break;
+        if (!db_it->GetValue(pledgeTx)) {
+            return error("%s: cannot read the pledge tx %s", __func__, key.txid.ToString());
+        }
+        batch.Erase(key);
+        batch.Erase(std::make_pair(DB_PLEDGE_TX_HEIGHT, pledgeTx.txHash));
+        batch.Erase(DBAccountKey(pledgeTx.sender, pledgeTx.nHeight, pledgeTx.txHash));
+        batch.Erase(DBAccountKey(pledgeTx.receiver, pledgeTx.nHeight, pledgeTx.txHash));
+        mapRestored.erase(pledgeTx.txHash);
+    }
+
+    for (const auto& restored : mapRestored) {
+        WritePledgeTx(batch, restored.second);
+    }
+    return WriteBatch(batch);
+}
+
+namespace {
+
+/** The changes of a block being written, the earlier pledge txs are read from the index database */
+class PledgeTxBlockView : public PledgeTxView
+{
+public:
+    using Reader = std::function<bool(const uint256&, PledgeTx&)>;
+
+    /// The pledge txs added or spent by the block
+    std::map<uint256, PledgeTx> m_changed;
+    /// The spending tx hash to the height and the hash of the pledge tx spent by an earlier block
+    std::map<uint256, std::pair<int, uint256>> m_spends;
+
+    explicit PledgeTxBlockView(Reader reader) : m_reader(std::move(reader)) {}
+
+    bool GetPledgeTx(const uint256& txHash, PledgeTx& pledgeTx) override
+    {
+        auto it = m_changed.find(txHash);
+        if (it != m_changed.end()) {
+            pledgeTx = it->second;
+            return true;
+        }
+        return m_reader(txHash, pledgeTx);
+    }
+
+    void AddPledgeTx(PledgeTx pledgeTx) override
+    {
+        uint256 txHash = pledgeTx.txHash;
+        m_changed[txHash] = std::move(pledgeTx);
+    }
+
+    void SpendPledgeTx(const PledgeTx& pledgeTx, const uint256& spentByTxHash, int nSpentHeight) override
+    {
+        PledgeTx& changed = m_changed[pledgeTx.txHash] = pledgeTx;
+        changed.fAvailable = false;
+        if (pledgeTx.nHeight != nSpentHeight) {
+            m_spends[spentByTxHash] = std::make_pair(nSpentHeight, pledgeTx.txHash);
+        }
+    }
+
+private:
+    Reader m_reader;
+};
+
+} // namespace
+
+void StripPledgeTxs(PledgeTxView& view, const CBlock& block, int nHeight, const Consensus::Params& params)
+{
+    for (auto const& tx : block.vtx) {
+        if (tx->IsCoinBase() || !tx->IsUniform()) {
+            continue;
+        }
+        PledgeTx spentPledgeTx;
+        auto ppayload = ExtractTransactionDatacarrier(*tx, nHeight, {DATACARRIER_TYPE_BINDCHIAFARMER, DATACARRIER_TYPE_CHIA_POINT, DATACARRIER_TYPE_CHIA_POINT_TERM_1, DATACARRIER_TYPE_CHIA_POINT_TERM_2, DATACARRIER_TYPE_CHIA_POINT_TERM_3, DATACARRIER_TYPE_CHIA_POINT_RETARGET});
+        if (ppayload == nullptr) {
+            // Withdraw
+            if (view.GetPledgeTx(tx->vin[0].prevout.hash, spentPledgeTx)) {
+                view.SpendPledgeTx(spentPledgeTx, tx->GetHash(), nHeight);
+            }
+            continue;
+        }
+        assert(tx->vout.size() >= 2);
+        PledgeTx pledgeTx;
+        pledgeTx.blockHash = block.GetHash();
+        pledgeTx.nHeight = nHeight;
+        pledgeTx.txHash = tx->GetHash();
+        // account IDs
+        pledgeTx.sender = ExtractAccountID(tx->vout[0].scriptPubKey);
+        pledgeTx.pledgeType = ppayload->type;
+        pledgeTx.fAvailable = true;
+        if (ppayload->type == DATACARRIER_TYPE_BINDCHIAFARMER) {
+            pledgeTx.receiver = pledgeTx.sender;
+            pledgeTx.nReceivedAmount = tx->vout[0].nValue;
+            pledgeTx.nActualAmount = 0;
+            pledgeTx.pointType = DATACARRIER_TYPE_BINDCHIAFARMER;
+            pledgeTx.nPointHeight = 0;
+            pledgeTx.nExpiresOnHeight = 99999999;
+            pledgeTx.fInTerm = false;
+        } else {
+            if (ppayload->type == DATACARRIER_TYPE_CHIA_POINT_RETARGET) {
+                auto retargetPayload = PointRetargetPayload::As(ppayload);
+                pledgeTx.receiver = retargetPayload->GetReceiverID();
+                pledgeTx.pointType = retargetPayload->GetPointType();
+                pledgeTx.nPointHeight = retargetPayload->nPointHeight;
+                auto txHash = tx->vin[0].prevout.hash;
+                if (!view.GetPledgeTx(txHash, spentPledgeTx)) {
+                    throw std::runtime_error(tinyformat::format("cannot find original pledge-tx(%s)", txHash.GetHex()));
+                }
+                pledgeTx.nReceivedAmount = spentPledgeTx.nReceivedAmount;
+                view.SpendPledgeTx(spentPledgeTx, tx->GetHash(), nHeight);
+            } else {
+                // point
+                auto pointPayload = PointPayload::As(ppayload);
+                pledgeTx.receiver = pointPayload->GetReceiverID();
+                pledgeTx.nReceivedAmount = tx->vout[0].nValue;
+                pledgeTx.pointType = pledgeTx.pledgeType;
+                pledgeTx.nPointHeight = nHeight;
+            }
+            // check if it's state is in-term
+            int nTermIndex = pledgeTx.pointType - DATACARRIER_TYPE_CHIA_POINT;
+            auto const& term = params.BHDIP009PledgeTerms[nTermIndex];
+            int nExpiresOnHeight = pledgeTx.nPointHeight + term.nLockHeight;
+            pledgeTx.fInTerm = nHeight < nExpiresOnHeight;
+            if (pledgeTx.fInTerm) {
+                pledgeTx.nActualAmount = term.nWeightPercent * pledgeTx.nReceivedAmount / 100;
+            } else {
+                pledgeTx.nActualAmount = params.BHDIP009PledgeTerms[0].nWeightPercent * pledgeTx.nReceivedAmount / 100;
+            }
+            pledgeTx.nExpiresOnHeight = nExpiresOnHeight;
+        }
+        // save
+        view.AddPledgeTx(std::move(pledgeTx));
+    }
+}
+
+PledgeIndex::PledgeIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<PledgeIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+PledgeIndex::~PledgeIndex() {}
+
+bool PledgeIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex, int nVersionMask)
+{
+    if (pindex->nHeight < Params().GetConsensus().BHDIP009Height) return true;
+    return WritePledgeTxs(block, pindex->nHeight);
+}
+
+bool PledgeIndex::WritePledgeTxs(const CBlock& block, int nHeight)
+{
+    PledgeTxBlockView view([this](const uint256& txHash, PledgeTx& pledgeTx) { return m_db->ReadPledgeTx(txHash, pledgeTx); });
+    try {
+        StripPledgeTxs(view, block, nHeight, Params().GetConsensus());
+    } catch (const std::runtime_error& e) {
+        return error("%s: %s", __func__, e.what());
+    }
+
+    CDBBatch batch(*m_db);
+    for (const auto& changed : view.m_changed) {
+        m_db->WritePledgeTx(batch, changed.second);
+    }
+    for (const auto& spend : view.m_spends) {
+        batch.Write(DBHeightTxKey(DB_PLEDGE_SPENT, spend.second.first, spend.first), spend.second.second);
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool PledgeIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    if (!EraseAboveHeight(new_tip->nHeight)) {
+        return false;
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& PledgeIndex::GetDB() const { return *m_db; }
+
+bool PledgeIndex::EraseAboveHeight(int nHeight)
+{
+    return m_db->EraseAboveHeight(nHeight);
+}
+
+bool PledgeIndex::FindPledgeTxs(int nStartHeight, int nEndHeight, const CAccountID* pAccountID, std::vector<PledgeTx>& vPledgeTxs) const
+{
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    if (pAccountID == nullptr) {
+        db_it->Seek(DBHeightTxKey(DB_PLEDGE_TX, nStartHeight, uint256()));
+        for (; db_it->Valid(); db_it->Next()) {
+            DBHeightTxKey key;
+            if (!db_it->GetKey(key) || key.prefix != DB_PLEDGE_TX || key.height > nEndHeight) break;
+            PledgeTx pledgeTx;
+            if (!db_it->GetValue(pledgeTx)) {
+                return error("%s: cannot read the pledge tx %s", __func__, key.txid.ToString());
+            }
+            vPledgeTxs.push_back(std::move(pledgeTx));
+        }
+        return true;
+    }
+
+    db_it->Seek(DBAccountKey(*pAccountID, nStartHeight, uint256()));
+    for (; db_it->Valid(); db_it->Next()) {
+        DBAccountKey key;
+        if (!db_it->GetKey(key) || key.accountID != *pAccountID || key.height > nEndHeight) break;
+        PledgeTx pledgeTx;
+        if (!m_db->Read(DBHeightTxKey(DB_PLEDGE_TX, key.height, key.txid), pledgeTx)) {
+            return error("%s: cannot read the pledge tx %s", __func__, key.txid.ToString());
+        }
+        vPledgeTxs.push_back(std::move(pledgeTx));
+    }
+    return true;
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_PLEDGEINDEX_H
+#define BITCOIN_INDEX_PLEDGEINDEX_H
+
+#include <amount.h>
+#include <chain.h>
+#include <index/base.h>
+#include <primitives/transaction.h>
+#include <script/standard.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <map>
+#include <vector>
+
+namespace Consensus {
+struct Params;
+}
+
+/** A bind, point, term or retarget tx of the chiapos chain */
+struct PledgeTx {
+    uint256 blockHash;
+    int nHeight;
+    uint256 txHash;
+    CAccountID sender;
+    CAccountID receiver;
+    CAmount nReceivedAmount;
+    CAmount nActualAmount;
+    DatacarrierType pledgeType;
+    DatacarrierType pointType;
+    int nPointHeight;
+    int nExpiresOnHeight;
+    bool fAvailable;
+    bool fInTerm;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(blockHash);
+        READWRITE(nHeight);
+        READWRITE(txHash);
+        READWRITE(sender);
+        READWRITE(receiver);
+        READWRITE(nReceivedAmount);
+        READWRITE(nActualAmount);
+        uint32_t nPledgeType = pledgeType, nPointType = pointType;
+        READWRITE(nPledgeType);
+        READWRITE(nPointType);
+        pledgeType = static_cast<DatacarrierType>(nPledgeType);
+        pointType = static_cast<DatacarrierType>(nPointType);
+        READWRITE(nPointHeight);
+        READWRITE(nExpiresOnHeight);
+        READWRITE(fAvailable);
+        READWRITE(fInTerm);
+    }
+};
+
+/** The pledge txs seen so far while the blocks are stripped in order */
+class PledgeTxView
+{
+public:
+    virtual ~PledgeTxView() {}
+
+    virtual bool GetPledgeTx(const uint256& txHash, PledgeTx& pledgeTx) = 0;
+
+    virtual void AddPledgeTx(PledgeTx pledgeTx) = 0;
+
+    /** The pledge tx is withdrawn or retargeted by the tx of the height */
+    virtual void SpendPledgeTx(const PledgeTx& pledgeTx, const uint256& spentByTxHash, int nSpentHeight) = 0;
+};
+
+/** Strip the pledge txs of a block into the view, throw std::runtime_error when a retarget refers to an unknown pledge tx */
+void StripPledgeTxs(PledgeTxView& view, const CBlock& block, int nHeight, const Consensus::Params& params);
+
+/**
+ * PledgeIndex records the pledge txs of the chiapos chain, by tx and by the accounts of
+ * the sender and the receiver, so the pledges can be queried without reading the blocks.
+ */
+class PledgeIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex, int nVersionMask) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "pledgeindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit PledgeIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~PledgeIndex() override;
+
+    /// Look up the pledge txs of the height range.
+    ///
+    /// @param[in]   nStartHeight  The first height of the range.
+    /// @param[in]   nEndHeight  The last height of the range.
+    /// @param[in]   pAccountID  Only the pledge txs sent or received by the account when it isn't null.
+    /// @param[out]  vPledgeTxs  The pledge txs in the order of the height.
+    /// @return  true if the index is read successfully
+    bool FindPledgeTxs(int nStartHeight, int nEndHeight, const CAccountID* pAccountID, std::vector<PledgeTx>& vPledgeTxs) const;
+
+    /// Write the pledge txs of a block, the pledge txs it spends become unavailable.
+    bool WritePledgeTxs(const CBlock& block, int nHeight);
+
+    /// Erase the pledge txs above the height, the pledge txs they spent become available again.
+    bool EraseAboveHeight(int nHeight);
+};
+
+/// The global pledge index, used in querychainpledgeinfo. May be null.
+extern std::unique_ptr<PledgeIndex> g_pledgeindex;
+
+#endif // BITCOIN_INDEX_PLEDGEINDEX_H
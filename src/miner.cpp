@@ -27,6 +27,8 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
+#include <numeric>
 #include <queue>
 #include <utility>
 
@@ -232,6 +234,58 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewChiaBlock(const CBlockI
 {
     int64_t nTimeStart = GetTimeMicros();
 
+    std::unique_ptr<CBlockTemplate> ptemplate =
+        CreateNewChiaBlockTemplate(pindexPrev, scriptPubKeyIn, chiapos::MakeBytes(farmerSk.GetPubKey()));
+    if (!ptemplate) return nullptr;
+
+    int64_t nTime1 = GetTimeMicros();
+
+    FillChiaBlock(ptemplate->block, pindexPrev, farmerSk, posProof, vdfProof, chainparams.GetConsensus());
+
+    int64_t nTime2 = GetTimeMicros();
+
+    CValidationState state;
+    if (!TestBlockValidity(state, chainparams, ptemplate->block, const_cast<CBlockIndex*>(pindexPrev), false, false)) {
+        throw std::runtime_error(
+            strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
+    }
+
+    int64_t nTime3 = GetTimeMicros();
+
+    LogPrint(BCLog::BENCH, "CreateNewChiaBlock() template: %.2fms, fill: %.2fms, validity: %.2fms (total %.2fms)\n",
+        0.001 * (nTime1 - nTimeStart), 0.001 * (nTime2 - nTime1), 0.001 * (nTime3 - nTime2), 0.001 * (nTime3 - nTimeStart));
+
+    return ptemplate;
+}
+
+std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewChiaBlockTemplate(const CBlockIndex *pindexPrev,
+    const CScript &scriptPubKeyIn,
+    const std::vector<uint8_t> &vchFarmerPk)
+{
+    int64_t nTimeStart = GetTimeMicros();
+
+    CAccountID accountID = ExtractAccountID(scriptPubKeyIn);
+    assert(!accountID.IsNull());
+    std::unique_ptr<CBlockTemplate> ptemplate = SelectChiaBlockTransactions(pindexPrev, accountID);
+    if (!ptemplate) return nullptr;
+
+    int64_t nTime1 = GetTimeMicros();
+
+    AddChiaCoinbase(*ptemplate, pindexPrev, scriptPubKeyIn, vchFarmerPk, chainparams);
+
+    int64_t nTime2 = GetTimeMicros();
+
+    LogPrint(BCLog::BENCH, "CreateNewChiaBlockTemplate() packages: %.2fms, coinbase: %.2fms (total %.2fms)\n",
+        0.001 * (nTime1 - nTimeStart), 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
+
+    return ptemplate;
+}
+
+std::unique_ptr<CBlockTemplate> BlockAssembler::SelectChiaBlockTransactions(const CBlockIndex *pindexPrev,
+    const CAccountID &generator)
+{
+    int64_t nTimeStart = GetTimeMicros();
+
     resetBlock();
 
     pblocktemplate.reset(new CBlockTemplate());
@@ -239,8 +293,7 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewChiaBlock(const CBlockI
     if (!pblocktemplate.get()) return nullptr;
     pblock = &pblocktemplate->block; // pointer for convenience
 
-    generatorAccountID = ExtractAccountID(scriptPubKeyIn);
-    assert(!generatorAccountID.IsNull());
+    generatorAccountID = generator;
 
     // Add dummy coinbase tx as first transaction
     pblock->vtx.emplace_back();
@@ -276,19 +329,41 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewChiaBlock(const CBlockI
     int nDescendantsUpdated = 0;
     addPackageTxs(nPackagesSelected, nDescendantsUpdated);
 
-    int64_t nTime1 = GetTimeMicros();
-
     m_last_block_num_txs = nBlockTx;
     m_last_block_weight = nBlockWeight;
 
+    // Fill in header, they are all zero for burst related fields
+    pblock->hashPrevBlock = pindexPrev->GetBlockHash();
+
+    LogPrint(BCLog::POC, "SelectChiaBlockTransactions(): block weight: %u txs: %u fees: %ld sigops %d\n", GetBlockWeight(*pblock), nBlockTx,
+        nFees, nBlockSigOpsCost);
+
+    LogPrint(BCLog::BENCH, "SelectChiaBlockTransactions() packages: %.2fms (%d packages, %d updated descendants)\n",
+        0.001 * (GetTimeMicros() - nTimeStart), nPackagesSelected, nDescendantsUpdated);
+
+    return std::move(pblocktemplate);
+}
+
+void BlockAssembler::AddChiaCoinbase(CBlockTemplate& blocktemplate, const CBlockIndex *pindexPrev,
+    const CScript &scriptPubKeyIn,
+    const std::vector<uint8_t> &vchFarmerPk,
+    const CChainParams &chainparams)
+{
+    AssertLockHeld(cs_main);
+    CBlock& block = blocktemplate.block;
+    assert(block.hashPrevBlock == pindexPrev->GetBlockHash());
+    const Consensus::Params &params = chainparams.GetConsensus();
+    const int nHeight = pindexPrev->nHeight + 1;
+    const CAmount nFees = std::accumulate(blocktemplate.vTxFees.begin() + 1, blocktemplate.vTxFees.end(), CAmount(0));
+
+    CAccountID generatorAccountID = ExtractAccountID(scriptPubKeyIn);
+    assert(!generatorAccountID.IsNull());
+
     // Create coinbase transaction.
     CMutableTransaction coinbaseTx;
     coinbaseTx.vin.resize(1);
     coinbaseTx.vin[0].prevout.SetNull();
 
-    chiapos::PubKey farmerPk = farmerSk.GetPubKey();
-    chiapos::Bytes vchFarmerPk = chiapos::MakeBytes(farmerPk);
-
     coinbaseTx.vin[0].scriptSig = (CScript() << nHeight << vchFarmerPk) + COINBASE_FLAGS;
     assert(coinbaseTx.vin[0].scriptSig.size() <= 100);
 
@@ -307,54 +382,47 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewChiaBlock(const CBlockI
         coinbaseTx.vout[1].scriptPubKey = GetScriptForDestination(fundDest);
         coinbaseTx.vout[1].nValue = blockReward.fund009;
     }
-    pblock->vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
-    pblocktemplate->vchCoinbaseCommitment = GenerateCoinbaseCommitment(*pblock, pindexPrev, params);
-    pblocktemplate->vTxFees[0] = -nFees;
+    block.vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
+    blocktemplate.vchCoinbaseCommitment = GenerateCoinbaseCommitment(block, pindexPrev, params);
+    blocktemplate.vTxFees[0] = -nFees;
 
-    // Fill in header, they are all zero for burst related fields
-    pblock->hashPrevBlock = pindexPrev->GetBlockHash();
-    pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
-    pblocktemplate->vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*pblock->vtx[0]);
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    blocktemplate.vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*block.vtx[0]);
+}
+
+void BlockAssembler::FillChiaBlock(CBlock& block, const CBlockIndex* pindexPrev,
+    const chiapos::CKey &farmerSk,
+    const chiapos::CPosProof &posProof,
+    const chiapos::CVdfProof &vdfProof,
+    const Consensus::Params &params)
+{
+    assert(block.hashPrevBlock == pindexPrev->GetBlockHash());
+    int nHeight = pindexPrev->nHeight + 1;
+
+    // The template may have been assembled a while ago
+    block.nTime = std::max<int64_t>(block.nTime, GetAdjustedTime());
 
     uint64_t nDifficultyPrev = chiapos::GetDifficultyForNextIterations(pindexPrev, params);
 
-    pblock->chiaposFields.posProof = posProof;
-    pblock->chiaposFields.vdfProof = vdfProof;
+    block.chiaposFields.posProof = posProof;
+    block.chiaposFields.vdfProof = vdfProof;
     double targetMulFactor = 1.0;
     if (nHeight >= params.BHDIP010TargetSpacingMulFactorEnableAtHeight) {
         targetMulFactor = params.BHDIP010TargetSpacingMulFactor;
     }
-    pblock->chiaposFields.nDifficulty =
-        chiapos::AdjustDifficulty(nDifficultyPrev, pblock->chiaposFields.GetTotalDuration(), params.BHDIP008TargetSpacing,
+    block.chiaposFields.nDifficulty =
+        chiapos::AdjustDifficulty(nDifficultyPrev, block.chiaposFields.GetTotalDuration(), params.BHDIP008TargetSpacing,
                                   chiapos::QueryDurationFix(nHeight, params.BHDIP009TargetDurationFixes),
                                   chiapos::GetDifficultyChangeMaxFactor(nHeight, params), params.BHDIP009StartDifficulty, targetMulFactor);
 
-    LogPrint(BCLog::POC, "%s: difficulty=%ld, farmer-pk: %s, duration: %ld, iters: %ld\n", __func__, pblock->chiaposFields.nDifficulty,
-              chiapos::BytesToHex(pblock->chiaposFields.posProof.vchFarmerPk), pblock->chiaposFields.GetTotalDuration(),
-              pblock->chiaposFields.GetTotalIters());
+    LogPrint(BCLog::POC, "%s: difficulty=%ld, farmer-pk: %s, duration: %ld, iters: %ld\n", __func__, block.chiaposFields.nDifficulty,
+              chiapos::BytesToHex(block.chiaposFields.posProof.vchFarmerPk), block.chiaposFields.GetTotalDuration(),
+              block.chiaposFields.GetTotalIters());
 
     // Make a signature by using farmer private-key for the block
-    uint256 unsignedHash = pblock->GetUnsignaturedHash();
+    uint256 unsignedHash = block.GetUnsignaturedHash();
     LogPrint(BCLog::POC, "%s: making signature hash: %s\n", __func__, unsignedHash.GetHex());
-    pblock->chiaposFields.vchFarmerSignature = chiapos::MakeBytes(farmerSk.Sign(chiapos::MakeBytes(unsignedHash)));
-
-    LogPrint(BCLog::POC, "CreateNewBlock(): block weight: %u txs: %u fees: %ld sigops %d\n", GetBlockWeight(*pblock), nBlockTx,
-        nFees, nBlockSigOpsCost);
-
-    int64_t nTime2 = GetTimeMicros();
-
-    LogPrint(BCLog::BENCH,
-        "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n",
-        0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1),
-        0.001 * (nTime2 - nTimeStart));
-
-    CValidationState state;
-    if (!TestBlockValidity(state, chainparams, *pblock, const_cast<CBlockIndex*>(pindexPrev), false, false)) {
-        throw std::runtime_error(
-            strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
-    }
-
-    return std::move(pblocktemplate);
+    block.chiaposFields.vchFarmerSignature = chiapos::MakeBytes(farmerSk.Sign(chiapos::MakeBytes(unsignedHash)));
 }
 
 void BlockAssembler::onlyUnconfirmed(CTxMemPool::setEntries &testSet)
@@ -641,3 +709,171 @@ bool BlockAssembler::sign(CBlock &block, const CKey &privKey)
 
     return true;
 }
+
+std::unique_ptr<CChiaBlockTemplateCache> g_chia_template_cache;
+
+CChiaBlockTemplateCache::CChiaBlockTemplateCache(const CChainParams& params) : m_params(params) {}
+
+CChiaBlockTemplateCache::~CChiaBlockTemplateCache()
+{
+    Stop();
+}
+
+void CChiaBlockTemplateCache::Stop()
+{
+    {
+        LOCK(m_mutex);
+        m_stopping = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+std::unique_ptr<CBlockTemplate> CChiaBlockTemplateCache::Take(const CBlockIndex* pindexPrev, const CScript& scriptPubKey, const std::vector<uint8_t>& vchFarmerPk)
+{
+    LOCK(m_mutex);
+    if (!m_thread.joinable() && !m_stopping) {
+        // A farmer is mining on the node, keep its templates from now on
+        m_thread = std::thread(&TraceThread<std::function<void()>>, "chiatemplate",
+                               std::bind(&CChiaBlockTemplateCache::ThreadAssemble, this));
+    }
+    FarmerKey key(scriptPubKey, vchFarmerPk);
+    auto itFarmer = m_farmers.find(key);
+    if (itFarmer == m_farmers.end()) {
+        if (m_farmers.size() >= CHIA_TEMPLATE_MAX_FARMERS) {
+            // Forget the farmer who released a block least recently
+            auto itOldest = std::min_element(m_farmers.begin(), m_farmers.end(),
+                [](const std::pair<const FarmerKey, int64_t>& a, const std::pair<const FarmerKey, int64_t>& b) { return a.second < b.second; });
+            m_templates.erase(itOldest->first);
+            m_farmers.erase(itOldest);
+        }
+        m_farmers.emplace(key, GetTime());
+        // A new farmer, assemble its template for the next block
+        m_tip_changed = true;
+        m_cond.notify_all();
+    } else {
+        itFarmer->second = GetTime();
+    }
+    auto it = m_templates.find(key);
+    if (it == m_templates.end() || it->second->block.hashPrevBlock != pindexPrev->GetBlockHash()) {
+        return nullptr;
+    }
+    return MakeUnique<CBlockTemplate>(*it->second);
+}
+
+void CChiaBlockTemplateCache::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    if (fInitialDownload) return;
+    {
+        LOCK(m_mutex);
+        m_tip_changed = true;
+    }
+    m_cond.notify_all();
+}
+
+void CChiaBlockTemplateCache::TransactionAddedToMempool(const CTransactionRef &ptx)
+{
+    {
+        LOCK(m_mutex);
+        m_mempool_changed = true;
+    }
+    m_cond.notify_all();
+}
+
+void CChiaBlockTemplateCache::AssembleTemplates()
+{
+    std::vector<FarmerKey> vFarmers;
+    {
+        LOCK(m_mutex);
+        for (const auto& entry : m_farmers) {
+            vFarmers.push_back(entry.first);
+        }
+    }
+    if (vFarmers.empty()) return;
+
+    int64_t nTimeStart = GetTimeMicros();
+    std::map<FarmerKey, std::shared_ptr<const CBlockTemplate>> templates;
+    LOCK(cs_main);
+    const CBlockIndex* pindexPrev = ::ChainActive().Tip();
+    if (pindexPrev == nullptr) return;
+
+    // The transactions are selected once for all farmers, the selection doesn't depend on the farmer except that a
+    // farmer cannot package the bind tx which changes an active binding of its own account
+    std::unique_ptr<CBlockTemplate> pselection;
+    try {
+        pselection = BlockAssembler(m_params).SelectChiaBlockTransactions(pindexPrev, CAccountID());
+    } catch (const std::exception& e) {
+        LogPrintf("%s: cannot select the transactions of the chia block templates: %s\n", __func__, e.what());
+    }
+    std::set<CAccountID> setBindAccounts;
+    if (pselection) {
+        for (size_t i = 1; i < pselection->block.vtx.size(); ++i) {
+            const CTransaction& tx = *pselection->block.vtx[i];
+            if (tx.IsUniform() && ExtractTransactionDatacarrier(tx, pindexPrev->nHeight + 1, {DATACARRIER_TYPE_BINDPLOTTER, DATACARRIER_TYPE_BINDCHIAFARMER})) {
+                setBindAccounts.insert(ExtractAccountID(tx.vout[0].scriptPubKey));
+            }
+        }
+    }
+
+    for (const FarmerKey& key : vFarmers) {
+        std::unique_ptr<CBlockTemplate> ptemplate;
+        try {
+            if (pselection && !setBindAccounts.count(ExtractAccountID(key.first))) {
+                ptemplate = MakeUnique<CBlockTemplate>(*pselection);
+                BlockAssembler::AddChiaCoinbase(*ptemplate, pindexPrev, key.first, key.second, m_params);
+            } else {
+                ptemplate = BlockAssembler(m_params).CreateNewChiaBlockTemplate(pindexPrev, key.first, key.second);
+            }
+        } catch (const std::exception& e) {
+            LogPrintf("%s: cannot assemble the chia block template for farmer %s: %s\n", __func__, chiapos::BytesToHex(key.second), e.what());
+        }
+        if (ptemplate) {
+            templates[key] = std::move(ptemplate);
+        }
+    }
+
+    {
+        LOCK(m_mutex);
+        for (const FarmerKey& key : vFarmers) {
+            auto it = templates.find(key);
+            if (it != templates.end()) {
+                m_templates[key] = std::move(it->second);
+            } else {
+                m_templates.erase(key);
+            }
+        }
+    }
+    LogPrint(BCLog::BENCH, "%s: %u chia block templates on block %d assembled in %.2fms\n", __func__,
+        templates.size(), pindexPrev->nHeight, 0.001 * (GetTimeMicros() - nTimeStart));
+}
+
+void CChiaBlockTemplateCache::ThreadAssemble()
+{
+    while (true) {
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_cond.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stopping || m_tip_changed || m_mempool_changed; });
+            if (!m_stopping && !m_tip_changed) {
+                // Only the mempool has changed, wait for more transactions unless the tip changes
+                m_cond.wait_for(lock, std::chrono::milliseconds(CHIA_TEMPLATE_MEMPOOL_DELAY_MS),
+                                [this]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stopping || m_tip_changed; });
+            }
+            if (m_stopping) return;
+            m_tip_changed = m_mempool_changed = false;
+            int64_t nNow = GetTime();
+            for (auto it = m_farmers.begin(); it != m_farmers.end();) {
+                if (nNow - it->second > CHIA_TEMPLATE_FARMER_EXPIRY) {
+                    m_templates.erase(it->first);
+                    it = m_farmers.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        if (::ChainstateActive().IsInitialBlockDownload()) continue;
+        AssembleTemplates();
+    }
+}
@@ -10,9 +10,13 @@
 #include <primitives/block.h>
 #include <txmempool.h>
 #include <validation.h>
+#include <validationinterface.h>
 
+#include <condition_variable>
+#include <map>
 #include <memory>
 #include <stdint.h>
+#include <thread>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
@@ -182,6 +186,29 @@ public:
         const chiapos::CPosProof &posProof,
         const chiapos::CVdfProof &vdfProof);
 
+    /** Construct the transactions and the coinbase of a chia block for the farmer, the proofs are filled in by FillChiaBlock() */
+    std::unique_ptr<CBlockTemplate> CreateNewChiaBlockTemplate(const CBlockIndex *pindexPrev,
+        const CScript &scriptPubKeyIn,
+        const std::vector<uint8_t> &vchFarmerPk);
+
+    /** Select the transactions of a chia block on top of pindexPrev, the coinbase is left empty for AddChiaCoinbase(). A null
+     *  generator selects the transactions for any farmer who doesn't package a bind tx of its own account */
+    std::unique_ptr<CBlockTemplate> SelectChiaBlockTransactions(const CBlockIndex *pindexPrev,
+        const CAccountID &generator);
+
+    /** Build the coinbase and the reward of the farmer on top of the transactions selected by SelectChiaBlockTransactions() */
+    static void AddChiaCoinbase(CBlockTemplate& blocktemplate, const CBlockIndex *pindexPrev,
+        const CScript &scriptPubKeyIn,
+        const std::vector<uint8_t> &vchFarmerPk,
+        const CChainParams &chainparams);
+
+    /** Fill the proofs and the difficulty into a chia block template on top of pindexPrev, then sign it by the farmer */
+    static void FillChiaBlock(CBlock& block, const CBlockIndex* pindexPrev,
+        const chiapos::CKey &farmerSk,
+        const chiapos::CPosProof &posProof,
+        const chiapos::CVdfProof &vdfProof,
+        const Consensus::Params &params);
+
     static Optional<int64_t> m_last_block_num_txs;
     static Optional<int64_t> m_last_block_weight;
 
@@ -222,4 +249,55 @@ private:
     bool sign(CBlock &block, const CKey &privKey);
 };
 
+/** Wait for the mempool to settle down before the chia block templates are assembled again */
+static const int64_t CHIA_TEMPLATE_MEMPOOL_DELAY_MS = 1000;
+/** The farmers who haven't released a block for the time are forgotten */
+static const int64_t CHIA_TEMPLATE_FARMER_EXPIRY = 24 * 60 * 60;
+/** The most farmers whose templates are assembled in advance, the least recently used one is forgotten */
+static const size_t CHIA_TEMPLATE_MAX_FARMERS = 64;
+
+/**
+ * Keeps a chia block template for each farmer who released a block recently, assembled on top of the tip by a
+ * background thread whenever the tip or the mempool changes. A new proof then only needs to be filled in and signed.
+ */
+class CChiaBlockTemplateCache final : public CValidationInterface
+{
+public:
+    explicit CChiaBlockTemplateCache(const CChainParams& params);
+    ~CChiaBlockTemplateCache();
+
+    void Stop();
+
+    /** A copy of the template of the farmer on top of pindexPrev, null if it isn't assembled. The farmer is remembered
+     *  so the templates of the next blocks are assembled in advance, the background thread is started by the first call */
+    std::unique_ptr<CBlockTemplate> Take(const CBlockIndex* pindexPrev, const CScript& scriptPubKey, const std::vector<uint8_t>& vchFarmerPk);
+
+    /** Assemble the templates of the remembered farmers on top of the tip, called by the background thread */
+    void AssembleTemplates();
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
+    void TransactionAddedToMempool(const CTransactionRef &ptx) override;
+
+private:
+    using FarmerKey = std::pair<CScript, std::vector<uint8_t>>;
+
+    void ThreadAssemble();
+
+    const CChainParams& m_params;
+    std::thread m_thread;
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_stopping GUARDED_BY(m_mutex){false};
+    bool m_tip_changed GUARDED_BY(m_mutex){false};
+    bool m_mempool_changed GUARDED_BY(m_mutex){false};
+    /** The farmers and the time they released a block last */
+    std::map<FarmerKey, int64_t> m_farmers GUARDED_BY(m_mutex);
+    std::map<FarmerKey, std::shared_ptr<const CBlockTemplate>> m_templates GUARDED_BY(m_mutex);
+};
+
+/** The chia block templates assembled in advance, may be null */
+extern std::unique_ptr<CChiaBlockTemplateCache> g_chia_template_cache;
+
 #endif // BITCOIN_MINER_H
@@ -637,6 +637,18 @@ static bool PeerHasHeader(CNodeState *state, const CBlockIndex *pindex) EXCLUSIV
     return false;
 }
 
+/** Append the header of pindex for an announcement, false when its chia fields cannot be read back from the db */
+static bool AppendBlockHeader(std::vector<CBlock>& vHeaders, const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    try {
+        vHeaders.push_back(pindex->GetBlockHeader());
+    } catch (const std::runtime_error& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+        return false;
+    }
+    return true;
+}
+
 /** Update pindexLastCommonBlock and add not-in-flight missing successors to vBlocks, until it has
  *  at most count entries. */
 static void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller, const Consensus::Params& consensusParams) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
@@ -2528,7 +2540,11 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         LogPrint(BCLog::NET, "getheaders %d to %s from peer=%d\n", (pindex ? pindex->nHeight : -1), hashStop.IsNull() ? "end" : hashStop.ToString(), pfrom->GetId());
         for (; pindex; pindex = ::ChainActive().Next(pindex))
         {
-            vHeaders.push_back(pindex->GetBlockHeader());
+            if (!AppendBlockHeader(vHeaders, pindex)) {
+                // Send the headers before it, the peer asks for the rest again
+                pindex = pindex->pprev;
+                break;
+            }
             if (--nLimit <= 0 || pindex->GetBlockHash() == hashStop)
                 break;
         }
@@ -3364,9 +3380,11 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         chiapos::CVdfProof vdfProof;
         vRecv >> vdfProof;
 
-        // check the proof and ensure it is valid
+        // check the proof and ensure it is valid, the peer states below are guarded by cs_main
         CValidationState validState;
-        if (!chiapos::CheckVdfProof(vdfProof, validState)) {
+        bool fValid = chiapos::CheckVdfProof(vdfProof, validState);
+        LOCK(cs_main);
+        if (!fValid) {
             Misbehaving(pfrom->GetId(), 100);
             LogPrint(BCLog::POC, "%s: invalid vdf proof has been received, challenge=%s, proof=%s, iters=%d\n", __func__, vdfProof.challenge.GetHex(), chiapos::BytesToHex(vdfProof.vchProof), vdfProof.nVdfIters);
             return true;
@@ -3389,9 +3407,8 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             }
         });
 
-        LOCK(cs_main);
-        if (!chiapos::AddLocalVdfProof(vdfProof)) {
-            // TODO the vdf proof already exists
+        if (chiapos::AddLocalVdfProof(vdfProof)) {
+            GetMainSignals().NewVdfProof(std::make_shared<const chiapos::CVdfProof>(vdfProof));
         }
         return true;
     }
@@ -3854,14 +3871,20 @@ bool PeerLogicValidation::SendMessages(CNode* pto)
                     pBestIndex = pindex;
                     if (fFoundStartingHeader) {
                         // add this to the headers message
-                        vHeaders.push_back(pindex->GetBlockHeader());
+                        if (!AppendBlockHeader(vHeaders, pindex)) {
+                            fRevertToInv = true;
+                            break;
+                        }
                     } else if (PeerHasHeader(&state, pindex)) {
                         continue; // keep looking for the first new block
                     } else if (pindex->pprev == nullptr || PeerHasHeader(&state, pindex->pprev)) {
                         // Peer doesn't have this header but they do have the prior one.
                         // Start sending headers.
                         fFoundStartingHeader = true;
-                        vHeaders.push_back(pindex->GetBlockHeader());
+                        if (!AppendBlockHeader(vHeaders, pindex)) {
+                            fRevertToInv = true;
+                            break;
+                        }
                     } else {
                         // Peer doesn't have this header or the prior one -- nothing will
                         // connect, so bail out.
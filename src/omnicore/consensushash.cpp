@@ -11,19 +11,28 @@
 #include <omnicore/log.h>
 #include <omnicore/parse_string.h>
 #include <omnicore/sp.h>
+#include <omnicore/tally.h>
 
 #include <arith_uint256.h>
 #include <uint256.h>
 
 #include <stdint.h>
 #include <algorithm>
+#include <map>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <openssl/sha.h>
 
 namespace mastercore
 {
+//! Consensus strings of the non-empty balances, ordered by address and then by property
+static std::map<std::pair<std::string, uint32_t>, std::string> mapBalanceStrings GUARDED_BY(cs_tally);
+//! Addresses with balances changed since their consensus strings were generated
+static std::set<std::string> setChangedBalances GUARDED_BY(cs_tally);
+
 bool ShouldConsensusHashBlock(int block) {
     if (msc_debug_consensus_hash_every_block) {
         return true;
@@ -98,6 +107,48 @@ std::string GenerateConsensusString(const uint32_t propertyId, const std::string
     return strprintf("%d|%s", propertyId, address);
 }
 
+void SetConsensusHashBalancesChanged(const std::string& address)
+{
+    LOCK(cs_tally);
+    setChangedBalances.insert(address);
+}
+
+void ClearConsensusHashBalances()
+{
+    LOCK(cs_tally);
+    mapBalanceStrings.clear();
+    setChangedBalances.clear();
+}
+
+/**
+ * Generates the consensus strings of the balances changed since the last call.
+ *
+ * The strings are kept in the order of the balances stage, so the hash only
+ * needs to walk them instead of sorting and formatting the whole tally map.
+ */
+static void UpdateBalanceStrings() EXCLUSIVE_LOCKS_REQUIRED(cs_tally)
+{
+    for (std::set<std::string>::const_iterator it = setChangedBalances.begin(); it != setChangedBalances.end(); ++it) {
+        const std::string& address = *it;
+        std::map<std::pair<std::string, uint32_t>, std::string>::iterator str_it = mapBalanceStrings.lower_bound(std::make_pair(address, 0U));
+        while (str_it != mapBalanceStrings.end() && str_it->first.first == address) {
+            mapBalanceStrings.erase(str_it++);
+        }
+
+        std::unordered_map<std::string, CMPTally>::iterator tally_it = mp_tally_map.find(address);
+        if (tally_it == mp_tally_map.end()) continue;
+        CMPTally& tally = tally_it->second;
+        tally.init();
+        uint32_t propertyId = 0;
+        while (0 != (propertyId = (tally.next()))) {
+            std::string dataStr = GenerateConsensusString(tally, address, propertyId);
+            if (dataStr.empty()) continue; // skip empty balances
+            mapBalanceStrings.emplace_hint(str_it, std::make_pair(address, propertyId), std::move(dataStr));
+        }
+    }
+    setChangedBalances.clear();
+}
+
 /**
  * Obtains a hash of the active state to use for consensus verification and checkpointing.
  *
@@ -157,24 +208,14 @@ uint256 GetConsensusHash()
 
     if (msc_debug_consensus_hash) PrintToLog("Beginning generation of current consensus hash...\n");
 
-    // Balances - loop through the tally map, updating the sha context with the data from each balance and tally type
+    // Balances - loop through the consensus strings of the balances, which are sorted by address and property ID
     // Placeholders:  "address|propertyid|balance|selloffer_reserve|accept_reserve|metadex_reserve"
-    // Sort alphabetically first
-    std::map<std::string, CMPTally> tallyMapSorted;
-    for (std::unordered_map<std::string, CMPTally>::iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
-        tallyMapSorted.insert(std::make_pair(uoit->first,uoit->second));
-    }
-    for (std::map<std::string, CMPTally>::iterator my_it = tallyMapSorted.begin(); my_it != tallyMapSorted.end(); ++my_it) {
-        const std::string& address = my_it->first;
-        CMPTally& tally = my_it->second;
-        tally.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = (tally.next()))) {
-            std::string dataStr = GenerateConsensusString(tally, address, propertyId);
-            if (dataStr.empty()) continue; // skip empty balances
-            if (msc_debug_consensus_hash) PrintToLog("Adding balance data to consensus hash: %s\n", dataStr);
-            SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
-        }
+    // Only the balances changed since the last hash are formatted again
+    UpdateBalanceStrings();
+    for (std::map<std::pair<std::string, uint32_t>, std::string>::const_iterator it = mapBalanceStrings.begin(); it != mapBalanceStrings.end(); ++it) {
+        const std::string& dataStr = it->second;
+        if (msc_debug_consensus_hash) PrintToLog("Adding balance data to consensus hash: %s\n", dataStr);
+        SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
     }
 
     // DEx sell offers - loop through the DEx and add each sell offer to the consensus hash (ordered by txid)
@@ -318,22 +359,12 @@ uint256 GetBalancesHash(const uint32_t hashPropertyId)
 
     LOCK(cs_tally);
 
-    std::map<std::string, CMPTally> tallyMapSorted;
-    for (std::unordered_map<std::string, CMPTally>::iterator uoit = mp_tally_map.begin(); uoit != mp_tally_map.end(); ++uoit) {
-        tallyMapSorted.insert(std::make_pair(uoit->first,uoit->second));
-    }
-    for (std::map<std::string, CMPTally>::iterator my_it = tallyMapSorted.begin(); my_it != tallyMapSorted.end(); ++my_it) {
-        const std::string& address = my_it->first;
-        CMPTally& tally = my_it->second;
-        tally.init();
-        uint32_t propertyId = 0;
-        while (0 != (propertyId = (tally.next()))) {
-            if (propertyId != hashPropertyId) continue;
-            std::string dataStr = GenerateConsensusString(tally, address, propertyId);
-            if (dataStr.empty()) continue;
-            if (msc_debug_consensus_hash) PrintToLog("Adding data to balances hash: %s\n", dataStr);
-            SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
-        }
+    UpdateBalanceStrings();
+    for (std::map<std::pair<std::string, uint32_t>, std::string>::const_iterator it = mapBalanceStrings.begin(); it != mapBalanceStrings.end(); ++it) {
+        if (it->first.second != hashPropertyId) continue;
+        const std::string& dataStr = it->second;
+        if (msc_debug_consensus_hash) PrintToLog("Adding data to balances hash: %s\n", dataStr);
+        SHA256_Update(&shaCtx, dataStr.c_str(), dataStr.length());
     }
 
     uint256 balancesHash;
@@ -3,6 +3,8 @@
 
 #include <uint256.h>
 
+#include <string>
+
 namespace mastercore
 {
 /** Checks if a given block should be consensus hashed. */
@@ -17,6 +19,12 @@ uint256 GetMetaDExHash(const uint32_t propertyId = 0);
 /** Obtains a hash of the balances for a specific property. */
 uint256 GetBalancesHash(const uint32_t hashPropertyId);
 
+/** Marks the balances of an address as changed, their consensus strings are generated again before the next hash. */
+void SetConsensusHashBalancesChanged(const std::string& address);
+
+/** Drops the consensus strings of all balances, used when the tally map is cleared. */
+void ClearConsensusHashBalances();
+
 }
 
 #endif // BITCOIN_OMNICORE_CONSENSUSHASH_H
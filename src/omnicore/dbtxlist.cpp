@@ -22,6 +22,7 @@
 #include <leveldb/iterator.h>
 #include <leveldb/slice.h>
 #include <leveldb/status.h>
+#include <leveldb/write_batch.h>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
@@ -30,6 +31,7 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -43,6 +45,40 @@ using mastercore::GetBlockIndex;
 using mastercore::isNonMainNet;
 using mastercore::pDbTransaction;
 
+/* Besides the records keyed by txid, the database holds a height index of the master records, so the
+ * queries of a block range and the rollback of a reorg read the range only.
+ *
+ * Keys of the height index are "h<height>:<key of the master record>", the height is zero padded to
+ * ten digits, so that the entries are ordered by height. The values are empty.
+ * The number of the transactions, the master records with a txid as key, is stored as "txcount".
+ */
+static const std::string TX_COUNT_KEY = "txcount";
+
+static std::string HeightIndexKey(int nBlock, const std::string& key)
+{
+    return strprintf("h%010d:%s", nBlock, key);
+}
+
+/** The key of the master record of a height index entry, or an empty string if the entry is out of the range. */
+static std::string ParseHeightIndexKey(const leveldb::Slice& sKey, int blockLast)
+{
+    const std::string strKey = sKey.ToString();
+    if (strKey.size() < 12 || strKey[0] != 'h' || strKey[11] != ':') return "";
+    if (atoi(strKey.substr(1, 10)) > blockLast) return "";
+    return strKey.substr(12);
+}
+
+/** Whether the record is a master record: a transaction, or the summary of the MetaDEx cancels of a transaction. */
+static bool IsMasterRecord(const std::string& key, const std::string& value, int& nBlock)
+{
+    if (key.size() != 64 && !(key.size() == 66 && key.compare(64, 2, "-C") == 0)) return false;
+    std::vector<std::string> vstr;
+    boost::split(vstr, value, boost::is_any_of(":"), boost::token_compress_on);
+    if (4 != vstr.size()) return false;
+    nBlock = atoi(vstr[1]);
+    return true;
+}
+
 CMPTxList::CMPTxList(const fs::path& path, bool fWipe)
 {
     leveldb::Status status = Open(path, fWipe);
@@ -69,10 +105,96 @@ void CMPTxList::recordTX(const uint256 &txid, bool fValid, int nBlock, unsigned
     PrintToLog("%s(%s, valid=%s, block= %d, type= %d, value= %lu)\n",
             __func__, txid.ToString(), fValid ? "YES" : "NO", nBlock, type, nValue);
 
-    status = pdb->Put(writeoptions, key, value);
+    status = writeMasterRecord(key, nBlock, value);
     ++nWritten;
 }
 
+/**
+ * Writes a master record, with its height index entry and the transaction count.
+ */
+leveldb::Status CMPTxList::writeMasterRecord(const std::string& key, int nBlock, const std::string& value)
+{
+    leveldb::WriteBatch batch;
+    std::string strOldValue;
+    int nOldBlock;
+    if (pdb->Get(readoptions, key, &strOldValue).ok() && IsMasterRecord(key, strOldValue, nOldBlock)) {
+        batch.Delete(HeightIndexKey(nOldBlock, key));
+    } else if (key.size() == 64) {
+        batch.Put(TX_COUNT_KEY, strprintf("%d", getMPTransactionCountTotal() + 1));
+    }
+    batch.Put(key, value);
+    batch.Put(HeightIndexKey(nBlock, key), "");
+    return pdb->Write(writeoptions, &batch);
+}
+
+/**
+ * Deletes the master records of the block range, returns the number of deleted records.
+ */
+int CMPTxList::deleteMasterRecords(int blockFirst, int blockLast)
+{
+    leveldb::WriteBatch batch;
+    int nDeleted = 0;
+    int nTxs = 0;
+    leveldb::Iterator* it = NewIterator();
+
+    for (it->Seek(HeightIndexKey(blockFirst, "")); it->Valid(); it->Next()) {
+        std::string key = ParseHeightIndexKey(it->key(), blockLast);
+        if (key.empty()) break;
+        std::string strValue;
+        if (pdb->Get(readoptions, key, &strValue).ok()) {
+            PrintToLog("%s() DELETING: %s=%s\n", __func__, key, strValue);
+            batch.Delete(key);
+            if (key.size() == 64) ++nTxs;
+        }
+        batch.Delete(it->key());
+        ++nDeleted;
+    }
+
+    delete it;
+
+    if (nTxs > 0) {
+        batch.Put(TX_COUNT_KEY, strprintf("%d", std::max(0, getMPTransactionCountTotal() - nTxs)));
+    }
+    leveldb::Status status = pdb->Write(writeoptions, &batch);
+    if (!status.ok()) {
+        PrintToLog("%s(): ERROR: %s\n", __func__, status.ToString());
+    }
+    return nDeleted;
+}
+
+/**
+ * Builds the height index and the transaction count of a database written before they existed.
+ */
+bool CMPTxList::BuildHeightIndex()
+{
+    int64_t nTimeStart = GetTimeMicros();
+    leveldb::WriteBatch batch;
+    int nIndexed = 0;
+    int nTxs = 0;
+    leveldb::Iterator* it = NewIterator();
+
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        const std::string key = it->key().ToString();
+        int nBlock;
+        if (!IsMasterRecord(key, it->value().ToString(), nBlock)) continue;
+        batch.Put(HeightIndexKey(nBlock, key), "");
+        ++nIndexed;
+        if (key.size() == 64) ++nTxs;
+    }
+
+    delete it;
+
+    batch.Put(TX_COUNT_KEY, strprintf("%d", nTxs));
+    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    if (!status.ok()) {
+        PrintToLog("%s(): ERROR: %s\n", __func__, status.ToString());
+        return false;
+    }
+
+    PrintToLog("%s(): indexed %d records of %d transactions [%.3f sec]\n", __func__, nIndexed, nTxs, 0.000001 * (GetTimeMicros() - nTimeStart));
+    return true;
+}
+
 void CMPTxList::recordPaymentTX(const uint256& txid, bool fValid, int nBlock, unsigned int vout, unsigned int propertyId, uint64_t nValue, std::string buyer, std::string seller)
 {
     if (!pdb) return;
@@ -111,7 +233,7 @@ void CMPTxList::recordPaymentTX(const uint256& txid, bool fValid, int nBlock, un
     const std::string value = strprintf("%u:%d:%u:%lu", fValid ? 1 : 0, nBlock, type, numberOfPayments);
     leveldb::Status status;
     PrintToLog("DEXPAYDEBUG : Writing master record %s(%s, valid=%s, block= %d, type= %d, number of payments= %lu)\n", __func__, txid.ToString(), fValid ? "YES" : "NO", nBlock, type, numberOfPayments);
-    status = pdb->Put(writeoptions, key, value);
+    status = writeMasterRecord(key, nBlock, value);
 
     // Step 4 - Write sub-record with payment details
     const std::string txidStr = txid.ToString();
@@ -153,7 +275,7 @@ void CMPTxList::recordMetaDExCancelTX(const uint256& txidMaster, const uint256&
     const std::string key = txidMasterStr;
     const std::string value = strprintf("%u:%d:%u:%lu", fValid ? 1 : 0, nBlock, type, refNumber);
     PrintToLog("METADEXCANCELDEBUG : Writing master record %s(%s, valid=%s, block= %d, type= %d, number of affected transactions= %d)\n", __func__, txidMaster.ToString(), fValid ? "YES" : "NO", nBlock, type, refNumber);
-    status = pdb->Put(writeoptions, key, value);
+    status = writeMasterRecord(key, nBlock, value);
 
     // Step 4 - Write sub-record with cancel details
     const std::string txidStr = txidMaster.ToString() + "-C";
@@ -299,40 +421,15 @@ bool CMPTxList::getSendAllDetails(const uint256& txid, int subSend, uint32_t& pr
 
 int CMPTxList::getMPTransactionCountTotal()
 {
-    int count = 0;
-    leveldb::Slice skey, svalue;
-    leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        if (skey.ToString().length() == 64) {
-            ++count;
-        } //extra entries for cancels and purchases are more than 64 chars long
-    }
-    delete it;
-    return count;
+    std::string strValue;
+    if (!pdb->Get(readoptions, TX_COUNT_KEY, &strValue).ok()) return 0;
+    return atoi(strValue);
 }
 
 int CMPTxList::getMPTransactionCountBlock(int block)
 {
-    int count = 0;
-    leveldb::Slice skey, svalue;
-    leveldb::Iterator* it = NewIterator();
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        svalue = it->value();
-        if (skey.ToString().length() == 64) {
-            std::string strValue = svalue.ToString();
-            std::vector<std::string> vstr;
-            boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-            if (4 == vstr.size()) {
-                if (atoi(vstr[1]) == block) {
-                    ++count;
-                }
-            }
-        }
-    }
-    delete it;
-    return count;
+    std::set<uint256> txs;
+    return GetOmniTxsInBlockRange(block, block, txs);
 }
 
 /** Returns a list of all Omni transactions in the given block range. */
@@ -340,22 +437,13 @@ int CMPTxList::GetOmniTxsInBlockRange(int blockFirst, int blockLast, std::set<ui
 {
     int count = 0;
     leveldb::Iterator* it = NewIterator();
-    
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        const leveldb::Slice& sKey = it->key();
-        const leveldb::Slice& sValue = it->value();
-
-        if (sKey.ToString().length() == 64) {
-            const std::string& strValue = sValue.ToString();
-            std::vector<std::string> vStr;
-            boost::split(vStr, strValue, boost::is_any_of(":"), boost::token_compress_on);
-            if (4 == vStr.size()) {
-                int blockCurrent = atoi(vStr[1]);
-                if (blockCurrent >= blockFirst && blockCurrent <= blockLast) {
-                    retTxs.insert(uint256S(sKey.ToString()));                    
-                    ++count;
-                }
-            }
+
+    for (it->Seek(HeightIndexKey(blockFirst, "")); it->Valid(); it->Next()) {
+        std::string key = ParseHeightIndexKey(it->key(), blockLast);
+        if (key.empty()) break;
+        if (key.size() == 64) {
+            retTxs.insert(uint256S(key));
+            ++count;
         }
     }
 
@@ -480,15 +568,10 @@ std::set<int> CMPTxList::GetSeedBlocks(int startHeight, int endHeight)
 
     leveldb::Iterator* it = NewIterator();
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
-        std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
-        if (4 != vstr.size()) continue; // unexpected number of tokens
-        int block = atoi(vstr[1]);
-        if (block >= startHeight && block <= endHeight) {
-            setSeedBlocks.insert(block);
-        }
+    for (it->Seek(HeightIndexKey(startHeight, "")); it->Valid(); it->Next()) {
+        std::string key = ParseHeightIndexKey(it->key(), endHeight);
+        if (key.empty()) break;
+        setSeedBlocks.insert(atoi(it->key().ToString().substr(1, 10)));
     }
 
     delete it;
@@ -726,13 +809,14 @@ bool CMPTxList::CheckForFreezeTxs(int blockHeight)
 
     leveldb::Iterator* it = NewIterator();
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        std::string itData = it->value().ToString();
+    for (it->Seek(HeightIndexKey(blockHeight, "")); it->Valid(); it->Next()) {
+        std::string key = ParseHeightIndexKey(it->key(), std::numeric_limits<int>::max());
+        if (key.empty()) break;
+        std::string strValue;
+        if (!pdb->Get(readoptions, key, &strValue).ok()) continue;
         std::vector<std::string> vstr;
-        boost::split(vstr, itData, boost::is_any_of(":"), boost::token_compress_on);
+        boost::split(vstr, strValue, boost::is_any_of(":"), boost::token_compress_on);
         if (4 != vstr.size()) continue;
-        int block = atoi(vstr[1]);
-        if (block < blockHeight) continue;
         uint16_t txtype = atoi(vstr[2]);
         if (txtype == MSC_TYPE_FREEZE_PROPERTY_TOKENS || txtype == MSC_TYPE_UNFREEZE_PROPERTY_TOKENS ||
                 txtype == MSC_TYPE_ENABLE_FREEZING || txtype == MSC_TYPE_DISABLE_FREEZING) {
@@ -771,40 +855,20 @@ void CMPTxList::printAll()
 // pass in bDeleteFound = true to erase each entry found within the block range
 bool CMPTxList::isMPinBlockRange(int starting_block, int ending_block, bool bDeleteFound)
 {
-    leveldb::Slice skey, svalue;
-    unsigned int count = 0;
-    std::vector<std::string> vstr;
-    int block;
     unsigned int n_found = 0;
 
-    leveldb::Iterator* it = NewIterator();
-
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        skey = it->key();
-        svalue = it->value();
-
-        ++count;
-
-        std::string strvalue = it->value().ToString();
-
-        // parse the string returned, find the validity flag/bit & other parameters
-        boost::split(vstr, strvalue, boost::is_any_of(":"), boost::token_compress_on);
-
-        // only care about the block number/height here
-        if (2 <= vstr.size()) {
-            block = atoi(vstr[1]);
-
-            if ((starting_block <= block) && (block <= ending_block)) {
-                ++n_found;
-                PrintToLog("%s() DELETING: %s=%s\n", __func__, skey.ToString(), svalue.ToString());
-                if (bDeleteFound) pdb->Delete(writeoptions, skey);
-            }
+    if (bDeleteFound) {
+        n_found = deleteMasterRecords(starting_block, ending_block);
+    } else {
+        leveldb::Iterator* it = NewIterator();
+        for (it->Seek(HeightIndexKey(starting_block, "")); it->Valid(); it->Next()) {
+            if (ParseHeightIndexKey(it->key(), ending_block).empty()) break;
+            ++n_found;
         }
+        delete it;
     }
 
     PrintToLog("%s(%d, %d); n_found= %d\n", __func__, starting_block, ending_block, n_found);
 
-    delete it;
-
     return (n_found);
 }
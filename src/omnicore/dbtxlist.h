@@ -7,12 +7,15 @@
 #include <fs.h>
 #include <uint256.h>
 
+#include <leveldb/status.h>
+
 #include <stdint.h>
 
 #include <set>
 #include <string>
 
 /** LevelDB based storage for transactions, with txid as key and validity bit, and other data as value.
+ *  The transactions are indexed by block height as well, and their number is maintained.
  */
 class CMPTxList : public CDBBase
 {
@@ -41,6 +44,8 @@ public:
 
     int getDBVersion();
     int setDBVersion();
+    /** Builds the height index and the transaction count of a database written before they existed. */
+    bool BuildHeightIndex();
 
     bool exists(const uint256& txid);
     bool getTX(const uint256& txid, std::string& value);
@@ -56,6 +61,10 @@ public:
     void printAll();
 
     bool isMPinBlockRange(int, int, bool);
+
+private:
+    leveldb::Status writeMasterRecord(const std::string& key, int nBlock, const std::string& value);
+    int deleteMasterRecords(int blockFirst, int blockLast);
 };
 
 namespace mastercore
@@ -137,6 +137,8 @@ std::set<std::pair<std::string,uint32_t> > setFrozenAddresses;
 
 //! In-memory collection of all amounts for all addresses for all properties
 std::unordered_map<std::string, CMPTally> mastercore::mp_tally_map;
+//! Holders and total number of tokens per property, updated together with the tallies
+std::unordered_map<uint32_t, CMPPropertyHolders> mastercore::mp_property_holders;
 
 // Only needed for GUI:
 
@@ -418,7 +420,6 @@ std::string mastercore::getTokenLabel(uint32_t propertyId)
 // optionally counts the number of addresses who own that property: n_owners_total
 int64_t mastercore::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
 {
-    int64_t prev = 0;
     int64_t owners = 0;
     int64_t totalTokens = 0;
 
@@ -430,18 +431,10 @@ int64_t mastercore::getTotalTokens(uint32_t propertyId, int64_t* n_owners_total)
     }
 
     if (!property.fixed || n_owners_total) {
-        for (std::unordered_map<std::string, CMPTally>::const_iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-            const CMPTally& tally = it->second;
-
-            totalTokens += tally.getMoney(propertyId, BALANCE);
-            totalTokens += tally.getMoney(propertyId, SELLOFFER_RESERVE);
-            totalTokens += tally.getMoney(propertyId, ACCEPT_RESERVE);
-            totalTokens += tally.getMoney(propertyId, METADEX_RESERVE);
-
-            if (prev != totalTokens) {
-                prev = totalTokens;
-                owners++;
-            }
+        std::unordered_map<uint32_t, CMPPropertyHolders>::const_iterator it = mp_property_holders.find(propertyId);
+        if (it != mp_property_holders.end()) {
+            totalTokens = it->second.totalTokens;
+            owners = it->second.holders.size();
         }
         int64_t cachedFee = pDbFeeCache->GetCachedAmount(propertyId);
         totalTokens += cachedFee;
@@ -489,6 +482,18 @@ bool mastercore::update_tally_map(const std::string& who, uint32_t propertyId, i
     CMPTally& tally = my_it->second;
     bRet = tally.updateMoney(propertyId, amount, ttype);
 
+    if (bRet && ttype != PENDING) {
+        SetConsensusHashBalancesChanged(who);
+
+        CMPPropertyHolders& property = mp_property_holders[propertyId];
+        property.totalTokens += amount;
+        if (tally.getMoneyHeld(propertyId) != 0) {
+            property.holders.insert(who);
+        } else {
+            property.holders.erase(who);
+        }
+    }
+
     after = GetTokenBalance(who, propertyId, ttype);
     if (!bRet) {
         assert(before == after);
@@ -1270,6 +1275,8 @@ void clear_all_state()
 
     // Memory based storage
     mp_tally_map.clear();
+    mp_property_holders.clear();
+    ClearConsensusHashBalances();
     my_offers.clear();
     my_accepts.clear();
     my_crowds.clear();
@@ -1418,6 +1425,12 @@ int mastercore_init()
         pathStateFiles = GetOmniDataDir() / "MP_persist";
         TryCreateDirectories(pathStateFiles);
 
+        if (!startClean && pDbTransactionList->getDBVersion() == DB_VERSION_BEFORE_TXLIST_HEIGHT_INDEX) {
+            PrintToConsole("Building the height index of the tx meta-info database...\n");
+            if (pDbTransactionList->BuildHeightIndex()) {
+                assert(pDbTransactionList->setDBVersion() == DB_VERSION);
+            }
+        }
         wrongDBVersion = (pDbTransactionList->getDBVersion() != DB_VERSION);
 
         ++mastercoreInitialized;
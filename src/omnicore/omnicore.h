@@ -38,7 +38,9 @@ int const DONT_STORE_MAINNET_STATE_UNTIL = 0;
 #define TEST_ECO_PROPERTY_1 (0x80000003UL)
 
 // increment this value to force a refresh of the state (similar to --omnistartclean)
-#define DB_VERSION 8
+#define DB_VERSION 9
+// the txlist of this version is upgraded by building its height index, the state is kept
+#define DB_VERSION_BEFORE_TXLIST_HEIGHT_INDEX 8
 
 // could probably also use: int64_t maxInt64 = std::numeric_limits<int64_t>::max();
 // maximum numeric values from the spec:
@@ -181,6 +183,8 @@ namespace mastercore
 {
 //! In-memory collection of all amounts for all addresses for all properties
 extern std::unordered_map<std::string, CMPTally> mp_tally_map GUARDED_BY(cs_tally);
+//! Holders and total number of tokens per property, maintained alongside mp_tally_map
+extern std::unordered_map<uint32_t, CMPPropertyHolders> mp_property_holders GUARDED_BY(cs_tally);
 
 /** Returns the encoding class, used to embed a payload. */
 int GetEncodingClass(const CTransaction& tx, int nBlock);
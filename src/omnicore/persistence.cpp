@@ -6,6 +6,7 @@
 
 #include <omnicore/persistence.h>
 
+#include <omnicore/consensushash.h>
 #include <omnicore/dex.h>
 #include <omnicore/log.h>
 #include <omnicore/mdex.h>
@@ -598,6 +599,8 @@ int RestoreInMemoryState(const std::string& filename, int what, bool verifyHash)
     switch (what) {
         case FILETYPE_BALANCES:
             mp_tally_map.clear();
+            mp_property_holders.clear();
+            ClearConsensusHashBalances();
             inputLineFunc = input_msc_balances_string;
             break;
 
@@ -13,6 +13,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_set>
 #include <utility>
 
 namespace mastercore
@@ -40,17 +41,16 @@ OwnerAddrType STO_GetReceivers(const std::string& sender, uint32_t property, int
 
     {
         LOCK(cs_tally);
-        std::unordered_map<std::string, CMPTally>::iterator it;
+        static const std::unordered_set<std::string> noHolders;
+        std::unordered_map<uint32_t, CMPPropertyHolders>::const_iterator holders_it = mp_property_holders.find(property);
 
-        for (it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-            const std::string& address = it->first;
-            const CMPTally& tally = it->second;
+        // Only the holders of the property are visited, the other tallies hold no tokens of it
+        const std::unordered_set<std::string>& holders = (holders_it != mp_property_holders.end()) ? holders_it->second.holders : noHolders;
+        for (std::unordered_set<std::string>::const_iterator it = holders.begin(); it != holders.end(); ++it) {
+            const std::string& address = *it;
+            const CMPTally& tally = mp_tally_map.at(address);
 
-            int64_t tokens = 0;
-            tokens += tally.getMoney(property, BALANCE);
-            tokens += tally.getMoney(property, SELLOFFER_RESERVE);
-            tokens += tally.getMoney(property, ACCEPT_RESERVE);
-            tokens += tally.getMoney(property, METADEX_RESERVE);
+            int64_t tokens = tally.getMoneyHeld(property);
 
             // Do not include the sender
             if (address == sender) {
@@ -166,6 +166,31 @@ int64_t CMPTally::getMoneyReserved(uint32_t propertyId) const
     return money;
 }
 
+/**
+ * Returns the number of tokens held by the entity.
+ *
+ * The held tokens are the available balance and the reserved tokens,
+ * pending tokens are not yet held.
+ *
+ * @param propertyId  The identifier of the tally to lookup
+ * @return The held balance
+ */
+int64_t CMPTally::getMoneyHeld(uint32_t propertyId) const
+{
+    int64_t money = 0;
+    TokenMap::const_iterator it = mp_token.find(propertyId);
+
+    if (it != mp_token.end()) {
+        const BalanceRecord& record = it->second;
+        money += record.balance[BALANCE];
+        money += record.balance[SELLOFFER_RESERVE];
+        money += record.balance[ACCEPT_RESERVE];
+        money += record.balance[METADEX_RESERVE];
+    }
+
+    return money;
+}
+
 /**
  * Compares the tally with another tally and returns true, if they are equal.
  *
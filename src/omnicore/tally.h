@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 #include <map>
+#include <string>
+#include <unordered_set>
 
 //! Balance record types
 enum TallyType {
@@ -52,6 +54,9 @@ public:
     /** Returns the number of reserved tokens. */
     int64_t getMoneyReserved(uint32_t propertyId) const;
 
+    /** Returns the number of tokens in the balance and the reserves, without the pending amount. */
+    int64_t getMoneyHeld(uint32_t propertyId) const;
+
     /** Compares the tally with another tally and returns true, if they are equal. */
     bool operator==(const CMPTally& rhs) const;
 
@@ -62,5 +67,15 @@ public:
     int64_t print(uint32_t propertyId = 1, bool bDivisible = true) const;
 };
 
+/** The holders of a single property, the entities with tokens in the balance or in a reserve.
+ */
+struct CMPPropertyHolders
+{
+    //! Sum of the tokens held by all entities, without the pending amounts
+    int64_t totalTokens = 0;
+    //! Entities which hold a non-zero number of tokens
+    std::unordered_set<std::string> holders;
+};
+
 
 #endif // BITCOIN_OMNICORE_TALLY_H
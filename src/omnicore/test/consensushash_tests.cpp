@@ -0,0 +1,53 @@
+#include <omnicore/consensushash.h>
+#include <omnicore/omnicore.h>
+#include <omnicore/tally.h>
+
+#include <test/test_bitcoin.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include <openssl/sha.h>
+
+using namespace mastercore;
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_consensushash_tests, BasicTestingSetup)
+
+static uint256 HashStrings(const std::string& data)
+{
+    uint256 hash;
+    SHA256((const unsigned char*)data.c_str(), data.length(), (unsigned char*)&hash);
+    return hash;
+}
+
+BOOST_AUTO_TEST_CASE(balances_hash_incremental)
+{
+    LOCK(cs_tally);
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+    ClearConsensusHashBalances();
+
+    BOOST_CHECK(update_tally_map("bob", 3, 100, BALANCE));
+    BOOST_CHECK(update_tally_map("alice", 3, 50, BALANCE));
+    BOOST_CHECK(update_tally_map("alice", 3, 25, METADEX_RESERVE));
+    BOOST_CHECK(update_tally_map("carol", 3, 10, PENDING));
+    BOOST_CHECK(update_tally_map("carol", 4, 10, BALANCE));
+    BOOST_CHECK_EQUAL(GetBalancesHash(3), HashStrings("alice|3|50|0|0|25" "bob|3|100|0|0|0"));
+
+    // Changed and emptied balances are hashed again
+    BOOST_CHECK(update_tally_map("bob", 3, -100, BALANCE));
+    BOOST_CHECK(update_tally_map("carol", 3, 10, BALANCE));
+    BOOST_CHECK(update_tally_map("alice", 3, 5, SELLOFFER_RESERVE));
+    BOOST_CHECK_EQUAL(GetBalancesHash(3), HashStrings("alice|3|50|5|0|25" "carol|3|10|0|0|0"));
+    BOOST_CHECK_EQUAL(GetBalancesHash(4), HashStrings("carol|4|10|0|0|0"));
+
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+    ClearConsensusHashBalances();
+    BOOST_CHECK_EQUAL(GetBalancesHash(3), HashStrings(""));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,3 +1,4 @@
+#include <omnicore/omnicore.h>
 #include <omnicore/tally.h>
 
 #include <test/test_bitcoin.h>
@@ -6,6 +7,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+using namespace mastercore;
+
 BOOST_FIXTURE_TEST_SUITE(omnicore_tally_tests, BasicTestingSetup)
 
 BOOST_AUTO_TEST_CASE(empty_tally)
@@ -318,5 +321,34 @@ BOOST_AUTO_TEST_CASE(tally_overflow)
     BOOST_CHECK_EQUAL(tally.getMoneyReserved(3), int64_t(9223372036854775807LL));
 }
 
+BOOST_AUTO_TEST_CASE(property_holders)
+{
+    LOCK(cs_tally);
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+
+    BOOST_CHECK(update_tally_map("alice", 7, 1000, BALANCE));
+    BOOST_CHECK(update_tally_map("bob", 7, 500, BALANCE));
+    BOOST_CHECK(update_tally_map("carol", 7, 300, PENDING));
+    BOOST_CHECK_EQUAL(mp_property_holders[7].totalTokens, 1500);
+    BOOST_CHECK_EQUAL(mp_property_holders[7].holders.size(), 2U);
+    BOOST_CHECK_EQUAL(mp_property_holders[7].holders.count("carol"), 0U);
+
+    // Reserved tokens are still held
+    BOOST_CHECK(update_tally_map("bob", 7, -500, BALANCE));
+    BOOST_CHECK(update_tally_map("bob", 7, 500, METADEX_RESERVE));
+    BOOST_CHECK_EQUAL(mp_property_holders[7].totalTokens, 1500);
+    BOOST_CHECK_EQUAL(mp_property_holders[7].holders.count("bob"), 1U);
+
+    // A failed update doesn't change the holders
+    BOOST_CHECK(!update_tally_map("alice", 7, -1001, BALANCE));
+    BOOST_CHECK(update_tally_map("alice", 7, -1000, BALANCE));
+    BOOST_CHECK_EQUAL(mp_property_holders[7].totalTokens, 500);
+    BOOST_CHECK_EQUAL(mp_property_holders[7].holders.size(), 1U);
+    BOOST_CHECK_EQUAL(mp_property_holders[7].holders.count("alice"), 0U);
+
+    mp_tally_map.clear();
+    mp_property_holders.clear();
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+#include <omnicore/dbtxlist.h>
+
+#include <test/test_bitcoin.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_txlist_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(txlist_block_range)
+{
+    CMPTxList txlist(GetDataDir() / "MP_txlist_test", true);
+    uint256 txid1 = uint256S("01");
+    uint256 txid2 = uint256S("02");
+    uint256 txid3 = uint256S("03");
+    uint256 txid4 = uint256S("04");
+
+    txlist.recordTX(txid1, true, 100, 0, 0);
+    txlist.recordTX(txid2, true, 101, 0, 0);
+    txlist.recordTX(txid3, false, 101, 0, 0);
+    txlist.recordPaymentTX(txid4, true, 102, 1, 3, 1000, "buyer", "seller");
+    txlist.recordPaymentTX(txid4, true, 102, 2, 3, 2000, "buyer", "seller");
+    txlist.recordMetaDExCancelTX(txid1, txid2, true, 102, 3, 500);
+
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountTotal(), 4);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountBlock(100), 1);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountBlock(101), 2);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountBlock(102), 1);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountBlock(103), 0);
+
+    std::set<uint256> txs;
+    BOOST_CHECK_EQUAL(txlist.GetOmniTxsInBlockRange(101, 102, txs), 3);
+    BOOST_CHECK(txs == std::set<uint256>({txid2, txid3, txid4}));
+
+    std::set<int> seedBlocks = txlist.GetSeedBlocks(0, 101);
+    BOOST_CHECK(seedBlocks == std::set<int>({100, 101}));
+
+    BOOST_CHECK(txlist.isMPinBlockRange(102, 200, false));
+    BOOST_CHECK(!txlist.isMPinBlockRange(103, 200, false));
+}
+
+BOOST_AUTO_TEST_CASE(txlist_rollback)
+{
+    CMPTxList txlist(GetDataDir() / "MP_txlist_test", true);
+    uint256 txid1 = uint256S("01");
+    uint256 txid2 = uint256S("02");
+    uint256 txid3 = uint256S("03");
+
+    txlist.recordTX(txid1, true, 100, 0, 0);
+    txlist.recordTX(txid2, true, 101, 0, 0);
+    txlist.recordMetaDExCancelTX(txid3, txid2, true, 101, 3, 500);
+
+    // Rolled back by a reorg
+    BOOST_CHECK(txlist.isMPinBlockRange(101, 200, true));
+    BOOST_CHECK(txlist.exists(txid1));
+    BOOST_CHECK(!txlist.exists(txid2));
+    BOOST_CHECK_EQUAL(txlist.getNumberOfMetaDExCancels(txid3), 0);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountTotal(), 1);
+    BOOST_CHECK(!txlist.isMPinBlockRange(101, 200, false));
+
+    // Reprocessed at another height
+    txlist.recordTX(txid2, true, 102, 0, 0);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountTotal(), 2);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountBlock(101), 0);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountBlock(102), 1);
+
+    // An overwrite moves the index entry
+    txlist.recordTX(txid2, true, 103, 0, 0);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountTotal(), 2);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountBlock(102), 0);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountBlock(103), 1);
+
+    // Building the index again finds the same records
+    BOOST_CHECK(txlist.BuildHeightIndex());
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountTotal(), 2);
+    BOOST_CHECK_EQUAL(txlist.getMPTransactionCountBlock(103), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
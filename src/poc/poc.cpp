@@ -2,6 +2,10 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <poc/poc.h>
 #include <chainparams.h>
 #include <compat/endian.h>
@@ -208,44 +212,52 @@ static constexpr int HASHES_PER_SCOOP = 2;
 static constexpr int SCOOP_SIZE = HASHES_PER_SCOOP * HASH_SIZE; // 2 hashes per scoop
 static constexpr int SCOOPS_PER_PLOT = 4096;
 static constexpr int PLOT_SIZE = SCOOPS_PER_PLOT * SCOOP_SIZE; // 256KB
-static std::unique_ptr<unsigned char> calcDLDataCache(new unsigned char[PLOT_SIZE + 16]); // Global calc cache
 
-//! Thread safe
-static uint64_t CalcDL(int nHeight, const uint256& generationSignature, const uint64_t& nPlotterId, const uint64_t& nNonce, const Consensus::Params& params) {
-    CShabal256 shabal256;
-    uint256 temp;
-
-    // Row data
-    const uint64_t plotterId_be = htobe64(nPlotterId);
-    const uint64_t nonce_be = htobe64(nNonce);
-    unsigned char *const data = calcDLDataCache.get();
-    memcpy(data + PLOT_SIZE, (const unsigned char*)&plotterId_be, 8);
-    memcpy(data + PLOT_SIZE + 8, (const unsigned char*)&nonce_be, 8);
+//! Thread safe. Calculate the deadlines of a batch of nonces, the plots are hashed in parallel lanes
+static void CalcDLBatch(const PlotterNonce* nonces, uint64_t* deadlines, size_t count) {
+    assert(count <= MAX_BATCH_NONCES);
+
+    // Row data. The 2MB scratch buffer of a full batch is kept by the calling thread, the
+    // checks and the mining threads calculate deadlines over and over
+#if defined(HAVE_THREAD_LOCAL)
+    static thread_local std::unique_ptr<unsigned char[]> scratch(new unsigned char[MAX_BATCH_NONCES * (PLOT_SIZE + 16)]);
+#else
+    std::unique_ptr<unsigned char[]> scratch(new unsigned char[count * (PLOT_SIZE + 16)]);
+#endif
+    unsigned char* data[MAX_BATCH_NONCES];
+    for (size_t n = 0; n < count; n++) {
+        data[n] = scratch.get() + n * (PLOT_SIZE + 16);
+        const uint64_t plotterId_be = htobe64(nonces[n].nPlotterId);
+        const uint64_t nonce_be = htobe64(nonces[n].nNonce);
+        memcpy(data[n] + PLOT_SIZE, (const unsigned char*)&plotterId_be, 8);
+        memcpy(data[n] + PLOT_SIZE + 8, (const unsigned char*)&nonce_be, 8);
+    }
+    const unsigned char* in[MAX_BATCH_NONCES];
+    unsigned char* out[MAX_BATCH_NONCES];
     for (int i = PLOT_SIZE; i > 0; i -= HASH_SIZE) {
         int len = PLOT_SIZE + 16 - i;
         if (len > SCOOPS_PER_PLOT) {
             len = SCOOPS_PER_PLOT;
         }
 
-        shabal256
-            .Write(data + i, len)
-            .Finalize(data + i - HASH_SIZE);
+        for (size_t n = 0; n < count; n++) {
+            in[n] = data[n] + i;
+            out[n] = data[n] + i - HASH_SIZE;
+        }
+        Shabal256Batch(out, in, len, count);
     }
     // Final
-    shabal256
-        .Write(data, PLOT_SIZE + 16)
-        .Finalize(temp.begin());
-    for (int i = 0; i < PLOT_SIZE; i++) {
-        data[i] = (unsigned char) (data[i] ^ (temp.begin()[i % HASH_SIZE]));
+    unsigned char finals[MAX_BATCH_NONCES][HASH_SIZE];
+    for (size_t n = 0; n < count; n++) {
+        in[n] = data[n];
+        out[n] = finals[n];
+    }
+    Shabal256Batch(out, in, PLOT_SIZE + 16, count);
+    for (size_t n = 0; n < count; n++) {
+        for (int i = 0; i < PLOT_SIZE; i++) {
+            data[n][i] = (unsigned char) (data[n][i] ^ (finals[n][i % HASH_SIZE]));
+        }
     }
-
-    // Scoop
-    const uint64_t height_be = htobe64(static_cast<uint64_t>(nHeight));
-    shabal256
-        .Write(generationSignature.begin(), generationSignature.size())
-        .Write((const unsigned char*)&height_be, 8)
-        .Finalize((unsigned char*)temp.begin());
-    const uint32_t scoop = (uint32_t) (temp.begin()[31] + 256 * temp.begin()[30]) % 4096;
 
     // PoC2 Rearrangement. Swap high hash
     //
@@ -255,32 +267,77 @@ static uint64_t CalcDL(int nHeight, const uint256& generationSignature, const ui
     // [3] <-> [N-3]
     //
     // Only care hash data of scoop index
-    memcpy(data + scoop * SCOOP_SIZE + HASH_SIZE, data + (SCOOPS_PER_PLOT - scoop) * SCOOP_SIZE - HASH_SIZE, HASH_SIZE);
+    unsigned char messages[MAX_BATCH_NONCES][HASH_SIZE + SCOOP_SIZE];
+    for (size_t n = 0; n < count; n++) {
+        // Scoop, the plot hashes above don't depend on the block the nonce is mined on
+        uint256 temp;
+        const uint64_t height_be = htobe64(static_cast<uint64_t>(nonces[n].nHeight));
+        CShabal256()
+            .Write(nonces[n].generationSignature.begin(), nonces[n].generationSignature.size())
+            .Write((const unsigned char*)&height_be, 8)
+            .Finalize((unsigned char*)temp.begin());
+        const uint32_t scoop = (uint32_t) (temp.begin()[31] + 256 * temp.begin()[30]) % 4096;
+
+        memcpy(data[n] + scoop * SCOOP_SIZE + HASH_SIZE, data[n] + (SCOOPS_PER_PLOT - scoop) * SCOOP_SIZE - HASH_SIZE, HASH_SIZE);
+        memcpy(messages[n], nonces[n].generationSignature.begin(), HASH_SIZE);
+        memcpy(messages[n] + HASH_SIZE, data[n] + scoop * SCOOP_SIZE, SCOOP_SIZE);
+        in[n] = messages[n];
+        out[n] = finals[n];
+    }
 
     // Result
-    shabal256
-        .Write(generationSignature.begin(), generationSignature.size())
-        .Write(data + scoop * SCOOP_SIZE, SCOOP_SIZE)
-        .Finalize(temp.begin());
-    return temp.GetUint64(0);
+    Shabal256Batch(out, in, HASH_SIZE + SCOOP_SIZE, count);
+    for (size_t n = 0; n < count; n++) {
+        deadlines[n] = ReadLE64(finals[n]);
+    }
 }
 
-//! Thread unsafe
-static uint64_t CalculateUnformattedDeadline(const CBlockIndex& prevBlockIndex, const CBlockHeader& block, const Consensus::Params& params)
+//! Thread safe
+static void CalculateUnformattedDeadlines(Span<const PlotterNonce> nonces, uint64_t* deadlines, const Consensus::Params& params)
 {
-    // Fund
-    if (prevBlockIndex.nHeight + 1 <= params.BHDIP001PreMiningEndHeight)
-        return 0;
+    std::vector<PlotterNonce> batch;
+    std::vector<size_t> batchPositions;
+    batch.reserve(MAX_BATCH_NONCES);
+    batchPositions.reserve(MAX_BATCH_NONCES);
+    for (size_t n = 0; n < nonces.size(); n++) {
+        const PlotterNonce& nonce = nonces[n];
+        if (nonce.nHeight <= params.BHDIP001PreMiningEndHeight) {
+            // Fund
+            deadlines[n] = 0;
+        } else if (nonce.nPlotterId == 0 && nonce.nHeight >= params.BHDIP006Height) {
+            // BHDIP006 disallow plotter 0
+            deadlines[n] = poc::INVALID_DEADLINE;
+        } else if (params.fAllowMinDifficultyBlocks) {
+            // Regtest use nonce as deadline
+            deadlines[n] = nonce.nNonce * nonce.nBaseTarget;
+        } else {
+            batch.push_back(nonce);
+            batchPositions.push_back(n);
+        }
 
-    // BHDIP006 disallow plotter 0
-    if (block.nPlotterId == 0 && prevBlockIndex.nHeight + 1 >= params.BHDIP006Height)
-        return poc::INVALID_DEADLINE;
+        if (batch.size() == MAX_BATCH_NONCES || (n + 1 == nonces.size() && !batch.empty())) {
+            uint64_t batchDeadlines[MAX_BATCH_NONCES];
+            CalcDLBatch(batch.data(), batchDeadlines, batch.size());
+            for (size_t i = 0; i < batch.size(); i++) {
+                deadlines[batchPositions[i]] = batchDeadlines[i];
+            }
+            batch.clear();
+            batchPositions.clear();
+        }
+    }
+}
 
-    // Regtest use nonce as deadline
-    if (params.fAllowMinDifficultyBlocks)
-        return block.nNonce * prevBlockIndex.nBaseTarget;
+static uint64_t CalculateUnformattedDeadline(const CBlockIndex& prevBlockIndex, const CBlockHeader& block, const Consensus::Params& params)
+{
+    const PlotterNonce nonce = MakePlotterNonce(prevBlockIndex, block);
+    uint64_t deadline;
+    CalculateUnformattedDeadlines(Span<const PlotterNonce>(&nonce, 1), &deadline, params);
+    return deadline;
+}
 
-    return CalcDL(prevBlockIndex.nHeight + 1, prevBlockIndex.GetNextGenerationSignature(), block.nPlotterId, block.nNonce, params);
+PlotterNonce MakePlotterNonce(const CBlockIndex& prevBlockIndex, const CBlockHeader& block)
+{
+    return PlotterNonce{block.nPlotterId, block.nNonce, prevBlockIndex.nHeight + 1, prevBlockIndex.GetNextGenerationSignature(), prevBlockIndex.nBaseTarget};
 }
 
 // Require hold cs_main
@@ -289,6 +346,41 @@ uint64_t CalculateDeadline(const CBlockIndex& prevBlockIndex, const CBlockHeader
     return CalculateUnformattedDeadline(prevBlockIndex, block, params) / prevBlockIndex.nBaseTarget;
 }
 
+std::vector<uint64_t> CalculateDeadlines(Span<const PlotterNonce> nonces, const Consensus::Params& params)
+{
+    std::vector<uint64_t> deadlines(nonces.size());
+    CalculateUnformattedDeadlines(nonces, deadlines.data(), params);
+    for (size_t n = 0; n < nonces.size(); n++) {
+        deadlines[n] /= nonces[n].nBaseTarget;
+    }
+    return deadlines;
+}
+
+uint256 CalculateNextGenerationSignature(int nHeight, const uint256& generationSignature, const uint256& hashMerkleRoot, uint64_t nPlotterId, const Consensus::Params& params)
+{
+    uint256 nextGenerationSignature;
+    if (nHeight + 1 <= params.BHDIP001PreMiningEndHeight) {
+        //! Pre-Mining not exist generation signature
+    } else if (nHeight + 1 <= params.BHDIP007Height) {
+        //! hashMerkleRoot + nPlotterId. Unsafe
+        // Legacy consensus use little endian
+        uint64_t plotterId = htole64(nPlotterId);
+        CShabal256()
+            .Write(hashMerkleRoot.begin(), hashMerkleRoot.size())
+            .Write((const unsigned char*)&plotterId, 8)
+            .Finalize(nextGenerationSignature.begin());
+    } else if (nHeight + 1 < params.BHDIP009Height) {
+        //! generationSignature + nPlotterId
+        assert(!generationSignature.IsNull());
+        uint64_t plotterId = htobe64(nPlotterId);
+        CShabal256()
+            .Write(generationSignature.begin(), generationSignature.size())
+            .Write((const unsigned char*)&plotterId, 8)
+            .Finalize(nextGenerationSignature.begin());
+    }
+    return nextGenerationSignature;
+}
+
 uint64_t CalculateBaseTarget(const CBlockIndex& prevBlockIndex, const CBlockHeader& block, const Consensus::Params& params)
 {
     int nHeight = prevBlockIndex.nHeight + 1;
@@ -801,24 +893,22 @@ static inline int64_t GetCompatibleNetCapacity(int nMiningHeight, const Consensu
 }
 
 arith_uint256 CalculateAverageNetworkSpace(CBlockIndex const* pindexCurr, Consensus::Params const& params, int nCountBlocks) {
-    CBlockIndex const* pindex = pindexCurr;
     int nCount = nCountBlocks > 0 ? nCountBlocks : params.BHDIP009DifficultyEvalWindow;
-    int nActual{0};
-    arith_uint256 result;
-    while (nCount > 0 && pindex->nHeight >= params.BHDIP009Height) {
-        int nBitsOfFilter = pindex->nHeight < params.BHDIP009PlotIdBitsOfFilterEnableOnHeight ? 0 : params.BHDIP009PlotIdBitsOfFilter;
-        auto netspace = chiapos::CalculateNetworkSpace(chiapos::GetDifficultyForNextIterations(pindex->pprev, params),
-                pindex->chiaposFields.GetTotalIters(), params.BHDIP009DifficultyConstantFactorBits);
-        ++nActual;
-        result += netspace;
-        // Next
-        pindex = pindex->pprev;
-        --nCount;
-    }
+    int nActual = std::max(std::min(pindexCurr->nHeight - params.BHDIP009Height + 1, nCount), 0);
     LogPrint(BCLog::POC, "%s: average netspace for total %ld block(s)\n", __func__, nActual);
     if (nActual == 0) {
         return 0;
     }
+    if (nCount == params.BHDIP009DifficultyEvalWindow) {
+        // The sum of the evaluation window is stored on the block index
+        return pindexCurr->nChiaNetspaceSum / nActual;
+    }
+    arith_uint256 result;
+    CBlockIndex const* pindex = pindexCurr;
+    for (int i = 0; i < nActual; ++i) {
+        result += chiapos::GetChiaBlockNetworkSpace(pindex, params);
+        pindex = pindex->pprev;
+    }
     return result / nActual;
 }
 
@@ -904,7 +994,7 @@ CAmount GetMiningRequireBalance(const CAccountID& generatorAccountID, const CPlo
                 nBlockCount++;
                 for (const CPlotterBindData &bindData : plotters) {
                     assert(block.IsChiaBlock());
-                    if (bindData == CChiaFarmerPk(block.chiaposFields.posProof.vchFarmerPk)) {
+                    if (bindData == CChiaFarmerPk(block.chiaposFields.vchFarmerPk)) {
                         ++nMinedCount;
                         break;
                     }
@@ -961,9 +1051,9 @@ CAmount GetMiningRequireBalance(const CAccountID& generatorAccountID, const CPlo
     }
 }
 
-bool CheckProofOfCapacity(const CBlockIndex& prevBlockIndex, const CBlockHeader& block, const Consensus::Params& params)
+bool CheckProofOfCapacity(const CBlockIndex& prevBlockIndex, const CBlockHeader& block, const Consensus::Params& params, const uint64_t* pdeadline)
 {
-    uint64_t deadline = CalculateDeadline(prevBlockIndex, block, params);
+    uint64_t deadline = pdeadline ? *pdeadline : CalculateDeadline(prevBlockIndex, block, params);
 
     // Maybe overflow on arithmetic operation
     if (deadline > poc::MAX_TARGET_DEADLINE)
@@ -10,6 +10,7 @@
 #include <primitives/transaction.h>
 #include <script/script.h>
 #include <script/standard.h>
+#include <span.h>
 #include <uint256.h>
 
 #include <stdlib.h>
@@ -66,6 +67,9 @@ static const int64_t MAX_TARGET_DEADLINE = std::numeric_limits<uint32_t>::max();
 // Invalid deadline
 static const uint64_t INVALID_DEADLINE = std::numeric_limits<uint64_t>::max();
 
+// Max nonces of a deadline batch, the lanes of Shabal256Batch
+static const size_t MAX_BATCH_NONCES = 8;
+
 /**
  * Calculate deadline
  *
@@ -77,6 +81,42 @@ static const uint64_t INVALID_DEADLINE = std::numeric_limits<uint64_t>::max();
  */
 uint64_t CalculateDeadline(const CBlockIndex& prevBlockIndex, const CBlockHeader& block, const Consensus::Params& params);
 
+/** Plotter and nonce of a deadline, with the block they are mined on */
+struct PlotterNonce {
+    uint64_t nPlotterId;
+    uint64_t nNonce;
+    int nHeight;                 // Height of the mined block
+    uint256 generationSignature; // Next generation signature of the previous block
+    uint64_t nBaseTarget;        // Base target of the previous block
+};
+
+/** The plotter and nonce of a block header mined on prevBlockIndex */
+PlotterNonce MakePlotterNonce(const CBlockIndex& prevBlockIndex, const CBlockHeader& block);
+
+/**
+ * Calculate deadlines of nonces, plots are hashed in SIMD lanes when available. The nonces may be mined on
+ * different blocks, only the scoop and the final hash depend on the block.
+ *
+ * @param nonces            Plotter and nonce pairs with their blocks
+ * @param params            Consensus params
+ *
+ * @return Return deadlines, in the order of nonces
+ */
+std::vector<uint64_t> CalculateDeadlines(Span<const PlotterNonce> nonces, const Consensus::Params& params);
+
+/**
+ * Calculate the generation signature which the block after a block is mined on
+ *
+ * @param nHeight               Height of the block
+ * @param generationSignature   Generation signature of the block, the next one of its previous block
+ * @param hashMerkleRoot        Merkle root of the block
+ * @param nPlotterId            Plotter of the block
+ * @param params                Consensus params
+ *
+ * @return Return null after the blocks of burst
+ */
+uint256 CalculateNextGenerationSignature(int nHeight, const uint256& generationSignature, const uint256& hashMerkleRoot, uint64_t nPlotterId, const Consensus::Params& params);
+
 /**
  * Calculate base target
  *
@@ -208,10 +248,11 @@ CAmount GetMiningRequireBalance(const CAccountID& generatorAccountID, const CPlo
  * @param prevBlockIndex    Previous block
  * @param block             Block header
  * @param params            Consensus params
+ * @param pdeadline         Deadline calculated ahead, nullptr to calculate it
  *
  * @return Return true is poc valid
  */
-bool CheckProofOfCapacity(const CBlockIndex& prevBlockIndex, const CBlockHeader& block, const Consensus::Params& params);
+bool CheckProofOfCapacity(const CBlockIndex& prevBlockIndex, const CBlockHeader& block, const Consensus::Params& params, const uint64_t* pdeadline = nullptr);
 
 /**
  * Add private key for mining signature
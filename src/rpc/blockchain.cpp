@@ -146,11 +146,12 @@ UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex
         }
     } else {
         // BHDIP009 fields
-        result.pushKV("farmerSignature", chiapos::BytesToHex(blockindex->chiaposFields.vchFarmerSignature));
-        result.pushKV("challenge", blockindex->chiaposFields.posProof.challenge.GetHex());
+        auto pfields = blockindex->GetChiaposFields();
+        result.pushKV("farmerSignature", chiapos::BytesToHex(pfields->vchFarmerSignature));
+        result.pushKV("challenge", blockindex->chiaposFields.challenge.GetHex());
         // Proof of Space fields
-        result.pushKV("pos", GetPosFields(blockindex->chiaposFields.posProof));
-        result.pushKV("vdf", GetVdfFields(blockindex->chiaposFields.vdfProof));
+        result.pushKV("pos", GetPosFields(pfields->posProof));
+        result.pushKV("vdf", GetVdfFields(pfields->vdfProof));
     }
     if (blockindex->pprev)
         result.pushKV("previousblockhash", blockindex->pprev->GetBlockHash().GetHex());
@@ -216,15 +217,16 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
     auto const& params = Params().GetConsensus();
     if (blockindex->nHeight >= params.BHDIP009Height) {
         // PoS fields
-        result.pushKV("chia_pos", GetPosFields(blockindex->chiaposFields.posProof));
-        result.pushKV("chia_vdf", GetVdfFields(blockindex->chiaposFields.vdfProof));
+        auto pfields = blockindex->GetChiaposFields();
+        result.pushKV("chia_pos", GetPosFields(pfields->posProof));
+        result.pushKV("chia_vdf", GetVdfFields(pfields->vdfProof));
         result.pushKV("chia_vdfspeed", chiapos::MakeNumberStr(blockindex->chiaposFields.GetTotalIters() / blockindex->chiaposFields.GetTotalDuration()));
         // Misc for chia fields
         result.pushKV("chia_totalIters", blockindex->chiaposFields.GetTotalIters());
         result.pushKV("chia_duration", blockindex->chiaposFields.GetTotalDuration());
         result.pushKV("chia_difficulty", blockindex->chiaposFields.nDifficulty);
         result.pushKV("chia_blockWork", chiapos::GetChiaBlockDifficulty(blockindex, params));
-        result.pushKV("chia_farmerSignature", chiapos::BytesToHex(blockindex->chiaposFields.vchFarmerSignature));
+        result.pushKV("chia_farmerSignature", chiapos::BytesToHex(pfields->vchFarmerSignature));
         auto netspace = chiapos::MakeNumberTiB(poc::CalculateAverageNetworkSpace(blockindex, params));
         result.pushKV("chia_netspace_tb", netspace.GetLow64());
     }
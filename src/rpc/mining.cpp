@@ -1114,7 +1114,7 @@ static UniValue getactivebindplotter(const JSONRPCRequest& request)
             if (idData.GetType() == CPlotterBindData::Type::BURST) {
                 match = block.nPlotterId == idData.GetBurstPlotterId();
             } else {
-                match = block.chiaposFields.posProof.vchFarmerPk == idData.GetChiaFarmerPk().ToBytes();
+                match = block.chiaposFields.vchFarmerPk == idData.GetChiaFarmerPk().ToBytes();
             }
             if (match) {
                 UniValue lastBlock(UniValue::VOBJ);
@@ -1230,7 +1230,7 @@ static UniValue listbindplotterofaddress(const JSONRPCRequest& request)
             [&mapPlotterMiningCount, &nBlockCount](const CBlockIndex &block) {
                 nBlockCount++;
                 if (block.IsChiaBlock()) {
-                    mapPlotterMiningCount[CPlotterBindData(CChiaFarmerPk(block.chiaposFields.posProof.vchFarmerPk))]++;
+                    mapPlotterMiningCount[CPlotterBindData(CChiaFarmerPk(block.chiaposFields.vchFarmerPk))]++;
                 } else {
                     mapPlotterMiningCount[CPlotterBindData(block.nPlotterId)]++;
                 }
@@ -1547,7 +1547,7 @@ static UniValue getpledgeofaddress(const std::string &address, CPlotterBindData
                     nBlockCount++;
                     bool fMatch, fChia;
                     if (block.nHeight >= params.BHDIP009Height) {
-                        fMatch = plotters.count(CPlotterBindData(CChiaFarmerPk(block.chiaposFields.posProof.vchFarmerPk))) > 0;
+                        fMatch = plotters.count(CPlotterBindData(CChiaFarmerPk(block.chiaposFields.vchFarmerPk))) > 0;
                         fChia = true;
                     } else {
                         fMatch = plotters.count(CPlotterBindData(block.nPlotterId)) > 0;
@@ -1556,7 +1556,7 @@ static UniValue getpledgeofaddress(const std::string &address, CPlotterBindData
                     if (fMatch) {
                         nMinedBlockCount++;
                         if (fChia) {
-                            auto& item = mapBindPlotter[CPlotterBindData(CChiaFarmerPk(block.chiaposFields.posProof.vchFarmerPk))];
+                            auto& item = mapBindPlotter[CPlotterBindData(CChiaFarmerPk(block.chiaposFields.vchFarmerPk))];
                             item.minedCount++;
                             item.pindexLast = &block;
                         } else {
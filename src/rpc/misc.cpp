@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <chiapos/post.h>
 #include <crypto/ripemd160.h>
 #include <key_io.h>
 #include <httpserver.h>
@@ -14,6 +15,7 @@
 #include <util/system.h>
 #include <util/strencodings.h>
 #include <util/validation.h>
+#include <validation.h>
 
 #include <stdint.h>
 #include <tuple>
@@ -379,6 +381,27 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCVdfStoreMemoryInfo()
+{
+    chiapos::VdfStoreStats stats = chiapos::GetLocalVdfStoreStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("usage", uint64_t(stats.nUsage));
+    obj.pushKV("max", uint64_t(stats.nMaxUsage));
+    obj.pushKV("challenges", uint64_t(stats.nChallenges));
+    return obj;
+}
+
+static UniValue RPCBlockIndexMemoryInfo()
+{
+    BlockIndexMemoryStats stats = GetBlockIndexMemoryStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("chiapos_fields_saved", uint64_t(stats.nChiaposFieldsSaved));
+    obj.pushKV("chiapos_fields_cached", uint64_t(stats.nCacheEntries));
+    obj.pushKV("cache_hits", stats.nCacheHits);
+    obj.pushKV("cache_misses", stats.nCacheMisses);
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -420,6 +443,17 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"vdf_store\": {            (json object) Information about the received vdf requests and proofs\n"
+            "    \"usage\": xxxxx,         (numeric) Number of bytes used\n"
+            "    \"max\": xxxxx,           (numeric) Maximum number of bytes, see -maxvdfstore\n"
+            "    \"challenges\": xxxxx,    (numeric) Number of the challenges stored\n"
+            "  },\n"
+            "  \"block_index\": {          (json object) Information about the block index\n"
+            "    \"chiapos_fields_saved\": xxxxx, (numeric) Number of bytes of the chia proofs and signatures left on disk\n"
+            "    \"chiapos_fields_cached\": xxxxx, (numeric) Number of the blocks which chia fields are cached after they are read\n"
+            "    \"cache_hits\": xxxxx,    (numeric) Number of the reads of the chia fields served from the cache\n"
+            "    \"cache_misses\": xxxxx,  (numeric) Number of the reads of the chia fields from the block index database\n"
             "  }\n"
             "}\n"
                     },
@@ -437,6 +471,8 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("vdf_store", RPCVdfStoreMemoryInfo());
+        obj.pushKV("block_index", RPCBlockIndexMemoryInfo());
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
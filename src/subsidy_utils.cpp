@@ -1,5 +1,7 @@
 #include "subsidy_utils.h"
 
+#include <algorithm>
+
 /**
  * Mutex to guard access to validation specific variables, such as reading
  * or changing the chainstate.
@@ -49,11 +51,38 @@ CAmount GetBlockSubsidy(int nHeight, Consensus::Params const& consensusParams) {
     return nSubsidy;
 }
 
+/** The lowest height above nHeight whose subsidy may differ from the subsidy of nHeight */
+static int GetNextSubsidyChangeHeight(int nHeight, Consensus::Params const& params) {
+    int nNextHeight;
+    if (nHeight < params.BHDIP008Height) {
+        int nInterval = params.nSubsidyHalvingInterval * 600 / params.BHDIP001TargetSpacing;
+        nNextHeight = std::min((nHeight / nInterval + 1) * nInterval, params.BHDIP008Height);
+    } else {
+        int nEqualHeight = params.BHDIP008Height * params.BHDIP001TargetSpacing / params.BHDIP008TargetSpacing;
+        int nInterval = params.nSubsidyHalvingInterval * 600 / params.BHDIP008TargetSpacing;
+        nNextHeight = ((nHeight - params.BHDIP008Height + nEqualHeight) / nInterval + 1) * nInterval + params.BHDIP008Height - nEqualHeight;
+    }
+    if (nHeight < params.BHDIP009Height) {
+        nNextHeight = std::min(nNextHeight, params.BHDIP009Height);
+    }
+    if (nHeight < params.BHDIP010Height) {
+        nNextHeight = std::min(nNextHeight, params.BHDIP010Height);
+    }
+    return nNextHeight;
+}
+
 CAmount GetTotalSupplyBeforeHeight(int nHeight, Consensus::Params const& params) {
+    // The subsidy is constant between halvings and upgrades, sum it by ranges
     CAmount totalReward{0};
-    for (int i = 0; i < nHeight; ++i) {
-        CAmount blockReward = GetBlockSubsidy(i, params);
-        totalReward += blockReward;
+    for (int i = 0; i < nHeight;) {
+        CAmount nSubsidy = GetBlockSubsidy(i, params);
+        if (nSubsidy == 0 && i >= params.BHDIP008Height) {
+            // Halvings only increase from here
+            break;
+        }
+        int nNextHeight = std::min(GetNextSubsidyChangeHeight(i, params), nHeight);
+        totalReward += nSubsidy * (nNextHeight - i);
+        i = nNextHeight;
     }
     return totalReward;
 }
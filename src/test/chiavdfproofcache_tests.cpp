@@ -0,0 +1,111 @@
+// Copyright (c) 2012-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chiapos/post.h>
+#include <consensus/validation.h>
+#include <rpc/server.h>
+#include <univalue.h>
+
+static chiapos::CVdfProof MakeVdfProof()
+{
+    chiapos::CVdfProof vdfProof;
+    vdfProof.challenge = InsecureRand256();
+    vdfProof.vchY = chiapos::Bytes(chiapos::VDF_FORM_SIZE, 1);
+    vdfProof.vchProof = chiapos::Bytes(100, 2);
+    vdfProof.nWitnessType = 0;
+    vdfProof.nVdfIters = 1000;
+    vdfProof.nVdfDuration = 1;
+    return vdfProof;
+}
+
+static bool IsCached(chiapos::CVdfProofCache& cache, chiapos::CVdfProof const& vdfProof)
+{
+    uint256 entry;
+    cache.ComputeEntry(entry, vdfProof);
+    return cache.Get(entry);
+}
+
+static UniValue QueryVdfCacheInfo()
+{
+    JSONRPCRequest request;
+    request.strMethod = "queryvdfcacheinfo";
+    request.params = UniValue(UniValue::VARR);
+    return tableRPC.execute(request);
+}
+
+BOOST_FIXTURE_TEST_SUITE(chiavdfproofcache_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(chiavdfproofcache_entries)
+{
+    uint256 nonce = InsecureRand256();
+    chiapos::CVdfProofCache cache(nonce);
+    cache.setup_bytes(chiapos::VDF_PROOF_CACHE_BYTES);
+
+    chiapos::CVdfProof vdfProof = MakeVdfProof();
+    BOOST_CHECK(!IsCached(cache, vdfProof));
+    uint256 entry;
+    cache.ComputeEntry(entry, vdfProof);
+    cache.Set(entry);
+    BOOST_CHECK(IsCached(cache, vdfProof));
+
+    // Any change of the verified proof is a miss
+    chiapos::CVdfProof changed = vdfProof;
+    changed.vchY[0] ^= 1;
+    BOOST_CHECK(!IsCached(cache, changed));
+    changed = vdfProof;
+    changed.vchProof.back() ^= 1;
+    BOOST_CHECK(!IsCached(cache, changed));
+    changed = vdfProof;
+    changed.nVdfIters += 1;
+    BOOST_CHECK(!IsCached(cache, changed));
+    changed = vdfProof;
+    changed.nWitnessType = 1;
+    BOOST_CHECK(!IsCached(cache, changed));
+    BOOST_CHECK_EQUAL(cache.GetHits(), 1U);
+    BOOST_CHECK_EQUAL(cache.GetMisses(), 5U);
+
+    // The entries of a cache salted with another nonce are not the same
+    chiapos::CVdfProofCache cacheOtherSalt(InsecureRand256());
+    cacheOtherSalt.setup_bytes(chiapos::VDF_PROOF_CACHE_BYTES);
+    uint256 entryOtherSalt;
+    cacheOtherSalt.ComputeEntry(entryOtherSalt, vdfProof);
+    BOOST_CHECK(entryOtherSalt != entry);
+    cacheOtherSalt.Set(entryOtherSalt);
+    BOOST_CHECK(!cacheOtherSalt.Get(entry));
+    BOOST_CHECK(!cache.Get(entryOtherSalt));
+
+    // The same nonce makes the same entries
+    chiapos::CVdfProofCache cacheSameSalt(nonce);
+    uint256 entrySameSalt;
+    cacheSameSalt.ComputeEntry(entrySameSalt, vdfProof);
+    BOOST_CHECK(entrySameSalt == entry);
+}
+
+BOOST_AUTO_TEST_CASE(chiavdfproofcache_rpc_counters)
+{
+    UniValue info = QueryVdfCacheInfo();
+    uint64_t nHits = info["hits"].get_int64();
+    uint64_t nMisses = info["misses"].get_int64();
+
+    // The proof is found in the cache by CheckVdfProof once it is verified, the class-group verification is skipped
+    chiapos::CVdfProof vdfProof = MakeVdfProof();
+    chiapos::CVdfProofCache& cache = chiapos::GetVdfProofCache();
+    BOOST_CHECK(!IsCached(cache, vdfProof));
+    uint256 entry;
+    cache.ComputeEntry(entry, vdfProof);
+    cache.Set(entry);
+    CValidationState state;
+    BOOST_CHECK(chiapos::CheckVdfProof(vdfProof, state));
+    BOOST_CHECK(chiapos::CheckVdfProof(vdfProof, state));
+
+    info = QueryVdfCacheInfo();
+    BOOST_CHECK_EQUAL(info["hits"].get_int64(), nHits + 2);
+    BOOST_CHECK_EQUAL(info["misses"].get_int64(), nMisses + 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
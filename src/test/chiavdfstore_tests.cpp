@@ -0,0 +1,121 @@
+// Copyright (c) 2012-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chiapos/post.h>
+#include <util/system.h>
+
+static chiapos::CVdfProof MakeVdfProof(uint256 const& challenge, uint64_t nIters)
+{
+    chiapos::CVdfProof vdfProof;
+    vdfProof.challenge = challenge;
+    vdfProof.vchY = chiapos::Bytes(100, 1);
+    vdfProof.vchProof = chiapos::Bytes(100, 2);
+    vdfProof.nWitnessType = 0;
+    vdfProof.nVdfIters = nIters;
+    vdfProof.nVdfDuration = 1;
+    return vdfProof;
+}
+
+BOOST_FIXTURE_TEST_SUITE(chiavdfstore_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(chiavdfstore_find_proof)
+{
+    chiapos::PruneLocalVdfStore(1000, uint256());
+    uint256 challenge = InsecureRand256();
+    BOOST_CHECK(chiapos::AddLocalVdfProof(MakeVdfProof(challenge, 3000)));
+    BOOST_CHECK(chiapos::AddLocalVdfProof(MakeVdfProof(challenge, 1000)));
+    BOOST_CHECK(chiapos::AddLocalVdfProof(MakeVdfProof(challenge, 2000)));
+    BOOST_CHECK(!chiapos::AddLocalVdfProof(MakeVdfProof(challenge, 2000)));
+    BOOST_CHECK_EQUAL(chiapos::QueryLocalVdfProof(challenge).size(), 3U);
+
+    chiapos::CVdfProof vdfProof;
+    BOOST_CHECK(chiapos::FindLocalVdfProof(challenge, 1500, &vdfProof));
+    BOOST_CHECK_EQUAL(vdfProof.nVdfIters, 2000U);
+    BOOST_CHECK(chiapos::FindLocalVdfProof(challenge, 3000, &vdfProof));
+    BOOST_CHECK_EQUAL(vdfProof.nVdfIters, 3000U);
+    BOOST_CHECK(!chiapos::FindLocalVdfProof(challenge, 3001, &vdfProof));
+    BOOST_CHECK(!chiapos::FindLocalVdfProof(InsecureRand256(), 1, &vdfProof));
+}
+
+BOOST_AUTO_TEST_CASE(chiavdfstore_prune)
+{
+    chiapos::PruneLocalVdfStore(1000, uint256());
+    uint256 challengeOld = InsecureRand256();
+    BOOST_CHECK(chiapos::AddLocalVdfRequest(challengeOld, 1000));
+    BOOST_CHECK(!chiapos::AddLocalVdfRequest(challengeOld, 1000));
+    BOOST_CHECK(chiapos::AddLocalVdfProof(MakeVdfProof(challengeOld, 1000)));
+
+    chiapos::PruneLocalVdfStore(1000 + chiapos::VDF_STORE_EXPIRY_DEPTH, uint256());
+    uint256 challengeNew = InsecureRand256();
+    BOOST_CHECK(chiapos::AddLocalVdfRequest(challengeNew, 1000));
+    size_t nUsage = chiapos::GetLocalVdfStoreStats().nUsage;
+
+    // The old challenge is evicted
+    chiapos::PruneLocalVdfStore(1000 + chiapos::VDF_STORE_EXPIRY_DEPTH + 1, uint256());
+    BOOST_CHECK(chiapos::QueryLocalVdfRequests(challengeOld).empty());
+    BOOST_CHECK(chiapos::QueryLocalVdfProof(challengeOld).empty());
+    BOOST_CHECK_EQUAL(chiapos::QueryLocalVdfRequests(challengeNew).size(), 1U);
+    BOOST_CHECK(chiapos::GetLocalVdfStoreStats().nUsage < nUsage);
+}
+
+BOOST_AUTO_TEST_CASE(chiavdfstore_disconnect)
+{
+    chiapos::PruneLocalVdfStore(2000, uint256());
+
+    // The tip is lowered by a disconnect, the challenges seen after it are stamped with the lower height
+    chiapos::PruneLocalVdfStore(1990, uint256());
+    uint256 challenge = InsecureRand256();
+    BOOST_CHECK(chiapos::AddLocalVdfRequest(challenge, 1000));
+    chiapos::PruneLocalVdfStore(1990 + chiapos::VDF_STORE_EXPIRY_DEPTH, uint256());
+    BOOST_CHECK_EQUAL(chiapos::QueryLocalVdfRequests(challenge).size(), 1U);
+    chiapos::PruneLocalVdfStore(1990 + chiapos::VDF_STORE_EXPIRY_DEPTH + 1, uint256());
+    BOOST_CHECK(chiapos::QueryLocalVdfRequests(challenge).empty());
+}
+
+BOOST_AUTO_TEST_CASE(chiavdfstore_flood)
+{
+    gArgs.ForceSetArg("-maxvdfstore", "1");
+    chiapos::InitLocalVdfStore();
+    uint256 tipChallenge = InsecureRand256();
+    chiapos::PruneLocalVdfStore(3000, tipChallenge);
+    BOOST_CHECK(chiapos::AddLocalVdfRequest(tipChallenge, 1000));
+    BOOST_CHECK(chiapos::AddLocalVdfProof(MakeVdfProof(tipChallenge, 1000)));
+    uint256 challengeFirst = InsecureRand256();
+    BOOST_CHECK(chiapos::AddLocalVdfRequest(challengeFirst, 1000));
+
+    // The store is filled with junk challenges seen later, the oldest challenges are evicted except the tip challenge
+    chiapos::PruneLocalVdfStore(3001, tipChallenge);
+    for (int i = 0; i < 20000; ++i) {
+        BOOST_CHECK(chiapos::AddLocalVdfRequest(InsecureRand256(), 1000));
+    }
+    chiapos::VdfStoreStats stats = chiapos::GetLocalVdfStoreStats();
+    BOOST_CHECK(stats.nUsage <= stats.nMaxUsage);
+    BOOST_CHECK(chiapos::QueryLocalVdfRequests(challengeFirst).empty());
+    BOOST_CHECK_EQUAL(chiapos::QueryLocalVdfRequests(tipChallenge).size(), 1U);
+    BOOST_CHECK(chiapos::FindLocalVdfProof(tipChallenge, 1000));
+
+    // The tip challenge still takes new requests and proofs
+    BOOST_CHECK(chiapos::AddLocalVdfRequest(tipChallenge, 2000));
+    BOOST_CHECK(chiapos::AddLocalVdfProof(MakeVdfProof(tipChallenge, 2000)));
+    BOOST_CHECK_EQUAL(chiapos::QueryLocalVdfProof(tipChallenge).size(), 2U);
+
+    // The requests which do not fit beside the tip challenge are refused
+    gArgs.ForceSetArg("-maxvdfstore", "0");
+    chiapos::InitLocalVdfStore();
+    BOOST_CHECK_EQUAL(chiapos::GetLocalVdfStoreStats().nChallenges, 1U);
+    uint256 challengeJunk = InsecureRand256();
+    BOOST_CHECK(!chiapos::AddLocalVdfRequest(challengeJunk, 1000));
+    BOOST_CHECK(!chiapos::AddLocalVdfRequest(tipChallenge, 3000));
+    BOOST_CHECK_EQUAL(chiapos::GetLocalVdfStoreStats().nChallenges, 1U);
+    BOOST_CHECK_EQUAL(chiapos::QueryLocalVdfRequests(tipChallenge).size(), 2U);
+
+    gArgs.ForceSetArg("-maxvdfstore", std::to_string(chiapos::DEFAULT_MAX_VDF_STORE_SIZE));
+    chiapos::InitLocalVdfStore();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,11 +3,14 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <attributes.h>
+#include <chainparams.h>
 #include <clientversion.h>
 #include <coins.h>
+#include <consensus/pledge_term.h>
 #include <script/standard.h>
 #include <streams.h>
 #include <test/setup_common.h>
+#include <txdb.h>
 #include <uint256.h>
 #include <undo.h>
 #include <util/strencodings.h>
@@ -53,8 +56,9 @@ public:
 
     uint256 GetBestBlock() const override { return hashBestBlock_; }
 
-    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override
+    bool BatchWrite(CCoinsMap& mapCoins, CAccountTotalsMap& mapTotals, const uint256& hashBlock) override
     {
+        mapTotals.clear();
         for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); ) {
             if (it->second.flags & CCoinsCacheEntry::DIRTY) {
                 // Same optimization used in CCoinsViewDB is to only write dirty entries.
@@ -593,8 +597,9 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags)
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
     CCoinsMap map;
+    CAccountTotalsMap totals;
     InsertCoinsMapEntry(map, value, flags);
-    BOOST_CHECK(view.BatchWrite(map, {}));
+    BOOST_CHECK(view.BatchWrite(map, totals, {}));
 }
 
 class SingleEntryCacheTest
@@ -861,4 +866,345 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(account_totals)
+{
+    // The totals must give the same amounts as weighting each point coin
+    PledgeTerms terms;
+    terms[0] = {100, 8};
+    terms[1] = {200, 20};
+    terms[2] = {300, 50};
+    terms[3] = {400, 100};
+
+    CAccountID sender = ExtractAccountID(GetScriptForDestination(ScriptHash(uint160(g_insecure_rand_ctx.randbytes(20)))));
+    CAccountID receiver = ExtractAccountID(GetScriptForDestination(ScriptHash(uint160(g_insecure_rand_ctx.randbytes(20)))));
+    CAccountTotalsMap mapTotals;
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    for (int i = 0; i < 1000; ++i) {
+        Coin coin(CTxOut(InsecureRandRange(100 * COIN), GetScriptForDestination(ScriptHash(sender))), 1, false);
+        coin.Refresh();
+        DatacarrierType type = static_cast<DatacarrierType>(DATACARRIER_TYPE_CHIA_POINT + InsecureRandRange(4));
+        if (InsecureRandBool()) {
+            auto payload = std::make_shared<PointPayload>(type);
+            payload->receiverID = receiver;
+            coin.extraData = payload;
+        } else {
+            auto payload = std::make_shared<PointRetargetPayload>();
+            payload->receiverID = receiver;
+            payload->pointType = type;
+            payload->nPointHeight = 1;
+            coin.extraData = payload;
+        }
+        coins.emplace_back(COutPoint(InsecureRand256(), 0), coin);
+        ApplyCoinToAccountTotals(mapTotals, coins.back().first, coins.back().second, 1);
+    }
+    // Spend some of them
+    for (auto it = coins.begin(); it != coins.end();) {
+        if (InsecureRandRange(3) == 0) {
+            ApplyCoinToAccountTotals(mapTotals, it->first, it->second, -1);
+            it = coins.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    CAmount nCoinAmount{0}, nExpectedSend{0}, nExpectedReceive{0};
+    for (const auto& pair : coins) {
+        const Coin& coin = pair.second;
+        nCoinAmount += coin.out.nValue;
+        if (coin.IsPoint()) {
+            nExpectedSend += coin.out.nValue;
+            nExpectedReceive += terms[coin.GetExtraDataType() - DATACARRIER_TYPE_CHIA_POINT].nWeightPercent * coin.out.nValue / 100;
+        } else {
+            int nWeightPercent = terms[PointRetargetPayload::As(coin.extraData)->GetPointType() - DATACARRIER_TYPE_CHIA_POINT].nWeightPercent;
+            nExpectedSend += nWeightPercent * coin.out.nValue / 100;
+            nExpectedReceive += nWeightPercent * coin.out.nValue / 100;
+        }
+    }
+
+    CAmount balanceBindPlotter{0}, balancePointSend{0}, balancePointReceive{0};
+    BOOST_CHECK_EQUAL(mapTotals[sender].GetBalance(&balanceBindPlotter, &balancePointSend, &balancePointReceive, &terms, false), nCoinAmount);
+    BOOST_CHECK_EQUAL(balanceBindPlotter, 0);
+    BOOST_CHECK_EQUAL(balancePointSend, nExpectedSend);
+    BOOST_CHECK_EQUAL(balancePointReceive, 0);
+    BOOST_CHECK_EQUAL(mapTotals[receiver].GetBalance(&balanceBindPlotter, &balancePointSend, &balancePointReceive, &terms, false), 0);
+    BOOST_CHECK_EQUAL(balancePointSend, 0);
+    BOOST_CHECK_EQUAL(balancePointReceive, nExpectedReceive);
+
+    // Round trip through serialization
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << mapTotals[receiver];
+    CAccountTotals totals;
+    ss >> totals;
+    totals.GetBalance(&balanceBindPlotter, &balancePointSend, &balancePointReceive, &terms, false);
+    BOOST_CHECK_EQUAL(balancePointReceive, nExpectedReceive);
+}
+
+namespace
+{
+//! The balances of an account, as returned by GetAccountBalance()
+struct AccountBalances {
+    CAmount nCoin{0}, nBindPlotter{0}, nPointSend{0}, nPointReceive{0};
+
+    bool operator==(const AccountBalances& other) const {
+        return nCoin == other.nCoin && nBindPlotter == other.nBindPlotter && nPointSend == other.nPointSend && nPointReceive == other.nPointReceive;
+    }
+};
+
+std::ostream& operator<<(std::ostream& os, const AccountBalances& balances) {
+    return os << strprintf("coin=%d bind=%d send=%d receive=%d", balances.nCoin, balances.nBindPlotter, balances.nPointSend, balances.nPointReceive);
+}
+
+//! Calculate the balances of an account by weighting each unspent coin
+AccountBalances CalculateAccountBalances(const std::map<COutPoint, Coin>& coins, const CAccountID& accountID, const PledgeTerms& terms, bool includeBurst) {
+    AccountBalances balances;
+    for (const auto& pair : coins) {
+        const Coin& coin = pair.second;
+        if (coin.refOutAccountID == accountID) {
+            balances.nCoin += coin.out.nValue;
+            if (coin.IsBindPlotter() && (includeBurst || coin.GetExtraDataType() == DATACARRIER_TYPE_BINDCHIAFARMER)) {
+                balances.nBindPlotter += PROTOCOL_BINDPLOTTER_LOCKAMOUNT;
+            } else if (coin.IsPoint() && (includeBurst || coin.GetExtraDataType() != DATACARRIER_TYPE_POINT)) {
+                balances.nPointSend += coin.out.nValue;
+            } else if (coin.IsPointRetarget()) {
+                balances.nPointSend += terms[PointRetargetPayload::As(coin.extraData)->GetPointType() - DATACARRIER_TYPE_CHIA_POINT].nWeightPercent * coin.out.nValue / 100;
+            }
+        }
+        if (coin.IsPoint() && PointPayload::As(coin.extraData)->GetReceiverID() == accountID) {
+            if (coin.GetExtraDataType() == DATACARRIER_TYPE_POINT) {
+                if (includeBurst)
+                    balances.nPointReceive += coin.out.nValue;
+            } else {
+                balances.nPointReceive += terms[coin.GetExtraDataType() - DATACARRIER_TYPE_CHIA_POINT].nWeightPercent * coin.out.nValue / 100;
+            }
+        } else if (coin.IsPointRetarget() && PointRetargetPayload::As(coin.extraData)->GetReceiverID() == accountID) {
+            balances.nPointReceive += terms[PointRetargetPayload::As(coin.extraData)->GetPointType() - DATACARRIER_TYPE_CHIA_POINT].nWeightPercent * coin.out.nValue / 100;
+        }
+    }
+    return balances;
+}
+
+AccountBalances GetTotalsBalances(const CCoinsViewCache& view, const CAccountID& accountID, const PledgeTerms& terms, bool includeBurst) {
+    AccountBalances balances;
+    balances.nCoin = view.GetAccountBalance(includeBurst, accountID, &balances.nBindPlotter, &balances.nPointSend, &balances.nPointReceive, &terms);
+    return balances;
+}
+
+//! The balances from scanning the coins of the database and the caches, as GetAccountBalance() did before the totals
+AccountBalances GetScannedBalances(const CCoinsViewCache& view, const CAccountID& accountID, const PledgeTerms& terms, bool includeBurst) {
+    AccountBalances balances;
+    balances.nCoin = view.GetBalance(accountID, CCoinsMap(), &balances.nBindPlotter, &balances.nPointSend, &balances.nPointReceive, &terms, 0, includeBurst);
+    return balances;
+}
+
+Coin MakeAccountTotalsCoin(const std::vector<CAccountID>& accounts, int nBindHeight) {
+    const CAccountID& owner = accounts[InsecureRandRange(accounts.size())];
+    const CAccountID& receiver = accounts[InsecureRandRange(accounts.size())];
+    Coin coin(CTxOut(1 + InsecureRandRange(100 * COIN), GetScriptForDestination(ScriptHash(owner))), 1 + InsecureRandRange(1000), false);
+    coin.Refresh();
+    DatacarrierType chiaPointType = static_cast<DatacarrierType>(DATACARRIER_TYPE_CHIA_POINT + InsecureRandRange(4));
+    switch (InsecureRandRange(6)) {
+    case 0: {
+        auto payload = std::make_shared<BindPlotterPayload>(DATACARRIER_TYPE_BINDPLOTTER);
+        payload->SetId(CPlotterBindData(InsecureRand32()));
+        coin.extraData = payload;
+        coin.nHeight = nBindHeight;
+        break;
+    }
+    case 1: {
+        auto payload = std::make_shared<BindPlotterPayload>(DATACARRIER_TYPE_BINDCHIAFARMER);
+        payload->SetId(CPlotterBindData(CChiaFarmerPk(g_insecure_rand_ctx.randbytes(48))));
+        coin.extraData = payload;
+        coin.nHeight = nBindHeight;
+        break;
+    }
+    case 2: {
+        auto payload = std::make_shared<PointPayload>(InsecureRandBool() ? DATACARRIER_TYPE_POINT : chiaPointType);
+        payload->receiverID = receiver;
+        coin.extraData = payload;
+        break;
+    }
+    case 3: {
+        auto payload = std::make_shared<PointRetargetPayload>();
+        payload->receiverID = receiver;
+        payload->pointType = chiaPointType;
+        payload->nPointHeight = 0;
+        coin.extraData = payload;
+        break;
+    }
+    default:
+        // A plain coin
+        break;
+    }
+    return coin;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(account_totals_cache_stack)
+{
+    PledgeTerms terms;
+    terms[0] = {100, 8};
+    terms[1] = {200, 20};
+    terms[2] = {300, 50};
+    terms[3] = {400, 100};
+
+    std::vector<CAccountID> accounts;
+    for (int i = 0; i < 3; ++i) {
+        accounts.push_back(ExtractAccountID(GetScriptForDestination(ScriptHash(uint160(g_insecure_rand_ctx.randbytes(20))))));
+    }
+    // The spent bind coins above BHDIP007 are unbound rather than erased
+    const int nBindHeight = Params().GetConsensus().BHDIP007Height + 1;
+
+    CCoinsViewDB base(GetDataDir() / "account_totals", 1 << 20, true, true);
+    std::vector<std::unique_ptr<CCoinsViewCache>> stack;
+    stack.push_back(MakeUnique<CCoinsViewCache>(&base));
+
+    std::map<COutPoint, Coin> coins; // The unspent coins of the top cache
+    std::map<COutPoint, Coin> spent; // The spent coins which can be added back by a reorg
+    int nOverwrites{0}, nReadds{0}, nDatabaseFlushes{0};
+    for (int i = 0; i < 4000; ++i) {
+        CCoinsViewCache& top = *stack.back();
+        uint32_t r = InsecureRandRange(100);
+        if (r < 40 || coins.empty()) {
+            COutPoint outpoint(InsecureRand256(), 0);
+            Coin coin = MakeAccountTotalsCoin(accounts, InsecureRandBool() ? 1 : nBindHeight);
+            coins[outpoint] = coin;
+            top.AddCoin(outpoint, std::move(coin), false);
+        } else if (r < 70) {
+            auto it = std::next(coins.begin(), InsecureRandRange(coins.size()));
+            BOOST_CHECK(top.SpendCoin(it->first, nullptr, InsecureRandRange(4) == 0));
+            spent.insert(*it);
+            coins.erase(it);
+        } else if (r < 78 && !spent.empty()) {
+            // A disconnected block adds the spent coins back
+            auto it = std::next(spent.begin(), InsecureRandRange(spent.size()));
+            Coin coin = it->second;
+            coins.insert(*it);
+            top.AddCoin(it->first, std::move(coin), true);
+            spent.erase(it);
+            ++nReadds;
+        } else if (r < 86) {
+            // The coin may be in a lower view only, it must not be counted twice
+            auto it = std::next(coins.begin(), InsecureRandRange(coins.size()));
+            Coin coin = it->second;
+            nOverwrites += top.HaveCoinInCache(it->first) ? 0 : 1;
+            top.AddCoin(it->first, std::move(coin), true);
+        } else if (r < 92 && stack.size() < 4) {
+            stack.push_back(MakeUnique<CCoinsViewCache>(&top));
+        } else if (r < 97 && stack.size() > 1) {
+            top.SetBestBlock(InsecureRand256());
+            BOOST_CHECK(top.Flush());
+            stack.pop_back();
+        } else {
+            // Flush the whole stack to the database
+            while (!stack.empty()) {
+                stack.back()->SetBestBlock(InsecureRand256());
+                BOOST_CHECK(stack.back()->Flush());
+                stack.pop_back();
+            }
+            stack.push_back(MakeUnique<CCoinsViewCache>(&base));
+            ++nDatabaseFlushes;
+        }
+
+        const CCoinsViewCache& view = *stack.back();
+        bool fFlushed = stack.size() == 1 && view.GetCacheSize() == 0;
+        for (const CAccountID& accountID : accounts) {
+            for (bool includeBurst : {false, true}) {
+                AccountBalances expected = CalculateAccountBalances(coins, accountID, terms, includeBurst);
+                AccountBalances totals = GetTotalsBalances(view, accountID, terms, includeBurst);
+                AccountBalances scanned = GetScannedBalances(view, accountID, terms, includeBurst);
+                BOOST_CHECK_EQUAL(totals, scanned);
+                if (!fFlushed) {
+                    // The scan counts the retarget coins of the database until the spent ones are flushed, see
+                    // CCoinsViewCache::GetAccountBalance(). Everything else is the same.
+                    expected.nPointSend = scanned.nPointSend;
+                }
+                BOOST_CHECK_EQUAL(scanned, expected);
+            }
+        }
+    }
+    BOOST_CHECK(nOverwrites > 0);
+    BOOST_CHECK(nReadds > 0);
+    BOOST_CHECK(nDatabaseFlushes > 0);
+}
+
+BOOST_AUTO_TEST_CASE(account_totals_spent_retarget)
+{
+    PledgeTerms terms;
+    terms[0] = {100, 8};
+    terms[1] = {200, 20};
+    terms[2] = {300, 50};
+    terms[3] = {400, 100};
+    CAccountID sender = ExtractAccountID(GetScriptForDestination(ScriptHash(uint160(g_insecure_rand_ctx.randbytes(20)))));
+    CAccountID receiver = ExtractAccountID(GetScriptForDestination(ScriptHash(uint160(g_insecure_rand_ctx.randbytes(20)))));
+
+    CCoinsViewDB base(GetDataDir() / "account_totals_retarget", 1 << 20, true, true);
+    COutPoint outpoint(InsecureRand256(), 0);
+    {
+        Coin coin(CTxOut(10 * COIN, GetScriptForDestination(ScriptHash(sender))), 1, false);
+        coin.Refresh();
+        auto payload = std::make_shared<PointRetargetPayload>();
+        payload->receiverID = receiver;
+        payload->pointType = DATACARRIER_TYPE_CHIA_POINT_TERM_1;
+        payload->nPointHeight = 0;
+        coin.extraData = payload;
+        CCoinsViewCache cache(&base);
+        cache.AddCoin(outpoint, std::move(coin), false);
+        cache.SetBestBlock(InsecureRand256());
+        BOOST_CHECK(cache.Flush());
+    }
+
+    CCoinsViewCache cache(&base);
+    BOOST_CHECK_EQUAL(GetTotalsBalances(cache, sender, terms, false).nPointSend, 10 * COIN * 20 / 100);
+    BOOST_CHECK_EQUAL(GetScannedBalances(cache, sender, terms, false).nPointSend, 10 * COIN * 20 / 100);
+    BOOST_CHECK(cache.SpendCoin(outpoint));
+    // The scan drops the spent retarget coin only after it's flushed, the balances are scanned until then
+    BOOST_CHECK_EQUAL(GetTotalsBalances(cache, sender, terms, false).nPointSend, 10 * COIN * 20 / 100);
+    BOOST_CHECK_EQUAL(GetScannedBalances(cache, sender, terms, false).nPointSend, 10 * COIN * 20 / 100);
+    {
+        // The same in a cache over the cache
+        CCoinsViewCache child(&cache);
+        BOOST_CHECK_EQUAL(GetTotalsBalances(child, sender, terms, false).nPointSend, 10 * COIN * 20 / 100);
+    }
+    BOOST_CHECK_EQUAL(GetTotalsBalances(cache, receiver, terms, false).nPointReceive, 0);
+    BOOST_CHECK_EQUAL(GetScannedBalances(cache, receiver, terms, false).nPointReceive, 0);
+    cache.SetBestBlock(InsecureRand256());
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(GetTotalsBalances(cache, sender, terms, false).nPointSend, 0);
+    BOOST_CHECK_EQUAL(GetScannedBalances(cache, sender, terms, false).nPointSend, 0);
+}
+
+BOOST_AUTO_TEST_CASE(account_totals_fallback_term)
+{
+    // The totals weight a pledge with its term at any height, which is only the same as the scan while the
+    // fallback term of GetTerm() is the term itself
+    PledgeTerms terms;
+    terms[0] = {100, 8};
+    terms[1] = {200, 20};
+    terms[2] = {300, 50};
+    terms[3] = {400, 100};
+    CAccountID sender = ExtractAccountID(GetScriptForDestination(ScriptHash(uint160(g_insecure_rand_ctx.randbytes(20)))));
+    CAccountID receiver = ExtractAccountID(GetScriptForDestination(ScriptHash(uint160(g_insecure_rand_ctx.randbytes(20)))));
+
+    CCoinsViewDB base(GetDataDir() / "account_totals_fallback", 1 << 20, true, true);
+    CCoinsViewCache cache(&base);
+    for (int i = 0; i < CAccountTotals::TERM_COUNT; ++i) {
+        Coin coin(CTxOut(10 * COIN, GetScriptForDestination(ScriptHash(sender))), 1, false);
+        coin.Refresh();
+        auto payload = std::make_shared<PointPayload>(static_cast<DatacarrierType>(DATACARRIER_TYPE_CHIA_POINT + i));
+        payload->receiverID = receiver;
+        coin.extraData = payload;
+        cache.AddCoin(COutPoint(InsecureRand256(), 0), std::move(coin), false);
+    }
+    cache.SetBestBlock(InsecureRand256());
+    BOOST_CHECK(cache.Flush());
+
+    // Every pledge is locked for longer than its term
+    int nHeight = 1 + terms[3].nLockHeight + 1;
+    AccountBalances totals, scanned;
+    totals.nCoin = cache.GetAccountBalance(false, receiver, &totals.nBindPlotter, &totals.nPointSend, &totals.nPointReceive, &terms, nHeight);
+    scanned.nCoin = cache.GetBalance(receiver, CCoinsMap(), &scanned.nBindPlotter, &scanned.nPointSend, &scanned.nPointReceive, &terms, nHeight, false);
+    BOOST_CHECK_EQUAL(totals, scanned);
+    BOOST_CHECK_EQUAL(totals.nPointReceive, (8 + 20 + 50 + 100) * 10 * COIN / 100);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
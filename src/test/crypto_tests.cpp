@@ -13,6 +13,7 @@
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
 #include <crypto/sha512.h>
+#include <crypto/shabal256.h>
 #include <random.h>
 #include <util/strencodings.h>
 #include <test/setup_common.h>
@@ -749,4 +750,27 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+BOOST_AUTO_TEST_CASE(shabal256_batch)
+{
+    // Lengths cover the padding of the final block and the lengths hashed by the deadline calculation
+    for (size_t len : {0, 1, 31, 32, 63, 64, 65, 96, 127, 128, 4096, 4113}) {
+        for (size_t count = 1; count <= 17; ++count) {
+            std::vector<unsigned char> in(len * count);
+            for (unsigned char& c : in) {
+                c = InsecureRandBits(8);
+            }
+            std::vector<unsigned char> out1(32 * count), out2(32 * count);
+            std::vector<const unsigned char*> inputs(count);
+            std::vector<unsigned char*> outputs(count);
+            for (size_t j = 0; j < count; ++j) {
+                CShabal256().Write(in.data() + len * j, len).Finalize(out1.data() + 32 * j);
+                inputs[j] = in.data() + len * j;
+                outputs[j] = out2.data() + 32 * j;
+            }
+            Shabal256Batch(outputs.data(), inputs.data(), len, count);
+            BOOST_CHECK(out1 == out2);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -520,4 +520,38 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     fCheckpointsEnabled = true;
 }
 
+BOOST_AUTO_TEST_CASE(ChiaBlockTemplateCache_matches_assembler)
+{
+    const CChainParams& chainparams = Params();
+    CScript scriptPubKey = GetScriptForDestination(ScriptHash(CScript() << OP_TRUE));
+    std::vector<uint8_t> vchFarmerPk(48, 0x01);
+
+    CChiaBlockTemplateCache cache(chainparams);
+    const CBlockIndex* pindexPrev = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+    // The farmer is unknown to the cache until it asks for a template
+    BOOST_CHECK(cache.Take(pindexPrev, scriptPubKey, vchFarmerPk) == nullptr);
+    cache.AssembleTemplates();
+    std::unique_ptr<CBlockTemplate> pcached = cache.Take(pindexPrev, scriptPubKey, vchFarmerPk);
+    BOOST_REQUIRE(pcached);
+
+    std::unique_ptr<CBlockTemplate> pfresh;
+    {
+        LOCK(cs_main);
+        pfresh = BlockAssembler(chainparams).CreateNewChiaBlockTemplate(pindexPrev, scriptPubKey, vchFarmerPk);
+    }
+    BOOST_REQUIRE(pfresh);
+
+    // The cached template skips TestBlockValidity, everything but the time must be the same as a fresh one
+    BOOST_CHECK(pcached->block.hashPrevBlock == pfresh->block.hashPrevBlock);
+    BOOST_CHECK_EQUAL(pcached->block.nVersion, pfresh->block.nVersion);
+    BOOST_CHECK(pcached->block.hashMerkleRoot == pfresh->block.hashMerkleRoot);
+    BOOST_REQUIRE_EQUAL(pcached->block.vtx.size(), pfresh->block.vtx.size());
+    for (size_t i = 0; i < pfresh->block.vtx.size(); ++i) {
+        BOOST_CHECK(pcached->block.vtx[i]->GetWitnessHash() == pfresh->block.vtx[i]->GetWitnessHash());
+    }
+    BOOST_CHECK(pcached->vTxFees == pfresh->vTxFees);
+    BOOST_CHECK(pcached->vTxSigOpsCost == pfresh->vTxSigOpsCost);
+    BOOST_CHECK(pcached->vchCoinbaseCommitment == pfresh->vchCoinbaseCommitment);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <index/pledgeindex.h>
+#include <script/standard.h>
+#include <test/setup_common.h>
+
+#include <limits>
+#include <map>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pledgeindex_tests, BasicTestingSetup)
+
+static CAccountID MakeAccountID(unsigned char n)
+{
+    uint160 hash;
+    hash.begin()[0] = n;
+    return CAccountID(hash);
+}
+
+static CTransactionRef MakePledgeIndexTx(const uint256& prevHash, const CAccountID& sender, const CScript& scriptPayload)
+{
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::UNIFORM_VERSION;
+    mtx.vin.emplace_back(COutPoint(prevHash, 0));
+    mtx.vout.emplace_back(PROTOCOL_POINT_AMOUNT_MIN, GetScriptForDestination(ScriptHash(sender)));
+    if (!scriptPayload.empty()) {
+        mtx.vout.emplace_back(0, scriptPayload);
+    }
+    return MakeTransactionRef(std::move(mtx));
+}
+
+static CBlock MakePledgeIndexBlock(const CTransactionRef& tx)
+{
+    CBlock block;
+    block.vtx.push_back(tx);
+    return block;
+}
+
+static std::map<uint256, PledgeTx> FindPledgeTxs(const PledgeIndex& index, const CAccountID* pAccountID)
+{
+    std::vector<PledgeTx> vPledgeTxs;
+    BOOST_CHECK(index.FindPledgeTxs(0, std::numeric_limits<int>::max(), pAccountID, vPledgeTxs));
+    std::map<uint256, PledgeTx> pledgeTxs;
+    for (const PledgeTx& pledgeTx : vPledgeTxs) {
+        pledgeTxs.emplace(pledgeTx.txHash, pledgeTx);
+    }
+    return pledgeTxs;
+}
+
+BOOST_AUTO_TEST_CASE(pledgeindex_write_and_rewind)
+{
+    PledgeIndex index(1 << 20, true);
+    const int nHeight = Params().GetConsensus().BHDIP009Height;
+    const CAccountID sender = MakeAccountID(1), receiver = MakeAccountID(2), newReceiver = MakeAccountID(3);
+
+    // A pledge, its retarget to another receiver, and the withdraw of the retarget, one block each
+    uint256 prevHash;
+    prevHash.begin()[0] = 4;
+    CTransactionRef pledgeTx = MakePledgeIndexTx(prevHash, sender,
+            GetPointScriptForDestination(ScriptHash(receiver), DATACARRIER_TYPE_CHIA_POINT_TERM_1));
+    CTransactionRef retargetTx = MakePledgeIndexTx(pledgeTx->GetHash(), sender,
+            GetPointRetargetScriptForDestination(ScriptHash(newReceiver), DATACARRIER_TYPE_CHIA_POINT_TERM_1, nHeight));
+    CTransactionRef withdrawTx = MakePledgeIndexTx(retargetTx->GetHash(), sender, CScript());
+    BOOST_CHECK(index.WritePledgeTxs(MakePledgeIndexBlock(pledgeTx), nHeight));
+    BOOST_CHECK(index.WritePledgeTxs(MakePledgeIndexBlock(retargetTx), nHeight + 1));
+    BOOST_CHECK(index.WritePledgeTxs(MakePledgeIndexBlock(withdrawTx), nHeight + 2));
+
+    std::map<uint256, PledgeTx> pledgeTxs = FindPledgeTxs(index, nullptr);
+    BOOST_CHECK_EQUAL(pledgeTxs.size(), 2U);
+    BOOST_CHECK(pledgeTxs.at(pledgeTx->GetHash()).receiver == receiver);
+    BOOST_CHECK(!pledgeTxs.at(pledgeTx->GetHash()).fAvailable);
+    BOOST_CHECK(pledgeTxs.at(retargetTx->GetHash()).receiver == newReceiver);
+    BOOST_CHECK_EQUAL(pledgeTxs.at(retargetTx->GetHash()).nReceivedAmount, PROTOCOL_POINT_AMOUNT_MIN);
+    BOOST_CHECK(!pledgeTxs.at(retargetTx->GetHash()).fAvailable);
+
+    // The accounts refer to the pledge txs they sent or received
+    BOOST_CHECK_EQUAL(FindPledgeTxs(index, &sender).size(), 2U);
+    BOOST_CHECK_EQUAL(FindPledgeTxs(index, &receiver).count(pledgeTx->GetHash()), 1U);
+    pledgeTxs = FindPledgeTxs(index, &newReceiver);
+    BOOST_CHECK_EQUAL(pledgeTxs.size(), 1U);
+    BOOST_CHECK_EQUAL(pledgeTxs.count(retargetTx->GetHash()), 1U);
+    CAccountID nullAccountID;
+    BOOST_CHECK(FindPledgeTxs(index, &nullAccountID).empty());
+
+    // Rewinding the withdraw makes the retarget available again
+    BOOST_CHECK(index.EraseAboveHeight(nHeight + 1));
+    pledgeTxs = FindPledgeTxs(index, nullptr);
+    BOOST_CHECK_EQUAL(pledgeTxs.size(), 2U);
+    BOOST_CHECK(pledgeTxs.at(retargetTx->GetHash()).fAvailable);
+    BOOST_CHECK(!pledgeTxs.at(pledgeTx->GetHash()).fAvailable);
+
+    // Rewinding the retarget erases it and makes the pledge available again
+    BOOST_CHECK(index.EraseAboveHeight(nHeight));
+    pledgeTxs = FindPledgeTxs(index, nullptr);
+    BOOST_CHECK_EQUAL(pledgeTxs.size(), 1U);
+    BOOST_CHECK(pledgeTxs.at(pledgeTx->GetHash()).fAvailable);
+    BOOST_CHECK(FindPledgeTxs(index, &newReceiver).empty());
+    BOOST_CHECK_EQUAL(FindPledgeTxs(index, &sender).size(), 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
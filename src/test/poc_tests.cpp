@@ -0,0 +1,256 @@
+// Copyright (c) 2017-2023 The DePINC Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <chainparams.h>
+#include <chiapos/post.h>
+#include <crypto/shabal256.h>
+#include <poc/poc.h>
+#include <primitives/block.h>
+#include <test/setup_common.h>
+#include <util/memory.h>
+
+#include <memory>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(poc_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(poc_deadlines_of_different_blocks)
+{
+    // The regtest deadlines are not hashed
+    const std::unique_ptr<const CChainParams> chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+
+    // Three previous blocks, the lanes of a batch are mined on different blocks
+    std::vector<CBlockIndex> vPrevBlockIndexes(3);
+    for (std::size_t i = 0; i < vPrevBlockIndexes.size(); i++) {
+        CBlockIndex& prevBlockIndex = vPrevBlockIndexes[i];
+        prevBlockIndex.nHeight = params.BHDIP007Height + (int) i;
+        prevBlockIndex.nBaseTarget = poc::GetBaseTarget(prevBlockIndex.nHeight, params) + i;
+        prevBlockIndex.nextGenerationSignature = InsecureRand256();
+    }
+
+    // A full batch and the remaining lanes
+    std::vector<poc::PlotterNonce> nonces;
+    std::vector<uint64_t> expected;
+    CBlockHeader block;
+    for (std::size_t n = 0; n < poc::MAX_BATCH_NONCES + 2; n++) {
+        const CBlockIndex& prevBlockIndex = vPrevBlockIndexes[n % vPrevBlockIndexes.size()];
+        block.nPlotterId = 1234567890 + n % 2;
+        block.nNonce = InsecureRand32();
+        nonces.push_back(poc::MakePlotterNonce(prevBlockIndex, block));
+        expected.push_back(poc::CalculateDeadline(prevBlockIndex, block, params));
+    }
+    BOOST_CHECK(poc::CalculateDeadlines(Span<const poc::PlotterNonce>(nonces.data(), nonces.size()), params) == expected);
+}
+
+namespace {
+
+struct DeadlineVector {
+    int nHeight;
+    const char* generationSignature;
+    uint64_t nPlotterId;
+    uint64_t nNonce;
+    uint64_t nDeadline;
+};
+
+//! Deadlines of the scalar calculation before the plots were hashed in parallel lanes, the base target is 1
+const DeadlineVector deadlineVectors[] = {
+    {530661, "a7ed03accec63ec2be37c56eeb295e4ea77613574099744d74cd0911686cd4ef", 7206345490674453511ull, 2905769952259708810ull, 3245005845709335815ull},
+    {748798, "21beac960fdc5d214069e6742bdc5d1b79140328233f731caebe5c576a8eb8f5", 14288796302410930796ull, 3647355481ull, 17811843369959614646ull},
+    {246123, "2cfc73f99191ae7e0397ea5fdd70946299796cb2c1c359134ae437cdf72ec92e", 54739705253751189ull, 2250073598ull, 5160114469644348688ull},
+    {333372, "c708a05f49ca13b38ef88dea2d73ffbf37c6a8ab1f3cb3c14971be3406029286", 10181832950146322002ull, 5251157867003540409ull, 6416814002358926711ull},
+    {161217, "73d46432abc5ff1783adeb74c1de719d930f1c93bb1d8a4c2b3d858dc81eca1c", 11180315683247700915ull, 879522112ull, 11353461697139204342ull},
+    {233098, "7d92555f69d94308376f29bd2452e62c9b35e2fb0c77e14eda156ff26fea6be0", 8961726372162795528ull, 3893105413ull, 4865873030772929936ull},
+    {633959, "00ac1642749ec70d2664a2566eb855fcaa9d11fa51527031e9839f3be2249f84", 9237360160666605025ull, 16458439554294921436ull, 16326701981727938152ull},
+    {602984, "7b08ed3f70d1f704b47fb06100151cf0f2d3e81db1e8314b8e5776c64bcde34c", 2907069978233897230ull, 2502056116ull, 7581792503227107973ull},
+    {844509, "0d1e834e1bff23bbdbe72c74f3b5446eb864e1eeb1458fb980298c5dcff3968e", 2974944882805944223ull, 191623485ull, 1618450031769838974ull},
+    {213078, "6cfb348c5cec7e39b96681c3f56cf2d8213946ef3918cdd25f1a3455e35cbd6e", 10964685958667175652ull, 4872150755851752291ull, 17827990301640167763ull},
+    {403107, "b33ffb2e2d91033cd66c8e7c85de797494858d1d0e5e83439603b34f2195a222", 13565934077018031213ull, 105812748ull, 17576057684266576684ull},
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(poc_deadlines_known_answers)
+{
+    const std::unique_ptr<const CChainParams> chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+
+    std::vector<poc::PlotterNonce> nonces;
+    for (const DeadlineVector& deadlineVector : deadlineVectors) {
+        BOOST_REQUIRE(deadlineVector.nHeight >= params.BHDIP006Height);
+        poc::PlotterNonce nonce;
+        nonce.nPlotterId = deadlineVector.nPlotterId;
+        nonce.nNonce = deadlineVector.nNonce;
+        nonce.nHeight = deadlineVector.nHeight;
+        nonce.generationSignature = uint256S(deadlineVector.generationSignature);
+        nonce.nBaseTarget = 1;
+        nonces.push_back(nonce);
+    }
+
+    // Every run of the vectors, the full lanes, the lanes filled with the last message and the messages
+    // hashed one by one are all taken whatever lanes this CPU has
+    BOOST_TEST_MESSAGE("Shabal256 lanes: " << Shabal256BatchLanes());
+    for (std::size_t count = 1; count <= nonces.size(); count++) {
+        for (std::size_t start = 0; start + count <= nonces.size(); start++) {
+            const std::vector<uint64_t> deadlines = poc::CalculateDeadlines(Span<const poc::PlotterNonce>(nonces.data() + start, count), params);
+            for (std::size_t n = 0; n < count; n++) {
+                BOOST_CHECK_EQUAL(deadlines[n], deadlineVectors[start + n].nDeadline);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(poc_next_generation_signature)
+{
+    const std::unique_ptr<const CChainParams> chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+
+    CBlockIndex prevBlockIndex;
+    prevBlockIndex.nHeight = params.BHDIP007Height;
+    prevBlockIndex.nextGenerationSignature = InsecureRand256();
+
+    // The generation signatures of a run of headers are chained without their block index
+    CBlockIndex blockIndex;
+    blockIndex.pprev = &prevBlockIndex;
+    blockIndex.nHeight = prevBlockIndex.nHeight + 1;
+    blockIndex.hashMerkleRoot = InsecureRand256();
+    blockIndex.nPlotterId = 1234567890;
+    blockIndex.Update(params);
+    BOOST_CHECK(!blockIndex.GetNextGenerationSignature().IsNull());
+    BOOST_CHECK(blockIndex.GetNextGenerationSignature() == poc::CalculateNextGenerationSignature(blockIndex.nHeight, prevBlockIndex.GetNextGenerationSignature(),
+                                                                                                 blockIndex.hashMerkleRoot, blockIndex.nPlotterId, params));
+
+    // None after the blocks of burst
+    BOOST_CHECK(poc::CalculateNextGenerationSignature(params.BHDIP009Height - 1, InsecureRand256(), InsecureRand256(), 1234567890, params).IsNull());
+}
+
+//! The evaluation before the window sums were stored on the block index
+static uint64_t GetDifficultyForNextIterationsByWalk(const CBlockIndex* pindex, const Consensus::Params& params)
+{
+    if (pindex->nHeight + 1 == params.BHDIP009Height) {
+        return params.BHDIP009StartDifficulty;
+    }
+    arith_uint256 totalDifficulty{0};
+    int nCount = params.BHDIP009DifficultyEvalWindow;
+    while (nCount > 0 && pindex != nullptr && pindex->nHeight >= params.BHDIP009Height) {
+        totalDifficulty += chiapos::GetChiaBlockDifficulty(pindex, params);
+        --nCount;
+        pindex = pindex->pprev;
+    }
+    int nBlocksCalc = params.BHDIP009DifficultyEvalWindow - nCount;
+    if (nBlocksCalc == 0) {
+        return params.BHDIP009StartDifficulty;
+    }
+    return (totalDifficulty / nBlocksCalc).GetLow64();
+}
+
+static arith_uint256 CalculateAverageNetworkSpaceByWalk(const CBlockIndex* pindex, const Consensus::Params& params, int nCountBlocks = 0)
+{
+    int nCount = nCountBlocks > 0 ? nCountBlocks : params.BHDIP009DifficultyEvalWindow;
+    int nActual{0};
+    arith_uint256 result;
+    while (nCount > 0 && pindex->nHeight >= params.BHDIP009Height) {
+        result += chiapos::CalculateNetworkSpace(GetDifficultyForNextIterationsByWalk(pindex->pprev, params),
+                pindex->chiaposFields.GetTotalIters(), params.BHDIP009DifficultyConstantFactorBits);
+        ++nActual;
+        pindex = pindex->pprev;
+        --nCount;
+    }
+    if (nActual == 0) {
+        return 0;
+    }
+    return result / nActual;
+}
+
+//! Append chia blocks of varying difficulties and iterations to pindexPrev, nSeed makes the blocks of a fork different
+static void AppendChiaBlocks(std::vector<std::unique_ptr<CBlockIndex>>& blocks, CBlockIndex* pindexPrev, int nCount, int nSeed, const Consensus::Params& params)
+{
+    for (int i = 0; i < nCount; ++i) {
+        blocks.push_back(MakeUnique<CBlockIndex>());
+        CBlockIndex* pindex = blocks.back().get();
+        pindex->pprev = pindexPrev;
+        pindex->nHeight = pindexPrev ? pindexPrev->nHeight + 1 : 0;
+        pindex->BuildSkip();
+        if (pindex->nHeight >= params.BHDIP009Height) {
+            pindex->chiaposFields.nDifficulty = params.BHDIP009StartDifficulty + (pindex->nHeight * nSeed) % 7 * 1000;
+            pindex->chiaposFields.nVdfIters = 1000000 + (pindex->nHeight + nSeed) % 11 * 10000;
+            pindex->chiaposFields.nVdfDuration = 30;
+        }
+        pindex->Update(params);
+        pindexPrev = pindex;
+    }
+}
+
+static void CheckChiaWindowSums(const CBlockIndex* pindex, const Consensus::Params& params)
+{
+    BOOST_CHECK_EQUAL(chiapos::GetDifficultyForNextIterations(pindex, params), GetDifficultyForNextIterationsByWalk(pindex, params));
+    BOOST_CHECK(poc::CalculateAverageNetworkSpace(pindex, params) == CalculateAverageNetworkSpaceByWalk(pindex, params));
+    // The counts other than the window walk the blocks
+    BOOST_CHECK(poc::CalculateAverageNetworkSpace(pindex, params, 10) == CalculateAverageNetworkSpaceByWalk(pindex, params, 10));
+
+    // The sums of the block index are the sums of the blocks in the window
+    arith_uint256 nDifficultySum, nNetspaceSum;
+    const CBlockIndex* pindexWalk = pindex;
+    for (int i = 0; i < params.BHDIP009DifficultyEvalWindow && pindexWalk->nHeight >= params.BHDIP009Height; ++i) {
+        nDifficultySum += chiapos::GetChiaBlockDifficulty(pindexWalk, params);
+        nNetspaceSum += chiapos::GetChiaBlockNetworkSpace(pindexWalk, params);
+        pindexWalk = pindexWalk->pprev;
+    }
+    BOOST_CHECK(pindex->nChiaDifficultySum == nDifficultySum);
+    BOOST_CHECK(pindex->nChiaNetspaceSum == nNetspaceSum);
+}
+
+BOOST_AUTO_TEST_CASE(poc_chia_window_sums)
+{
+    Consensus::Params params = CreateChainParams(CBaseChainParams::MAIN)->GetConsensus();
+    params.BHDIP009Height = 100;
+    const int nWindow = params.BHDIP009DifficultyEvalWindow;
+    BOOST_REQUIRE(nWindow > 20);
+
+    std::vector<std::unique_ptr<CBlockIndex>> blocks;
+    AppendChiaBlocks(blocks, nullptr, params.BHDIP009Height + 3 * nWindow, 1, params);
+    auto GetBlock = [&](int nHeight) { return blocks[nHeight].get(); };
+
+    // Before and right at BHDIP009Height
+    BOOST_CHECK_EQUAL(chiapos::GetDifficultyForNextIterations(GetBlock(params.BHDIP009Height - 1), params), params.BHDIP009StartDifficulty);
+    BOOST_CHECK(GetBlock(params.BHDIP009Height - 1)->nChiaDifficultySum == 0);
+    BOOST_CHECK(poc::CalculateAverageNetworkSpace(GetBlock(params.BHDIP009Height - 1), params) == 0);
+    CheckChiaWindowSums(GetBlock(params.BHDIP009Height - 1), params);
+    CheckChiaWindowSums(GetBlock(params.BHDIP009Height), params);
+    BOOST_CHECK(GetBlock(params.BHDIP009Height)->nChiaDifficultySum == params.BHDIP009StartDifficulty);
+    // Inside a partial window
+    CheckChiaWindowSums(GetBlock(params.BHDIP009Height + 1), params);
+    CheckChiaWindowSums(GetBlock(params.BHDIP009Height + nWindow / 2), params);
+    // Exactly at the window size, and when the first block leaves the window
+    CheckChiaWindowSums(GetBlock(params.BHDIP009Height + nWindow - 1), params);
+    CheckChiaWindowSums(GetBlock(params.BHDIP009Height + nWindow), params);
+    CheckChiaWindowSums(GetBlock(params.BHDIP009Height + nWindow + 1), params);
+    for (std::size_t nHeight = params.BHDIP009Height - 2; nHeight < blocks.size(); ++nHeight) {
+        CheckChiaWindowSums(GetBlock(nHeight), params);
+    }
+
+    // On a fork the sums follow pprev, the blocks of the main chain are not changed
+    CBlockIndex* pindexMainTip = blocks.back().get();
+    const arith_uint256 nMainDifficultySum = pindexMainTip->nChiaDifficultySum;
+    const arith_uint256 nMainNetspaceSum = pindexMainTip->nChiaNetspaceSum;
+    CBlockIndex* pindexFork = GetBlock(params.BHDIP009Height + nWindow + nWindow / 2);
+    std::size_t nForkBegin = blocks.size();
+    AppendChiaBlocks(blocks, pindexFork, nWindow + 5, 3, params);
+    const CBlockIndex* pindexForkTip = blocks.back().get();
+    BOOST_CHECK(pindexForkTip->nHeight > pindexMainTip->nHeight);
+    for (std::size_t n = nForkBegin; n < blocks.size(); ++n) {
+        CheckChiaWindowSums(blocks[n].get(), params);
+    }
+    const CBlockIndex* pindexForkSameHeight = pindexForkTip->GetAncestor(pindexMainTip->nHeight);
+    BOOST_CHECK(pindexForkSameHeight != pindexMainTip);
+    BOOST_CHECK(pindexForkSameHeight->nChiaDifficultySum != pindexMainTip->nChiaDifficultySum);
+    BOOST_CHECK(pindexMainTip->nChiaDifficultySum == nMainDifficultySum);
+    BOOST_CHECK(pindexMainTip->nChiaNetspaceSum == nMainNetspaceSum);
+    CheckChiaWindowSums(pindexMainTip, params);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
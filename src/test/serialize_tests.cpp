@@ -2,6 +2,8 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <chain.h>
+#include <clientversion.h>
 #include <serialize.h>
 #include <streams.h>
 #include <hash.h>
@@ -379,4 +381,138 @@ BOOST_AUTO_TEST_CASE(class_methods)
     BOOST_CHECK(methodtest3 == methodtest4);
 }
 
+
+BOOST_AUTO_TEST_CASE(block_index_chiapos_fields_record)
+{
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.nTime = 1600000000;
+    header.chiaposFields.nDifficulty = 12345;
+    header.chiaposFields.posProof.challenge = InsecureRand256();
+    header.chiaposFields.posProof.nPlotK = 32;
+    header.chiaposFields.posProof.vchProof = chiapos::Bytes(256, 0x5a);
+    header.chiaposFields.vdfProof.vchY = chiapos::Bytes(100, 0x11);
+    header.chiaposFields.vdfProof.vchProof = chiapos::Bytes(100, 0x22);
+    header.chiaposFields.vdfProof.nVdfIters = 1000000;
+    header.chiaposFields.vdfProof.nVdfDuration = 300;
+    header.chiaposFields.vchFarmerSignature = chiapos::Bytes(96, 0x33);
+
+    CBlockIndex index(header);
+    index.nHeight = 100;
+    CDataStream ssWritten(SER_DISK, CLIENT_VERSION);
+    ssWritten << CDiskBlockIndex(&index, true);
+
+    // The released fields are copied from the written record and the status is updated
+    index.pchiaposFields.reset();
+    index.nStatus |= BLOCK_FAILED_VALID;
+    CDiskBlockIndex diskindex;
+    diskindex.fChiaposFieldsRecord = true;
+    CDataStream ssRead(ssWritten);
+    ssRead >> diskindex;
+    BOOST_CHECK(diskindex.fChiapos);
+    CDiskBlockIndex rewritten(&index, true);
+    BOOST_CHECK(rewritten.fChiaposFieldsRecord);
+    rewritten.vchChiaposFieldsRecord = std::move(diskindex.vchChiaposFieldsRecord);
+    CDataStream ssRewritten(SER_DISK, CLIENT_VERSION);
+    ssRewritten << rewritten;
+
+    CDiskBlockIndex decoded;
+    ssRewritten >> decoded;
+    BOOST_CHECK(decoded.nStatus & BLOCK_FAILED_VALID);
+    BOOST_CHECK(decoded.GetBlockHash() == header.GetHash());
+    BOOST_CHECK(decoded.fullChiaposFields.vdfProof.vchProof == header.chiaposFields.vdfProof.vchProof);
+    BOOST_CHECK(decoded.fullChiaposFields.vchFarmerSignature == header.chiaposFields.vchFarmerSignature);
+}
+
+
+BOOST_AUTO_TEST_CASE(block_index_generator_record)
+{
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.nTime = 1600000000;
+    header.nBaseTarget = 12345;
+    header.nNonce = 678;
+    header.nPlotterId = 1234567890;
+
+    CBlockIndex index(header);
+    index.nHeight = 100;
+    index.nStatus = BLOCK_VALID_SCRIPTS | BLOCK_HAVE_DATA;
+    index.generatorAccountID = CAccountID(g_insecure_rand_ctx.randbytes(sizeof(CAccountID)));
+    CDataStream ssWritten(SER_DISK, CLIENT_VERSION);
+    ssWritten << CDiskBlockIndex(&index, false);
+
+    // The generator without a public key is appended to the record
+    CDiskBlockIndex decoded;
+    CDataStream(ssWritten) >> decoded;
+    BOOST_CHECK(decoded.fHaveGenerator);
+    BOOST_CHECK(decoded.generatorAccountID == index.generatorAccountID);
+    BOOST_CHECK(decoded.GetBlockHash() == header.GetHash());
+
+    // The record of the former versions is the same without the flag of the version and the appended generator
+    CDataStream ssRecord(ssWritten);
+    int nRecordVersion;
+    ssRecord >> VARINT(nRecordVersion, VarIntMode::NONNEGATIVE_SIGNED);
+    BOOST_CHECK_EQUAL(nRecordVersion, CLIENT_VERSION | SERIALIZE_BLOCK_INDEX_GENERATOR);
+    int nFormerVersion = CLIENT_VERSION;
+    CDataStream ssFormer(SER_DISK, CLIENT_VERSION);
+    ssFormer << VARINT(nFormerVersion, VarIntMode::NONNEGATIVE_SIGNED);
+    ssFormer.write(ssRecord.data(), ssRecord.size() - sizeof(CAccountID));
+    CDiskBlockIndex former;
+    ssFormer >> former;
+    BOOST_CHECK(!former.fHaveGenerator);
+    BOOST_CHECK_EQUAL(former.generatorAccountID.GetUint64(0), index.generatorAccountID.GetUint64(0));
+    BOOST_CHECK(former.generatorAccountID != index.generatorAccountID);
+    BOOST_CHECK(former.GetBlockHash() == header.GetHash());
+
+    // The generator derived from the public key is not appended
+    index.vchPubKey = std::vector<unsigned char>(CPubKey::COMPRESSED_PUBLIC_KEY_SIZE, 0x02);
+    index.vchSignature = std::vector<unsigned char>(CPubKey::SIGNATURE_SIZE, 0x30);
+    index.nStatus |= BLOCK_HAVE_SIGNATURE;
+    CDataStream ssSigned(SER_DISK, CLIENT_VERSION);
+    ssSigned << CDiskBlockIndex(&index, false);
+    ssSigned >> VARINT(nRecordVersion, VarIntMode::NONNEGATIVE_SIGNED);
+    BOOST_CHECK_EQUAL(nRecordVersion, CLIENT_VERSION);
+}
+
+BOOST_AUTO_TEST_CASE(block_index_chiapos_fields_record_with_generator)
+{
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.nTime = 1600000000;
+    header.chiaposFields.nDifficulty = 12345;
+    header.chiaposFields.posProof.challenge = InsecureRand256();
+    header.chiaposFields.posProof.nPlotK = 32;
+    header.chiaposFields.posProof.vchProof = chiapos::Bytes(256, 0x5a);
+    header.chiaposFields.vdfProof.vchY = chiapos::Bytes(100, 0x11);
+    header.chiaposFields.vdfProof.vchProof = chiapos::Bytes(100, 0x22);
+    header.chiaposFields.vdfProof.nVdfIters = 1000000;
+    header.chiaposFields.vdfProof.nVdfDuration = 300;
+    header.chiaposFields.vchFarmerSignature = chiapos::Bytes(96, 0x33);
+
+    CBlockIndex index(header);
+    index.nHeight = 100;
+    index.nStatus = BLOCK_VALID_SCRIPTS | BLOCK_HAVE_DATA;
+    index.generatorAccountID = CAccountID(g_insecure_rand_ctx.randbytes(sizeof(CAccountID)));
+    CDataStream ssWritten(SER_DISK, CLIENT_VERSION);
+    ssWritten << CDiskBlockIndex(&index, true);
+
+    // The raw chia fields are copied without the generator appended after them
+    index.pchiaposFields.reset();
+    CDiskBlockIndex diskindex;
+    diskindex.fChiaposFieldsRecord = true;
+    CDataStream(ssWritten) >> diskindex;
+    BOOST_CHECK(diskindex.fHaveGenerator);
+    CDiskBlockIndex rewritten(&index, true);
+    rewritten.vchChiaposFieldsRecord = std::move(diskindex.vchChiaposFieldsRecord);
+    CDataStream ssRewritten(SER_DISK, CLIENT_VERSION);
+    ssRewritten << rewritten;
+    BOOST_CHECK(ssRewritten.str() == ssWritten.str());
+
+    CDiskBlockIndex decoded;
+    ssRewritten >> decoded;
+    BOOST_CHECK(decoded.fHaveGenerator);
+    BOOST_CHECK(decoded.generatorAccountID == index.generatorAccountID);
+    BOOST_CHECK(decoded.GetBlockHash() == header.GetHash());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
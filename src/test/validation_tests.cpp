@@ -2,13 +2,21 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <chain.h>
 #include <chainparams.h>
+#include <hash.h>
 #include <net.h>
+#include <txdb.h>
+#include <util/memory.h>
 #include <validation.h>
 #include <subsidy_utils.h>
 
 #include <test/setup_common.h>
 
+#include <limits>
+#include <map>
+#include <memory>
+
 #include <boost/signals2/signal.hpp>
 #include <boost/test/unit_test.hpp>
 
@@ -59,6 +67,317 @@ BOOST_AUTO_TEST_CASE(subsidy_limit_test)
     BOOST_CHECK_EQUAL(nSum, CAmount{2099999997690000});
 }
 
+static void TestTotalSupplyBeforeHeight(const Consensus::Params& consensusParams)
+{
+    // Compare with the sum of every block subsidy until the subsidy becomes zero after all upgrades
+    const int nFullCheckHeight = consensusParams.BHDIP009Height + consensusParams.nSubsidyHalvingInterval * 600 / consensusParams.BHDIP008TargetSpacing * 2;
+    CAmount nSum = 0;
+    CAmount nPrevSubsidy = -1;
+    for (int nHeight = 0; ; ++nHeight) {
+        CAmount nSubsidy = GetBlockSubsidy(nHeight, consensusParams);
+        if (nHeight < nFullCheckHeight || nSubsidy != nPrevSubsidy || nHeight % 997 == 0) {
+            // Checked without BOOST_CHECK_EQUAL on success, it's too slow for millions of heights
+            if (GetTotalSupplyBeforeHeight(nHeight, consensusParams) != nSum || GetTotalSupplyBeforeHeight(nHeight + 1, consensusParams) != nSum + nSubsidy) {
+                BOOST_ERROR("total supply mismatch at height " << nHeight);
+                break;
+            }
+        }
+        if (nSubsidy == 0 && nHeight >= nFullCheckHeight)
+            break;
+        nSum += nSubsidy;
+        nPrevSubsidy = nSubsidy;
+    }
+    BOOST_CHECK_EQUAL(GetTotalSupplyBeforeBHDIP009(consensusParams), GetTotalSupplyBeforeHeight(consensusParams.BHDIP009Height, consensusParams));
+}
+
+BOOST_AUTO_TEST_CASE(total_supply_test)
+{
+    LOCK(cs_main);
+    TestTotalSupplyBeforeHeight(CreateChainParams(CBaseChainParams::MAIN)->GetConsensus());
+    TestTotalSupplyBeforeHeight(CreateChainParams(CBaseChainParams::TESTNET)->GetConsensus());
+}
+
+//! The accumulated subsidy as calculated by walking back the whole chain
+static CAmount GetBlockAccumulateSubsidyByWalk(const CBlockIndex* pindexPrev, const Consensus::Params& consensusParams)
+{
+    CAmount accumulate = 0;
+    for (const CBlockIndex* pindex = pindexPrev; (pindex != nullptr) && (pindex->nStatus & BLOCK_UNCONDITIONAL) && (pindex->nHeight >= consensusParams.BHDIP008Height); pindex = pindex->pprev) {
+        if (pindex->nHeight < consensusParams.BHDIP009Height) {
+            int nPeriod = (pindex->nHeight - consensusParams.BHDIP008Height) / consensusParams.BHDIP008FundRoyaltyDecreasePeriodForLowMortgage;
+            int fundRatio = consensusParams.BHDIP008FundRoyaltyForLowMortgage - consensusParams.BHDIP008FundRoyaltyDecreaseForLowMortgage * nPeriod;
+            if (fundRatio < consensusParams.BHDIP001FundRoyaltyForFullMortgage)
+                fundRatio = consensusParams.BHDIP001FundRoyaltyForFullMortgage;
+            accumulate += (GetBlockSubsidy(pindex->nHeight, consensusParams) * (consensusParams.BHDIP001FundRoyaltyForLowMortgage - fundRatio)) / 1000;
+        } else {
+            accumulate += (GetBlockSubsidy(pindex->nHeight, consensusParams) * (1000 - consensusParams.BHDIP009FundRoyaltyForLowMortgage)) / 1000;
+        }
+    }
+    return accumulate;
+}
+
+BOOST_AUTO_TEST_CASE(block_accumulate_subsidy_test)
+{
+    LOCK(cs_main);
+    // Main consensus with upgrades moved to low heights
+    Consensus::Params consensusParams = CreateChainParams(CBaseChainParams::MAIN)->GetConsensus();
+    consensusParams.BHDIP008Height = 1000;
+    consensusParams.BHDIP009Height = 3000;
+
+    // A chain crossing BHDIP008 and BHDIP009, some blocks are conditional and the tail is not connected
+    const int nChainHeight = 5000;
+    const int nConnectedHeight = nChainHeight - 100;
+    std::vector<CBlockIndex> blocks(nChainHeight + 1);
+    for (int nHeight = 0; nHeight <= nChainHeight; nHeight++) {
+        CBlockIndex& block = blocks[nHeight];
+        block.nHeight = nHeight;
+        block.pprev = nHeight > 0 ? &blocks[nHeight - 1] : nullptr;
+        if (nHeight <= nConnectedHeight)
+            block.nStatus |= BLOCK_VALID_SCRIPTS;
+        if (nHeight >= consensusParams.BHDIP008Height && InsecureRandRange(500) != 0)
+            block.nStatus |= BLOCK_UNCONDITIONAL;
+    }
+
+    for (int i = 0; i < 10000; i++) {
+        const CBlockIndex* pindex = &blocks[InsecureRandRange(nChainHeight + 1)];
+        BOOST_CHECK_EQUAL(GetBlockAccumulateSubsidy(pindex, consensusParams), GetBlockAccumulateSubsidyByWalk(pindex, consensusParams));
+    }
+    for (int nHeight = nConnectedHeight - 1000; nHeight <= nChainHeight; nHeight++) {
+        BOOST_CHECK_EQUAL(GetBlockAccumulateSubsidy(&blocks[nHeight], consensusParams), GetBlockAccumulateSubsidyByWalk(&blocks[nHeight], consensusParams));
+    }
+
+    // Connecting the tail sets its flags
+    for (int nHeight = nConnectedHeight + 1; nHeight <= nChainHeight; nHeight++) {
+        blocks[nHeight].nStatus |= BLOCK_VALID_SCRIPTS | BLOCK_UNCONDITIONAL;
+        blocks[nHeight].nAccumulateSubsidy = -1;
+    }
+    BOOST_CHECK_EQUAL(GetBlockAccumulateSubsidy(&blocks[nChainHeight], consensusParams), GetBlockAccumulateSubsidyByWalk(&blocks[nChainHeight], consensusParams));
+}
+
+static chiapos::CBlockFields MakeMemoTestFields(uint8_t nSeed)
+{
+    chiapos::CBlockFields fields;
+    fields.posProof.challenge = uint256S(strprintf("%02x", nSeed));
+    fields.posProof.vchProof.assign(64, nSeed);
+    fields.vdfProof.challenge = fields.posProof.challenge;
+    fields.vdfProof.nVdfIters = 1000 + nSeed;
+    return fields;
+}
+
+BOOST_AUTO_TEST_CASE(verified_header_proofs_memo)
+{
+    // Forget the entries of the other tests
+    PruneVerifiedHeaderProofs(std::numeric_limits<int>::max());
+
+    const chiapos::CBlockFields fields1 = MakeMemoTestFields(1);
+    const chiapos::CBlockFields fields2 = MakeMemoTestFields(2);
+    const uint256 quality1 = uint256S("0101");
+    const uint256 quality2 = uint256S("0202");
+    uint256 mixedQualityString;
+
+    BOOST_CHECK(!FindVerifiedHeaderProof(fields1, 100, mixedQualityString));
+    MemoizeVerifiedHeaderProof(fields1, 100, quality1);
+    MemoizeVerifiedHeaderProof(fields2, 101, quality2);
+
+    // Found by the hash of the proofs and the height
+    BOOST_CHECK(FindVerifiedHeaderProof(fields1, 100, mixedQualityString));
+    BOOST_CHECK(mixedQualityString == quality1);
+    BOOST_CHECK(FindVerifiedHeaderProof(fields2, 101, mixedQualityString));
+    BOOST_CHECK(mixedQualityString == quality2);
+    // The entry is kept after it is found
+    BOOST_CHECK(FindVerifiedHeaderProof(fields1, 100, mixedQualityString));
+
+    // The same proofs at another height are verified again
+    mixedQualityString.SetNull();
+    BOOST_CHECK(!FindVerifiedHeaderProof(fields1, 101, mixedQualityString));
+    BOOST_CHECK(!FindVerifiedHeaderProof(fields1, 99, mixedQualityString));
+    BOOST_CHECK(mixedQualityString.IsNull());
+
+    // The signature isn't a part of the proofs
+    chiapos::CBlockFields fields1Signed = fields1;
+    fields1Signed.vchFarmerSignature.assign(96, 0xaa);
+    BOOST_CHECK(FindVerifiedHeaderProof(fields1Signed, 100, mixedQualityString));
+    // Another proof is a miss
+    chiapos::CBlockFields fields1Changed = fields1;
+    fields1Changed.vdfProof.nVdfIters++;
+    BOOST_CHECK(!FindVerifiedHeaderProof(fields1Changed, 100, mixedQualityString));
+
+    // The entries below the run height are dropped, the ones at the height are kept
+    PruneVerifiedHeaderProofs(101);
+    BOOST_CHECK(!FindVerifiedHeaderProof(fields1, 100, mixedQualityString));
+    BOOST_CHECK(FindVerifiedHeaderProof(fields2, 101, mixedQualityString));
+    BOOST_CHECK(mixedQualityString == quality2);
+    PruneVerifiedHeaderProofs(102);
+    BOOST_CHECK(!FindVerifiedHeaderProof(fields2, 101, mixedQualityString));
+}
+
+BOOST_AUTO_TEST_CASE(chiapos_fields_released_and_read_back)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = 1700000000;
+    header.chiaposFields = MakeMemoTestFields(3);
+    header.chiaposFields.nDifficulty = 1000;
+    header.chiaposFields.posProof.vchPoolPkOrHash.assign(32, 0x11);
+    header.chiaposFields.posProof.vchLocalPk.assign(48, 0x22);
+    header.chiaposFields.posProof.vchFarmerPk.assign(48, 0x33);
+    header.chiaposFields.posProof.nPlotK = 32;
+    header.chiaposFields.vdfProof.vchY.assign(100, 0x44);
+    header.chiaposFields.vdfProof.vchProof.assign(100, 0x55);
+    header.chiaposFields.vdfProof.nVdfDuration = 30;
+    header.chiaposFields.vchFarmerSignature.assign(96, 0x66);
+    const uint256 hash = header.GetHash();
+    const uint256 hashFields = SerializeHash(header.chiaposFields);
+
+    CBlockIndex index(header);
+    index.phashBlock = &hash;
+    index.nHeight = params.BHDIP009Height;
+    BOOST_REQUIRE(index.IsChiaBlock());
+    BOOST_REQUIRE(index.pchiaposFields);
+    const BlockIndexMemoryStats statsBefore = GetBlockIndexMemoryStats();
+
+    // Flushed with the fields in memory, then released
+    BOOST_REQUIRE(pblocktree->WriteBatchSync({}, 0, {&index}, params));
+    ReleaseBlockChiaposFields(&index);
+    BOOST_CHECK(!index.pchiaposFields);
+    BlockIndexMemoryStats stats = GetBlockIndexMemoryStats();
+    BOOST_CHECK(stats.nChiaposFieldsSaved > statsBefore.nChiaposFieldsSaved);
+    // The consensus fields are still in memory
+    BOOST_CHECK_EQUAL(index.chiaposFields.nDifficulty, 1000U);
+    BOOST_CHECK(index.chiaposFields.vchFarmerPk == header.chiaposFields.posProof.vchFarmerPk);
+
+    // Read back from the database by the first call, from the cache by the next one
+    std::shared_ptr<const chiapos::CBlockFields> pfields = index.GetChiaposFields();
+    BOOST_REQUIRE(pfields);
+    BOOST_CHECK(SerializeHash(*pfields) == hashFields);
+    stats = GetBlockIndexMemoryStats();
+    BOOST_CHECK_EQUAL(stats.nCacheMisses, statsBefore.nCacheMisses + 1);
+    BOOST_CHECK_EQUAL(stats.nCacheHits, statsBefore.nCacheHits);
+    BOOST_CHECK(stats.nCacheEntries >= 1);
+    BOOST_CHECK(index.GetChiaposFields() == pfields);
+    BOOST_CHECK(ReadBlockChiaposFields(hash) == pfields);
+    stats = GetBlockIndexMemoryStats();
+    BOOST_CHECK_EQUAL(stats.nCacheMisses, statsBefore.nCacheMisses + 1);
+    BOOST_CHECK_EQUAL(stats.nCacheHits, statsBefore.nCacheHits + 2);
+    BOOST_CHECK(index.GetBlockHeader().GetHash() == hash);
+
+    // Dirtied again after the release, the fields are copied from the record on disk
+    index.nStatus |= BLOCK_FAILED_VALID;
+    BOOST_REQUIRE(pblocktree->WriteBatchSync({}, 0, {&index}, params));
+    CDiskBlockIndex diskindex;
+    BOOST_REQUIRE(pblocktree->ReadBlockIndex(hash, diskindex));
+    BOOST_CHECK(diskindex.nStatus & BLOCK_FAILED_VALID);
+    BOOST_CHECK(SerializeHash(diskindex.fullChiaposFields) == hashFields);
+    BOOST_CHECK(diskindex.GetBlockHash() == hash);
+
+    // The fields of a block which isn't in the database are missing
+    BOOST_CHECK(ReadBlockChiaposFields(InsecureRand256()) == nullptr);
+    CBlockHeader headerUnknown = header;
+    headerUnknown.nTime++;
+    const uint256 hashUnknown = headerUnknown.GetHash();
+    CBlockIndex indexUnknown(headerUnknown);
+    indexUnknown.phashBlock = &hashUnknown;
+    indexUnknown.nHeight = params.BHDIP009Height;
+    ReleaseBlockChiaposFields(&indexUnknown);
+    BOOST_CHECK_THROW(indexUnknown.GetChiaposFields(), std::runtime_error);
+    // A dirty index whose record is missing isn't written
+    BOOST_CHECK(!pblocktree->WriteBatchSync({}, 0, {&indexUnknown}, params));
+}
+
+namespace {
+
+//! The bytes of a record written as they are
+struct RawRecord {
+    std::vector<char> vch;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const { s.write(vch.data(), vch.size()); }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(block_index_load_generators)
+{
+    const std::unique_ptr<const CChainParams> chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    CBlockTreeDB db(1 << 20, true, true);
+
+    // The generators of half of the records are not derived from a public key
+    const int nCount = 2000;
+    std::vector<CBlockIndex> vIndexes(nCount);
+    std::vector<uint256> vHashes(nCount);
+    std::vector<const CBlockIndex*> vBlockInfo;
+    for (int i = 0; i < nCount; i++) {
+        CBlockIndex& index = vIndexes[i];
+        index.pprev = i > 0 ? &vIndexes[i - 1] : nullptr;
+        index.nHeight = i + 1;
+        index.nStatus = BLOCK_VALID_SCRIPTS | BLOCK_HAVE_DATA;
+        index.nDataPos = i + 1;
+        index.nTx = 1;
+        index.nTime = 1531292789 + i * 300;
+        index.nBaseTarget = 12345;
+        index.nNonce = i;
+        index.nPlotterId = 1234567890;
+        index.generatorAccountID = CAccountID(g_insecure_rand_ctx.randbytes(sizeof(CAccountID)));
+        if (i % 2) {
+            index.nStatus |= BLOCK_HAVE_SIGNATURE;
+            index.vchPubKey.assign(CPubKey::COMPRESSED_PUBLIC_KEY_SIZE, 0x02);
+            index.vchSignature.assign(CPubKey::SIGNATURE_SIZE, 0x30);
+        }
+        vHashes[i] = index.GetBlockHeader().GetHash();
+        index.phashBlock = &vHashes[i];
+        vBlockInfo.push_back(&index);
+    }
+    BOOST_REQUIRE(db.WriteBatchSync({}, 0, vBlockInfo, params));
+
+    // Some records are written again the way the former versions write them, only their 'g' records have the full generators
+    std::vector<int> vFormer;
+    for (int i = 0; i < nCount; i += 14) {
+        CDataStream ssRecord(SER_DISK, CLIENT_VERSION);
+        ssRecord << CDiskBlockIndex(&vIndexes[i], false);
+        int nRecordVersion;
+        ssRecord >> VARINT(nRecordVersion, VarIntMode::NONNEGATIVE_SIGNED);
+        BOOST_REQUIRE(nRecordVersion & SERIALIZE_BLOCK_INDEX_GENERATOR);
+        int nFormerVersion = CLIENT_VERSION;
+        CDataStream ssFormer(SER_DISK, CLIENT_VERSION);
+        ssFormer << VARINT(nFormerVersion, VarIntMode::NONNEGATIVE_SIGNED);
+        ssFormer.write(ssRecord.data(), ssRecord.size() - sizeof(CAccountID));
+        BOOST_REQUIRE(db.Write(std::make_pair('b', vHashes[i]), RawRecord{std::vector<char>(ssFormer.begin(), ssFormer.end())}));
+        CDiskBlockIndex diskindex;
+        BOOST_REQUIRE(db.ReadBlockIndex(vHashes[i], diskindex));
+        BOOST_REQUIRE(!diskindex.fHaveGenerator);
+        vFormer.push_back(i);
+    }
+
+    for (int nLoad = 0; nLoad < 2; nLoad++) {
+        std::map<uint256, std::unique_ptr<CBlockIndex>> mapIndexes;
+        BOOST_REQUIRE(db.LoadBlockIndexGuts(params, [&mapIndexes](const uint256& hash) -> CBlockIndex* {
+            if (hash.IsNull())
+                return nullptr;
+            std::unique_ptr<CBlockIndex>& pindex = mapIndexes[hash];
+            if (!pindex)
+                pindex = MakeUnique<CBlockIndex>();
+            return pindex.get();
+        }));
+        BOOST_REQUIRE_EQUAL(mapIndexes.size(), (size_t) nCount);
+        for (int i = 0; i < nCount; i++) {
+            const CBlockIndex* pindex = mapIndexes[vHashes[i]].get();
+            BOOST_CHECK_EQUAL(pindex->nHeight, i + 1);
+            BOOST_CHECK(pindex->pprev == (i > 0 ? mapIndexes[vHashes[i - 1]].get() : nullptr));
+            BOOST_CHECK(pindex->generatorAccountID == vIndexes[i].generatorAccountID);
+        }
+    }
+
+    // The records of the former versions were written again with their generators
+    for (int i : vFormer) {
+        CDiskBlockIndex diskindex;
+        BOOST_REQUIRE(db.ReadBlockIndex(vHashes[i], diskindex));
+        BOOST_CHECK(diskindex.fHaveGenerator);
+        BOOST_CHECK(diskindex.generatorAccountID == vIndexes[i].generatorAccountID);
+    }
+}
+
 static bool ReturnFalse() { return false; }
 static bool ReturnTrue() { return true; }
 
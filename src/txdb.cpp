@@ -6,6 +6,7 @@
 #include <txdb.h>
 
 #include <chainparams.h>
+#include <chiapos/kernel/vdf.h>
 #include <hash.h>
 #include <random.h>
 #include <shutdown.h>
@@ -33,12 +34,23 @@
 
 /** UTXO version flag */
 static const char DB_COIN_VERSION = 'V';
-static const uint32_t DB_VERSION = 0x11;
+static const uint32_t DB_VERSION = 0x15;
+//! The oldest version that can be upgraded without rebuilding all indexes
+static const uint32_t DB_VERSION_INCREMENTAL_BASE = 0x11;
+//! Since this version the point coins are indexed by receiver
+static const uint32_t DB_VERSION_POINT_RECEIVE_INDEX = 0x12;
+//! Since this version the retarget coins are indexed by receiver
+static const uint32_t DB_VERSION_RETARGET_RECEIVE_INDEX = 0x13;
+//! Since this version the running totals of accounts are stored
+static const uint32_t DB_VERSION_ACCOUNT_TOTALS = 0x14;
+//! Since this version the coin index holds the height of coins
+static const uint32_t DB_VERSION_COIN_INDEX_HEIGHT = 0x15;
 
 static const char DB_COIN = 'C';
 static const char DB_BLOCK_FILES = 'f';
 static const char DB_BLOCK_INDEX = 'b';
 static const char DB_BLOCK_GENERATOR_INDEX = 'g';
+static const char DB_BLOCK_CHIA_METRICS = 'M';
 
 static const char DB_BEST_BLOCK = 'B';
 static const char DB_HEAD_BLOCKS = 'H';
@@ -56,6 +68,10 @@ static const char DB_COIN_POINT_CHIA_SEND_TERM_1 = '1';
 static const char DB_COIN_POINT_CHIA_SEND_TERM_2 = '2';
 static const char DB_COIN_POINT_CHIA_SEND_TERM_3 = '3';
 static const char DB_COIN_POINT_CHIA_POINT_RETARGET = 'r';
+static const char DB_COIN_POINT_RECEIVE_INDEX = 'Q';
+static const char DB_COIN_POINT_RETARGET_RECEIVE_INDEX = 'q';
+static const char DB_ACCOUNT_TOTALS = 't';
+static const char DB_ACCOUNT_TOTALS_BLOCK = 'u';
 
 namespace {
 
@@ -105,6 +121,26 @@ struct CoinIndexEntry {
     }
 };
 
+struct CoinIndexValue {
+    CAmount* pAmount;
+    uint32_t* pHeight;
+    CoinIndexValue(const CAmount* pAmountIn, const uint32_t* pHeightIn) :
+        pAmount(const_cast<CAmount*>(pAmountIn)),
+        pHeight(const_cast<uint32_t*>(pHeightIn)) {}
+
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        s << VARINT(*pAmount, VarIntMode::NONNEGATIVE_SIGNED);
+        s << VARINT(*pHeight);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        s >> VARINT(*pAmount, VarIntMode::NONNEGATIVE_SIGNED);
+        s >> VARINT(*pHeight);
+    }
+};
+
 struct BindPlotterEntry {
     COutPoint* outpoint;
     CAccountID* accountID;
@@ -191,6 +227,56 @@ struct PointEntry {
     }
 };
 
+struct PointReceiveEntry {
+    COutPoint* outpoint;
+    CAccountID* accountID; // This is the accountID for receiver
+    char pointKey; // The key of related point send entry
+    char key;
+    PointReceiveEntry(const COutPoint* outpointIn, const CAccountID* accountIDIn, char pointKeyIn) :
+        outpoint(const_cast<COutPoint*>(outpointIn)),
+        accountID(const_cast<CAccountID*>(accountIDIn)),
+        pointKey(pointKeyIn),
+        key(DB_COIN_POINT_RECEIVE_INDEX) {}
+
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        s << key;
+        s << *accountID;
+        s << pointKey;
+        s << outpoint->hash;
+        s << VARINT(outpoint->n);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        s >> key;
+        s >> *accountID;
+        s >> pointKey;
+        s >> outpoint->hash;
+        s >> VARINT(outpoint->n);
+    }
+};
+
+struct PointReceiveValue {
+    CAmount* pAmount;
+    uint32_t* pHeight;
+    PointReceiveValue(const CAmount* pAmountIn, const uint32_t* pHeightIn) :
+        pAmount(const_cast<CAmount*>(pAmountIn)),
+        pHeight(const_cast<uint32_t*>(pHeightIn)) {}
+
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        s << VARINT(*pAmount, VarIntMode::NONNEGATIVE_SIGNED);
+        s << VARINT(*pHeight);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        s >> VARINT(*pAmount, VarIntMode::NONNEGATIVE_SIGNED);
+        s >> VARINT(*pHeight);
+    }
+};
+
 struct PointRetargetEntry {
     COutPoint* outpoint;
     CAccountID* accountID;
@@ -242,6 +328,57 @@ struct PointRetargetValue {
     }
 };
 
+struct PointRetargetReceiveEntry {
+    COutPoint* outpoint;
+    CAccountID* accountID; // This is the accountID for receiver
+    char key;
+    PointRetargetReceiveEntry(const COutPoint* outpointIn, const CAccountID* accountIDIn) :
+        outpoint(const_cast<COutPoint*>(outpointIn)),
+        accountID(const_cast<CAccountID*>(accountIDIn)),
+        key(DB_COIN_POINT_RETARGET_RECEIVE_INDEX) {}
+
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        s << key;
+        s << *accountID;
+        s << outpoint->hash;
+        s << VARINT(outpoint->n);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        s >> key;
+        s >> *accountID;
+        s >> outpoint->hash;
+        s >> VARINT(outpoint->n);
+    }
+};
+
+struct PointRetargetReceiveValue {
+    CAmount* pAmount;
+    DatacarrierType* pPointType;
+    int* pPointHeight;
+
+    PointRetargetReceiveValue(CAmount* pAmountIn, DatacarrierType* pPointTypeIn, int* pPointHeightIn)
+        : pAmount(pAmountIn), pPointType(pPointTypeIn), pPointHeight(pPointHeightIn) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        s << VARINT(*pAmount, VarIntMode::NONNEGATIVE_SIGNED);
+        s << static_cast<uint32_t>(*pPointType);
+        s << *pPointHeight;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        uint32_t nPointType;
+        s >> VARINT(*pAmount, VarIntMode::NONNEGATIVE_SIGNED);
+        s >> nPointType;
+        *pPointType = static_cast<DatacarrierType>(nPointType);
+        s >> *pPointHeight;
+    }
+};
+
 Optional<char> KeyFromDatacarrierType(DatacarrierType type) noexcept {
     if (type == DATACARRIER_TYPE_BINDPLOTTER) {
         return DB_COIN_BINDPLOTTER;
@@ -328,7 +465,7 @@ std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
     return vhashHeadBlocks;
 }
 
-bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
+bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, CAccountTotalsMap &mapTotals, const uint256 &hashBlock) {
     CDBBatch batch(db);
     size_t count = 0;
     size_t changed = 0;
@@ -361,8 +498,10 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
                     batch.Erase(CoinIndexEntry(&it->first, &it->second.coin.refOutAccountID));
             } else {
                 batch.Write(CoinEntry(&it->first), it->second.coin);
-                if (!it->second.coin.refOutAccountID.IsNull())
-                    batch.Write(CoinIndexEntry(&it->first, &it->second.coin.refOutAccountID), VARINT(it->second.coin.out.nValue, VarIntMode::NONNEGATIVE_SIGNED));
+                if (!it->second.coin.refOutAccountID.IsNull()) {
+                    uint32_t nHeight = it->second.coin.nHeight;
+                    batch.Write(CoinIndexEntry(&it->first, &it->second.coin.refOutAccountID), CoinIndexValue(&it->second.coin.out.nValue, &nHeight));
+                }
             }
             changed++;
 
@@ -396,6 +535,9 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
                             throw std::runtime_error(strprintf("%s(%s:%d): cannot parse key from datacarrierType", __func__, __FILE__, __LINE__));
                         }
                         batch.Write(PointEntry(&it->first, &it->second.coin.refOutAccountID, *dbKey), PointPayload::As(it->second.coin.extraData)->GetReceiverID());
+                        CAmount nAmount = it->second.coin.out.nValue;
+                        uint32_t nHeight = it->second.coin.nHeight;
+                        batch.Write(PointReceiveEntry(&it->first, &PointPayload::As(it->second.coin.extraData)->GetReceiverID(), *dbKey), PointReceiveValue(&nAmount, &nHeight));
                     }
                     else if (it->second.coin.IsPointRetarget()) {
                         tryEraseTypes.erase(it->second.coin.GetExtraDataType());
@@ -405,6 +547,8 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
                         int nPointHeight = payload->GetPointHeight();
                         PointRetargetValue value(&receiverID, &pointType, &nPointHeight);
                         batch.Write(PointRetargetEntry(&it->first, &it->second.coin.refOutAccountID), value);
+                        CAmount nAmount = it->second.coin.out.nValue;
+                        batch.Write(PointRetargetReceiveEntry(&it->first, &receiverID), PointRetargetReceiveValue(&nAmount, &pointType, &nPointHeight));
                     }
                 }
 
@@ -427,6 +571,16 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
                         batch.Erase(PointRetargetEntry(&it->first, &it->second.coin.refOutAccountID));
                     }
                 }
+
+                // The receiver index entries can only be located from the payload of the coin
+                if (it->second.coin.IsSpent() && it->second.coin.IsPoint()) {
+                    auto dbKey = KeyFromDatacarrierType(it->second.coin.GetExtraDataType());
+                    if (dbKey.has_value()) {
+                        batch.Erase(PointReceiveEntry(&it->first, &PointPayload::As(it->second.coin.extraData)->GetReceiverID(), *dbKey));
+                    }
+                } else if (it->second.coin.IsSpent() && it->second.coin.IsPointRetarget()) {
+                    batch.Erase(PointRetargetReceiveEntry(&it->first, &PointRetargetPayload::As(it->second.coin.extraData)->GetReceiverID()));
+                }
             }
         }
 
@@ -447,6 +601,20 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
         }
     }
 
+    // Account totals are only written in the last batch, they are recalculated when the batches are interrupted
+    for (const auto& pair : mapTotals) {
+        CAccountTotals totals;
+        db.Read(std::make_pair(DB_ACCOUNT_TOTALS, pair.first), totals);
+        totals.Merge(pair.second);
+        if (totals.IsNull()) {
+            batch.Erase(std::make_pair(DB_ACCOUNT_TOTALS, pair.first));
+        } else {
+            batch.Write(std::make_pair(DB_ACCOUNT_TOTALS, pair.first), totals);
+        }
+    }
+    mapTotals.clear();
+    batch.Write(DB_ACCOUNT_TOTALS_BLOCK, hashBlock);
+
     // In the last batch, mark the database as consistent with hashBlock again.
     batch.Erase(DB_HEAD_BLOCKS);
     batch.Write(DB_BEST_BLOCK, hashBlock);
@@ -609,11 +777,11 @@ CCoinsViewCursorRef CCoinsViewDB::PointReceiveCursor(const CAccountID &accountID
     class CCoinsViewDBPointReceiveCursor : public CCoinsViewCursor
     {
     public:
-        CCoinsViewDBPointReceiveCursor(const CAccountID& accountIDIn, const CCoinsViewDB* pcoinviewdbIn, CDBIterator* pcursorIn, const uint256& hashBlockIn, char keyIn)
-                : CCoinsViewCursor(hashBlockIn), receiverAccountID(accountIDIn), pcoinviewdb(pcoinviewdbIn), pcursor(pcursorIn), outpoint(uint256(), 0), senderAccountID(), key(keyIn) {
-            // Seek cursor to first point coin
-            pcursor->Seek(keyIn);
-            GotoValidEntry();
+        CCoinsViewDBPointReceiveCursor(const CAccountID& accountIDIn, const CCoinsViewDB* pcoinviewdbIn, CDBIterator* pcursorIn, const uint256& hashBlockIn, char pointKeyIn)
+                : CCoinsViewCursor(hashBlockIn), receiverAccountID(accountIDIn), pcoinviewdb(pcoinviewdbIn), pcursor(pcursorIn), outpoint(uint256(), 0), pointKey(pointKeyIn) {
+            // Seek cursor to first point coin of the receiver
+            pcursor->Seek(PointReceiveEntry(&outpoint, &receiverAccountID, pointKey));
+            TestKey();
         }
 
         bool GetKey(COutPoint &key) const override {
@@ -631,21 +799,15 @@ CCoinsViewCursorRef CCoinsViewDB::PointReceiveCursor(const CAccountID &accountID
         bool Valid() const override { return !outpoint.IsNull(); }
         void Next() override {
             pcursor->Next();
-            GotoValidEntry();
+            TestKey();
         }
 
     private:
-        void GotoValidEntry() {
+        void TestKey() {
             CAccountID tempReceiverAccountID;
-            PointEntry entry(&outpoint, &senderAccountID, key);
-            while (true) {
-                if (!pcursor->Valid() || !pcursor->GetKey(entry) || entry.key != key || !pcursor->GetValue(tempReceiverAccountID)) {
-                    outpoint.SetNull();
-                    break;
-                }
-                if (tempReceiverAccountID == receiverAccountID)
-                    break;
-                pcursor->Next();
+            PointReceiveEntry entry(&outpoint, &tempReceiverAccountID, pointKey);
+            if (!pcursor->Valid() || !pcursor->GetKey(entry) || entry.key != DB_COIN_POINT_RECEIVE_INDEX || tempReceiverAccountID != receiverAccountID || entry.pointKey != pointKey) {
+                outpoint.SetNull();
             }
         }
 
@@ -653,8 +815,7 @@ CCoinsViewCursorRef CCoinsViewDB::PointReceiveCursor(const CAccountID &accountID
         const CCoinsViewDB* pcoinviewdb;
         std::unique_ptr<CDBIterator> pcursor;
         COutPoint outpoint;
-        CAccountID senderAccountID;
-        char key;
+        char pointKey;
     };
 
     return std::make_shared<CCoinsViewDBPointReceiveCursor>(accountID, this, db.NewIterator(), GetBestBlock(), KeyFromPointType(pt));
@@ -762,6 +923,13 @@ CBindPlotterCoinsMap CCoinsViewDB::GetAccountBindPlotterEntries(const CAccountID
     }
 }
 
+bool CCoinsViewDB::GetAccountTotals(const CAccountID &accountID, CAccountTotals &totals) const {
+    if (!db.Read(std::make_pair(DB_ACCOUNT_TOTALS, accountID), totals)) {
+        totals = CAccountTotals();
+    }
+    return true;
+}
+
 CBindPlotterCoinsMap CCoinsViewDB::GetBindPlotterEntries(const CPlotterBindData &bindData) const {
     CBindPlotterCoinsMap outpoints;
 
@@ -859,6 +1027,7 @@ CAmount CCoinsViewDB::GetCoinBalance(const CAccountID &accountID, const CCoinsMa
     std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
     CAmount availableBalance = 0;
     CAmount tempAmount = 0;
+    uint32_t tempHeight = 0;
     COutPoint tempOutpoint(uint256(), 0);
     CAccountID tempAccountID = accountID;
     CoinIndexEntry entry(&tempOutpoint, &tempAccountID);
@@ -867,20 +1036,11 @@ CAmount CCoinsViewDB::GetCoinBalance(const CAccountID &accountID, const CCoinsMa
     pcursor->Seek(entry);
     while (pcursor->Valid()) {
         if (pcursor->GetKey(entry) && entry.key == DB_COIN_INDEX && *entry.accountID == accountID) {
-            if (!pcursor->GetValue(REF(VARINT(tempAmount, VarIntMode::NONNEGATIVE_SIGNED))))
+            CoinIndexValue value(&tempAmount, &tempHeight);
+            if (!pcursor->GetValue(value))
                 throw std::runtime_error("Database read error");
-            if (nHeight != 0) {
-                // need to find the height of the coin
-                Coin coin;
-                if (!GetCoin(*entry.outpoint, coin)) {
-                    throw std::runtime_error("Read coin error");
-                }
-                if (coin.nHeight > nHeight) {
-                    pcursor->Next();
-                    continue;
-                }
-            }
-            availableBalance += tempAmount;
+            if (nHeight == 0 || tempHeight <= (uint32_t)nHeight)
+                availableBalance += tempAmount;
         } else {
             break;
         }
@@ -988,31 +1148,27 @@ CAmount CCoinsViewDB::GetBalancePointReceive(DatacarrierType type, CAccountID co
 
     // Read from database
     std::map<COutPoint, CAmount> selected;
-    CAccountID tempDebitAccountID;
-    CAccountID tempAccountID;
+    CAccountID tempAccountID = accountID;
     COutPoint tempOutpoint(uint256(), 0);
-    Coin pointCoin;
+    CAmount tempAmount = 0;
+    uint32_t tempHeight = 0;
 
-    PointEntry entry(&tempOutpoint, &tempAccountID, *key);
+    PointReceiveEntry entry(&tempOutpoint, &tempAccountID, *key);
+    PointReceiveValue value(&tempAmount, &tempHeight);
     pcursor->Seek(entry);
     while (pcursor->Valid()) {
-        if (pcursor->GetKey(entry) && entry.key == *key) {
-            if (!pcursor->GetValue(tempDebitAccountID))
+        if (pcursor->GetKey(entry) && entry.key == DB_COIN_POINT_RECEIVE_INDEX && *entry.accountID == accountID && entry.pointKey == *key) {
+            if (!pcursor->GetValue(value))
                 throw std::runtime_error("Database read error");
-            if (tempDebitAccountID == accountID) {
-                if (!db.Read(CoinEntry(entry.outpoint), pointCoin)) {
-                    throw std::runtime_error("Database read error");
-                }
-                // Calculate the actual amount of the pledge
-                CAmount nActual;
-                if (terms) {
-                    nActual = CalculateTermAmount(pointCoin.out.nValue, term, fallbackTerm, pointCoin.nHeight, nHeight);
-                } else {
-                    nActual = pointCoin.out.nValue;
-                }
-                balancePointReceive += nActual;
-                selected[*entry.outpoint] = nActual;
+            // Calculate the actual amount of the pledge
+            CAmount nActual;
+            if (terms) {
+                nActual = CalculateTermAmount(tempAmount, term, fallbackTerm, tempHeight, nHeight);
+            } else {
+                nActual = tempAmount;
             }
+            balancePointReceive += nActual;
+            selected[*entry.outpoint] = nActual;
         } else {
             break;
         }
@@ -1058,14 +1214,11 @@ CAmount CCoinsViewDB::GetBalancePointRetargetSend(CAccountID const& accountID, C
     CAmount balanceRevoke{0};
     std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
     COutPoint outpoint;
-    CAccountID tempAccountID;
+    CAccountID tempAccountID = accountID;
     PointRetargetEntry retargetEntry(&outpoint, &tempAccountID);
     pcursor->Seek(retargetEntry);
     while (pcursor->Valid()) {
-        if (!pcursor->GetKey(retargetEntry)) {
-            throw std::runtime_error("failed to read data from database");
-        }
-        if (retargetEntry.key != DB_COIN_POINT_CHIA_POINT_RETARGET) {
+        if (!pcursor->GetKey(retargetEntry) || retargetEntry.key != DB_COIN_POINT_CHIA_POINT_RETARGET || tempAccountID != accountID) {
             break;
         }
         // Because of the RETARGET tx is pointed to a RETARGET or a POINT, but the amount of the pledge should be the same,
@@ -1080,9 +1233,7 @@ CAmount CCoinsViewDB::GetBalancePointRetargetSend(CAccountID const& accountID, C
         if (!pcursor->GetValue(value)) {
             throw std::runtime_error("failed to get coin from database");
         }
-        if (tempAccountID == accountID) {
-            balanceRevoke += CalculatePledgeAmountFromRetargetCoin(coin.out.nValue, pointType, nPointHeight, *terms, nHeight);
-        }
+        balanceRevoke += CalculatePledgeAmountFromRetargetCoin(coin.out.nValue, pointType, nPointHeight, *terms, nHeight);
         // Next
         pcursor->Next();
     }
@@ -1109,32 +1260,23 @@ CAmount CCoinsViewDB::GetBalancePointRetargetReceive(CAccountID const& accountID
     std::map<COutPoint, CAmount> selected; // Coins are related to the accountID
     std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
     COutPoint outpoint;
-    CAccountID tempAccountID;
-    PointRetargetEntry retargetEntry(&outpoint, &tempAccountID);
+    CAccountID tempAccountID = accountID;
+    PointRetargetReceiveEntry retargetEntry(&outpoint, &tempAccountID);
     pcursor->Seek(retargetEntry);
     while (pcursor->Valid()) {
-        if (!pcursor->GetKey(retargetEntry)) {
-            throw std::runtime_error("failed to read data from database");
-        }
-        if (retargetEntry.key != DB_COIN_POINT_CHIA_POINT_RETARGET) {
+        if (!pcursor->GetKey(retargetEntry) || retargetEntry.key != DB_COIN_POINT_RETARGET_RECEIVE_INDEX || tempAccountID != accountID) {
             break;
         }
-        CAccountID receiverID;
+        CAmount nAmount;
         DatacarrierType pointType;
         int nPointHeight;
-        PointRetargetValue value(&receiverID, &pointType, &nPointHeight);
+        PointRetargetReceiveValue value(&nAmount, &pointType, &nPointHeight);
         if (!pcursor->GetValue(value)) {
-            throw std::runtime_error("failed to read receiver-id from database");
-        }
-        if (receiverID == accountID) {
-            Coin coin;
-            if (!GetCoin(outpoint, coin)) {
-                throw std::runtime_error("failed to read retargetCoin from database");
-            }
-            CAmount nActual = CalculatePledgeAmountFromRetargetCoin(coin.out.nValue, pointType, nPointHeight, *terms, nHeight);
-            balanceReceive += nActual;
-            selected[outpoint] = nActual;
+            throw std::runtime_error("failed to read retarget value from database");
         }
+        CAmount nActual = CalculatePledgeAmountFromRetargetCoin(nAmount, pointType, nPointHeight, *terms, nHeight);
+        balanceReceive += nActual;
+        selected[outpoint] = nActual;
         // Next
         pcursor->Next();
     }
@@ -1195,13 +1337,31 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
     batch.Write(DB_LAST_BLOCK, nLastFile);
     for (std::vector<const CBlockIndex*>::const_iterator it=blockinfo.begin(); it != blockinfo.end(); it++) {
         CDiskBlockIndex blockIndex(*it, (*it)->nHeight >= consensusParams.BHDIP009Height);
+        if (blockIndex.fChiaposFieldsRecord) {
+            // The chia fields were released after they were written, the index is written again with the same fields
+            CDiskBlockIndex diskindex;
+            diskindex.fChiaposFieldsRecord = true;
+            if (!Read(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), diskindex) || !diskindex.fChiapos || diskindex.vchChiaposFieldsRecord.empty())
+                return error("%s: failed to read the chiapos fields of block %s", __func__, (*it)->GetBlockHash().ToString());
+            blockIndex.vchChiaposFieldsRecord = std::move(diskindex.vchChiaposFieldsRecord);
+        }
         batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), blockIndex);
         if ((*it)->vchPubKey.empty() && !(*it)->generatorAccountID.IsNull())
             batch.Write(std::make_pair(DB_BLOCK_GENERATOR_INDEX, (*it)->GetBlockHash()), REF((*it)->generatorAccountID));
+        if ((*it)->pchiaMetrics)
+            batch.Write(std::make_pair(DB_BLOCK_CHIA_METRICS, (*it)->GetBlockHash()), *(*it)->pchiaMetrics);
     }
     return WriteBatch(batch, true);
 }
 
+bool CBlockTreeDB::ReadBlockMetrics(const uint256& hash, chiapos::CBlockMetrics& metrics) {
+    return Read(std::make_pair(DB_BLOCK_CHIA_METRICS, hash), metrics);
+}
+
+bool CBlockTreeDB::ReadBlockIndex(const uint256& hash, CDiskBlockIndex& diskindex) {
+    return Read(std::make_pair(DB_BLOCK_INDEX, hash), diskindex);
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
     return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
 }
@@ -1216,8 +1376,13 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
 
 bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
 {
+    int64_t nStart = GetTimeMillis();
     size_t batch_size = (size_t) gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
     CDBBatch batch(*this);
+    size_t nLoaded = 0, nUpgraded = 0, nResolved = 0;
+    //! The records written by the former versions only have the low 64 bits of the generator, they are kept to be
+    //! written again with the full one
+    std::vector<std::pair<CBlockIndex*, CDiskBlockIndex>> vRequireGenerator;
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
@@ -1233,7 +1398,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
             if (pcursor->GetValue(diskindex)) {
                 // Check chiapos related entries
                 if (diskindex.nHeight >= consensusParams.BHDIP009Height) {
-                    if (diskindex.chiaposFields.IsNull()) {
+                    if (diskindex.fullChiaposFields.IsNull()) {
                         LogPrintf("%s: found null chiaposFields, skip the diskindex, height=%d\n", __func__, diskindex.nHeight);
                         // Fields from chiapos are invalid, ignore this block
                         pcursor->Next();
@@ -1258,32 +1423,16 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->generatorAccountID = diskindex.generatorAccountID;
                 pindexNew->vchPubKey          = diskindex.vchPubKey;
                 pindexNew->vchSignature       = diskindex.vchSignature;
-                pindexNew->chiaposFields      = diskindex.chiaposFields;
-
-                // Load external generator
-                if ((pindexNew->nStatus & BLOCK_HAVE_DATA) && pindexNew->vchPubKey.empty() && pindexNew->nHeight > 0) {
-                    bool fRequireStore = false;
-                    CAccountID generatorAccountID;
-                    if (!Read(std::make_pair(DB_BLOCK_GENERATOR_INDEX, pindexNew->GetBlockHash()), REF(generatorAccountID))) {
-                        //! Slowly: Read from full block data
-                        CBlock block;
-                        if (!ReadBlockFromDisk(block, pindexNew, consensusParams))
-                            return error("%s: failed to read block value", __func__);
-                        generatorAccountID = ExtractAccountID(block.vtx[0]->vout[0].scriptPubKey);
-                        fRequireStore = !generatorAccountID.IsNull();
-                    }
-                    if (generatorAccountID.GetUint64(0) != pindexNew->generatorAccountID.GetUint64(0))
-                        return error("%s: failed to read external generator value", __func__);
-                    pindexNew->generatorAccountID = generatorAccountID;
-
-                    if (fRequireStore) {
-                        batch.Write(std::make_pair(DB_BLOCK_GENERATOR_INDEX, pindexNew->GetBlockHash()), REF(generatorAccountID));
-                        if (batch.SizeEstimate() > batch_size) {
-                            WriteBatch(batch);
-                            batch.Clear();
-                        }
-                    }
-                }
+                pindexNew->chiaposFields      = chiapos::CBlockIndexFields(diskindex.fullChiaposFields);
+                if (!diskindex.fullChiaposFields.vdfProof.vchProof.empty())
+                    pindexNew->hashNextChallenge = chiapos::MakeChallenge(pindexNew->GetBlockHash(), diskindex.fullChiaposFields.vdfProof.vchProof);
+                if (pindexNew->IsChiaBlock())
+                    NoteChiaposFieldsReleased(diskindex.fullChiaposFields);
+                ++nLoaded;
+
+                // The generator is resolved after the load
+                if ((pindexNew->nStatus & BLOCK_HAVE_DATA) && pindexNew->vchPubKey.empty() && pindexNew->nHeight > 0 && !diskindex.fHaveGenerator)
+                    vRequireGenerator.emplace_back(pindexNew, std::move(diskindex));
 
                 pcursor->Next();
             } else {
@@ -1294,6 +1443,62 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
         }
     }
 
+    // Load external generator of the records written by the former versions, the external records are read in one
+    // pass over their key range rather than looked up for each block
+    std::unordered_map<uint256, CAccountID, BlockHasher> mapGenerators;
+    if (!vRequireGenerator.empty()) {
+        pcursor->Seek(std::make_pair(DB_BLOCK_GENERATOR_INDEX, uint256()));
+        while (pcursor->Valid()) {
+            boost::this_thread::interruption_point();
+            if (ShutdownRequested()) return false;
+            std::pair<char, uint256> key;
+            if (pcursor->GetKey(key) && key.first == DB_BLOCK_GENERATOR_INDEX) {
+                if (!pcursor->GetValue(mapGenerators[key.second]))
+                    return error("%s: failed to read generator value", __func__);
+                pcursor->Next();
+            } else {
+                break;
+            }
+        }
+    }
+    for (auto& required : vRequireGenerator) {
+        CBlockIndex* pindexNew = required.first;
+        CDiskBlockIndex& diskindex = required.second;
+        bool fRequireStore = false;
+        CAccountID generatorAccountID;
+        auto itGenerator = mapGenerators.find(pindexNew->GetBlockHash());
+        if (itGenerator != mapGenerators.end()) {
+            generatorAccountID = itGenerator->second;
+        } else {
+            //! Slowly: Read from full block data
+            CBlock block;
+            if (!ReadBlockFromDisk(block, pindexNew, consensusParams))
+                return error("%s: failed to read block value", __func__);
+            generatorAccountID = ExtractAccountID(block.vtx[0]->vout[0].scriptPubKey);
+            fRequireStore = !generatorAccountID.IsNull();
+            ++nResolved;
+        }
+        if (generatorAccountID.GetUint64(0) != pindexNew->generatorAccountID.GetUint64(0))
+            return error("%s: failed to read external generator value", __func__);
+        pindexNew->generatorAccountID = generatorAccountID;
+
+        // Store the generator with the record, so it isn't resolved again on the next start
+        if (!generatorAccountID.IsNull()) {
+            diskindex.generatorAccountID = generatorAccountID;
+            batch.Write(std::make_pair(DB_BLOCK_INDEX, pindexNew->GetBlockHash()), diskindex);
+            // The former versions still read the generator from the external record
+            if (fRequireStore)
+                batch.Write(std::make_pair(DB_BLOCK_GENERATOR_INDEX, pindexNew->GetBlockHash()), REF(generatorAccountID));
+            ++nUpgraded;
+            if (batch.SizeEstimate() > batch_size) {
+                WriteBatch(batch);
+                batch.Clear();
+            }
+        }
+    }
+
+    LogPrintf("%s: loaded %u block index entries in %dms, %u records upgraded with their generators, %u generators resolved from the blocks\n", __func__,
+        nLoaded, GetTimeMillis() - nStart, nUpgraded, nResolved);
     return WriteBatch(batch);
 }
 
@@ -1302,8 +1507,12 @@ bool CCoinsViewDB::Upgrade(bool &fUpgraded) {
     fUpgraded = false;
     // Check coin database version
     uint32_t coinDbVersion = 0;
-    if (db.Read(DB_COIN_VERSION, REF(VARINT(coinDbVersion))) && coinDbVersion == DB_VERSION)
-        return true;
+    if (db.Read(DB_COIN_VERSION, REF(VARINT(coinDbVersion)))) {
+        if (coinDbVersion == DB_VERSION)
+            return HaveConsistentAccountTotals() || RebuildAccountTotals();
+        if (coinDbVersion >= DB_VERSION_INCREMENTAL_BASE && coinDbVersion < DB_VERSION)
+            return UpgradeIncremental(coinDbVersion);
+    }
     db.Erase(DB_COIN_VERSION);
     fUpgraded = true;
 
@@ -1321,7 +1530,10 @@ bool CCoinsViewDB::Upgrade(bool &fUpgraded) {
         CDBBatch batch(db);
         for (; pcursor->Valid(); pcursor->Next()) {
             const leveldb::Slice key = pcursor->GetKey();
-            if (key.size() > 32 && (key[0] == DB_COIN_INDEX || key[0] == DB_COIN_BINDPLOTTER || key[0] == DB_COIN_BINDCHIAFARMER || key[0] == DB_COIN_POINT_SEND || key[0] == DB_COIN_POINT_RECEIVE)) {
+            if (key.size() > 32 && (key[0] == DB_COIN_INDEX || key[0] == DB_COIN_BINDPLOTTER || key[0] == DB_COIN_BINDCHIAFARMER || key[0] == DB_COIN_POINT_SEND || key[0] == DB_COIN_POINT_RECEIVE ||
+                                  key[0] == DB_COIN_POINT_CHIA_SEND || key[0] == DB_COIN_POINT_CHIA_SEND_TERM_1 || key[0] == DB_COIN_POINT_CHIA_SEND_TERM_2 ||
+                                  key[0] == DB_COIN_POINT_CHIA_SEND_TERM_3 || key[0] == DB_COIN_POINT_RECEIVE_INDEX ||
+                                  key[0] == DB_COIN_POINT_CHIA_POINT_RETARGET || key[0] == DB_COIN_POINT_RETARGET_RECEIVE_INDEX)) {
                 batch.EraseSlice(key);
                 remove++;
 
@@ -1350,7 +1562,8 @@ bool CCoinsViewDB::Upgrade(bool &fUpgraded) {
 
                 if (!coin.refOutAccountID.IsNull()) {
                     // Coin index
-                    batch.Write(CoinIndexEntry(&outpoint, &coin.refOutAccountID), VARINT(coin.out.nValue, VarIntMode::NONNEGATIVE_SIGNED));
+                    uint32_t nCoinHeight = coin.nHeight;
+                    batch.Write(CoinIndexEntry(&outpoint, &coin.refOutAccountID), CoinIndexValue(&coin.out.nValue, &nCoinHeight));
                     add++;
 
                     // Extra data
@@ -1364,7 +1577,20 @@ bool CCoinsViewDB::Upgrade(bool &fUpgraded) {
                     else if (coin.IsPoint()) {
                         auto dbKey = KeyFromDatacarrierType(coin.GetExtraDataType());
                         batch.Write(PointEntry(&outpoint, &coin.refOutAccountID, dbKey.get_value_or(0)), REF(PointPayload::As(coin.extraData)->GetReceiverID()));
-                        add++;
+                        CAmount nAmount = coin.out.nValue;
+                        uint32_t nHeight = coin.nHeight;
+                        batch.Write(PointReceiveEntry(&outpoint, &PointPayload::As(coin.extraData)->GetReceiverID(), dbKey.get_value_or(0)), PointReceiveValue(&nAmount, &nHeight));
+                        add += 2;
+                    }
+                    else if (coin.IsPointRetarget()) {
+                        auto payload = PointRetargetPayload::As(coin.extraData);
+                        CAccountID receiverID = payload->GetReceiverID();
+                        DatacarrierType pointType = payload->GetPointType();
+                        int nPointHeight = payload->GetPointHeight();
+                        CAmount nAmount = coin.out.nValue;
+                        batch.Write(PointRetargetEntry(&outpoint, &coin.refOutAccountID), PointRetargetValue(&receiverID, &pointType, &nPointHeight));
+                        batch.Write(PointRetargetReceiveEntry(&outpoint, &receiverID), PointRetargetReceiveValue(&nAmount, &pointType, &nPointHeight));
+                        add += 2;
                     }
 
                     if (batch.SizeEstimate() > batch_size) {
@@ -1388,12 +1614,214 @@ bool CCoinsViewDB::Upgrade(bool &fUpgraded) {
         db.WriteBatch(batch);
     }
 
+    LogPrintf("[%s]. remove utxo %d, add utxo %d\n", ShutdownRequested() ? "CANCELLED" : "DONE", remove, add);
+
+    if (!ShutdownRequested() && !RebuildAccountTotals())
+        return false;
+
     // Update coin version
     if (!db.Write(DB_COIN_VERSION, VARINT(DB_VERSION)))
         return error("%s: cannot write UTXO version", __func__);
 
     uiInterface.ShowProgress("", 100, false);
-    LogPrintf("[%s]. remove utxo %d, add utxo %d\n", ShutdownRequested() ? "CANCELLED" : "DONE", remove, add);
 
     return !ShutdownRequested();
 }
+
+/** Upgrade the database from a recent format, only the missing indexes are created */
+bool CCoinsViewDB::UpgradeIncremental(uint32_t nVersion) {
+    LogPrintf("Upgrading UTXO database from %08x to %08x...\n", nVersion, DB_VERSION);
+    uiInterface.ShowProgress(_("Upgrading UTXO database").translated, 0, true);
+
+    if (nVersion < DB_VERSION_POINT_RECEIVE_INDEX && !UpgradePointReceiveIndex())
+        return false;
+
+    if (nVersion < DB_VERSION_RETARGET_RECEIVE_INDEX && !UpgradePointRetargetReceiveIndex())
+        return false;
+
+    if (nVersion < DB_VERSION_ACCOUNT_TOTALS && !RebuildAccountTotals())
+        return false;
+
+    if (nVersion < DB_VERSION_COIN_INDEX_HEIGHT && !UpgradeCoinIndexHeight())
+        return false;
+
+    if (ShutdownRequested())
+        return false;
+
+    // Update coin version
+    if (!db.Write(DB_COIN_VERSION, VARINT(DB_VERSION)))
+        return error("%s: cannot write UTXO version", __func__);
+
+    uiInterface.ShowProgress("", 100, false);
+    return true;
+}
+
+/** Create the receiver index from the point entries of senders */
+bool CCoinsViewDB::UpgradePointReceiveIndex() {
+    size_t batch_size = (size_t) gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
+    int add = 0;
+    CDBBatch batch(db);
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    for (char key : {DB_COIN_POINT_SEND, DB_COIN_POINT_CHIA_SEND, DB_COIN_POINT_CHIA_SEND_TERM_1, DB_COIN_POINT_CHIA_SEND_TERM_2, DB_COIN_POINT_CHIA_SEND_TERM_3}) {
+        COutPoint outpoint(uint256(), 0);
+        CAccountID senderID;
+        PointEntry entry(&outpoint, &senderID, key);
+        pcursor->Seek(entry);
+        for (; pcursor->Valid(); pcursor->Next()) {
+            if (ShutdownRequested())
+                return false;
+            if (!pcursor->GetKey(entry) || entry.key != key)
+                break;
+            CAccountID receiverID;
+            if (!pcursor->GetValue(receiverID))
+                return error("%s: cannot parse point record", __func__);
+            Coin coin;
+            if (!GetCoin(outpoint, coin))
+                return error("%s: cannot read point coin %s", __func__, outpoint.ToString());
+            CAmount nAmount = coin.out.nValue;
+            uint32_t nHeight = coin.nHeight;
+            batch.Write(PointReceiveEntry(&outpoint, &receiverID, key), PointReceiveValue(&nAmount, &nHeight));
+            add++;
+
+            if (batch.SizeEstimate() > batch_size) {
+                db.WriteBatch(batch);
+                batch.Clear();
+            }
+        }
+    }
+    db.WriteBatch(batch);
+    LogPrintf("%s: add %d point receive entries\n", __func__, add);
+    return true;
+}
+
+/** Create the receiver index from the retarget entries of revokers */
+bool CCoinsViewDB::UpgradePointRetargetReceiveIndex() {
+    size_t batch_size = (size_t) gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
+    int add = 0;
+    CDBBatch batch(db);
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    COutPoint outpoint(uint256(), 0);
+    CAccountID revokerID;
+    PointRetargetEntry entry(&outpoint, &revokerID);
+    pcursor->Seek(entry);
+    for (; pcursor->Valid(); pcursor->Next()) {
+        if (ShutdownRequested())
+            return false;
+        if (!pcursor->GetKey(entry) || entry.key != DB_COIN_POINT_CHIA_POINT_RETARGET)
+            break;
+        CAccountID receiverID;
+        DatacarrierType pointType;
+        int nPointHeight;
+        PointRetargetValue value(&receiverID, &pointType, &nPointHeight);
+        if (!pcursor->GetValue(value))
+            return error("%s: cannot parse retarget record", __func__);
+        Coin coin;
+        if (!GetCoin(outpoint, coin))
+            return error("%s: cannot read retarget coin %s", __func__, outpoint.ToString());
+        CAmount nAmount = coin.out.nValue;
+        batch.Write(PointRetargetReceiveEntry(&outpoint, &receiverID), PointRetargetReceiveValue(&nAmount, &pointType, &nPointHeight));
+        add++;
+
+        if (batch.SizeEstimate() > batch_size) {
+            db.WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    db.WriteBatch(batch);
+    LogPrintf("%s: add %d retarget receive entries\n", __func__, add);
+    return true;
+}
+
+/** Rewrite the coin index with the height of coins */
+bool CCoinsViewDB::UpgradeCoinIndexHeight() {
+    size_t batch_size = (size_t) gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
+    int update = 0;
+    CDBBatch batch(db);
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    COutPoint outpoint;
+    CoinEntry entry(&outpoint);
+    for (pcursor->Seek(DB_COIN); pcursor->Valid(); pcursor->Next()) {
+        if (ShutdownRequested())
+            return false;
+        if (!pcursor->GetKey(entry) || entry.key != DB_COIN)
+            break;
+        Coin coin;
+        if (!pcursor->GetValue(coin))
+            return error("%s: cannot parse coin record", __func__);
+        if (coin.refOutAccountID.IsNull())
+            continue;
+        uint32_t nHeight = coin.nHeight;
+        batch.Write(CoinIndexEntry(&outpoint, &coin.refOutAccountID), CoinIndexValue(&coin.out.nValue, &nHeight));
+        update++;
+
+        if (batch.SizeEstimate() > batch_size) {
+            db.WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    db.WriteBatch(batch);
+    LogPrintf("%s: update %d coin index entries\n", __func__, update);
+    return true;
+}
+
+bool CCoinsViewDB::HaveConsistentAccountTotals() const {
+    uint256 hashTotalsBlock;
+    if (!db.Read(DB_ACCOUNT_TOTALS_BLOCK, hashTotalsBlock))
+        hashTotalsBlock.SetNull();
+    return hashTotalsBlock == GetBestBlock() && GetHeadBlocks().empty();
+}
+
+bool CCoinsViewDB::RebuildAccountTotals() {
+    LogPrintf("%s: rebuilding account totals...\n", __func__);
+    size_t batch_size = (size_t) gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+
+    // Clear old data
+    CDBBatch batch(db);
+    for (pcursor->Seek(DB_ACCOUNT_TOTALS); pcursor->Valid(); pcursor->Next()) {
+        std::pair<char, CAccountID> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ACCOUNT_TOTALS)
+            break;
+        batch.Erase(key);
+        if (batch.SizeEstimate() > batch_size) {
+            db.WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    db.WriteBatch(batch);
+    batch.Clear();
+
+    // Sum coins, the totals are merged into the database when too many accounts are held in memory
+    static const size_t MAX_ACCOUNTS_IN_MEMORY = 100000;
+    CAccountTotalsMap mapTotals;
+    auto fnWriteTotals = [this, &mapTotals, &batch]() {
+        for (const auto& pair : mapTotals) {
+            CAccountTotals totals;
+            db.Read(std::make_pair(DB_ACCOUNT_TOTALS, pair.first), totals);
+            totals.Merge(pair.second);
+            batch.Write(std::make_pair(DB_ACCOUNT_TOTALS, pair.first), totals);
+        }
+        db.WriteBatch(batch);
+        batch.Clear();
+        mapTotals.clear();
+    };
+    COutPoint outpoint;
+    CoinEntry entry(&outpoint);
+    for (pcursor->Seek(DB_COIN); pcursor->Valid(); pcursor->Next()) {
+        if (ShutdownRequested())
+            return false;
+        if (!pcursor->GetKey(entry) || entry.key != DB_COIN)
+            break;
+        Coin coin;
+        if (!pcursor->GetValue(coin))
+            return error("%s: cannot parse coin record", __func__);
+        ApplyCoinToAccountTotals(mapTotals, outpoint, coin, 1);
+        if (mapTotals.size() > MAX_ACCOUNTS_IN_MEMORY)
+            fnWriteTotals();
+    }
+    fnWriteTotals();
+
+    if (!db.Write(DB_ACCOUNT_TOTALS_BLOCK, GetBestBlock()))
+        return error("%s: cannot write the block of account totals", __func__);
+    return true;
+}
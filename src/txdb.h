@@ -18,6 +18,7 @@
 #include <vector>
 
 class CBlockIndex;
+class CDiskBlockIndex;
 class uint256;
 
 //! No need to periodic flush if at least this much space still available.
@@ -38,6 +39,8 @@ static const int64_t nMaxBlockDBCache = 2;
 static const int64_t nMaxTxIndexCache = 1024;
 //! Max memory allocated to all block filter index caches combined in MiB.
 static const int64_t max_filter_index_cache = 1024;
+//! Max memory allocated to the pledge index database in MiB.
+static const int64_t nMaxPledgeIndexCache = 64;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
 
@@ -56,7 +59,7 @@ public:
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
-    bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
+    bool BatchWrite(CCoinsMap &mapCoins, CAccountTotalsMap &mapTotals, const uint256 &hashBlock) override;
     CCoinsViewCursorRef Cursor() const override;
     CCoinsViewCursorRef Cursor(const CAccountID &accountID) const override;
     CCoinsViewCursorRef PointSendCursor(const CAccountID &accountID, PointType pt) const override;
@@ -83,8 +86,24 @@ public:
 
     CBindPlotterCoinsMap GetAccountBindPlotterEntries(const CAccountID &accountID, const CPlotterBindData &bindData = {}) const override;
     CBindPlotterCoinsMap GetBindPlotterEntries(const CPlotterBindData &bindData) const override;
+    bool GetAccountTotals(const CAccountID &accountID, CAccountTotals &totals) const override;
 
 private:
+    //! Upgrade from a version since DB_VERSION_INCREMENTAL_BASE by creating the missing indexes only
+    bool UpgradeIncremental(uint32_t nVersion);
+
+    bool UpgradePointReceiveIndex();
+
+    bool UpgradePointRetargetReceiveIndex();
+
+    bool UpgradeCoinIndexHeight();
+
+    //! Whether the account totals were written with the coins of the best block
+    bool HaveConsistentAccountTotals() const;
+
+    //! Recalculate the account totals from all coins
+    bool RebuildAccountTotals();
+
     CAmount GetBalanceBind(CPlotterBindData::Type type, CAccountID const& accountID, CCoinsMap const& mapChildCoins) const;
 
     CAmount GetCoinBalance(const CAccountID &accountID, const CCoinsMap &mapChildCoins, int nHeight) const;
@@ -115,6 +134,8 @@ public:
     void ReadReindexing(bool &fReindexing);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    bool ReadBlockMetrics(const uint256& hash, chiapos::CBlockMetrics& metrics);
+    bool ReadBlockIndex(const uint256& hash, CDiskBlockIndex& diskindex);
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
 };
 
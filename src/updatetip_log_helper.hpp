@@ -8,8 +8,8 @@
 
 #include <chainparams.h>
 #include <interfaces/chain.h>
-
-double GuessVerificationProgress(const ChainTxData& data, const CBlockIndex *pindex);
+#include <util/moneystr.h>
+#include <validation.h>
 
 class UpdateTipLogHelper {
 public:
@@ -26,6 +26,7 @@ public:
             return false;
         }
         m_pindex = m_pindex->pprev;
+        m_logVec.clear();
         ApplyLogFromCurrIndex();
         return true;
     }
@@ -55,18 +56,6 @@ public:
     }
 
 private:
-    uint64_t CalculateReqIters(Consensus::Params const& params) const {
-        // calculate required vdf iterations
-        chiapos::PubKeyOrHash poolPkOrHash = chiapos::MakePubKeyOrHash(static_cast<chiapos::PlotPubKeyType>(m_pindex->chiaposFields.posProof.nPlotType), m_pindex->chiaposFields.posProof.vchPoolPkOrHash);
-        uint256 mixed_quality_string = chiapos::MakeMixedQualityString(
-                chiapos::MakeArray<chiapos::PK_LEN>(m_pindex->chiaposFields.posProof.vchLocalPk), chiapos::MakeArray<chiapos::PK_LEN>(m_pindex->chiaposFields.posProof.vchFarmerPk), poolPkOrHash,
-                m_pindex->chiaposFields.posProof.nPlotK, m_pindex->chiaposFields.posProof.challenge, m_pindex->chiaposFields.posProof.vchProof);
-        int nTargetHeight = m_pindex->nHeight;
-        int nBitsFilter = nTargetHeight < params.BHDIP009PlotIdBitsOfFilterEnableOnHeight ? 0 : params.BHDIP009PlotIdBitsOfFilter;
-        uint64_t nBaseIters = chiapos::GetBaseIters(nTargetHeight, params);
-        return chiapos::CalculateIterationsQuality(mixed_quality_string, chiapos::GetDifficultyForNextIterations(m_pindex->pprev, params), nBitsFilter, params.BHDIP009DifficultyConstantFactorBits, m_pindex->chiaposFields.posProof.nPlotK, nBaseIters);
-    }
-
     void ApplyLogFromCurrIndex() {
         AddLogEntry("new best", m_pindex->GetBlockHash().GetHex());
         AddLogEntry("height", m_pindex->nHeight);
@@ -79,31 +68,30 @@ private:
         AddLogEntry("work", GetBlockWork(*m_pindex).GetLow64());
         AddLogEntry("type", m_pindex->nHeight >= params.BHDIP009Height ? "chia" : "burst");
         // For BHDIP009?
-        if (m_pindex->nHeight >= params.BHDIP009Height) {
-            int nBlockDuration = m_pindex->GetBlockTime() - m_pindex->pprev->GetBlockTime();
-            AddLogEntry("block-time", chiapos::FormatTime(nBlockDuration));
+        auto pmetrics = GetChiaBlockMetrics(m_pindex, params);
+        if (pmetrics) {
+            AddLogEntry("block-time", chiapos::FormatTime(pmetrics->nBlockDuration));
             // vdf related
-            AddLogEntry("vdf-iters", m_pindex->chiaposFields.vdfProof.nVdfIters);
-            AddLogEntry("vdf-time", chiapos::FormatTime(m_pindex->chiaposFields.vdfProof.nVdfDuration));
-            auto vdf_req = CalculateReqIters(params);
-            AddLogEntry("vdf-iters-req", vdf_req);
-            AddLogEntryBool("vdf-req-match", m_pindex->chiaposFields.vdfProof.nVdfIters == vdf_req);
+            AddLogEntry("vdf-iters", m_pindex->chiaposFields.nVdfIters);
+            AddLogEntry("vdf-time", chiapos::FormatTime(m_pindex->chiaposFields.nVdfDuration));
+            AddLogEntry("vdf-iters-req", pmetrics->nRequiredIters);
+            AddLogEntryBool("vdf-req-match", m_pindex->chiaposFields.nVdfIters == pmetrics->nRequiredIters);
             std::string strVdfSpeed = chiapos::FormatNumberStr(std::to_string(m_pindex->chiaposFields.GetTotalIters() / m_pindex->chiaposFields.GetTotalDuration()));
             AddLogEntry(tinyformat::format("vdf=%s(%s ips)", chiapos::MakeNumberStr(m_pindex->chiaposFields.GetTotalIters()), strVdfSpeed));
             // filter bits
             AddLogEntry("filter-bit", m_pindex->nHeight < params.BHDIP009PlotIdBitsOfFilterEnableOnHeight ? 0 : params.BHDIP009PlotIdBitsOfFilter);
             // challenge
-            uint256 challenge = chiapos::MakeChallenge(m_pindex, params);
-            AddLogEntry("challenge", challenge.GetHex());
-            AddLogEntry("challenge-diff", chiapos::GetDifficultyForNextIterations(m_pindex, params));
+            AddLogEntry("quality", pmetrics->mixedQualityString.GetHex());
+            AddLogEntry("challenge", pmetrics->challenge.GetHex());
+            AddLogEntry("challenge-diff", pmetrics->nChallengeDifficulty);
             // difficulty
             AddLogEntry("block-difficulty", chiapos::GetChiaBlockDifficulty(m_pindex, params));
             AddLogEntry("min-difficulty", chiapos::MakeNumberStr(params.BHDIP009StartDifficulty));
-            AddLogEntry("k", m_pindex->chiaposFields.posProof.nPlotK);
-            AddLogEntry("farmer-pk", chiapos::BytesToHex(m_pindex->chiaposFields.posProof.vchFarmerPk));
+            AddLogEntry("k", m_pindex->chiaposFields.nPlotK);
+            AddLogEntry("farmer-pk", chiapos::BytesToHex(m_pindex->chiaposFields.vchFarmerPk));
             // netspace
-            auto netspace = chiapos::CalculateNetworkSpace(chiapos::GetDifficultyForNextIterations(m_pindex->pprev, params), m_pindex->chiaposFields.GetTotalIters(), params.BHDIP009DifficultyConstantFactorBits);
-            AddLogEntry("netspace", netspace.GetLow64());
+            AddLogEntry("netspace", pmetrics->nNetspace);
+            AddLogEntry("reward", FormatMoney(pmetrics->nCoinbaseReward));
         }
     }
 
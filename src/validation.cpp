@@ -52,6 +52,7 @@
 #include <amount.h>
 #include <chiapos/kernel/bls_key.h>
 #include <coins.h>
+#include <core_memusage.h>
 #include <logging.h>
 #include <cstdint>
 
@@ -61,6 +62,7 @@
 
 #include <cinttypes>
 #include <future>
+#include <list>
 #include <sstream>
 #include <string>
 
@@ -1254,21 +1256,39 @@ bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CBlockIndex* pindex
     return ReadRawBlockFromDisk(block, block_pos, message_start);
 }
 
+/** The subsidy that a block adds to the accumulated subsidy */
+static CAmount GetBlockAccumulateSubsidyDelta(const CBlockIndex* pindex, const Consensus::Params& consensusParams)
+{
+    if (pindex->nHeight < consensusParams.BHDIP009Height) {
+        int nPeriod = (pindex->nHeight - consensusParams.BHDIP008Height) / consensusParams.BHDIP008FundRoyaltyDecreasePeriodForLowMortgage;
+        int fundRatio = consensusParams.BHDIP008FundRoyaltyForLowMortgage - consensusParams.BHDIP008FundRoyaltyDecreaseForLowMortgage * nPeriod;
+        if (fundRatio < consensusParams.BHDIP001FundRoyaltyForFullMortgage)
+            fundRatio = consensusParams.BHDIP001FundRoyaltyForFullMortgage;
+        assert(fundRatio <= consensusParams.BHDIP001FundRoyaltyForLowMortgage);
+        return (GetBlockSubsidy(pindex->nHeight, consensusParams) * (consensusParams.BHDIP001FundRoyaltyForLowMortgage - fundRatio)) / 1000;
+    } else {
+        return (GetBlockSubsidy(pindex->nHeight, consensusParams) * (1000 - consensusParams.BHDIP009FundRoyaltyForLowMortgage)) / 1000;
+    }
+}
+
 CAmount GetBlockAccumulateSubsidy(const CBlockIndex* pindexPrev, const Consensus::Params& consensusParams)
 {
     AssertLockHeld(cs_main);
+    // Walk back to the nearest block that has the accumulated subsidy calculated
     CAmount accumulate = 0;
+    std::vector<const CBlockIndex*> vUncalculated;
     for (const CBlockIndex* pindex = pindexPrev; (pindex != nullptr) && (pindex->nStatus & BLOCK_UNCONDITIONAL) && (pindex->nHeight >= consensusParams.BHDIP008Height); pindex = pindex->pprev) {
-        if (pindex->nHeight < consensusParams.BHDIP009Height) {
-            int nPeriod = (pindex->nHeight - consensusParams.BHDIP008Height) / consensusParams.BHDIP008FundRoyaltyDecreasePeriodForLowMortgage;
-            int fundRatio = consensusParams.BHDIP008FundRoyaltyForLowMortgage - consensusParams.BHDIP008FundRoyaltyDecreaseForLowMortgage * nPeriod;
-            if (fundRatio < consensusParams.BHDIP001FundRoyaltyForFullMortgage)
-                fundRatio = consensusParams.BHDIP001FundRoyaltyForFullMortgage;
-            assert(fundRatio <= consensusParams.BHDIP001FundRoyaltyForLowMortgage);
-            accumulate += (GetBlockSubsidy(pindex->nHeight, consensusParams) * (consensusParams.BHDIP001FundRoyaltyForLowMortgage - fundRatio)) / 1000;
-        } else {
-            accumulate += (GetBlockSubsidy(pindex->nHeight, consensusParams) * (1000 - consensusParams.BHDIP009FundRoyaltyForLowMortgage)) / 1000;
+        if (pindex->nAccumulateSubsidy >= 0) {
+            accumulate = pindex->nAccumulateSubsidy;
+            break;
         }
+        vUncalculated.push_back(pindex);
+    }
+    for (auto it = vUncalculated.rbegin(); it != vUncalculated.rend(); ++it) {
+        accumulate += GetBlockAccumulateSubsidyDelta(*it, consensusParams);
+        // The unconditional flags of connected blocks and their ancestors do not change anymore
+        if ((*it)->IsValid(BLOCK_VALID_SCRIPTS))
+            (*it)->nAccumulateSubsidy = accumulate;
     }
     return accumulate;
 }
@@ -2062,6 +2082,245 @@ void ThreadScriptCheck(int worker_num) {
     scriptcheckqueue.Thread();
 }
 
+static CCheckQueue<CHeaderProofCheck> headerproofcheckqueue(16);
+
+void ThreadHeaderProofCheck(int worker_num) {
+    util::ThreadRename(strprintf("hdrproof.%i", worker_num));
+    headerproofcheckqueue.Thread();
+}
+
+/** The mixed quality strings of the chia proofs which are verified ahead of the header acceptance, by the hash of the proofs */
+struct VerifiedHeaderProof {
+    int nTargetHeight;
+    uint256 mixedQualityString;
+};
+static Mutex g_verified_header_proofs_mutex;
+static std::map<uint256, VerifiedHeaderProof> g_verified_header_proofs GUARDED_BY(g_verified_header_proofs_mutex);
+//! The deadlines of the burst headers which are calculated ahead of the header acceptance, by the hash of the header
+struct CalculatedHeaderDeadline {
+    int nTargetHeight;
+    uint64_t deadline;
+};
+static std::map<uint256, CalculatedHeaderDeadline> g_calculated_header_deadlines GUARDED_BY(g_verified_header_proofs_mutex);
+
+static uint256 GetChiaProofsHash(const chiapos::CBlockFields& fields)
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << fields.posProof << fields.vdfProof;
+    return ss.GetHash();
+}
+
+bool CHeaderProofCheck::operator()() {
+    if (!vNonces.empty()) {
+        std::vector<uint64_t> deadlines = poc::CalculateDeadlines(Span<const poc::PlotterNonce>(vNonces.data(), vNonces.size()), *pparams);
+        LOCK(g_verified_header_proofs_mutex);
+        for (std::size_t n = 0; n < vNonces.size(); n++) {
+            g_calculated_header_deadlines[vHashes[n]] = CalculatedHeaderDeadline{vNonces[n].nHeight, deadlines[n]};
+        }
+        return true;
+    }
+
+    CValidationState state;
+    uint256 mixedQualityString;
+    if (chiapos::CheckBlockFieldsProofs(pheader->chiaposFields, nTargetHeight, state, *pparams, mixedQualityString)) {
+        MemoizeVerifiedHeaderProof(pheader->chiaposFields, nTargetHeight, mixedQualityString);
+    }
+    // Failures are not memoized, the header acceptance verifies them again and reports the reason
+    return true;
+}
+
+bool VerifyLocalChiaProofs(const chiapos::CBlockFields& fields, int nTargetHeight, const Consensus::Params& params, CValidationState& state)
+{
+    int64_t nTimeStart = GetTimeMicros();
+    uint256 mixedQualityString;
+    if (!chiapos::CheckBlockFieldsProofs(fields, nTargetHeight, state, params, mixedQualityString))
+        return false;
+    LogPrint(BCLog::BENCH, "    - Verify local proofs: %.2fms\n", (GetTimeMicros() - nTimeStart) * MILLI);
+
+    // The proofs of the lower heights can't be released any more
+    PruneVerifiedHeaderProofs(nTargetHeight);
+    MemoizeVerifiedHeaderProof(fields, nTargetHeight, mixedQualityString);
+    return true;
+}
+
+void MemoizeVerifiedHeaderProof(const chiapos::CBlockFields& fields, int nTargetHeight, const uint256& mixedQualityString)
+{
+    LOCK(g_verified_header_proofs_mutex);
+    g_verified_header_proofs[GetChiaProofsHash(fields)] = VerifiedHeaderProof{nTargetHeight, mixedQualityString};
+}
+
+bool FindVerifiedHeaderProof(const chiapos::CBlockFields& fields, int nTargetHeight, uint256& mixedQualityString)
+{
+    LOCK(g_verified_header_proofs_mutex);
+    auto it = g_verified_header_proofs.find(GetChiaProofsHash(fields));
+    if (it == g_verified_header_proofs.end() || it->second.nTargetHeight != nTargetHeight)
+        return false;
+    mixedQualityString = it->second.mixedQualityString;
+    return true;
+}
+
+void PruneVerifiedHeaderProofs(int nHeight)
+{
+    LOCK(g_verified_header_proofs_mutex);
+    for (auto it = g_verified_header_proofs.begin(); it != g_verified_header_proofs.end();) {
+        if (it->second.nTargetHeight < nHeight) {
+            it = g_verified_header_proofs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/** Find the deadline of a burst header calculated ahead, the entry is kept until its run is accepted */
+static bool FindCalculatedHeaderDeadline(const uint256& hash, uint64_t& deadline)
+{
+    LOCK(g_verified_header_proofs_mutex);
+    auto it = g_calculated_header_deadlines.find(hash);
+    if (it == g_calculated_header_deadlines.end())
+        return false;
+    deadline = it->second.deadline;
+    return true;
+}
+
+/** The memoized proofs and deadlines of a run of headers, they are erased once the headers of the run are accepted or rejected */
+class CHeaderProofsAheadRun
+{
+public:
+    std::vector<uint256> vProofsHashes;
+    std::vector<uint256> vHeaderHashes;
+
+    ~CHeaderProofsAheadRun() {
+        LOCK(g_verified_header_proofs_mutex);
+        for (const uint256& proofsHash : vProofsHashes)
+            g_verified_header_proofs.erase(proofsHash);
+        for (const uint256& hash : vHeaderHashes)
+            g_calculated_header_deadlines.erase(hash);
+    }
+};
+
+/**
+ * Check a chia header of a run against the block before it without verifying its proofs, like CheckBlockFields does
+ * first. The challenge, the durations and the difficulty are checked, nDifficultySum is the sum of the difficulty
+ * evaluation window ending with the previous block and is moved to the window ending with this header.
+ */
+static bool CheckHeaderFieldsAhead(const chiapos::CBlockFields& fields, int nTargetHeight, const uint256& challenge, uint64_t nPrevVdfDuration,
+                                   arith_uint256& nDifficultySum, const std::function<uint64_t(int)>& getDifficulty, const Consensus::Params& params)
+{
+    if (fields.nVersion != chiapos::CHIAHEADER_VERSION || challenge.IsNull())
+        return false;
+    if ((nTargetHeight > params.BHDIP009Height && nPrevVdfDuration == 0) || fields.vdfProof.nVdfDuration == 0)
+        return false;
+    if (fields.posProof.challenge != challenge || fields.vdfProof.challenge != challenge)
+        return false;
+
+    // The average difficulty of the window ending with the previous block, see GetDifficultyForNextIterations
+    uint64_t nDifficultyPrev = params.BHDIP009StartDifficulty;
+    int nBlocksCalc = std::min(nTargetHeight - 1 - params.BHDIP009Height + 1, params.BHDIP009DifficultyEvalWindow);
+    if (nTargetHeight != params.BHDIP009Height && nBlocksCalc > 0)
+        nDifficultyPrev = (nDifficultySum / nBlocksCalc).GetLow64();
+    if (nDifficultyPrev == 0)
+        return false;
+    uint64_t nDifficulty = chiapos::AdjustBlockDifficulty(nDifficultyPrev, fields.GetTotalDuration(), nTargetHeight, params);
+    if (nDifficulty == 0 || nDifficulty != fields.nDifficulty)
+        return false;
+
+    // The window ending with this header, see CBlockIndex::Update
+    if (nTargetHeight == params.BHDIP009Height)
+        nDifficultySum = 0;
+    nDifficultySum += fields.nDifficulty;
+    int nLeavingHeight = nTargetHeight - params.BHDIP009DifficultyEvalWindow;
+    if (nLeavingHeight >= params.BHDIP009Height)
+        nDifficultySum -= getDifficulty(nLeavingHeight);
+    return true;
+}
+
+/**
+ * Verify the proofs of a run of chia headers on the worker threads, and calculate the deadlines of the burst
+ * headers in batches of SIMD lanes. Only the headers connected to a known block and not accepted yet are
+ * checked. The chia headers are checked against the headers before them first, the proofs are only verified
+ * for the headers before the first one which fails, so a run can't make the workers verify proofs which the
+ * header acceptance rejects without verifying them. The memoized entries are recorded in the run.
+ */
+static void VerifyHeaderProofsAhead(const std::vector<CBlockHeader>& headers, std::size_t beginCheckWorkIndex, const CChainParams& chainparams, CHeaderProofsAheadRun& run) LOCKS_EXCLUDED(cs_main)
+{
+    if (nScriptCheckThreads == 0 || headers.size() < 2)
+        return;
+
+    std::vector<uint256> vHashes;
+    vHashes.reserve(headers.size());
+    for (const CBlockHeader& header : headers) {
+        if (!vHashes.empty() && header.hashPrevBlock != vHashes.back())
+            break;
+        vHashes.push_back(header.GetHash());
+    }
+
+    const Consensus::Params& params = chainparams.GetConsensus();
+    std::vector<CHeaderProofCheck> vChecks;
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindexPrev = LookupBlockIndex(headers[0].hashPrevBlock);
+        if (pindexPrev == nullptr)
+            return;
+        // The generation signatures of the burst headers are chained from the previous block
+        uint256 generationSignature = pindexPrev->GetNextGenerationSignature();
+        uint64_t nPrevBaseTarget = pindexPrev->nBaseTarget;
+        // The challenges and the difficulty window of the chia headers are chained from the previous block
+        uint256 challenge = chiapos::MakeChallenge(pindexPrev, params);
+        uint64_t nPrevVdfDuration = pindexPrev->chiaposFields.nVdfDuration;
+        arith_uint256 nDifficultySum = pindexPrev->nChiaDifficultySum;
+        auto getDifficulty = [&](int nHeight) -> uint64_t {
+            if (nHeight > pindexPrev->nHeight)
+                return headers[nHeight - pindexPrev->nHeight - 1].chiaposFields.nDifficulty;
+            return chiapos::GetChiaBlockDifficulty(pindexPrev->GetAncestor(nHeight), params);
+        };
+        std::vector<uint256> vBatchHashes;
+        std::vector<poc::PlotterNonce> vBatchNonces;
+        for (std::size_t index = 0; index < vHashes.size(); index++) {
+            const CBlockHeader& header = headers[index];
+            int nTargetHeight = pindexPrev->nHeight + 1 + (int) index;
+            bool fCheck = index >= beginCheckWorkIndex && LookupBlockIndex(vHashes[index]) == nullptr;
+            if (nTargetHeight < params.BHDIP009Height) {
+                if (fCheck && !params.BHDIP009SkipTestChainChecks) {
+                    vBatchHashes.push_back(vHashes[index]);
+                    vBatchNonces.push_back(poc::PlotterNonce{header.nPlotterId, header.nNonce, nTargetHeight, generationSignature, nPrevBaseTarget});
+                }
+                generationSignature = poc::CalculateNextGenerationSignature(nTargetHeight, generationSignature, header.hashMerkleRoot, header.nPlotterId, params);
+                nPrevBaseTarget = header.nBaseTarget;
+                if (nTargetHeight + 1 == params.BHDIP009Height)
+                    challenge = chiapos::MakeChallenge(vHashes[index], chiapos::Bytes(100, 0));
+            } else {
+                if (!header.IsChiaBlock() || !CheckHeaderFieldsAhead(header.chiaposFields, nTargetHeight, challenge, nPrevVdfDuration, nDifficultySum, getDifficulty, params))
+                    break;
+                if (fCheck) {
+                    vChecks.emplace_back(nTargetHeight, header, params);
+                    run.vProofsHashes.push_back(GetChiaProofsHash(header.chiaposFields));
+                }
+                challenge = header.chiaposFields.vdfProof.vchProof.empty() ? uint256() : chiapos::MakeChallenge(vHashes[index], header.chiaposFields.vdfProof.vchProof);
+                nPrevVdfDuration = header.chiaposFields.vdfProof.nVdfDuration;
+            }
+            if (vBatchNonces.size() == poc::MAX_BATCH_NONCES) {
+                run.vHeaderHashes.insert(run.vHeaderHashes.end(), vBatchHashes.begin(), vBatchHashes.end());
+                vChecks.emplace_back(std::move(vBatchHashes), std::move(vBatchNonces), params);
+                vBatchHashes.clear();
+                vBatchNonces.clear();
+            }
+        }
+        if (!vBatchNonces.empty()) {
+            run.vHeaderHashes.insert(run.vHeaderHashes.end(), vBatchHashes.begin(), vBatchHashes.end());
+            vChecks.emplace_back(std::move(vBatchHashes), std::move(vBatchNonces), params);
+        }
+    }
+    if (vChecks.size() < 2)
+        return;
+
+    int64_t nTimeStart = GetTimeMicros();
+    CCheckQueueControl<CHeaderProofCheck> control(&headerproofcheckqueue);
+    std::size_t nChecks = vChecks.size();
+    control.Add(vChecks);
+    control.Wait();
+    LogPrint(BCLog::BENCH, "    - Verify %u header proofs and deadline batches: %.2fms\n", (unsigned) nChecks, (GetTimeMicros() - nTimeStart) * MILLI);
+}
+
 VersionBitsCache versionbitscache GUARDED_BY(cs_main);
 
 int32_t ComputeBlockVersion(const CBlockIndex* pindexPrev, const Consensus::Params& params)
@@ -2493,7 +2752,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
             return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, error("ConnectBlock(): The vdf duration=%d is fake or the block is in the future, new height=%d, block.time=%ld, pindex.time=%ld", block.chiaposFields.vdfProof.nVdfDuration, pindex->nHeight + 1, block.GetBlockTime(), pindex->GetBlockTime()), REJECT_INVALID, "bad-cb-vdf-duration");
         }
         // Check bind plotter status
-        CChiaFarmerPk farmerPk = CChiaFarmerPk(pindex->chiaposFields.posProof.vchFarmerPk);
+        CChiaFarmerPk farmerPk = CChiaFarmerPk(pindex->chiaposFields.vchFarmerPk);
         CPlotterBindData bindData(farmerPk);
         std::string address = EncodeDestination(ExtractDestination(block.vtx[0]->vout[0].scriptPubKey));
 
@@ -2503,7 +2762,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         if (!fRewardAddrPreloaded && !view.HaveActiveBindPlotter(pindex->generatorAccountID, bindData)) {
             return state.Invalid(ValidationInvalidReason::CONSENSUS,
                             error("ConnectBlock(): Not active bind %" PRIu64 " to %s (chiapos)",
-                            chiapos::BytesToHex(pindex->chiaposFields.posProof.vchFarmerPk), address),
+                            chiapos::BytesToHex(pindex->chiaposFields.vchFarmerPk), address),
                             REJECT_INVALID, "bad-cb-bindplotter");
         }
     } else if (pindex->nHeight >= chainparams.GetConsensus().BHDIP006BindPlotterActiveHeight &&
@@ -2521,7 +2780,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     CPlotterBindData bindData;
     if (pindex->nHeight >= chainparams.GetConsensus().BHDIP009Height) {
         // Chia blocks
-        bindData = CChiaFarmerPk(pindex->chiaposFields.posProof.vchFarmerPk);
+        bindData = CChiaFarmerPk(pindex->chiaposFields.vchFarmerPk);
     } else {
         bindData = pindex->nPlotterId;
     }
@@ -2702,15 +2961,24 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         setDirtyBlockIndex.insert(pindex);
     }
 
+    // Metrics of the chia block, they are written with the block index
+    if (pindex->nHeight >= chainparams.GetConsensus().BHDIP009Height && !pindex->pchiaMetrics) {
+        pindex->pchiaMetrics = std::make_shared<const chiapos::CBlockMetrics>(
+                chiapos::MakeBlockMetrics(pindex, block, chainparams.GetConsensus()));
+        setDirtyBlockIndex.insert(pindex);
+    }
+
     // Set unconditional flags
     if (pindex->nHeight >= chainparams.GetConsensus().BHDIP008Height && blockReward.fUnconditional) {
         if (!(pindex->nStatus & BLOCK_UNCONDITIONAL)) {
             pindex->nStatus |= BLOCK_UNCONDITIONAL;
+            pindex->nAccumulateSubsidy = -1;
             setDirtyBlockIndex.insert(pindex);
         }
     } else {
         if (pindex->nStatus & BLOCK_UNCONDITIONAL) {
             pindex->nStatus &= ~BLOCK_UNCONDITIONAL;
+            pindex->nAccumulateSubsidy = -1;
             setDirtyBlockIndex.insert(pindex);
         }
     }
@@ -2801,14 +3069,25 @@ bool CChainState::FlushStateToDisk(
                     setDirtyFileInfo.erase(it++);
                 }
                 std::vector<const CBlockIndex*> vBlocks;
+                std::vector<CBlockIndex*> vBlocksWithMetrics;
+                std::vector<CBlockIndex*> vBlocksWithChiaposFields;
                 vBlocks.reserve(setDirtyBlockIndex.size());
                 for (std::set<CBlockIndex*>::iterator it = setDirtyBlockIndex.begin(); it != setDirtyBlockIndex.end(); ) {
                     vBlocks.push_back(*it);
+                    if ((*it)->pchiaMetrics)
+                        vBlocksWithMetrics.push_back(*it);
+                    if ((*it)->pchiaposFields)
+                        vBlocksWithChiaposFields.push_back(*it);
                     setDirtyBlockIndex.erase(it++);
                 }
                 if (!pblocktree->WriteBatchSync(vFiles, nLastBlockFile, vBlocks, chainparams.GetConsensus())) {
                     return AbortNode(state, "Failed to write to block index database");
                 }
+                // The written metrics and chia fields are read from the block index database from now on
+                for (CBlockIndex* pindex : vBlocksWithMetrics)
+                    pindex->pchiaMetrics.reset();
+                for (CBlockIndex* pindex : vBlocksWithChiaposFields)
+                    ReleaseBlockChiaposFields(pindex);
             }
             // Finally remove any pruned files
             if (fFlushForPrune)
@@ -2889,6 +3168,7 @@ void static UpdateTip(const CBlockIndex* pindexNew, const CChainParams& chainPar
         g_best_block = pindexNew->GetBlockHash();
         g_best_block_cv.notify_all();
     }
+    chiapos::NotifyChallengeUpdate();
 
     std::string warningMessages;
     if (!::ChainstateActive().IsInitialBlockDownload())
@@ -2974,6 +3254,7 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
     m_chain.SetTip(pindexDelete->pprev);
 
     UpdateTip(pindexDelete->pprev, chainparams);
+    chiapos::PruneLocalVdfStore(pindexDelete->pprev->nHeight, chiapos::MakeChallenge(pindexDelete->pprev, chainparams.GetConsensus()));
 
 #ifdef ENABLE_OMNICORE
     //! Omni Core: begin block disconnect notification
@@ -3137,6 +3418,7 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     // Update m_chain & related variables.
     m_chain.SetTip(pindexNew);
     UpdateTip(pindexNew, chainparams);
+    chiapos::PruneLocalVdfStore(pindexNew->nHeight, chiapos::MakeChallenge(pindexNew, chainparams.GetConsensus()));
 
     int64_t nTime6 = GetTimeMicros(); nTimePostConnect += nTime6 - nTime5; nTimeTotal += nTime6 - nTime1;
     LogPrint(BCLog::BENCH, "  - Connect postprocess: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime5) * MILLI, nTimePostConnect * MICRO, nTimePostConnect * MILLI / nBlocksTotal);
@@ -3703,6 +3985,8 @@ CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block)
     pindexNew->nSequenceId = 0;
     BlockMap::iterator mi = m_block_index.insert(std::make_pair(hash, pindexNew)).first;
     pindexNew->phashBlock = &((*mi).first);
+    if (!block.chiaposFields.vdfProof.vchProof.empty())
+        pindexNew->hashNextChallenge = chiapos::MakeChallenge(hash, block.chiaposFields.vdfProof.vchProof);
     BlockMap::iterator miPrev = m_block_index.find(block.hashPrevBlock);
     if (miPrev != m_block_index.end())
     {
@@ -3925,13 +4209,17 @@ static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state,
 
     if (pindexPrev->nHeight + 1 >= chainparams.GetConsensus().BHDIP009Height) {
         LogPrint(BCLog::POC, "%s: difficulty=%ld, k=%d\n", __func__, block.chiaposFields.nDifficulty, block.chiaposFields.posProof.nPlotK);
-        if (!chiapos::CheckBlockFields(block.chiaposFields, block.nTime, pindexPrev, state, chainparams.GetConsensus())) {
+        uint256 mixedQualityString;
+        bool fVerified = FindVerifiedHeaderProof(block.chiaposFields, pindexPrev->nHeight + 1, mixedQualityString);
+        if (!chiapos::CheckBlockFields(block.chiaposFields, block.nTime, pindexPrev, state, chainparams.GetConsensus(), fVerified ? &mixedQualityString : nullptr)) {
             return false;
         }
     } else {
         if (!chainparams.GetConsensus().BHDIP009SkipTestChainChecks) {
             LogPrint(BCLog::POC, "%s: checking burst fields...\n", __func__);
-            if (!poc::CheckProofOfCapacity(*pindexPrev, block, chainparams.GetConsensus())) {
+            uint64_t deadline;
+            bool fCalculated = FindCalculatedHeaderDeadline(hashBlock, deadline);
+            if (!poc::CheckProofOfCapacity(*pindexPrev, block, chainparams.GetConsensus(), fCalculated ? &deadline : nullptr)) {
                 return state.Invalid(ValidationInvalidReason::BLOCK_INVALID_HEADER, false, REJECT_INVALID, "bad-work", "check work failed");
             }
         }
@@ -4394,6 +4682,8 @@ bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidatio
     {
         // Don't hold cs_main too long time
         std::size_t beginCheckWorkIndex = (std::size_t) (nLastKnownBlockIndex + 1);
+        CHeaderProofsAheadRun proofsAheadRun;
+        VerifyHeaderProofsAhead(headers, beginCheckWorkIndex, chainparams, proofsAheadRun);
         for (std::size_t index = 0; index < headers.size();) {
             if (index > 0) { // Let's other thread hold cs_main
                 NotifyHeaderTip();
@@ -4956,6 +5246,7 @@ bool CChainState::LoadChainTip(const CChainParams& chainparams)
     }
     m_chain.SetTip(pindex);
     PruneBlockIndexCandidates();
+    chiapos::PruneLocalVdfStore(pindex->nHeight, chiapos::MakeChallenge(pindex, chainparams.GetConsensus()));
 
     tip = m_chain.Tip();
     LogPrintf("Loaded best chain: hashBestChain=%s height=%d date=%s progress=%f\n",
@@ -5318,6 +5609,73 @@ void CChainState::UnloadBlockIndex() {
     setBlockIndexCandidates.clear();
 }
 
+// The full chia fields of the block index, read back from the db when a caller needs more than the consensus fields
+namespace {
+Mutex cs_chiaposFieldsCache;
+//! The most recently read fields first
+std::list<std::pair<uint256, std::shared_ptr<const chiapos::CBlockFields>>> listChiaposFieldsCache GUARDED_BY(cs_chiaposFieldsCache);
+std::map<uint256, decltype(listChiaposFieldsCache)::iterator> mapChiaposFieldsCache GUARDED_BY(cs_chiaposFieldsCache);
+uint64_t nChiaposFieldsCacheHits GUARDED_BY(cs_chiaposFieldsCache) = 0;
+uint64_t nChiaposFieldsCacheMisses GUARDED_BY(cs_chiaposFieldsCache) = 0;
+std::atomic<size_t> nChiaposFieldsSaved{0};
+} // namespace
+
+std::shared_ptr<const chiapos::CBlockFields> ReadBlockChiaposFields(const uint256& hash)
+{
+    {
+        LOCK(cs_chiaposFieldsCache);
+        auto it = mapChiaposFieldsCache.find(hash);
+        if (it != mapChiaposFieldsCache.end()) {
+            listChiaposFieldsCache.splice(listChiaposFieldsCache.begin(), listChiaposFieldsCache, it->second);
+            ++nChiaposFieldsCacheHits;
+            return it->second->second;
+        }
+        ++nChiaposFieldsCacheMisses;
+    }
+    // The db is read out of the lock, a concurrent read of the same block is harmless
+    CDiskBlockIndex diskindex;
+    if (!pblocktree || !pblocktree->ReadBlockIndex(hash, diskindex) || diskindex.fullChiaposFields.IsNull())
+        return nullptr;
+    auto pfields = std::make_shared<const chiapos::CBlockFields>(std::move(diskindex.fullChiaposFields));
+    LOCK(cs_chiaposFieldsCache);
+    if (mapChiaposFieldsCache.count(hash) == 0) {
+        listChiaposFieldsCache.emplace_front(hash, pfields);
+        mapChiaposFieldsCache.emplace(hash, listChiaposFieldsCache.begin());
+        if (listChiaposFieldsCache.size() > CHIAPOS_FIELDS_CACHE_SIZE) {
+            mapChiaposFieldsCache.erase(listChiaposFieldsCache.back().first);
+            listChiaposFieldsCache.pop_back();
+        }
+    }
+    return pfields;
+}
+
+void NoteChiaposFieldsReleased(const chiapos::CBlockFields& fields)
+{
+    chiapos::CBlockIndexFields indexFields(fields);
+    nChiaposFieldsSaved += sizeof(chiapos::CBlockFields) + RecursiveDynamicUsage(fields) -
+                           sizeof(chiapos::CBlockIndexFields) - RecursiveDynamicUsage(indexFields);
+}
+
+void ReleaseBlockChiaposFields(CBlockIndex* pindex)
+{
+    NoteChiaposFieldsReleased(*pindex->pchiaposFields);
+    std::atomic_store(&pindex->pchiaposFields, std::shared_ptr<const chiapos::CBlockFields>());
+}
+
+BlockIndexMemoryStats GetBlockIndexMemoryStats()
+{
+    LOCK(cs_chiaposFieldsCache);
+    return BlockIndexMemoryStats{nChiaposFieldsSaved, listChiaposFieldsCache.size(), nChiaposFieldsCacheHits, nChiaposFieldsCacheMisses};
+}
+
+static void ClearChiaposFieldsCache()
+{
+    LOCK(cs_chiaposFieldsCache);
+    listChiaposFieldsCache.clear();
+    mapChiaposFieldsCache.clear();
+    nChiaposFieldsSaved = 0;
+}
+
 // May NOT be used after any connections are up as much
 // of the peer-processing logic assumes a consistent
 // block index state
@@ -5338,6 +5696,7 @@ void UnloadBlockIndex()
         warningcache[b].clear();
     }
     fHavePruned = false;
+    ClearChiaposFieldsCache();
 
     ::ChainstateActive().UnloadBlockIndex();
 }
@@ -5869,6 +6228,25 @@ bool DumpMempool(const CTxMemPool& pool)
     return true;
 }
 
+//! The metrics of a connected chia block, computed when the block was connected or read back from the db
+std::shared_ptr<const chiapos::CBlockMetrics> GetChiaBlockMetrics(const CBlockIndex* pindex, const Consensus::Params& consensusParams)
+{
+    AssertLockHeld(cs_main);
+    if (pindex == nullptr || pindex->nHeight < consensusParams.BHDIP009Height || !pindex->IsValid(BLOCK_VALID_SCRIPTS))
+        return nullptr;
+    if (pindex->pchiaMetrics)
+        return pindex->pchiaMetrics;
+    auto pmetrics = std::make_shared<chiapos::CBlockMetrics>();
+    if (pblocktree->ReadBlockMetrics(pindex->GetBlockHash(), *pmetrics))
+        return pmetrics;
+    // Connected before the metrics were stored
+    CBlock block;
+    if (IsBlockPruned(pindex) || !ReadBlockFromDisk(block, pindex, consensusParams))
+        return nullptr;
+    *pmetrics = chiapos::MakeBlockMetrics(pindex, block, consensusParams);
+    return pmetrics;
+}
+
 //! Guess how far we are in the verification process at the given block index
 //! require cs_main if pindex has not been validated yet (because nChainTx might be unset)
 double GuessVerificationProgress(const ChainTxData& data, const CBlockIndex *pindex) {
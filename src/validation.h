@@ -14,6 +14,7 @@
 #include <coins.h>
 #include <crypto/common.h> // for ReadLE64
 #include <fs.h>
+#include <poc/poc.h>
 #include <policy/feerate.h>
 #include <protocol.h> // For CMessageHeader::MessageStartChars
 #include <script/script_error.h>
@@ -113,8 +114,11 @@ static const int64_t DEFAULT_MAX_TIP_AGE = 24 * 60 * 60;
 /** Maximum age of our tip in seconds for us to be considered current for fee estimation */
 static const int64_t MAX_FEE_ESTIMATION_TIP_AGE = 3 * 60 * 60;
 
+/** Number of the chia block fields cached after they are read from the block index database */
+static const size_t CHIAPOS_FIELDS_CACHE_SIZE = 2048;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
 static const bool DEFAULT_TXINDEX = false;
+static const bool DEFAULT_PLEDGEINDEX = false;
 static const char* const DEFAULT_BLOCKFILTERINDEX = "0";
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 /** Default for -persistmempool */
@@ -253,6 +257,8 @@ bool LoadBlockIndex(const CChainParams& chainparams) EXCLUSIVE_LOCKS_REQUIRED(cs
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck(int worker_num);
+/** Run an instance of the header proof checking thread */
+void ThreadHeaderProofCheck(int worker_num);
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
 bool GetTransaction(const uint256& hash, CTransactionRef& tx, const Consensus::Params& params, uint256& hashBlock, const CBlockIndex* const blockIndex = nullptr);
 /**
@@ -279,6 +285,27 @@ int GetFullMortgageFundRoyaltyRatio(int nHeight, const Consensus::Params& consen
 int GetLowMortgageFundRoyaltyRatio(int nHeight, const Consensus::Params& consensusParams) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 CAmount GetBlockAccumulateSubsidy(const CBlockIndex* pindexPrev, const Consensus::Params& consensusParams) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/** The metrics of a connected chia block, read from the block index database or computed from the block for the blocks connected by older versions. Null if unavailable. */
+std::shared_ptr<const chiapos::CBlockMetrics> GetChiaBlockMetrics(const CBlockIndex* pindex, const Consensus::Params& consensusParams) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/** All the chia fields of a block read from the block index database, the recently read ones are cached. Null if unavailable. */
+std::shared_ptr<const chiapos::CBlockFields> ReadBlockChiaposFields(const uint256& hash);
+
+/** Count the memory of the chia fields which are left out of a block index */
+void NoteChiaposFieldsReleased(const chiapos::CBlockFields& fields);
+
+/** Leave the chia fields of a written block index out of memory, they are read from the block index database from now on */
+void ReleaseBlockChiaposFields(CBlockIndex* pindex);
+
+struct BlockIndexMemoryStats {
+    size_t nChiaposFieldsSaved;  //!< Bytes of the chia fields left out of the block index
+    size_t nCacheEntries;        //!< Number of the chia fields in the cache
+    uint64_t nCacheHits;
+    uint64_t nCacheMisses;
+};
+
+BlockIndexMemoryStats GetBlockIndexMemoryStats();
+
 /** Guess verification progress (as a fraction between 0.0=genesis and 1.0=current tip). */
 double GuessVerificationProgress(const ChainTxData& data, const CBlockIndex* pindex);
 
@@ -387,6 +414,39 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
+/**
+ * Closure representing the verification of the PoS and VDF proofs of one chia header.
+ * The proofs do not depend on the previous block, so the headers of a run are verified
+ * on the worker threads, the verified proofs are memoized by their hash for the header acceptance.
+ */
+class CHeaderProofCheck
+{
+private:
+    int nTargetHeight;
+    const CBlockHeader *pheader;
+    const Consensus::Params *pparams;
+    //! The burst headers of a deadline batch and their nonces, the plots are hashed in SIMD lanes
+    std::vector<uint256> vHashes;
+    std::vector<poc::PlotterNonce> vNonces;
+
+public:
+    CHeaderProofCheck(): nTargetHeight(0), pheader(nullptr), pparams(nullptr) {}
+    CHeaderProofCheck(int nTargetHeightIn, const CBlockHeader& headerIn, const Consensus::Params& paramsIn) :
+        nTargetHeight(nTargetHeightIn), pheader(&headerIn), pparams(&paramsIn) { }
+    CHeaderProofCheck(std::vector<uint256> vHashesIn, std::vector<poc::PlotterNonce> vNoncesIn, const Consensus::Params& paramsIn) :
+        nTargetHeight(0), pheader(nullptr), pparams(&paramsIn), vHashes(std::move(vHashesIn)), vNonces(std::move(vNoncesIn)) { }
+
+    bool operator()();
+
+    void swap(CHeaderProofCheck &check) {
+        std::swap(nTargetHeight, check.nTargetHeight);
+        std::swap(pheader, check.pheader);
+        std::swap(pparams, check.pparams);
+        vHashes.swap(check.vHashes);
+        vNonces.swap(check.vNonces);
+    }
+};
+
 /** Initializes the script-execution cache */
 void InitScriptExecutionCache();
 
@@ -404,6 +464,24 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex);
 /** Context-independent validity checks */
 bool CheckBlock(const CBlock& block, CValidationState& state, const CChainParams& chainparams, bool fCheckWork = true, bool fCheckMerkleRoot = true);
 
+/**
+ * Verify the PoS and VDF proofs of a chia block produced locally, before the block is assembled.
+ * The verified proofs are memoized by their hash, so the validation of the released block doesn't verify them again.
+ */
+bool VerifyLocalChiaProofs(const chiapos::CBlockFields& fields, int nTargetHeight, const Consensus::Params& params, CValidationState& state) LOCKS_EXCLUDED(cs_main);
+
+/** Memoize the verified proofs of a chia header for the target height, replacing the entry of the same proofs */
+void MemoizeVerifiedHeaderProof(const chiapos::CBlockFields& fields, int nTargetHeight, const uint256& mixedQualityString);
+
+/**
+ * Find the memoized proofs of a header, return false when they are not verified ahead for the height.
+ * The entry is kept, the header is checked again when the block is accepted.
+ */
+bool FindVerifiedHeaderProof(const chiapos::CBlockFields& fields, int nTargetHeight, uint256& mixedQualityString);
+
+/** Drop the memoized proofs below the height, they can't be accepted any more */
+void PruneVerifiedHeaderProofs(int nHeight);
+
 /** Check a block is completely valid from start to finish (only works on top of our current best block) */
 bool TestBlockValidity(CValidationState& state, const CChainParams& chainparams, const CBlock& block, CBlockIndex* pindexPrev, bool fCheckWork = true, bool fCheckMerkleRoot = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
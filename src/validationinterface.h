@@ -23,6 +23,9 @@ class uint256;
 class CScheduler;
 class CTxMemPool;
 enum class MemPoolRemovalReason;
+namespace chiapos {
+class CVdfProof;
+}
 
 // These functions dispatch to one or all registered wallets
 
@@ -143,6 +146,13 @@ protected:
      * Notifies listeners that a block which builds directly on our current tip
      * has been received and connected to the headers tree, though not validated yet */
     virtual void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) {};
+    /**
+     * Notifies listeners of a vdf proof which is added to the local vdf store,
+     * it is submitted by a timelord or relayed by a peer.
+     *
+     * Called on a background thread.
+     */
+    virtual void NewVdfProof(const std::shared_ptr<const chiapos::CVdfProof>& vdfProof) {}
     friend void ::RegisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
@@ -182,6 +192,7 @@ public:
     void ChainStateFlushed(const CBlockLocator &);
     void BlockChecked(const CBlock&, const CValidationState&);
     void NewPoWValidBlock(const CBlockIndex *, const std::shared_ptr<const CBlock>&);
+    void NewVdfProof(const std::shared_ptr<const chiapos::CVdfProof> &);
 };
 
 CMainSignals& GetMainSignals();
@@ -5435,15 +5435,16 @@ static UniValue listpledges(const JSONRPCRequest& request)
         return NullUniValue;
     }
 
-    if (request.fHelp || request.params.size() > 4)
+    if (request.fHelp || request.params.size() > 5)
         throw std::runtime_error(
-            "listpledges (count skip include_watchonly include_invalid)\n"
+            "listpledges (count skip include_watchonly include_invalid address)\n"
             "\nReturns up to point transactions.\n"
             "\nArguments:\n"
             "1. count               (numeric, optional, default=10) The number of transactions to return\n"
             "2. skip                (numeric, optional, default=0) The number of transactions to skip\n"
             "3. include_watchonly   (bool, optional, default=false) Include transactions to watch-only addresses (see 'importaddress')\n"
             "4. include_invalid     (bool, optional, default=false) Include invalid coin\n"
+            "5. address             (string, optional) Only the point transactions from or to the address\n"
             "\nResult:\n"
             "[\n"
             "  {\n"
@@ -5484,6 +5485,13 @@ static UniValue listpledges(const JSONRPCRequest& request)
     bool fIncludeInvalid = false;
     if(!request.params[3].isNull())
         fIncludeInvalid = request.params[3].get_bool();
+    std::unique_ptr<CAccountID> pAccountID;
+    if (!request.params[4].isNull()) {
+        CTxDestination dest = DecodeDestination(request.params[4].get_str());
+        if (!IsValidDestination(dest))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+        pAccountID = MakeUnique<CAccountID>(ExtractAccountID(dest));
+    }
 
     if (nCount < 0)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative count");
@@ -5497,7 +5505,7 @@ static UniValue listpledges(const JSONRPCRequest& request)
     if (nCount == 0 || nFrom > (int)pwallet->mapWallet.size())
         return ret;
 
-    auto mapTxPledge = RetrievePledgeMap(pwallet, fIncludeInvalid, filter);
+    auto mapTxPledge = RetrievePledgeMap(pwallet, fIncludeInvalid, filter, pAccountID.get());
 
     if (nFrom >= (int)mapTxPledge.size())
         return ret;
@@ -5625,7 +5633,7 @@ static const CRPCCommand commands[] =
     { "wallet",             "sendpledgetoaddress",              &sendpledgetoaddress,           {"address","amount","comment","comment_to","subtractfeefromamount","replaceable","conf_target","estimate_mode"} },
     {"wallet",              "retargetpledge",                   &retargetpledge, {"txid", "address"} },
     { "wallet",             "withdrawpledge",                   &withdrawpledge,                {"txid","comment","comment_to","replaceable","conf_target","estimate_mode"} },
-    { "wallet",             "listpledges",                      &listpledges,                   {"count","skip","include_watchonly","include_invalid"} },
+    { "wallet",             "listpledges",                      &listpledges,                   {"count","skip","include_watchonly","include_invalid","address"} },
 };
 // clang-format on
 
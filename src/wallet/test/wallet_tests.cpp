@@ -515,4 +515,164 @@ BOOST_FIXTURE_TEST_CASE(dummy_input_size_test, TestChain100Setup)
     BOOST_CHECK_EQUAL(CalculateNestedKeyhashInputSize(true), DUMMY_NESTED_P2WPKH_INPUT_SIZE);
 }
 
+BOOST_AUTO_TEST_CASE(wallet_pledge_ledger_entry)
+{
+    uint160 senderHash, receiverHash;
+    senderHash.begin()[0] = 1;
+    receiverHash.begin()[0] = 2;
+
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::UNIFORM_VERSION;
+    mtx.vin.resize(1);
+    mtx.vout.emplace_back(PROTOCOL_POINT_AMOUNT_MIN, GetScriptForDestination(ScriptHash(senderHash)));
+    mtx.vout.emplace_back(0, GetPointRetargetScriptForDestination(ScriptHash(receiverHash), DATACARRIER_TYPE_CHIA_POINT_TERM_1, 100));
+
+    CWalletPledge pledge;
+    BOOST_CHECK(MakeWalletPledge(CTransaction(mtx), pledge));
+    BOOST_CHECK(pledge.senderID == CAccountID(senderHash));
+    BOOST_CHECK(pledge.receiverID == CAccountID(receiverHash));
+    BOOST_CHECK_EQUAL(pledge.payloadType, DATACARRIER_TYPE_CHIA_POINT_RETARGET);
+    BOOST_CHECK_EQUAL(pledge.pointType, DATACARRIER_TYPE_CHIA_POINT_TERM_1);
+    BOOST_CHECK_EQUAL(pledge.nPointHeight, 100);
+    BOOST_CHECK(pledge.revokedByTxid.IsNull());
+    BOOST_CHECK(!pledge.fSpent);
+
+    // The ledger entry is written to the wallet database
+    pledge.revokedByTxid = mtx.GetHash();
+    pledge.fSpent = true;
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << pledge;
+    CWalletPledge pledgeRead;
+    ss >> pledgeRead;
+    BOOST_CHECK(pledgeRead.receiverID == pledge.receiverID);
+    BOOST_CHECK_EQUAL(pledgeRead.payloadType, pledge.payloadType);
+    BOOST_CHECK_EQUAL(pledgeRead.pointType, pledge.pointType);
+    BOOST_CHECK(pledgeRead.revokedByTxid == pledge.revokedByTxid);
+    BOOST_CHECK(pledgeRead.fSpent);
+
+    // Not a pledge tx
+    mtx.vout[1].scriptPubKey = GetTextScript("text");
+    BOOST_CHECK(!MakeWalletPledge(CTransaction(mtx), pledge));
+}
+
+static CMutableTransaction MakePledgeLedgerTx(const COutPoint& prevout, const CScript& scriptPubKey, const CScript& scriptPayload)
+{
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::UNIFORM_VERSION;
+    mtx.vin.emplace_back(prevout);
+    mtx.vout.emplace_back(PROTOCOL_POINT_AMOUNT_MIN, scriptPubKey);
+    if (!scriptPayload.empty()) {
+        mtx.vout.emplace_back(0, scriptPayload);
+    }
+    return mtx;
+}
+
+static size_t CountLedgerPledges(CWallet& wallet, bool fIncludeInvalid, bool fExpectValid)
+{
+    TxPledgeMap mapTxPledge = RetrievePledgeMap(&wallet, fIncludeInvalid, ISMINE_ALL);
+    for (const auto& entry : mapTxPledge) {
+        BOOST_CHECK_EQUAL(entry.second.fValid, fExpectValid);
+    }
+    return mapTxPledge.size();
+}
+
+BOOST_AUTO_TEST_CASE(wallet_pledge_ledger)
+{
+    uint160 senderHash, receiverHash;
+    uint256 prevHash;
+    senderHash.begin()[0] = 1;
+    receiverHash.begin()[0] = 2;
+    prevHash.begin()[0] = 3;
+    CScript senderScript = GetScriptForDestination(ScriptHash(senderHash));
+    {
+        LOCK(m_wallet.cs_wallet);
+        m_wallet.AddWatchOnly(senderScript, 0);
+    }
+
+    // The pledge tx is added to the ledger and indexed by both accounts
+    CMutableTransaction pledgeTx = MakePledgeLedgerTx(COutPoint(prevHash, 0), senderScript,
+            GetPointScriptForDestination(ScriptHash(receiverHash), DATACARRIER_TYPE_CHIA_POINT_TERM_1));
+    const uint256 pledgeHash = pledgeTx.GetHash();
+    CWalletTx wtxPledge(&m_wallet, MakeTransactionRef(pledgeTx));
+    BOOST_CHECK(m_wallet.AddToWallet(wtxPledge));
+    {
+        LOCK(m_wallet.cs_wallet);
+        BOOST_CHECK_EQUAL(m_wallet.mapPledges.count(pledgeHash), 1U);
+        BOOST_CHECK_EQUAL(m_wallet.mapPledgesByAccount.count(CAccountID(senderHash)), 1U);
+        BOOST_CHECK_EQUAL(m_wallet.mapPledgesByAccount.count(CAccountID(receiverHash)), 1U);
+    }
+    CAccountID receiverID(receiverHash);
+    BOOST_CHECK_EQUAL(RetrievePledgeMap(&m_wallet, true, ISMINE_ALL, &receiverID).size(), 1U);
+
+    // A pledge is valid once it is in the active chain
+    BOOST_CHECK_EQUAL(CountLedgerPledges(m_wallet, false, true), 0U);
+    BOOST_CHECK_EQUAL(CountLedgerPledges(m_wallet, true, false), 1U);
+    wtxPledge.SetConf(CWalletTx::Status::CONFIRMED, ::ChainActive().Genesis()->GetBlockHash(), 1);
+    BOOST_CHECK(m_wallet.AddToWallet(wtxPledge));
+    BOOST_CHECK_EQUAL(CountLedgerPledges(m_wallet, false, true), 1U);
+
+    // The withdraw tx of the wallet revokes the pledge
+    CMutableTransaction withdrawTx = MakePledgeLedgerTx(COutPoint(pledgeHash, 0), senderScript, CScript());
+    BOOST_CHECK(m_wallet.AddToWallet(CWalletTx(&m_wallet, MakeTransactionRef(withdrawTx))));
+    {
+        LOCK(m_wallet.cs_wallet);
+        BOOST_CHECK(m_wallet.mapPledges.at(pledgeHash).revokedByTxid == withdrawTx.GetHash());
+        BOOST_CHECK(!m_wallet.mapPledges.at(pledgeHash).fSpent);
+    }
+
+    // The pledge is spent while the withdraw tx is in a block, and unspent again when the block is disconnected
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(withdrawTx));
+    m_wallet.BlockConnected(block, {});
+    {
+        LOCK(m_wallet.cs_wallet);
+        BOOST_CHECK(m_wallet.mapPledges.at(pledgeHash).fSpent);
+    }
+    BOOST_CHECK_EQUAL(CountLedgerPledges(m_wallet, false, true), 0U);
+    BOOST_CHECK_EQUAL(CountLedgerPledges(m_wallet, true, false), 1U);
+    m_wallet.BlockDisconnected(block);
+    {
+        LOCK(m_wallet.cs_wallet);
+        BOOST_CHECK(!m_wallet.mapPledges.at(pledgeHash).fSpent);
+    }
+    BOOST_CHECK_EQUAL(CountLedgerPledges(m_wallet, false, true), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(wallet_pledge_ledger_upgrade)
+{
+    uint160 senderHash, receiverHash;
+    uint256 prevHash;
+    senderHash.begin()[0] = 1;
+    receiverHash.begin()[0] = 2;
+    prevHash.begin()[0] = 3;
+    CScript senderScript = GetScriptForDestination(ScriptHash(senderHash));
+    CMutableTransaction pledgeTx = MakePledgeLedgerTx(COutPoint(prevHash, 0), senderScript,
+            GetPointScriptForDestination(ScriptHash(receiverHash), DATACARRIER_TYPE_CHIA_POINT_TERM_1));
+    CMutableTransaction withdrawTx = MakePledgeLedgerTx(COutPoint(pledgeTx.GetHash(), 0), senderScript, CScript());
+
+    // A wallet written before the pledge ledger holds the txs without the ledger entries
+    CWallet wallet(m_chain.get(), WalletLocation(), WalletDatabase::CreateMock());
+    {
+        WalletBatch batch(wallet.GetDBHandle());
+        CWalletTx wtxPledge(&wallet, MakeTransactionRef(pledgeTx));
+        wtxPledge.mapValue["type"] = "pledge";
+        BOOST_CHECK(batch.WriteTx(wtxPledge));
+        CWalletTx wtxWithdraw(&wallet, MakeTransactionRef(withdrawTx));
+        wtxWithdraw.mapValue["type"] = "withdrawpledge";
+        wtxWithdraw.mapValue["relevant_txid"] = pledgeTx.GetHash().GetHex();
+        BOOST_CHECK(batch.WriteTx(wtxWithdraw));
+    }
+
+    // The ledger is built on load
+    bool fFirstRun;
+    BOOST_CHECK(wallet.LoadWallet(fFirstRun) == DBErrors::LOAD_OK);
+    LOCK(wallet.cs_wallet);
+    BOOST_CHECK_EQUAL(wallet.mapPledges.size(), 1U);
+    const CWalletPledge& pledge = wallet.mapPledges.at(pledgeTx.GetHash());
+    BOOST_CHECK(pledge.receiverID == CAccountID(receiverHash));
+    BOOST_CHECK(pledge.revokedByTxid == withdrawTx.GetHash());
+    BOOST_CHECK(!pledge.fSpent);
+    BOOST_CHECK_EQUAL(wallet.mapPledgesByAccount.count(CAccountID(senderHash)), 1U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,84 +2,95 @@
 
 #include <wallet/wallet.h>
 
-TxPledgeMap RetrievePledgeMap(CWallet* pwallet, bool fIncludeInvalid, isminefilter filter) {
-    std::set<uint256> revokedPledgeTxs;
+bool MakeWalletPledge(CTransaction const& tx, CWalletPledge& pledge) {
+    if (!tx.IsUniform()) {
+        return false;
+    }
+    // The point payloads don't depend on the height
+    CDatacarrierPayloadRef payload = ExtractTransactionDatacarrier(
+            tx, 0,
+            DatacarrierTypes{DATACARRIER_TYPE_POINT, DATACARRIER_TYPE_CHIA_POINT,
+                             DATACARRIER_TYPE_CHIA_POINT_TERM_1, DATACARRIER_TYPE_CHIA_POINT_TERM_2,
+                             DATACARRIER_TYPE_CHIA_POINT_TERM_3, DATACARRIER_TYPE_CHIA_POINT_RETARGET});
+    if (!payload) {
+        return false;
+    }
+    assert(payload->type == DATACARRIER_TYPE_POINT || DatacarrierTypeIsChiaPoint(payload->type) ||
+           payload->type == DATACARRIER_TYPE_CHIA_POINT_RETARGET);
+    pledge = CWalletPledge();
+    pledge.senderID = ExtractAccountID(tx.vout[0].scriptPubKey);
+    pledge.payloadType = payload->type;
+    if (payload->type == DATACARRIER_TYPE_CHIA_POINT_RETARGET) {
+        auto retargetPayload = PointRetargetPayload::As(payload);
+        pledge.receiverID = retargetPayload->GetReceiverID();
+        pledge.pointType = retargetPayload->GetPointType();
+        pledge.nPointHeight = retargetPayload->GetPointHeight();
+    } else {
+        pledge.receiverID = PointPayload::As(payload)->GetReceiverID();
+    }
+    return true;
+}
+
+static void RetrievePledge(CWallet* pwallet, interfaces::Chain::Lock& locked_chain, uint256 const& txid, CWalletPledge const& pledge,
+                           bool fIncludeInvalid, isminefilter filter, TxPledgeMap& mapTxPledge) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet) {
+    auto itWtx = pwallet->mapWallet.find(txid);
+    if (itWtx == std::end(pwallet->mapWallet)) {
+        return;
+    }
+    CWalletTx const& wtx = itWtx->second;
+    if (!locked_chain.checkFinalTx(*wtx.tx)) {
+        return;
+    }
+    // The pledge coin is in the utxo set of the active chain
+    bool fValid = !pledge.fSpent && wtx.GetDepthInMainChain(locked_chain) > 0;
+    if (!fIncludeInvalid && !fValid) {
+        return;
+    }
+    CTxDestination fromDest = ExtractDestination(wtx.tx->vout[0].scriptPubKey);
+    CTxDestination toDest = ScriptHash(pledge.receiverID);
+    isminetype sendIsmine = ::IsMine(*pwallet, fromDest);
+    isminetype receiveIsmine = ::IsMine(*pwallet, toDest);
+    bool fSendIsmine = (sendIsmine & filter) != 0;
+    bool fReceiveIsmine = (receiveIsmine & filter) != 0;
+    if (!fSendIsmine && !fReceiveIsmine) {
+        return;
+    }
+    TxPledge txPledgeRent;
+    txPledgeRent.txid = txid;
+    txPledgeRent.fromDest = fromDest;
+    txPledgeRent.toDest = toDest;
+    txPledgeRent.category = (fSendIsmine && fReceiveIsmine) ? "self" : (fSendIsmine ? "loan" : "debit");
+    txPledgeRent.payloadType = pledge.payloadType;
+    if (pledge.payloadType == DATACARRIER_TYPE_CHIA_POINT_RETARGET) {
+        txPledgeRent.pointType = pledge.pointType;
+        txPledgeRent.nPointHeight = pledge.nPointHeight;
+    }
+    txPledgeRent.fValid = fValid;
+    txPledgeRent.fFromWatchonly = (sendIsmine & ISMINE_WATCH_ONLY) != 0;
+    txPledgeRent.fToWatchonly = (receiveIsmine & ISMINE_WATCH_ONLY) != 0;
+    txPledgeRent.fChia = DatacarrierTypeIsChiaPoint(pledge.payloadType) ||
+                         pledge.payloadType == DATACARRIER_TYPE_CHIA_POINT_RETARGET;
+    txPledgeRent.fRevoked = !pledge.revokedByTxid.IsNull();
+    txPledgeRent.nBlockHeight = locked_chain.getBlockHeight(wtx.GetBlockHash()).get_value_or(0);
+    mapTxPledge.insert(std::pair<int64_t, TxPledge>(wtx.nTimeReceived, txPledgeRent));
+}
+
+TxPledgeMap RetrievePledgeMap(CWallet* pwallet, bool fIncludeInvalid, isminefilter filter, CAccountID const* pAccountID) {
     TxPledgeMap mapTxPledge;
     auto locked_chain = pwallet->chain().lock();
-    for (std::pair<const uint256, CWalletTx> const& pairWtx : pwallet->mapWallet) {
-        CWalletTx const& wtx = pairWtx.second;
-        if (!locked_chain->checkFinalTx(*wtx.tx)) {
-            continue;
+    LOCK(pwallet->cs_wallet);
+    if (pAccountID == nullptr) {
+        for (auto const& pledgePair : pwallet->mapPledges) {
+            RetrievePledge(pwallet, *locked_chain, pledgePair.first, pledgePair.second, fIncludeInvalid, filter, mapTxPledge);
         }
-        auto it = wtx.mapValue.find("type");
-        if (it == std::end(wtx.mapValue)) {
-            continue;
-        }
-        std::string type = it->second;
-        if (type == "withdrawpledge") {
-            // need to find it out and remove the related tx
-            revokedPledgeTxs.insert(uint256S(wtx.mapValue.find("relevant_txid")->second));
-            continue;
-        } else if (type == "pledge" || type == "retarget") {
-            // Extract tx
-            CDatacarrierPayloadRef payload = ExtractTransactionDatacarrier(
-                    *wtx.tx, locked_chain->getBlockHeight(wtx.GetBlockHash()).get_value_or(0),
-                    DatacarrierTypes{DATACARRIER_TYPE_POINT, DATACARRIER_TYPE_CHIA_POINT,
-                                     DATACARRIER_TYPE_CHIA_POINT_TERM_1, DATACARRIER_TYPE_CHIA_POINT_TERM_2,
-                                     DATACARRIER_TYPE_CHIA_POINT_TERM_3, DATACARRIER_TYPE_CHIA_POINT_RETARGET});
-            if (!payload) {
-                continue;
-            }
-            assert(payload->type == DATACARRIER_TYPE_POINT || DatacarrierTypeIsChiaPoint(payload->type) ||
-                   payload->type == DATACARRIER_TYPE_CHIA_POINT_RETARGET);
-            bool fValid = pwallet->chain().haveCoin(COutPoint(wtx.GetHash(), 0));
-            if (!fIncludeInvalid && !fValid) {
-                continue;
-            }
-            CTxDestination fromDest = ExtractDestination(wtx.tx->vout[0].scriptPubKey);
-            CTxDestination toDest;
-            if (payload->type == DATACARRIER_TYPE_CHIA_POINT_RETARGET) {
-                toDest = ScriptHash(PointRetargetPayload::As(payload)->GetReceiverID());
-            } else {
-                toDest = ScriptHash(PointPayload::As(payload)->GetReceiverID());
-            }
-            isminetype sendIsmine = ::IsMine(*pwallet, fromDest);
-            isminetype receiveIsmine = ::IsMine(*pwallet, toDest);
-            bool fSendIsmine = (sendIsmine & filter) != 0;
-            bool fReceiveIsmine = (receiveIsmine & filter) != 0;
-            if (!fSendIsmine && !fReceiveIsmine) {
-                continue;
-            }
-            TxPledge txPledgeRent;
-            txPledgeRent.txid = wtx.GetHash();
-            txPledgeRent.fromDest = fromDest;
-            txPledgeRent.toDest = toDest;
-            txPledgeRent.category = (fSendIsmine && fReceiveIsmine) ? "self" : (fSendIsmine ? "loan" : "debit");
-            txPledgeRent.payloadType = payload->type;
-            if (payload->type == DATACARRIER_TYPE_CHIA_POINT_RETARGET) {
-                auto retargetPayload = PointRetargetPayload::As(payload);
-                txPledgeRent.pointType = retargetPayload->GetPointType();
-                txPledgeRent.nPointHeight = retargetPayload->GetPointHeight();
-            }
-            txPledgeRent.fValid = fValid;
-            txPledgeRent.fFromWatchonly = (sendIsmine & ISMINE_WATCH_ONLY) != 0;
-            txPledgeRent.fToWatchonly = (receiveIsmine & ISMINE_WATCH_ONLY) != 0;
-            txPledgeRent.fChia = DatacarrierTypeIsChiaPoint(payload->type) ||
-                                 payload->type == DATACARRIER_TYPE_CHIA_POINT_RETARGET;
-            txPledgeRent.nBlockHeight = locked_chain->getBlockHeight(wtx.GetBlockHash()).get_value_or(0);
-            mapTxPledge.insert(std::pair<int64_t, TxPledge>(wtx.nTimeReceived, txPledgeRent));
-        }
-    }
-    // remove revoked txs
-    for (auto const& txid : revokedPledgeTxs) {
-        auto it = std::find_if(std::begin(mapTxPledge), std::end(mapTxPledge),
-                               [&txid](std::pair<int64_t, TxPledge> const& tx) { return tx.second.txid == txid; });
-        if (it != std::end(mapTxPledge)) {
-            // found
-            it->second.fRevoked = true;
+    } else {
+        auto range = pwallet->mapPledgesByAccount.equal_range(*pAccountID);
+        for (auto it = range.first; it != range.second; ++it) {
+            auto itPledge = pwallet->mapPledges.find(it->second);
+            assert(itPledge != std::end(pwallet->mapPledges));
+            RetrievePledge(pwallet, *locked_chain, itPledge->first, itPledge->second, fIncludeInvalid, filter, mapTxPledge);
         }
     }
-
     return mapTxPledge;
 }
 
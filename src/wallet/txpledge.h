@@ -1,6 +1,7 @@
 #ifndef BITCOIN_WALLET_TXPLEDGE_H
 #define BITCOIN_WALLET_TXPLEDGE_H
 
+#include <serialize.h>
 #include <uint256.h>
 
 #include <script/standard.h>
@@ -10,6 +11,39 @@
 
 class CWallet;
 
+/** A pledge or retarget tx of the wallet, kept in the pledge ledger of the wallet */
+struct CWalletPledge {
+    CAccountID senderID;
+    CAccountID receiverID;
+    DatacarrierType payloadType{DATACARRIER_TYPE_UNKNOWN};
+    //! The point type and the point height of a retarget
+    DatacarrierType pointType{DATACARRIER_TYPE_UNKNOWN};
+    int nPointHeight{0};
+    //! The withdraw tx of the wallet
+    uint256 revokedByTxid;
+    //! The pledge coin is spent by a tx of the active chain
+    bool fSpent{false};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(senderID);
+        READWRITE(receiverID);
+        uint32_t nPayloadType = payloadType, nPointType = pointType;
+        READWRITE(nPayloadType);
+        READWRITE(nPointType);
+        payloadType = static_cast<DatacarrierType>(nPayloadType);
+        pointType = static_cast<DatacarrierType>(nPointType);
+        READWRITE(nPointHeight);
+        READWRITE(revokedByTxid);
+        READWRITE(fSpent);
+    }
+};
+
+/** Create the ledger entry of a pledge or retarget tx, returns false for other txs */
+bool MakeWalletPledge(CTransaction const& tx, CWalletPledge& pledge);
+
 struct TxPledge {
     uint256 txid;
     CTxDestination fromDest;
@@ -28,7 +62,8 @@ struct TxPledge {
 
 using TxPledgeMap = std::multimap<int64_t, TxPledge>;
 
-TxPledgeMap RetrievePledgeMap(CWallet* pwallet, bool fIncludeInvalid, isminefilter filter);
+/** Read the pledges from the pledge ledger, only those sent or received by the account when pAccountID isn't null */
+TxPledgeMap RetrievePledgeMap(CWallet* pwallet, bool fIncludeInvalid, isminefilter filter, CAccountID const* pAccountID = nullptr);
 
 CAmount CalcActualAmount(CAmount pledgeAmount, int pledgeOnHeight, PledgeTerm const& term, PledgeTerm const& fallbackTerm, int chainHeight);
 
@@ -1293,6 +1293,9 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
         if (!batch.WriteTx(wtx))
             return false;
 
+    if (fInsertedNew || fUpdated)
+        AddToPledges(wtx, batch);
+
     // Break debit/credit balance caches:
     wtx.MarkDirty();
 
@@ -1346,6 +1349,84 @@ void CWallet::LoadToWallet(CWalletTx& wtxIn)
     }
 }
 
+void CWallet::LoadPledge(const uint256& txid, const CWalletPledge& pledge)
+{
+    auto ins = mapPledges.emplace(txid, pledge);
+    if (!ins.second) {
+        return;
+    }
+    mapPledgesByAccount.emplace(pledge.senderID, txid);
+    if (pledge.receiverID != pledge.senderID) {
+        mapPledgesByAccount.emplace(pledge.receiverID, txid);
+    }
+}
+
+void CWallet::AddToPledges(const CWalletTx& wtx, WalletBatch& batch)
+{
+    auto itType = wtx.mapValue.find("type");
+    if (itType == wtx.mapValue.end()) {
+        return;
+    }
+    if (itType->second == "withdrawpledge") {
+        auto itPledge = mapPledges.find(uint256S(wtx.mapValue.at("relevant_txid")));
+        if (itPledge != mapPledges.end() && itPledge->second.revokedByTxid != wtx.GetHash()) {
+            itPledge->second.revokedByTxid = wtx.GetHash();
+            batch.WritePledge(itPledge->first, itPledge->second);
+        }
+    } else if ((itType->second == "pledge" || itType->second == "retarget") && !mapPledges.count(wtx.GetHash())) {
+        CWalletPledge pledge;
+        if (MakeWalletPledge(*wtx.tx, pledge)) {
+            LoadPledge(wtx.GetHash(), pledge);
+            batch.WritePledge(wtx.GetHash(), pledge);
+        }
+    }
+}
+
+void CWallet::SyncPledgeSpends(const CTransaction& tx, bool fConfirmed)
+{
+    if (mapPledges.empty() || tx.IsCoinBase()) {
+        return;
+    }
+    for (const CTxIn& txin : tx.vin) {
+        if (txin.prevout.n != 0) {
+            continue;
+        }
+        auto itPledge = mapPledges.find(txin.prevout.hash);
+        if (itPledge == mapPledges.end() || itPledge->second.fSpent == fConfirmed) {
+            continue;
+        }
+        // The pledge coin is unspent again when the spending tx leaves the active chain
+        itPledge->second.fSpent = fConfirmed;
+        WalletBatch(*database, "r+", false).WritePledge(itPledge->first, itPledge->second);
+    }
+}
+
+void CWallet::UpgradePledges(interfaces::Chain::Lock& locked_chain)
+{
+    WalletBatch batch(*database, "r+", false);
+    std::vector<const CWalletTx*> vWithdrawTxs;
+    for (const auto& pairWtx : mapWallet) {
+        const CWalletTx& wtx = pairWtx.second;
+        auto itType = wtx.mapValue.find("type");
+        if (itType == wtx.mapValue.end() || mapPledges.count(wtx.GetHash())) {
+            continue;
+        }
+        if (itType->second == "withdrawpledge") {
+            vWithdrawTxs.push_back(&wtx);
+        } else if (itType->second == "pledge" || itType->second == "retarget") {
+            CWalletPledge pledge;
+            if (MakeWalletPledge(*wtx.tx, pledge)) {
+                pledge.fSpent = wtx.GetDepthInMainChain(locked_chain) > 0 && !chain().haveCoin(COutPoint(wtx.GetHash(), 0));
+                LoadPledge(wtx.GetHash(), pledge);
+                batch.WritePledge(wtx.GetHash(), pledge);
+            }
+        }
+    }
+    for (const CWalletTx* pwtx : vWithdrawTxs) {
+        AddToPledges(*pwtx, batch);
+    }
+}
+
 bool CWallet::AddToWalletIfInvolvingMe(const CTransactionRef& ptx, CWalletTx::Status status, const uint256& block_hash, int posInBlock, bool fUpdate)
 {
     const CTransaction& tx = *ptx;
@@ -1509,6 +1590,8 @@ void CWallet::MarkConflicted(const uint256& hashBlock, const uint256& hashTx)
 
 void CWallet::SyncTransaction(const CTransactionRef& ptx, CWalletTx::Status status, const uint256& block_hash, int posInBlock, bool update_tx)
 {
+    SyncPledgeSpends(*ptx, !block_hash.IsNull());
+
     if (!AddToWalletIfInvolvingMe(ptx, status, block_hash, posInBlock, update_tx))
         return; // Not one of ours
 
@@ -3794,6 +3877,10 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
     if (nLoadWalletRet != DBErrors::LOAD_OK)
         return nLoadWalletRet;
 
+    if (locked_chain) {
+        UpgradePledges(*locked_chain);
+    }
+
     return DBErrors::LOAD_OK;
 }
 
@@ -3805,6 +3892,16 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
         const auto& it = mapWallet.find(hash);
         wtxOrdered.erase(it->second.m_it_wtxOrdered);
         mapWallet.erase(it);
+        auto itPledge = mapPledges.find(hash);
+        if (itPledge != mapPledges.end()) {
+            for (const CAccountID& accountID : {itPledge->second.senderID, itPledge->second.receiverID}) {
+                auto range = mapPledgesByAccount.equal_range(accountID);
+                for (auto itAccount = range.first; itAccount != range.second;) {
+                    itAccount = itAccount->second == hash ? mapPledgesByAccount.erase(itAccount) : std::next(itAccount);
+                }
+            }
+            mapPledges.erase(itPledge);
+        }
         NotifyTransactionChanged(this, hash, CT_DELETED);
     }
 
@@ -20,6 +20,7 @@
 #include <wallet/coinselection.h>
 #include <wallet/crypter.h>
 #include <wallet/ismine.h>
+#include <wallet/txpledge.h>
 #include <wallet/walletdb.h>
 #include <wallet/walletutil.h>
 
@@ -857,6 +858,15 @@ private:
      * Should be called with non-zero block_hash and posInBlock if this is for a transaction that is included in a block. */
     void SyncTransaction(const CTransactionRef& tx, CWalletTx::Status status, const uint256& block_hash, int posInBlock = 0, bool update_tx = true) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /* Add a pledge or retarget tx to the pledge ledger, or mark the pledge revoked by a withdraw tx */
+    void AddToPledges(const CWalletTx& wtx, WalletBatch& batch) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    /* Mark the pledges spent by a tx, or unspent again when the tx leaves the active chain */
+    void SyncPledgeSpends(const CTransaction& tx, bool fConfirmed) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    /* Add the pledge txs of a wallet written before the pledge ledger to the ledger */
+    void UpgradePledges(interfaces::Chain::Lock& locked_chain) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     /* the HD chain data model (external chain counters) */
     CHDChain hdChain;
 
@@ -993,6 +1003,11 @@ public:
 
     std::map<uint256, CWalletTx> mapWallet GUARDED_BY(cs_wallet);
 
+    //! The pledge ledger, the pledge and retarget txs of mapWallet
+    std::map<uint256, CWalletPledge> mapPledges GUARDED_BY(cs_wallet);
+    //! The pledge txs by the accounts of the sender and the receiver
+    std::multimap<CAccountID, uint256> mapPledgesByAccount GUARDED_BY(cs_wallet);
+
     typedef std::multimap<int64_t, CWalletTx*> TxItems;
     TxItems wtxOrdered;
 
@@ -1143,6 +1158,7 @@ public:
     void MarkDirty();
     bool AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose=true);
     void LoadToWallet(CWalletTx& wtxIn) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    void LoadPledge(const uint256& txid, const CWalletPledge& pledge) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void TransactionAddedToMempool(const CTransactionRef& tx) override;
     void BlockConnected(const CBlock& block, const std::vector<CTransactionRef>& vtxConflicted) override;
     void BlockDisconnected(const CBlock& block) override;
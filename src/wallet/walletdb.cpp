@@ -38,6 +38,7 @@ const std::string MINVERSION{"minversion"};
 const std::string NAME{"name"};
 const std::string OLD_KEY{"wkey"};
 const std::string ORDERPOSNEXT{"orderposnext"};
+const std::string PLEDGE{"pledge"};
 const std::string POOL{"pool"};
 const std::string PURPOSE{"purpose"};
 const std::string SETTINGS{"settings"};
@@ -80,7 +81,12 @@ bool WalletBatch::WriteTx(const CWalletTx& wtx)
 
 bool WalletBatch::EraseTx(uint256 hash)
 {
-    return EraseIC(std::make_pair(DBKeys::TX, hash));
+    return EraseIC(std::make_pair(DBKeys::TX, hash)) && EraseIC(std::make_pair(DBKeys::PLEDGE, hash));
+}
+
+bool WalletBatch::WritePledge(const uint256& txid, const CWalletPledge& pledge)
+{
+    return WriteIC(std::make_pair(DBKeys::PLEDGE, txid), pledge);
 }
 
 bool WalletBatch::WriteKeyMetadata(const CKeyMetadata& meta, const CPubKey& pubkey, const bool overwrite)
@@ -247,6 +253,12 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
                 wss.fAnyUnordered = true;
 
             pwallet->LoadToWallet(wtx);
+        } else if (strType == DBKeys::PLEDGE) {
+            uint256 txid;
+            ssKey >> txid;
+            CWalletPledge pledge;
+            ssValue >> pledge;
+            pwallet->LoadPledge(txid, pledge);
         } else if (strType == DBKeys::WATCHS) {
             wss.nWatchKeys++;
             CScript script;
@@ -37,6 +37,7 @@ class CKeyPool;
 class CMasterKey;
 class CScript;
 class CWallet;
+struct CWalletPledge;
 class CWalletTx;
 class uint160;
 class uint256;
@@ -72,6 +73,7 @@ extern const std::string MINVERSION;
 extern const std::string NAME;
 extern const std::string OLD_KEY;
 extern const std::string ORDERPOSNEXT;
+extern const std::string PLEDGE;
 extern const std::string POOL;
 extern const std::string PURPOSE;
 extern const std::string SETTINGS;
@@ -222,6 +224,8 @@ public:
     bool WriteTx(const CWalletTx& wtx);
     bool EraseTx(uint256 hash);
 
+    bool WritePledge(const uint256& txid, const CWalletPledge& pledge);
+
     bool WriteKeyMetadata(const CKeyMetadata& meta, const CPubKey& pubkey, const bool overwrite);
     bool WriteKey(const CPubKey& vchPubKey, const CPrivKey& vchPrivKey, const CKeyMetadata &keyMeta);
     bool WriteCryptedKey(const CPubKey& vchPubKey, const std::vector<unsigned char>& vchCryptedSecret, const CKeyMetadata &keyMeta);
@@ -20,3 +20,8 @@ bool CZMQAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyVdfProof(const chiapos::CVdfProof &/*vdfProof*/)
+{
+    return true;
+}
@@ -9,6 +9,9 @@
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
+namespace chiapos {
+class CVdfProof;
+}
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
@@ -42,6 +45,7 @@ public:
 
     virtual bool NotifyBlock(const CBlockIndex *pindex);
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    virtual bool NotifyVdfProof(const chiapos::CVdfProof &vdfProof);
 
 protected:
     void *psocket;
@@ -4,6 +4,8 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <chiapos/block_fields.h>
+#include <chiapos/post.h>
 #include <streams.h>
 #include <zmq/zmqpublishnotifier.h>
 #include <validation.h>
@@ -16,6 +18,8 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
+static const char *MSG_HASHCHALLENGE = "hashchallenge";
+static const char *MSG_RAWVDFPROOF   = "rawvdfproof";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -207,3 +211,26 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     ss << transaction;
     return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
+
+bool CZMQPublishHashChallengeNotifier::NotifyBlock(const CBlockIndex *pindex)
+{
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    if (pindex->nHeight + 1 < consensusParams.BHDIP009Height) {
+        // No challenge before chiapos
+        return true;
+    }
+    uint256 challenge = chiapos::MakeChallenge(pindex, consensusParams);
+    LogPrint(BCLog::ZMQ, "zmq: Publish hashchallenge %s\n", challenge.GetHex());
+    char data[32];
+    for (unsigned int i = 0; i < 32; i++)
+        data[31 - i] = challenge.begin()[i];
+    return SendMessage(MSG_HASHCHALLENGE, data, 32);
+}
+
+bool CZMQPublishRawVdfProofNotifier::NotifyVdfProof(const chiapos::CVdfProof &vdfProof)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish rawvdfproof %s, iters=%d\n", vdfProof.challenge.GetHex(), vdfProof.nVdfIters);
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << vdfProof;
+    return SendMessage(MSG_RAWVDFPROOF, &(*ss.begin()), ss.size());
+}
@@ -52,4 +52,16 @@ public:
     bool NotifyTransaction(const CTransaction &transaction) override;
 };
 
+class CZMQPublishHashChallengeNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlock(const CBlockIndex *pindex) override;
+};
+
+class CZMQPublishRawVdfProofNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyVdfProof(const chiapos::CVdfProof &vdfProof) override;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H